@@ -235,7 +235,7 @@ int main(int argc, char *argv[]) {
 
   size_t window_id = glps_wm_window_create(wm, "3D Game with Camera", 800, 600);
 
-  if (!gladLoadGLLoader((GLADloadproc)glps_get_proc_addr())) {
+  if (!gladLoadGLLoader((GLADloadproc)glps_get_proc_addr)) {
     fprintf(stderr, "Failed to initialize GLAD\n");
     exit(EXIT_FAILURE);
   }
@@ -0,0 +1,217 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Background texture uploads through a shared context.
+ *
+ * A loader thread fills textures on its own shared context and hands each one
+ * to the render thread together with a fence. The render thread makes the
+ * GPU wait for the fence instead of stalling on glFinish, then blits the
+ * texture to the window.
+ *
+ * Arguments: number of textures to upload (default 60) and their size in
+ * pixels (default 1024).
+ */
+
+#include "glad/glad.h"
+#include <GLPS/glps_window_manager.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  glps_WindowManager *wm;
+  glps_SharedContext *shared;
+  unsigned long count;
+  int size;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t consumed;
+  GLuint texture; /* Uploaded texture waiting for the render thread. */
+  glps_Fence fence;
+  bool done;
+  bool cancelled; /* The window closed before every texture was shown. */
+
+  GLuint read_fbo;
+  unsigned long shown;
+} UploadData;
+
+void *loader_thread(void *data) {
+  UploadData *upload = (UploadData *)data;
+  if (!glps_wm_make_shared_context_current(upload->wm, upload->shared)) {
+    return NULL;
+  }
+
+  unsigned char *pixels = malloc((size_t)upload->size * upload->size * 4);
+  for (unsigned long i = 0; i < upload->count; ++i) {
+    for (int y = 0; y < upload->size; ++y) {
+      for (int x = 0; x < upload->size; ++x) {
+        unsigned char *p = pixels + ((size_t)y * upload->size + x) * 4;
+        p[0] = (unsigned char)(x + i * 4);
+        p[1] = (unsigned char)(y + i * 2);
+        p[2] = (unsigned char)(i * 8);
+        p[3] = 255;
+      }
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, upload->size, upload->size, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glps_Fence fence = glps_wm_fence_create(upload->wm);
+
+    pthread_mutex_lock(&upload->mutex);
+    while (upload->texture != 0 && !upload->cancelled) {
+      pthread_cond_wait(&upload->consumed, &upload->mutex);
+    }
+    bool cancelled = upload->cancelled;
+    if (!cancelled) {
+      upload->texture = texture;
+      upload->fence = fence;
+    }
+    pthread_mutex_unlock(&upload->mutex);
+
+    if (cancelled) {
+      glps_wm_fence_destroy(upload->wm, fence);
+      glDeleteTextures(1, &texture);
+      break;
+    }
+  }
+  free(pixels);
+
+  pthread_mutex_lock(&upload->mutex);
+  while (upload->texture != 0 && !upload->cancelled) {
+    pthread_cond_wait(&upload->consumed, &upload->mutex);
+  }
+  // Objects are shared, the texture nobody took is deleted here.
+  if (upload->texture != 0) {
+    glps_wm_fence_destroy(upload->wm, upload->fence);
+    glDeleteTextures(1, &upload->texture);
+    upload->texture = 0;
+    upload->fence = NULL;
+  }
+  upload->done = true;
+  pthread_mutex_unlock(&upload->mutex);
+
+  glps_wm_make_shared_context_current(upload->wm, NULL);
+  return NULL;
+}
+
+void window_frame_update_callback(size_t window_id, void *data) {
+  UploadData *upload = (UploadData *)data;
+
+  pthread_mutex_lock(&upload->mutex);
+  GLuint texture = upload->texture;
+  glps_Fence fence = upload->fence;
+  upload->texture = 0;
+  upload->fence = NULL;
+  pthread_cond_signal(&upload->consumed);
+  pthread_mutex_unlock(&upload->mutex);
+
+  if (texture != 0) {
+    // Commands from here on run once the upload finished on the GPU.
+    if (fence != NULL) {
+      glps_wm_fence_wait_gpu(upload->wm, fence);
+      glps_wm_fence_destroy(upload->wm, fence);
+    }
+
+    int width, height;
+    glps_wm_window_get_dimensions(upload->wm, window_id, &width, &height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, upload->read_fbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, texture, 0);
+    glBlitFramebuffer(0, 0, upload->size, upload->size, 0, 0, width, height,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glDeleteTextures(1, &texture);
+    upload->shown++;
+  }
+
+  glps_wm_swap_buffers(upload->wm, window_id);
+}
+
+void window_close_callback(size_t window_id, void *data) {
+  UploadData *upload = (UploadData *)data;
+
+  // The framebuffer goes while the window's context can still be current.
+  glps_wm_set_window_ctx_curr(upload->wm, window_id);
+  glDeleteFramebuffers(1, &upload->read_fbo);
+  upload->read_fbo = 0;
+  glps_wm_window_destroy(upload->wm, window_id);
+}
+
+int main(int argc, char *argv[]) {
+  UploadData upload = {0};
+  upload.count = argc > 1 ? strtoul(argv[1], NULL, 10) : 60;
+  upload.size = argc > 2 ? atoi(argv[2]) : 1024;
+  pthread_mutex_init(&upload.mutex, NULL);
+  pthread_cond_init(&upload.consumed, NULL);
+
+  glps_WindowManager *wm = glps_wm_init();
+  upload.wm = wm;
+
+  size_t window_id = glps_wm_window_create(wm, "Async Upload", 640, 480);
+  if (!gladLoadGLLoader((GLADloadproc)glps_get_proc_addr)) {
+    fprintf(stderr, "Failed to initialize GLAD\n");
+    exit(EXIT_FAILURE);
+  }
+
+  upload.shared = glps_wm_create_shared_context(wm);
+  if (upload.shared == NULL) {
+    fprintf(stderr, "Shared contexts are not supported\n");
+    glps_wm_destroy(wm);
+    return EXIT_FAILURE;
+  }
+
+  glps_wm_set_window_ctx_curr(wm, window_id);
+  glGenFramebuffers(1, &upload.read_fbo);
+  glps_wm_window_set_close_callback(wm, window_close_callback,
+                                    (void *)&upload);
+  glps_wm_window_set_frame_update_callback(wm, window_frame_update_callback,
+                                           (void *)&upload);
+
+  pthread_t loader;
+  pthread_create(&loader, NULL, loader_thread, &upload);
+
+  glClear(GL_COLOR_BUFFER_BIT);
+  glps_wm_swap_buffers(wm, window_id);
+
+  bool done = false;
+  while (!done && !glps_wm_should_close(wm)) {
+    pthread_mutex_lock(&upload.mutex);
+    done = upload.done;
+    pthread_mutex_unlock(&upload.mutex);
+  }
+
+  // A loader waiting for the closed window to take a texture gives up.
+  pthread_mutex_lock(&upload.mutex);
+  upload.cancelled = true;
+  pthread_cond_broadcast(&upload.consumed);
+  pthread_mutex_unlock(&upload.mutex);
+  pthread_join(loader, NULL);
+  printf("%lu of %lu textures shown\n", upload.shown, upload.count);
+
+  if (upload.read_fbo != 0) {
+    glps_wm_set_window_ctx_curr(wm, window_id);
+    glDeleteFramebuffers(1, &upload.read_fbo);
+  }
+  glps_wm_destroy_shared_context(wm, upload.shared);
+  glps_wm_destroy(wm);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Clipboard manager throughput benchmark.
+ *
+ * A child process keeps replacing the selection, the parent follows it in
+ * clipboard manager mode and reads every new selection, either into memory or
+ * streamed into a file. Neither process needs a window or keyboard focus, so
+ * it runs on a headless compositor implementing wlr-data-control:
+ *
+ *   sway --config /dev/null &
+ *   ./clipboard_bench 200 8388608 /tmp/selection.bin
+ *
+ * Arguments: number of selection changes (default 100), selection size in
+ * bytes (default 1 MiB) and an optional file to stream the selections into.
+ */
+
+#define _GNU_SOURCE
+#include <GLPS/glps_window_manager.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MIME "application/octet-stream"
+
+typedef struct {
+  glps_WindowManager *wm;
+  int control_fd;
+  int out_fd;
+  unsigned long changes;
+  unsigned long received;
+  size_t expected_size;
+  size_t bytes;
+  bool started;
+  bool failed;
+} BenchmarkData;
+
+double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Asks the source process for the next selection, or tells it to quit.
+void next_change(BenchmarkData *benchmark) {
+  if (benchmark->received == benchmark->changes) {
+    close(benchmark->control_fd);
+    benchmark->control_fd = -1;
+    return;
+  }
+
+  if (write(benchmark->control_fd, "n", 1) != 1) {
+    benchmark->failed = true;
+  }
+}
+
+void clipboard_callback(const char *mime, const char *buff, size_t size,
+                        void *data) {
+  BenchmarkData *benchmark = (BenchmarkData *)data;
+
+  if (size != benchmark->expected_size) {
+    fprintf(stderr, "Selection %lu: got %zu bytes, expected %zu\n",
+            benchmark->received, size, benchmark->expected_size);
+    benchmark->failed = true;
+  }
+
+  benchmark->bytes += size;
+  benchmark->received++;
+  next_change(benchmark);
+}
+
+void selection_callback(void *data) {
+  BenchmarkData *benchmark = (BenchmarkData *)data;
+
+  // The selection found at startup belongs to someone else.
+  if (!benchmark->started || benchmark->control_fd < 0)
+    return;
+
+  bool requested;
+  if (benchmark->out_fd >= 0) {
+    if (ftruncate(benchmark->out_fd, 0) < 0 ||
+        lseek(benchmark->out_fd, 0, SEEK_SET) < 0) {
+      benchmark->failed = true;
+      return;
+    }
+    requested = glps_wm_request_from_clipboard_to_fd(
+        benchmark->wm, BENCH_MIME, benchmark->out_fd, clipboard_callback,
+        benchmark);
+  } else {
+    requested = glps_wm_request_from_clipboard(benchmark->wm, BENCH_MIME,
+                                               clipboard_callback, benchmark);
+  }
+
+  // Cleared selections in between changes offer nothing to read.
+  (void)requested;
+}
+
+int run_source(int control_fd, size_t size) {
+  glps_WindowManager *wm = glps_wm_init();
+  if (!glps_wm_enable_data_control(wm)) {
+    glps_wm_destroy(wm);
+    return EXIT_FAILURE;
+  }
+
+  int fd = memfd_create("clipboard-bench", MFD_CLOEXEC);
+  char *content = fd >= 0 && ftruncate(fd, (off_t)size) == 0
+                      ? mmap(NULL, size, PROT_WRITE, MAP_SHARED, fd, 0)
+                      : MAP_FAILED;
+  if (content == MAP_FAILED) {
+    fprintf(stderr, "Failed to create the selection content\n");
+    glps_wm_destroy(wm);
+    return EXIT_FAILURE;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    content[i] = (char)('a' + i % 26);
+  }
+  munmap(content, size);
+
+  fcntl(control_fd, F_SETFL, O_NONBLOCK);
+  for (;;) {
+    char command;
+    ssize_t n = read(control_fd, &command, 1);
+    if (n == 0)
+      break;
+    if (n == 1) {
+      glps_wm_attach_fd_to_clipboard(wm, BENCH_MIME, fd, size);
+      continue;
+    }
+
+    // Serve the reader until the next command arrives.
+    if (!glps_wm_dispatch_events(wm, 1))
+      break;
+  }
+
+  close(fd);
+  glps_wm_destroy(wm);
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+  BenchmarkData benchmark = {0};
+  benchmark.changes = argc > 1 ? strtoul(argv[1], NULL, 10) : 100;
+  benchmark.expected_size = argc > 2 ? strtoul(argv[2], NULL, 10) : 1 << 20;
+  benchmark.out_fd = -1;
+
+  int control[2];
+  if (benchmark.changes == 0 || pipe(control) < 0) {
+    fprintf(stderr, "Usage: %s [changes] [size] [output file]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  pid_t source = fork();
+  if (source == 0) {
+    close(control[1]);
+    _exit(run_source(control[0], benchmark.expected_size));
+  }
+  close(control[0]);
+  benchmark.control_fd = control[1];
+
+  if (argc > 3) {
+    benchmark.out_fd = open(argv[3], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (benchmark.out_fd < 0) {
+      perror(argv[3]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  glps_WindowManager *wm = glps_wm_init();
+  benchmark.wm = wm;
+  if (!glps_wm_enable_data_control(wm)) {
+    fprintf(stderr, "The compositor does not support wlr-data-control\n");
+    close(benchmark.control_fd);
+    waitpid(source, NULL, 0);
+    glps_wm_destroy(wm);
+    return EXIT_FAILURE;
+  }
+  glps_wm_set_selection_callback(wm, selection_callback, &benchmark);
+  glps_wm_set_clipboard_callback(wm, clipboard_callback, &benchmark);
+
+  double start = now_s();
+  benchmark.started = true;
+  next_change(&benchmark);
+
+  while (benchmark.control_fd >= 0 && !benchmark.failed &&
+         glps_wm_dispatch_events(wm, 1000)) {
+  }
+  double elapsed = now_s() - start;
+
+  if (benchmark.control_fd >= 0) {
+    close(benchmark.control_fd);
+  }
+  waitpid(source, NULL, 0);
+
+  printf("%lu selections of %zu bytes %s in %.3f s\n", benchmark.received,
+         benchmark.expected_size,
+         benchmark.out_fd >= 0 ? "streamed to file" : "read into memory",
+         elapsed);
+  printf("%.1f changes/s, %.1f MB/s\n", benchmark.received / elapsed,
+         benchmark.bytes / elapsed / 1e6);
+
+  if (benchmark.out_fd >= 0) {
+    close(benchmark.out_fd);
+  }
+  glps_wm_destroy(wm);
+  return benchmark.failed || benchmark.received != benchmark.changes
+             ? EXIT_FAILURE
+             : EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Input-to-photon latency benchmark.
+ *
+ * Injects a synthetic input every few frames and reports the latency
+ * distribution once enough frames were presented. Real pointer, keyboard and
+ * touch events are measured too. To run it as a regression benchmark without a
+ * desktop, start a headless compositor and point the example at it:
+ *
+ *   weston --backend=headless-backend.so --socket=glps-bench &
+ *   WAYLAND_DISPLAY=glps-bench ./input_latency 600 50
+ *
+ * Arguments: number of frames to measure (default 600), an optional p99
+ * budget in ms, CPU time spent per frame in ms (default 0) and "input-thread"
+ * to read input on the input thread and dispatch it right before drawing. The
+ * exit status is non-zero when the p99 exceeds the budget.
+ */
+
+#include "glad/glad.h"
+#include <GLPS/glps_window_manager.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define INPUT_INTERVAL 4
+
+typedef struct {
+  glps_WindowManager *wm;
+  unsigned long frames;
+  unsigned long target_frames;
+  double work_ms;
+  bool input_thread;
+  bool done;
+  glps_LatencyStats stats;
+} BenchmarkData;
+
+void print_latency(const glps_LatencyStats *stats) {
+  printf("samples: %llu (discarded frames: %llu), %s\n",
+         (unsigned long long)stats->sample_count,
+         (unsigned long long)stats->discarded_count,
+         stats->presentation_feedback ? "measured to presentation"
+                                      : "measured to buffer submission");
+  printf("latency ms: mean %.2f min %.2f p50 %.2f p90 %.2f p99 %.2f max %.2f\n",
+         stats->mean_ms, stats->min_ms, stats->p50_ms, stats->p90_ms,
+         stats->p99_ms, stats->max_ms);
+  printf("dispatch ms: mean %.2f\n", stats->mean_dispatch_ms);
+
+  for (size_t i = 0; i < GLPS_LATENCY_BUCKETS; ++i) {
+    if (stats->histogram[i] == 0)
+      continue;
+    printf("  %3zu-%3zu ms: %u\n", i * GLPS_LATENCY_BUCKET_MS,
+           (i + 1) * GLPS_LATENCY_BUCKET_MS, stats->histogram[i]);
+  }
+}
+
+double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+void window_frame_update_callback(size_t window_id, void *data) {
+  BenchmarkData *benchmark = (BenchmarkData *)data;
+
+  // Stands in for the simulation, which input doesn't need yet.
+  double end = now_ms() + benchmark->work_ms;
+  while (now_ms() < end) {
+  }
+  if (benchmark->input_thread) {
+    glps_wm_dispatch_input(benchmark->wm);
+  }
+
+  if (benchmark->frames % INPUT_INTERVAL == 0) {
+    glps_wm_window_mark_input(benchmark->wm, window_id);
+  }
+
+  glClearColor((benchmark->frames % 2) ? 1.0f : 0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glps_wm_swap_buffers(benchmark->wm, window_id);
+
+  if (++benchmark->frames == benchmark->target_frames) {
+    benchmark->stats =
+        glps_wm_window_get_latency_stats(benchmark->wm, window_id);
+    benchmark->done = true;
+  }
+}
+
+void window_close_callback(size_t window_id, void *data) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_wm_window_destroy(wm, window_id);
+}
+
+int main(int argc, char *argv[]) {
+  BenchmarkData benchmark = {0};
+  benchmark.target_frames = argc > 1 ? strtoul(argv[1], NULL, 10) : 600;
+  double p99_budget_ms = argc > 2 ? strtod(argv[2], NULL) : 0.0;
+  benchmark.work_ms = argc > 3 ? strtod(argv[3], NULL) : 0.0;
+  bool input_thread = argc > 4 && strcmp(argv[4], "input-thread") == 0;
+
+  glps_WindowManager *wm = glps_wm_init();
+  benchmark.wm = wm;
+
+  size_t window_id =
+      glps_wm_window_create(wm, "Input Latency Benchmark", 320, 240);
+  if (!gladLoadGLLoader((GLADloadproc)glps_get_proc_addr)) {
+    fprintf(stderr, "Failed to initialize GLAD\n");
+    exit(EXIT_FAILURE);
+  }
+
+  glps_wm_set_window_ctx_curr(wm, window_id);
+  glps_wm_window_set_close_callback(wm, window_close_callback, (void *)wm);
+  glps_wm_window_set_frame_update_callback(wm, window_frame_update_callback,
+                                           (void *)&benchmark);
+
+  if (input_thread) {
+    benchmark.input_thread = glps_wm_start_input_thread(wm);
+  }
+
+  glClear(GL_COLOR_BUFFER_BIT);
+  glps_wm_swap_buffers(wm, window_id);
+
+  while (!benchmark.done && !glps_wm_should_close(wm)) {
+  }
+
+  print_latency(&benchmark.stats);
+
+  int status = EXIT_SUCCESS;
+  if (p99_budget_ms > 0.0 && benchmark.stats.p99_ms > p99_budget_ms) {
+    fprintf(stderr, "p99 latency %.2f ms exceeds the %.2f ms budget\n",
+            benchmark.stats.p99_ms, p99_budget_ms);
+    status = EXIT_FAILURE;
+  }
+
+  glps_wm_destroy(wm);
+  return status;
+}
@@ -0,0 +1,185 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Render threads of the Wayland backend without a compositor.
+ *
+ * The real render thread and sync code runs against stubbed EGL. The owner
+ * keeps destroying window 0 as glps_wl_window_destroy does, shifting the ID
+ * of every window still rendering, and posts frames, resizes and input
+ * meanwhile. Each frame a render thread reads its own window and the next
+ * one by ID and checks that both are the windows with those IDs. Built with
+ * -DGLPS_TSAN=ON on Wayland it must finish without reports:
+ *
+ *   ./render_thread_stress 2000
+ *
+ * Argument: number of windows created and destroyed (default 500).
+ */
+
+#include "glps_egl_context.h"
+#include "glps_gpu_timer.h"
+#include "glps_render_thread.h"
+#include "glps_sync.h"
+#include "glps_wayland.h"
+#include <stdio.h>
+
+#define STRESS_WINDOWS 3
+
+static atomic_ulong frames, resizes, wrong_windows;
+
+bool glps_egl_make_thread_ctx_current(glps_WindowManager *wm,
+                                      EGLSurface surface, EGLContext ctx) {
+  return true;
+}
+
+EGLContext glps_egl_create_thread_ctx(glps_WindowManager *wm) {
+  return (EGLContext)1;
+}
+
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx) {
+  return EGL_TRUE;
+}
+
+EGLSurface eglGetCurrentSurface(EGLint readdraw) { return EGL_NO_SURFACE; }
+
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read,
+                          EGLContext ctx) {
+  return EGL_TRUE;
+}
+
+void glps_gpu_timer_release(glps_WindowManager *wm, glps_GpuTimer *timer) {}
+
+// What the backend does to the EGL window, on the thread that swaps.
+void glps_wl_window_resize_buffers(glps_WaylandWindow *window,
+                                   const glps_WindowEvent *event) {
+  window->surface_scale.width = event->resize.logical_width;
+  window->surface_scale.dirty = true;
+}
+
+glps_WaylandWindow *glps_wl_window(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandWindow *window = glps_render_thread_window(window_id);
+  return window != NULL ? window : wm->windows[window_id];
+}
+
+// Windows are told apart by their width, which no two live ones share.
+static int window_width(glps_WindowManager *wm, size_t window_id) {
+  glps_WindowProperties properties = {0};
+  unsigned epoch;
+  glps_WaylandWindow *window = glps_sync_read_begin(wm, window_id, &epoch);
+  if (window != NULL)
+    GLPS_SEQLOCK_SNAPSHOT(&window->properties_cell, &properties);
+  glps_sync_read_end(wm, epoch);
+  return properties.width;
+}
+
+static void frame_callback(size_t window_id, void *data) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+
+  // Stands in for drawing and swapping, which the thread owns.
+  glps_WaylandWindow *window = glps_wl_window(wm, window_id);
+  window->shm_frame++;
+
+  int own = window_width(wm, window_id);
+  int other = window_width(wm, (window_id + 1) % STRESS_WINDOWS);
+  if (own != window->properties.width || other == own)
+    atomic_fetch_add(&wrong_windows, 1);
+  atomic_fetch_add(&frames, 1);
+}
+
+static void resize_callback(size_t window_id, int width, int height,
+                            void *data) {
+  atomic_fetch_add(&resizes, 1);
+}
+
+static void create_window(glps_WindowManager *wm, int width) {
+  glps_WaylandWindow *window = calloc(1, sizeof(glps_WaylandWindow));
+  window->properties.width = width;
+  window->properties.height = 120;
+  GLPS_SEQLOCK_PUBLISH(&window->properties_cell, &window->properties);
+
+  size_t window_id = wm->window_count;
+  wm->windows[window_id] = window;
+  wm->window_count++;
+  window->render_thread = glps_render_thread_start(wm, window_id);
+  if (window->render_thread == NULL) {
+    fprintf(stderr, "Failed to start a render thread\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void destroy_window(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  glps_render_thread_stop(window->render_thread);
+
+  for (size_t i = window_id; i < wm->window_count - 1; ++i) {
+    wm->windows[i] = wm->windows[i + 1];
+    glps_render_thread_set_window_id(wm->windows[i]->render_thread, i);
+  }
+  wm->window_count--;
+
+  glps_sync_synchronize(wm);
+  free(window);
+}
+
+int main(int argc, char *argv[]) {
+  unsigned long cycles = argc > 1 ? strtoul(argv[1], NULL, 10) : 500;
+
+  glps_WindowManager *wm = calloc(1, sizeof(glps_WindowManager));
+  wm->windows = calloc(STRESS_WINDOWS + 1, sizeof(*wm->windows));
+  wm->egl_ctx = calloc(1, sizeof(glps_EGLContext));
+  if (!glps_sync_init(wm)) {
+    return EXIT_FAILURE;
+  }
+  wm->callbacks.window_frame_update_callback = frame_callback;
+  wm->callbacks.window_frame_update_data = wm;
+  wm->callbacks.window_resize_callback = resize_callback;
+
+  int width = 0;
+  for (size_t i = 0; i < STRESS_WINDOWS; ++i) {
+    create_window(wm, 160 + width++ % 64);
+  }
+
+  for (unsigned long cycle = 0; cycle < cycles; ++cycle) {
+    create_window(wm, 160 + width++ % 64);
+    for (int round = 0; round < 16; ++round) {
+      for (size_t i = 0; i < wm->window_count; ++i) {
+        glps_WindowEvent event = {.type = GLPS_WINDOW_EVENT_FRAME,
+                                  .window_id = i};
+        glps_render_thread_post(wm->windows[i]->render_thread, &event);
+        event.type = GLPS_WINDOW_EVENT_RESIZE;
+        event.resize.logical_width = wm->windows[i]->properties.width;
+        glps_render_thread_post(wm->windows[i]->render_thread, &event);
+        event.type = GLPS_WINDOW_EVENT_MOUSE_MOVE;
+        glps_render_thread_post(wm->windows[i]->render_thread, &event);
+      }
+    }
+    destroy_window(wm, 0);
+  }
+  while (wm->window_count > 0) {
+    destroy_window(wm, 0);
+  }
+
+  printf("%lu frames, %lu resizes, %lu wrong windows\n",
+         atomic_load(&frames), atomic_load(&resizes),
+         atomic_load(&wrong_windows));
+
+  glps_sync_destroy(wm);
+  free(wm->egl_ctx);
+  free(wm->windows);
+  free(wm);
+  return atomic_load(&wrong_windows) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
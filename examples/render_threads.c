@@ -0,0 +1,112 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Parallel rendering of independent windows.
+ *
+ * Every frame of every window burns a fixed amount of CPU time before it is
+ * cleared and swapped. On the dispatch thread the windows share one frame
+ * rate; with a render thread each they keep their own on multi-core
+ * machines.
+ *
+ * Arguments: number of windows (default 4), CPU time per frame in
+ * milliseconds (default 8), duration in seconds (default 5) and "single" to
+ * render everything on the dispatch thread.
+ */
+
+#include "glad/glad.h"
+#include <GLPS/glps_window_manager.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  glps_WindowManager *wm;
+  double work_ms;
+} RenderData;
+
+double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+void window_frame_update_callback(size_t window_id, void *data) {
+  RenderData *render = (RenderData *)data;
+
+  // Stands in for culling, animation and command recording.
+  double end = now_s() + render->work_ms / 1000.0;
+  while (now_s() < end) {
+  }
+
+  glClearColor(0.2f * (float)(window_id % 5), 0.3f, 0.4f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glps_wm_swap_buffers(render->wm, window_id);
+}
+
+int main(int argc, char *argv[]) {
+  size_t windows = argc > 1 ? strtoul(argv[1], NULL, 10) : 4;
+  RenderData render = {.work_ms = argc > 2 ? atof(argv[2]) : 8.0};
+  double duration = argc > 3 ? atof(argv[3]) : 5.0;
+  bool threaded = !(argc > 4 && strcmp(argv[4], "single") == 0);
+
+  glps_WindowManager *wm = glps_wm_init();
+  render.wm = wm;
+
+  for (size_t i = 0; i < windows; ++i) {
+    glps_wm_window_create(wm, "Render Threads", 320, 240);
+  }
+  if (!gladLoadGLLoader((GLADloadproc)glps_get_proc_addr)) {
+    fprintf(stderr, "Failed to initialize GLAD\n");
+    exit(EXIT_FAILURE);
+  }
+  glps_wm_window_set_frame_update_callback(wm, window_frame_update_callback,
+                                           (void *)&render);
+
+  // The first swap of each window gets its frame callbacks going.
+  for (size_t i = 0; i < windows; ++i) {
+    glps_wm_set_window_ctx_curr(wm, i);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glps_wm_swap_buffers(wm, i);
+    if (threaded && !glps_wm_window_start_render_thread(wm, i)) {
+      fprintf(stderr, "Failed to start the render thread of window %zu\n", i);
+      threaded = false;
+    }
+  }
+
+  double end = now_s() + duration;
+  while (now_s() < end && !glps_wm_should_close(wm)) {
+  }
+
+  // Statistics are only read once no thread updates them anymore.
+  for (size_t i = 0; i < windows; ++i) {
+    glps_wm_window_stop_render_thread(wm, i);
+  }
+
+  printf("%zu windows, %.1f ms of work per frame, %s\n", windows,
+         render.work_ms, threaded ? "one render thread each" : "single thread");
+  for (size_t i = 0; i < windows; ++i) {
+    glps_FrameStats stats = glps_wm_window_get_frame_stats(wm, i);
+    printf("window %zu: %llu frames, %.1f fps, p99 %.2f ms\n", i,
+           (unsigned long long)stats.frame_count,
+           (double)stats.frame_count / duration, stats.p99_frame_ms);
+  }
+
+  glps_wm_destroy(wm);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * CPU rendering without OpenGL.
+ *
+ * A square bounces over a static gradient. Only the squares of this frame and
+ * of the frames the buffer missed are redrawn and sent, as told by the
+ * buffer's age:
+ *
+ *   gcc software_render.c -lGLPS -o software_render
+ */
+
+#include <GLPS/glps_window_manager.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SQUARE_SIZE 64
+#define HISTORY 4 /**< Square positions remembered, more than buffers. */
+
+typedef struct {
+  glps_WindowManager *wm;
+  int x, y, dx, dy;
+  glps_Rect history[HISTORY]; /**< Square of each frame, newest first. */
+  int frames;                 /**< Frames presented, capped at HISTORY. */
+} SoftwareData;
+
+static void draw_background(const glps_PixelBuffer *buffer,
+                            const glps_Rect *rect) {
+  for (int y = rect->y; y < rect->y + rect->height; ++y) {
+    uint32_t *row = buffer->pixels + (size_t)y * buffer->stride;
+    for (int x = rect->x; x < rect->x + rect->width; ++x) {
+      uint32_t r = x * 255 / buffer->width, g = y * 255 / buffer->height;
+      row[x] = r << 16 | g << 8 | 0x60;
+    }
+  }
+}
+
+static void draw_square(const glps_PixelBuffer *buffer, const glps_Rect *rect) {
+  for (int y = rect->y; y < rect->y + rect->height; ++y) {
+    uint32_t *row = buffer->pixels + (size_t)y * buffer->stride;
+    for (int x = rect->x; x < rect->x + rect->width; ++x)
+      row[x] = 0xffffff;
+  }
+}
+
+static void move_square(SoftwareData *data, int width, int height) {
+  data->x += data->dx;
+  data->y += data->dy;
+  if (data->x < 0 || data->x + SQUARE_SIZE > width) {
+    data->dx = -data->dx;
+    data->x += 2 * data->dx;
+  }
+  if (data->y < 0 || data->y + SQUARE_SIZE > height) {
+    data->dy = -data->dy;
+    data->y += 2 * data->dy;
+  }
+}
+
+void window_frame_update_callback(size_t window_id, void *user_data) {
+  SoftwareData *data = (SoftwareData *)user_data;
+
+  glps_PixelBuffer buffer = glps_wm_window_map_pixels(data->wm, window_id);
+  if (buffer.pixels == NULL || buffer.width < SQUARE_SIZE ||
+      buffer.height < SQUARE_SIZE)
+    return;
+
+  move_square(data, buffer.width, buffer.height);
+  for (int i = HISTORY - 1; i > 0; --i)
+    data->history[i] = data->history[i - 1];
+  data->history[0] = (glps_Rect){data->x, data->y, SQUARE_SIZE, SQUARE_SIZE};
+
+  // The buffer holds the frame from `age` frames ago: the squares drawn
+  // since then are stale in it.
+  glps_Rect damage[HISTORY];
+  size_t damage_count = 0;
+  bool full = buffer.age == 0 || buffer.age >= data->frames;
+  if (full) {
+    glps_Rect whole = {0, 0, buffer.width, buffer.height};
+    draw_background(&buffer, &whole);
+  } else {
+    for (int i = 1; i <= buffer.age; ++i) {
+      draw_background(&buffer, &data->history[i]);
+      damage[damage_count++] = data->history[i];
+    }
+  }
+  draw_square(&buffer, &data->history[0]);
+  damage[damage_count++] = data->history[0];
+
+  // No damage for a full redraw presents the whole buffer.
+  glps_wm_window_present_pixels(data->wm, window_id, full ? NULL : damage,
+                                full ? 0 : damage_count);
+  if (data->frames < HISTORY)
+    data->frames++;
+}
+
+void window_resize_callback(size_t window_id, int width, int height,
+                            void *user_data) {
+  SoftwareData *data = (SoftwareData *)user_data;
+  data->x = data->y = 0;
+  data->frames = 0;
+}
+
+int main(int argc, char *argv[]) {
+  SoftwareData data = {.dx = 3, .dy = 2};
+  data.wm = glps_wm_init();
+
+  glps_wm_window_create_software(data.wm, "Software Rendering", 640, 480);
+  glps_wm_window_set_frame_update_callback(
+      data.wm, window_frame_update_callback, (void *)&data);
+  glps_wm_window_set_resize_callback(data.wm, window_resize_callback,
+                                     (void *)&data);
+
+  // The first present starts the frame updates.
+  window_frame_update_callback(0, &data);
+
+  while (!glps_wm_should_close(data.wm)) {
+  }
+
+  glps_wm_destroy(data.wm);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Stress test of the threading contract.
+ *
+ * Windows render on their own threads and input is read on the input thread,
+ * while reader threads keep querying dimensions and frame statistics of every
+ * window and a control thread has windows created and destroyed through
+ * tasks. The oldest window is destroyed each time, shifting the ID of every
+ * window still rendering. Render threads also query another window by ID,
+ * which must not answer with their own. With the library configured with
+ * -DGLPS_TSAN=ON it must finish without reports:
+ *
+ *   gcc -g -fsanitize=thread thread_stress.c glad/glad.c ... -lGLPS
+ *   weston --backend=headless-backend.so --socket=glps-stress &
+ *   WAYLAND_DISPLAY=glps-stress ./thread_stress 4 2000
+ *
+ * Arguments: number of reader threads (default 4) and number of windows
+ * created and destroyed by the control thread (default 1000).
+ *
+ * Without a compositor, render_thread_stress runs the same checks on the
+ * render threads alone.
+ */
+
+#include "glad/glad.h"
+#include <GLPS/glps_window_manager.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STRESS_WINDOWS 3
+
+typedef struct {
+  glps_WindowManager *wm;
+  unsigned long cycles;
+  atomic_ulong created;
+  atomic_ulong destroyed;
+  atomic_ulong queries;
+  atomic_ulong wrong_windows;
+  atomic_bool done;
+  int next_width; /**< Owner only, no two live windows share a width. */
+} StressData;
+
+static size_t create_window(StressData *stress) {
+  int width = 160 + stress->next_width++ % 64;
+  return glps_wm_window_create(stress->wm, "Thread Stress", width, 120);
+}
+
+void window_frame_update_callback(size_t window_id, void *data) {
+  StressData *stress = (StressData *)data;
+
+  // Windows are told apart by their width. The next ID belongs to another
+  // window, or to none while it is being destroyed.
+  int own = 0, other = 0, height = 0;
+  glps_wm_window_get_dimensions(stress->wm, window_id, &own, &height);
+  glps_wm_window_get_dimensions(stress->wm, (window_id + 1) % STRESS_WINDOWS,
+                                &other, &height);
+  if (own == 0 || other == own) {
+    atomic_fetch_add(&stress->wrong_windows, 1);
+  }
+
+  glClearColor(0.1f * (float)(window_id % 10), 0.2f, 0.3f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glps_wm_swap_buffers(stress->wm, window_id);
+}
+
+void create_window_task(glps_WindowManager *wm, void *data) {
+  StressData *stress = (StressData *)data;
+
+  size_t window_id = create_window(stress);
+  glps_wm_set_window_ctx_curr(wm, window_id);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glps_wm_swap_buffers(wm, window_id);
+  glps_wm_window_start_render_thread(wm, window_id);
+  atomic_fetch_add(&stress->created, 1);
+}
+
+// Destroys the oldest window while the others render, their IDs shift down.
+void destroy_window_task(glps_WindowManager *wm, void *data) {
+  StressData *stress = (StressData *)data;
+
+  glps_wm_window_destroy(wm, 0);
+  atomic_fetch_add(&stress->destroyed, 1);
+}
+
+void finish_task(glps_WindowManager *wm, void *data) {
+  StressData *stress = (StressData *)data;
+  atomic_store(&stress->done, true);
+}
+
+void *reader_thread(void *data) {
+  StressData *stress = (StressData *)data;
+
+  while (!atomic_load(&stress->done)) {
+    // The last ID comes and goes, it is only asked for its dimensions, which
+    // are left untouched while no window has it.
+    int width = 0, height = 0;
+    glps_wm_window_get_dimensions(stress->wm, STRESS_WINDOWS, &width, &height);
+    for (size_t i = 0; i < STRESS_WINDOWS; ++i) {
+      glps_wm_window_get_dimensions(stress->wm, i, &width, &height);
+      glps_FrameStats stats = glps_wm_window_get_frame_stats(stress->wm, i);
+      double fps = glps_wm_get_fps(stress->wm, i);
+      (void)stats;
+      (void)fps;
+      atomic_fetch_add(&stress->queries, 1);
+    }
+  }
+  return NULL;
+}
+
+void *control_thread(void *data) {
+  StressData *stress = (StressData *)data;
+
+  for (unsigned long i = 0; i < stress->cycles; ++i) {
+    glps_wm_post_task(stress->wm, create_window_task, stress);
+    glps_wm_post_task(stress->wm, destroy_window_task, stress);
+  }
+  glps_wm_post_task(stress->wm, finish_task, stress);
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  size_t readers = argc > 1 ? strtoul(argv[1], NULL, 10) : 4;
+  StressData stress = {.cycles = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000};
+
+  glps_WindowManager *wm = glps_wm_init();
+  stress.wm = wm;
+
+  for (size_t i = 0; i < STRESS_WINDOWS; ++i) {
+    create_window(&stress);
+  }
+  if (!gladLoadGLLoader((GLADloadproc)glps_get_proc_addr)) {
+    fprintf(stderr, "Failed to initialize GLAD\n");
+    exit(EXIT_FAILURE);
+  }
+  glps_wm_window_set_frame_update_callback(wm, window_frame_update_callback,
+                                           (void *)&stress);
+
+  for (size_t i = 0; i < STRESS_WINDOWS; ++i) {
+    glps_wm_set_window_ctx_curr(wm, i);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glps_wm_swap_buffers(wm, i);
+    if (!glps_wm_window_start_render_thread(wm, i)) {
+      fprintf(stderr, "Render threads are not supported\n");
+      glps_wm_destroy(wm);
+      return EXIT_FAILURE;
+    }
+  }
+  glps_wm_start_input_thread(wm);
+
+  pthread_t *threads = malloc(sizeof(pthread_t) * (readers + 1));
+  for (size_t i = 0; i < readers; ++i) {
+    pthread_create(&threads[i], NULL, reader_thread, &stress);
+  }
+  pthread_create(&threads[readers], NULL, control_thread, &stress);
+
+  while (!atomic_load(&stress.done) && !glps_wm_should_close(wm)) {
+  }
+  atomic_store(&stress.done, true);
+
+  for (size_t i = 0; i < readers + 1; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+
+  printf("%lu windows created, %lu destroyed, %lu queries, %lu answered by "
+         "the wrong window\n",
+         atomic_load(&stress.created), atomic_load(&stress.destroyed),
+         atomic_load(&stress.queries), atomic_load(&stress.wrong_windows));
+
+  glps_wm_destroy(wm);
+  return atomic_load(&stress.created) == stress.cycles &&
+                 atomic_load(&stress.destroyed) == stress.cycles &&
+                 atomic_load(&stress.wrong_windows) == 0
+             ? EXIT_SUCCESS
+             : EXIT_FAILURE;
+}
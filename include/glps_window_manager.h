@@ -9,12 +9,56 @@
 
 #include "glps_common.h"
 
+/*
+ * Threads
+ *
+ * The thread calling glps_wm_init owns the window manager: it dispatches
+ * events and is the only one creating, destroying or configuring windows,
+ * setting callbacks and using the Clipboard. Other threads hand such work to
+ * it with glps_wm_post_task; glps_wm_window_destroy does so by itself.
+ *
+ * On Wayland, any thread may call glps_wm_window_get_dimensions,
+ * glps_wm_window_get_framebuffer_size, glps_wm_window_get_frame_stats and
+ * glps_wm_get_fps at any time. They read snapshots the owning threads publish,
+ * without locking or waiting for them.
+ *
+ * A window rendered on its render thread is swapped, timed and has its frame
+ * statistics configured from that thread only. Input read by the input thread
+ * is dispatched by the owner. Every other thread must have stopped using the
+ * window manager before glps_wm_destroy.
+ */
+
 /**
  * @brief Initializes the GLPS Window Manager.
  * @return Pointer to the initialized GLPS Window Manager.
  */
 glps_WindowManager *glps_wm_init(void);
 
+/**
+ * @brief Sets the framebuffer format of windows created afterwards.
+ *
+ * The matching config is looked up once per descriptor and cached, so
+ * creating many windows with the same format doesn't query the driver again.
+ * Unless the driver supports EGL_KHR_no_config_context, windows created after
+ * the first one keep the first window's format.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param desc Requested format, see GLPS_SURFACE_DESC_DEFAULT.
+ */
+void glps_wm_set_surface_desc(glps_WindowManager *wm,
+                              const glps_SurfaceDesc *desc);
+
+/**
+ * @brief Sets the rendering context, created together with the first window.
+ *
+ * Allows OpenGL ES, compatibility profiles, debug and robust contexts, and
+ * no-error contexts that skip error checking in the driver.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param desc Requested context, see GLPS_CONTEXT_DESC_DEFAULT.
+ * @return false if the context was already created.
+ */
+bool glps_wm_set_context_desc(glps_WindowManager *wm,
+                              const glps_ContextDesc *desc);
+
 /**
  * @brief Creates a new window with the specified title and dimensions.
  * @param wm Pointer to the GLPS Window Manager.
@@ -27,7 +71,25 @@ size_t glps_wm_window_create(glps_WindowManager *wm, const char *title,
                              int width, int height);
 
 /**
- * @brief Gets dimensions of a window.
+ * @brief Creates a window drawn by the CPU instead of OpenGL.
+ *
+ * The window has no GL context; draw into the buffer returned by
+ * glps_wm_window_map_pixels and show it with glps_wm_window_present_pixels.
+ * Backed by wl_shm on Wayland and MIT-SHM on X11, not available on Win32.
+ * Present the first frame after creating it; each present asks for the next
+ * frame update.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param title Title of the new window.
+ * @param width Width of the new window in pixels.
+ * @param height Height of the new window in pixels.
+ * @return The ID of the created window.
+ */
+size_t glps_wm_window_create_software(glps_WindowManager *wm,
+                                      const char *title, int width,
+                                      int height);
+
+/**
+ * @brief Gets dimensions of a window. Safe from any thread on Wayland.
  * @param wm Pointer to the GLPS Window Manager.
  * @param window_id ID of the window to get dimensions of.
  * @param width Window width pointer.
@@ -37,7 +99,23 @@ void glps_wm_window_get_dimensions(glps_WindowManager *wm, size_t window_id,
                                    int *width, int *height);
 
 /**
- * @brief Allows user to set callback to handle window resize.
+ * @brief Gets the size of the buffers a window renders to, in pixels. On
+ * scaled Wayland outputs it differs from the window dimensions, which are in
+ * surface units, and below a render scale of 1 it is the scaled size. Safe
+ * from any thread on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param width Buffer width pointer.
+ * @param height Buffer height pointer.
+ */
+void glps_wm_window_get_framebuffer_size(glps_WindowManager *wm,
+                                         size_t window_id, int *width,
+                                         int *height);
+
+/**
+ * @brief Allows user to set callback to handle window resize. The callback gets
+ * the framebuffer size, which also changes with the output scale and the
+ * render scale.
  * @param wm Pointer to the GLPS Window Manager.
  * @param window_resize_callback user-set window resize callback.
  * @param data Additional data to pass to the callback.
@@ -69,6 +147,50 @@ void glps_wm_window_set_close_callback(
     glps_WindowManager *wm,
     void (*window_close_callback)(size_t window_id, void *data), void *data);
 
+/**
+ * @brief Sets the callback for refresh rate and scale changes of a window.
+ *
+ * Runs when the window moves to an output with another refresh rate or scale,
+ * or when its output changes mode. A window spanning several outputs follows
+ * the fastest refresh and the largest scale among them. Runs on the thread
+ * that renders the window. Only sent on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_output_callback Function to call with the refresh rate in Hz
+ * and the integer scale.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_window_set_output_callback(
+    glps_WindowManager *wm,
+    void (*window_output_callback)(size_t window_id, double refresh_hz,
+                                   int scale, void *data),
+    void *data);
+
+/**
+ * @brief Sets the callback for outputs being added, changed or removed.
+ *
+ * Outputs present at startup were announced before this can be set, list
+ * them with glps_wm_get_outputs. Only sent on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param output_callback Function to call with the output's properties.
+ * @param data Additional data to pass to the callback.
+ */
+void glps_wm_set_output_callback(
+    glps_WindowManager *wm,
+    void (*output_callback)(const glps_Output *output, GLPS_OUTPUT_EVENT event,
+                            void *data),
+    void *data);
+
+/**
+ * @brief Lists the outputs (monitors) with their mode, refresh and scale.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param outputs Receives up to max_outputs outputs, may be NULL to count.
+ * @param max_outputs Capacity of outputs.
+ * @return Number of outputs, which may exceed max_outputs. Always 0 outside
+ * Wayland.
+ */
+size_t glps_wm_get_outputs(glps_WindowManager *wm, glps_Output *outputs,
+                           size_t max_outputs);
+
 /**
  * @brief Sets the OpenGL context of a specific window as the current context.
  * @param wm Pointer to the GLPS Window Manager.
@@ -83,8 +205,183 @@ void glps_wm_set_window_ctx_curr(glps_WindowManager *wm, size_t window_id);
  */
 void glps_wm_swap_buffers(glps_WindowManager *wm, size_t window_id);
 
+/**
+ * @brief Maps the next buffer of a software window for drawing.
+ *
+ * The pixels are shared with the display server, nothing is copied when
+ * presenting. Buffers are reused between frames and only reallocated when the
+ * window size changes. Mapping again before presenting returns the same
+ * buffer.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of a window created with glps_wm_window_create_software.
+ * @return The buffer, with NULL pixels if the display server still reads
+ * every buffer; try again at the next frame update.
+ */
+glps_PixelBuffer glps_wm_window_map_pixels(glps_WindowManager *wm,
+                                           size_t window_id);
+
+/**
+ * @brief Presents the mapped buffer of a software window.
+ *
+ * Only the damaged rectangles are sent. The buffer's age tells which older
+ * frame it holds, so a damaged region has to be redrawn for `age` frames.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the software window.
+ * @param damage Rectangles changed in this frame, in buffer pixels; NULL
+ * damages the whole window.
+ * @param damage_count Number of rectangles in damage.
+ * @return false if no buffer was mapped.
+ */
+bool glps_wm_window_present_pixels(glps_WindowManager *wm, size_t window_id,
+                                   const glps_Rect *damage,
+                                   size_t damage_count);
+
+/**
+ * @brief Moves rendering of a window to a thread of its own.
+ *
+ * The thread owns a context sharing objects with the windows' context and
+ * keeps it current on the window. From then on the frame update, resize and
+ * input callbacks of this window run on that thread, frame updates that are
+ * still pending are coalesced, and glps_wm_swap_buffers is called from there.
+ * The close callback keeps running on the thread dispatching events, and
+ * glps_wm_set_window_ctx_curr must no longer be used for the window. Only
+ * implemented on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return true if the thread runs.
+ */
+bool glps_wm_window_start_render_thread(glps_WindowManager *wm,
+                                        size_t window_id);
+
+/**
+ * @brief Joins the render thread of a window, callbacks run on the
+ * dispatching thread again. Done by glps_wm_window_destroy as well.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ */
+void glps_wm_window_stop_render_thread(glps_WindowManager *wm,
+                                       size_t window_id);
+
+/**
+ * @brief Reads pointer, keyboard and touch events on a thread of their own.
+ *
+ * The events are timestamped as soon as they arrive, even while a frame is
+ * being rendered, and wait in a queue. Their callbacks still run on the
+ * thread dispatching events, from glps_wm_should_close,
+ * glps_wm_dispatch_events or glps_wm_dispatch_input. Only implemented on
+ * Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return true if the thread runs.
+ */
+bool glps_wm_start_input_thread(glps_WindowManager *wm);
+
+/**
+ * @brief Joins the input thread, after running the callbacks of the events
+ * it read. Done by glps_wm_destroy as well.
+ * @param wm Pointer to the GLPS Window Manager.
+ */
+void glps_wm_stop_input_thread(glps_WindowManager *wm);
+
+/**
+ * @brief Runs the callbacks of the input queued by the input thread, without
+ * waiting for more.
+ *
+ * Call it from the dispatching thread right before a frame samples input, so
+ * the frame sees the most recent events.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The number of events dispatched.
+ */
+size_t glps_wm_dispatch_input(glps_WindowManager *wm);
+
+/**
+ * @brief Runs a task on the thread owning the window manager.
+ *
+ * Called from the owner itself, the task runs right away. Otherwise it runs
+ * the next time the owner dispatches events, which it is woken up for.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param task Function to run, given the window manager and data.
+ * @param data User data passed to the task.
+ * @return false if the task couldn't be queued.
+ */
+bool glps_wm_post_task(glps_WindowManager *wm,
+                       void (*task)(glps_WindowManager *wm, void *data),
+                       void *data);
+
+/**
+ * @brief Creates a context sharing textures, buffers and shaders with the
+ * windows' context, for uploads and shader compiles on worker threads.
+ *
+ * Needs an existing window. The context is surfaceless where
+ * EGL_KHR_surfaceless_context is supported and bound to a 1x1 pbuffer
+ * otherwise. Implemented on Wayland and X11.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The new context, or NULL on failure.
+ */
+glps_SharedContext *glps_wm_create_shared_context(glps_WindowManager *wm);
+
+/**
+ * @brief Makes a shared context current on the calling thread.
+ *
+ * A context can only be current on one thread at a time.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param shared Context to bind, NULL to release the thread's context.
+ * @return true on success.
+ */
+bool glps_wm_make_shared_context_current(glps_WindowManager *wm,
+                                         glps_SharedContext *shared);
+
+/**
+ * @brief Destroys a shared context. Release it on its thread first.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param shared Context to destroy.
+ */
+void glps_wm_destroy_shared_context(glps_WindowManager *wm,
+                                    glps_SharedContext *shared);
+
+/**
+ * @brief Inserts a fence after the commands issued so far on the calling
+ * thread's context and flushes them.
+ *
+ * Hand the fence to the thread that uses the results, e.g. after uploading a
+ * texture, instead of calling glFinish. Requires EGL_KHR_fence_sync.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The fence, or NULL if fences are unsupported.
+ */
+glps_Fence glps_wm_fence_create(glps_WindowManager *wm);
+
+/**
+ * @brief Blocks the calling thread until a fence signaled.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param fence Fence to wait for.
+ * @param timeout_ns Longest wait, UINT64_MAX to wait indefinitely, 0 to poll.
+ * @return true if the fence signaled.
+ */
+bool glps_wm_fence_wait(glps_WindowManager *wm, glps_Fence fence,
+                        uint64_t timeout_ns);
+
+/**
+ * @brief Makes the GPU wait for a fence before executing commands issued
+ * afterwards on the calling thread's context, without blocking the thread.
+ *
+ * Falls back to glps_wm_fence_wait without EGL_KHR_wait_sync.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param fence Fence to wait for.
+ * @return true on success.
+ */
+bool glps_wm_fence_wait_gpu(glps_WindowManager *wm, glps_Fence fence);
+
+/**
+ * @brief Destroys a fence, signaled or not.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param fence Fence to destroy, NULL is ignored.
+ */
+void glps_wm_fence_destroy(glps_WindowManager *wm, glps_Fence fence);
+
 /**
  * @brief Sets the swap interval for buffer swaps.
+ *
+ * On X11 the frame update callback runs again after every swap, so the
+ * interval also paces it.
  * @param wm Pointer to the GLPS Window Manager.
  * @param swap_interval Number of vertical refreshes between buffer swaps.
  */
@@ -210,6 +507,23 @@ void glps_wm_set_touch_callback(
                            double minor, double orientation, void *data),
     void *data);
 
+/**
+ * @brief Sets the callback for raw pointer motion.
+ *
+ * Reports the unaccelerated motion of relative pointing devices, summed up
+ * once per dispatch, even when the pointer is stuck at a screen edge. It goes
+ * to the window under the pointer, or to the focused window when the pointer
+ * is elsewhere. Only sent on X11 with XInput 2.2.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param raw_motion_callback Function to call with the motion in device
+ * units.
+ */
+void glps_wm_set_raw_motion_callback(
+    glps_WindowManager *wm,
+    void (*raw_motion_callback)(size_t window_id, double dx, double dy,
+                                void *data),
+    void *data);
+
 /* ======= Clipboard ======= */
 /**
  * @brief Attaches data to Clipboard.
@@ -219,15 +533,178 @@ void glps_wm_set_touch_callback(
  */
 void glps_wm_attach_to_clipboard(glps_WindowManager *wm, char *mime,
                                  char *data);
+/**
+ * @brief Attaches a caller-owned buffer to the Clipboard without copying it.
+ *
+ * The buffer must stay valid and unchanged until the selection is replaced by
+ * another attach call or the window manager is destroyed.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime The mime type.
+ * @param data The data to attach to the Clipboard.
+ * @param size Size of the data in bytes.
+ * @return true if the selection was set.
+ */
+bool glps_wm_attach_buffer_to_clipboard(glps_WindowManager *wm,
+                                        const char *mime, const void *data,
+                                        size_t size);
+/**
+ * @brief Attaches the contents of a file descriptor to the Clipboard.
+ *
+ * The descriptor is duplicated, so the caller may close it. Its contents are
+ * spliced into the receiving client's pipe, which makes this the cheapest way
+ * to offer large data, e.g. from a memfd. Not available on Win32.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime The mime type.
+ * @param fd A descriptor sendfile can read from, such as a memfd or file.
+ * @param size Number of bytes to offer, 0 to offer the whole file.
+ * @return true if the selection was set.
+ */
+bool glps_wm_attach_fd_to_clipboard(glps_WindowManager *wm, const char *mime,
+                                    int fd, size_t size);
+/**
+ * @brief Offers several representations of the same content on the Clipboard.
+ *
+ * Nothing is serialized up front: each provider is only called when another
+ * client pastes its MIME type.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param providers The MIME types and their providers.
+ * @param count Number of providers, at most GLPS_MAX_CLIPBOARD_TYPES.
+ * @return true if the selection was set.
+ */
+bool glps_wm_attach_providers_to_clipboard(
+    glps_WindowManager *wm, const glps_ClipboardProvider *providers,
+    size_t count);
+/**
+ * @brief Lists the MIME types the current Clipboard content is offered in.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime_types Receives up to max types, valid until the selection
+ * changes.
+ * @param max Capacity of mime_types.
+ * @return Number of offered types, which may exceed max.
+ */
+size_t glps_wm_get_clipboard_mime_types(glps_WindowManager *wm,
+                                        const char **mime_types, size_t max);
+/**
+ * @brief Sets the default callback for asynchronous Clipboard requests.
+ *
+ * Used by glps_wm_request_from_clipboard when no callback is given.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param clipboard_callback Function to call with the NUL-terminated content,
+ * valid until the selection changes.
+ * @param data User data passed to the callback.
+ */
+void glps_wm_set_clipboard_callback(
+    glps_WindowManager *wm,
+    void (*clipboard_callback)(const char *mime, const char *buff, size_t size,
+                               void *data),
+    void *data);
 /**
  * @brief Gets data from clipboard.
+ *
+ * The selection is only read when asked for and cached until it changes. The
+ * first call after a change blocks until the source sent its data, use
+ * glps_wm_request_from_clipboard to avoid that.
  * @param wm Pointer to the GLPS Window Manager.
  * @param  data The data attached to the Clipboard.
  * @param data_size The size of the data buffer you're saving Clipboard content
- * to.
+ * to. Longer Clipboard content is truncated.
  */
 void glps_wm_get_from_clipboard(glps_WindowManager *wm, char *data,
                                 size_t data_size);
+/**
+ * @brief Requests the Clipboard content without blocking.
+ *
+ * The data is read from the event loop as it arrives, so a slow source never
+ * stalls rendering. The callback runs once it was fully read, right away if
+ * it is cached, and not at all if the selection changes first.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime MIME type to request, NULL for the preferred text type.
+ * @param clipboard_callback Function to call with the NUL-terminated content,
+ * valid until the selection changes. NULL uses the callback set with
+ * glps_wm_set_clipboard_callback.
+ * @param data User data passed to the callback.
+ * @return true if the Clipboard holds the requested type.
+ */
+bool glps_wm_request_from_clipboard(
+    glps_WindowManager *wm, const char *mime,
+    void (*clipboard_callback)(const char *mime, const char *buff, size_t size,
+                               void *data),
+    void *data);
+/**
+ * @brief Requests the Clipboard content and streams it into a descriptor.
+ *
+ * Meant for large selections: the data moves from the source into fd without
+ * being copied into memory or cached. fd is duplicated, the caller may close
+ * it right away.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime MIME type to request, NULL for the preferred text type.
+ * @param fd Descriptor to write to, e.g. an open file.
+ * @param clipboard_callback Function to call once everything was written, with
+ * a NULL buffer and the number of bytes written. NULL uses the callback set
+ * with glps_wm_set_clipboard_callback.
+ * @param data User data passed to the callback.
+ * @return true if the Clipboard holds the requested type.
+ */
+bool glps_wm_request_from_clipboard_to_fd(
+    glps_WindowManager *wm, const char *mime, int fd,
+    void (*clipboard_callback)(const char *mime, const char *buff, size_t size,
+                               void *data),
+    void *data);
+/**
+ * @brief Sets a callback for Clipboard changes.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param selection_callback Function to call whenever another selection was
+ * set, or it was cleared.
+ * @param data User data passed to the callback.
+ */
+void glps_wm_set_selection_callback(glps_WindowManager *wm,
+                                    void (*selection_callback)(void *data),
+                                    void *data);
+/**
+ * @brief Switches the Clipboard to clipboard manager mode.
+ *
+ * Uses the wlr-data-control protocol to follow and set the selection without
+ * keyboard focus or any window. Only available on Wayland compositors that
+ * implement it.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return true if clipboard manager mode is active.
+ */
+bool glps_wm_enable_data_control(glps_WindowManager *wm);
+/**
+ * @brief Waits for and dispatches events, including Clipboard transfers.
+ *
+ * Unlike glps_wm_should_close it returns after timeout_ms even if nothing
+ * happened, for clients without windows such as clipboard managers.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param timeout_ms Longest wait in milliseconds, negative waits indefinitely.
+ * @return false once the connection to the display failed.
+ */
+bool glps_wm_dispatch_events(glps_WindowManager *wm, int timeout_ms);
+
+/**
+ * @brief Returns the file descriptor of the display connection, for event
+ * loops that wait on their own descriptors too.
+ *
+ * When it is readable, call glps_wm_dispatch_events with a timeout of 0.
+ * Tasks posted from other threads and the input thread wake the Wayland
+ * loop through descriptors of their own, use a timeout there when relying on
+ * them.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The descriptor, or -1 on backends without one.
+ */
+int glps_wm_get_event_fd(glps_WindowManager *wm);
+/**
+ * @brief Gets the Clipboard content without copying it.
+ *
+ * Fetches the content like glps_wm_get_from_clipboard.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime MIME type to get, NULL for the preferred text type.
+ * @param size Receives the size of the content in bytes.
+ * @return The NUL-terminated content, valid until the selection changes, or
+ * NULL if nothing was received.
+ */
+const void *glps_wm_get_clipboard_data(glps_WindowManager *wm,
+                                       const char *mime, size_t *size);
 
 /* ======= Drag & Drop ======= */
 /**
@@ -246,10 +723,233 @@ void glps_wm_start_drag_n_drop(
     void (*drag_n_drop_callback)(size_t origin_window_id, char *mime,
                                  char *buff, void *data),
     void *data);
+/**
+ * @brief Sets the MIME types accepted for drops, in order of preference.
+ *
+ * A drag is accepted in the first of these types it offers and rejected if it
+ * offers none. The drag & drop callback receives the accepted type. By
+ * default plain text is accepted.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime_types The accepted types, copied.
+ * @param count Number of types, 0 to restore the default.
+ */
+void glps_wm_set_drag_n_drop_mime_types(glps_WindowManager *wm,
+                                        const char *const *mime_types,
+                                        size_t count);
+/**
+ * @brief Sets a callback for dropped files.
+ *
+ * Drops offering text/uri-list are then accepted as such, unless other types
+ * were set with glps_wm_set_drag_n_drop_mime_types, and reported as a list of
+ * decoded paths instead of through the drag & drop callback. The list is
+ * read as it arrives, whatever its size.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param map_files Memory-maps the dropped local files, so even very large
+ * ones can be read in place without copying. Ignored on Win32.
+ * @param drop_files_callback Function to call with the dropped files, valid
+ * until it returns.
+ * @param data User data passed to the callback.
+ */
+void glps_wm_set_drop_files_callback(
+    glps_WindowManager *wm, bool map_files,
+    void (*drop_files_callback)(size_t window_id,
+                                const glps_DroppedFile *files, size_t count,
+                                void *data),
+    void *data);
 
 /* ======= Utilities ======= */
+
+/**
+ * @brief Gets the frame-time statistics of a window.
+ *
+ * Frames are counted at every `glps_wm_swap_buffers` call (every
+ * `glps_wm_window_update` call on X11). Nothing is allocated. Safe from any
+ * thread on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return The statistics, zeroed if the window is invalid.
+ */
+glps_FrameStats glps_wm_window_get_frame_stats(glps_WindowManager *wm,
+                                               size_t window_id);
+
+/**
+ * @brief Sets the frame budget used to count over-budget frames.
+ *
+ * Clears the statistics window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param budget_ms Budget in milliseconds, or 0 to follow the refresh rate
+ * of the window's output. Defaults to one refresh period once the output is
+ * known, 1000 / 60 until then.
+ */
+void glps_wm_window_set_frame_budget(glps_WindowManager *wm, size_t window_id,
+                                     double budget_ms);
+
+/**
+ * @brief Sets how many recent frames the windowed statistics cover.
+ *
+ * Clears the statistics window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param frames Number of frames, clamped to `GLPS_FRAME_STATS_HISTORY`.
+ * Defaults to 120.
+ */
+void glps_wm_window_set_frame_stats_window(glps_WindowManager *wm,
+                                           size_t window_id, size_t frames);
+
+/**
+ * @brief Enables or disables GPU frame timing for a window.
+ *
+ * When enabled, each frame is wrapped in a GL_TIME_ELAPSED query from one
+ * `glps_wm_swap_buffers` call to the next. Results are read back a few frames
+ * later without stalling, and are reported in the `gpu_` fields of
+ * `glps_wm_window_get_frame_stats`. Windows sharing a context are each timed
+ * from glps_wm_set_window_ctx_curr to their swap; a query another window's
+ * frame cuts into is left out rather than misreported. Requires a context with
+ * timer queries (OpenGL 3.3 or ARB_timer_query), which includes Mesa llvmpipe.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param enabled Whether to time frames. Disabled by default.
+ */
+void glps_wm_window_set_gpu_timing(glps_WindowManager *wm, size_t window_id,
+                                   bool enabled);
+
+/**
+ * @brief Gets the input-to-photon latency statistics of a window.
+ *
+ * On Wayland, input events carry the compositor's event time and frames that
+ * show them are followed with presentation feedback, so samples end when the
+ * frame reaches the screen. Elsewhere, or when the compositor lacks
+ * presentation-time support, samples end at buffer submission.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return The statistics, zeroed if the window is invalid.
+ */
+glps_LatencyStats glps_wm_window_get_latency_stats(glps_WindowManager *wm,
+                                                   size_t window_id);
+
+/**
+ * @brief Clears the latency statistics of a window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ */
+void glps_wm_window_reset_latency_stats(glps_WindowManager *wm,
+                                        size_t window_id);
+
+/**
+ * @brief Marks a synthetic input event on a window at the current time.
+ *
+ * The next presented frame closes a latency sample, as for a real event. Use
+ * it for input sources GLPS doesn't see, or to benchmark the present path
+ * against a headless compositor.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ */
+void glps_wm_window_mark_input(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Gets the timestamps of the input event being dispatched.
+ *
+ * Only meaningful from inside an input callback.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The event timestamps, zeroed if no event has been received.
+ */
+glps_InputTimestamp glps_wm_get_input_timestamp(glps_WindowManager *wm);
+
+/**
+ * @brief Gets the device that sent the input event being dispatched.
+ *
+ * Only meaningful from inside a pointer, scroll or touch callback. Devices
+ * are told apart on X11 with XInput 2.2, where the ID is the XInput2 ID of
+ * the physical device.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The device, zeroed when the backend doesn't tell.
+ */
+glps_InputDevice glps_wm_get_input_device(glps_WindowManager *wm);
+
+/**
+ * @brief Gets the mean frame rate of a window. Safe from any thread on
+ * Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return `mean_fps` from `glps_wm_window_get_frame_stats`.
+ */
 double glps_wm_get_fps(glps_WindowManager *wm, size_t window_id);
 
+/**
+ * @brief Gets the refresh rate of the output showing a window. Safe from any
+ * thread on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return Refresh rate in Hz, 0 until the window is shown or outside Wayland.
+ */
+double glps_wm_window_get_refresh_rate(glps_WindowManager *wm,
+                                       size_t window_id);
+
+/**
+ * @brief Gets the integer scale of the output showing a window. Safe from any
+ * thread on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return The scale, 1 if unknown.
+ */
+int glps_wm_window_get_scale(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Renders a window at a fraction of its device pixels and upscales it,
+ * trading sharpness for frame time. The window gets a resize callback with the
+ * smaller framebuffer size. Wayland lets the compositor scale through
+ * wp_viewporter; elsewhere frames after the next swap draw into an offscreen
+ * framebuffer blitted to the window at each swap, see
+ * glps_wm_window_get_framebuffer. Ignored for software windows outside
+ * Wayland. Safe from any thread on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param render_scale Fraction of the device pixels, clamped to [0.1, 1].
+ */
+void glps_wm_window_set_render_scale(glps_WindowManager *wm, size_t window_id,
+                                     double render_scale);
+
+/**
+ * @brief Gets the render scale of a window. Safe from any thread on Wayland.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return The render scale, 1 at full resolution.
+ */
+double glps_wm_window_get_render_scale(glps_WindowManager *wm,
+                                       size_t window_id);
+
+/**
+ * @brief Lets GLPS pick the render scale of a window from its frame times.
+ * The scale drops when frames miss the frame budget or the GPU time nears it,
+ * and rises in small steps after a run of frames with headroom, waiting longer
+ * each time a rise had to be undone. Each change goes through
+ * glps_wm_window_set_render_scale, so the resize callback and
+ * glps_wm_window_get_render_scale tell the application when to draw text and
+ * UI at full resolution separately, keeping them crisp. Meant for windows that
+ * draw continuously; enable GPU timing to scale before frames are missed.
+ * Call it from the thread rendering the window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @param enabled Whether to adapt the scale. Disabling restores a scale of 1.
+ * @param min_scale Lowest scale picked, at least 0.1.
+ * @param max_scale Highest scale picked, at most 1.
+ */
+void glps_wm_window_set_dynamic_resolution(glps_WindowManager *wm,
+                                           size_t window_id, bool enabled,
+                                           double min_scale, double max_scale);
+
+/**
+ * @brief Gets the framebuffer the current frame of a window draws into, to
+ * bind instead of 0. It is an offscreen framebuffer below a render scale of 1
+ * outside Wayland, and 0 otherwise.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return The framebuffer object name.
+ */
+unsigned int glps_wm_window_get_framebuffer(glps_WindowManager *wm,
+                                            size_t window_id);
+
 void *glps_get_proc_addr(const char *name) ;
 
 #endif // GLPS_WINDOW_MANAGER_H
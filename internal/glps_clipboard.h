@@ -0,0 +1,57 @@
+#ifndef GLPS_CLIPBOARD_H
+#define GLPS_CLIPBOARD_H
+
+#include "glps_common.h"
+
+/** Initial allocation of a receive buffer, doubled as data arrives. */
+#define GLPS_CLIPBOARD_INITIAL_CAPACITY 4096
+
+/** Longest pause of a source before a blocking fetch gives up. */
+#define GLPS_CLIPBOARD_FETCH_TIMEOUT_MS 5000
+
+/** Bytes read per wakeup, so a fast source can't starve the event loop. */
+#define GLPS_CLIPBOARD_READ_BUDGET (1024 * 1024)
+
+/** Bytes written per wakeup, for the same reason. */
+#define GLPS_CLIPBOARD_WRITE_BUDGET (1024 * 1024)
+
+void glps_clipboard_source_init(glps_ClipboardSource *source);
+bool glps_clipboard_source_copy(glps_ClipboardSource *source, const char *mime,
+                                const void *data, size_t size);
+bool glps_clipboard_source_set_buffer(glps_ClipboardSource *source,
+                                      const char *mime, const void *data,
+                                      size_t size);
+bool glps_clipboard_source_set_fd(glps_ClipboardSource *source,
+                                  const char *mime, int fd, size_t size);
+bool glps_clipboard_source_set_provider(glps_ClipboardSource *source,
+                                        const char *mime,
+                                        glps_ClipboardProviderFn provider,
+                                        void *data);
+bool glps_clipboard_send_begin(glps_ClipboardSend *send,
+                               const glps_ClipboardSource *source,
+                               const char *mime, int fd);
+int glps_clipboard_send_some(glps_ClipboardSend *send);
+void glps_clipboard_send_end(glps_ClipboardSend *send);
+bool glps_clipboard_source_read(const glps_ClipboardSource *source,
+                                const char *mime,
+                                glps_ClipboardBuffer *buffer);
+void glps_clipboard_source_release(glps_ClipboardSource *source);
+void glps_clipboard_sources_release(glps_ClipboardSource *sources,
+                                    size_t count);
+
+int glps_clipboard_buffer_read_some(glps_ClipboardBuffer *buffer, int fd);
+int glps_clipboard_splice_some(int fd, int out_fd, size_t *written);
+bool glps_clipboard_buffer_write(const glps_ClipboardBuffer *buffer, int fd);
+/**
+ * @brief Splits a text/uri-list in place and decodes local file URIs.
+ * @return Entries pointing into list, released with free(), or NULL.
+ */
+glps_DroppedFile *glps_clipboard_parse_uri_list(char *list, size_t size,
+                                                size_t *count);
+void glps_clipboard_map_files(glps_DroppedFile *files, size_t count);
+void glps_clipboard_unmap_files(glps_DroppedFile *files, size_t count);
+
+void glps_clipboard_buffer_clear(glps_ClipboardBuffer *buffer);
+void glps_clipboard_buffer_free(glps_ClipboardBuffer *buffer);
+
+#endif
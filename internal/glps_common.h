@@ -18,6 +18,8 @@
 #include <unistd.h>
 
 #include "utils/logger/pico_logger.h"
+#include "utils/profiler/pico_profiler.h"
+#include "utils/profiler/pico_trace.h"
 #include <stdlib.h>
 
 // Windows
@@ -29,12 +31,16 @@
 
 // Wayland
 #ifdef GLPS_USE_WAYLAND
+#include "xdg/fractional-scale-v1.h"
+#include "xdg/presentation-time.h"
+#include "xdg/viewporter.h"
 #include "xdg/wlr-data-control-unstable-v1.h"
 #include "xdg/xdg-decorations.h"
 #include "xdg/xdg-dialog.h"
 #include "xdg/xdg-shell.h"
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
+#include <pthread.h>
 #include <sys/mman.h>
 #include <wayland-client-protocol.h>
 #include <wayland-client.h>
@@ -43,9 +49,18 @@
 #endif
 
 #ifdef GLPS_USE_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <X11/X.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
+#include <xcb/xcb.h>
+#ifdef GLPS_HAVE_XINPUT2
+#include <xcb/xinput.h>
+#endif
+#ifdef GLPS_HAVE_XCB_SHM
+#include <xcb/shm.h>
+#endif
 #endif
 
 #define MAX_WINDOWS 100
@@ -59,8 +74,213 @@ typedef struct
   char title[64]; /**< Title of the window. */
   int width;
   int height;
+  int refresh_mhz; /**< Fastest refresh of the outputs showing the window,
+                        in mHz, 0 if unknown. */
+  int scale;       /**< Largest scale of those outputs, 0 if unknown. */
+  int buffer_width;    /**< Size of the buffers rendered to, in pixels. */
+  int buffer_height;
+  double render_scale; /**< Fraction of the device pixels rendered. */
 } glps_WindowProperties;
 
+#define GLPS_FRAME_STATS_HISTORY 512 /**< Maximum frames kept per window. */
+#define GLPS_FRAME_STATS_BUCKETS 16  /**< Frame-time histogram buckets. */
+#define GLPS_FRAME_STATS_BUCKET_MS 4 /**< Width of a histogram bucket in ms. */
+
+/**
+ * @struct glps_FrameStats
+ * @brief Frame-time statistics of a window.
+ *
+ * Fields prefixed with `window_`, the histogram, the mean and the percentiles
+ * cover the most recent frames, up to the configured statistics window.
+ * Histogram bucket `i` counts frames that took
+ * `[i * GLPS_FRAME_STATS_BUCKET_MS, (i + 1) * GLPS_FRAME_STATS_BUCKET_MS)` ms;
+ * the last bucket also holds every longer frame.
+ */
+typedef struct
+{
+  uint64_t frame_count;       /**< Frames presented since creation. */
+  uint64_t over_budget_count; /**< Frames over budget since creation. */
+  double budget_ms;           /**< Frame budget in milliseconds. */
+  double last_frame_ms;       /**< Duration of the most recent frame. */
+  double mean_frame_ms;       /**< Mean frame time over the window. */
+  double mean_fps;            /**< Mean frame rate over the window. */
+  double min_frame_ms;        /**< Shortest frame in the window. */
+  double max_frame_ms;        /**< Longest frame in the window. */
+  double p50_frame_ms;        /**< Median frame time in the window. */
+  double p90_frame_ms;        /**< 90th percentile frame time in the window. */
+  double p99_frame_ms;        /**< 99th percentile frame time in the window. */
+  uint32_t window_frames;     /**< Frames in the window. */
+  uint32_t window_over_budget; /**< Frames over budget in the window. */
+  uint32_t histogram[GLPS_FRAME_STATS_BUCKETS]; /**< Frame-time histogram. */
+  uint64_t gpu_frame_count;   /**< Frames timed on the GPU since creation. */
+  uint32_t window_gpu_frames; /**< GPU-timed frames in the window. */
+  double last_gpu_ms;         /**< GPU time of the most recent timed frame. */
+  double mean_gpu_ms;         /**< Mean GPU frame time over the window. */
+  double max_gpu_ms;          /**< Longest GPU frame time in the window. */
+  double p99_gpu_ms;          /**< 99th percentile GPU frame time. */
+  double refresh_hz; /**< Refresh of the window's output, 0 if unknown. */
+} glps_FrameStats;
+
+/**
+ * @struct glps_FrameStatsTracker
+ * @brief Per-window ring of frame times backing `glps_FrameStats`.
+ */
+typedef struct
+{
+  uint64_t last_frame_ns; /**< Timestamp of the previous frame, 0 if none. */
+  float frame_ms[GLPS_FRAME_STATS_HISTORY]; /**< Ring of frame times. */
+  uint32_t head;          /**< Next slot to write. */
+  uint32_t count;         /**< Frames currently in the ring. */
+  uint32_t window;        /**< Statistics window in frames. */
+  uint32_t window_over_budget;
+  uint32_t histogram[GLPS_FRAME_STATS_BUCKETS];
+  uint64_t frame_count;
+  uint64_t over_budget_count;
+  double budget_ms;
+  float gpu_ms[GLPS_FRAME_STATS_HISTORY]; /**< Ring of GPU frame times. */
+  uint32_t gpu_head;
+  uint32_t gpu_count;
+  uint64_t gpu_frame_count;
+  double refresh_hz; /**< Refresh of the window's output, 0 if unknown. */
+  bool budget_set;   /**< Budget set by the user rather than the refresh. */
+} glps_FrameStatsTracker;
+
+/**
+ * @struct glps_ResolutionController
+ * @brief Adapts the render scale of a window to its measured frame times.
+ *
+ * Frames are judged in periods. The scale drops when a period misses the
+ * budget and rises again only after a run of periods with headroom; that run
+ * doubles each time a rise had to be undone, so a window whose load sits at
+ * the edge settles instead of oscillating.
+ */
+typedef struct
+{
+  bool enabled;
+  double min_scale;
+  double max_scale;
+  double scale;           /**< Scale last chosen. */
+  uint64_t frames_seen;   /**< frame_count of the tracker already judged. */
+  uint64_t gpu_seen;      /**< gpu_frame_count already judged. */
+  uint32_t frames;        /**< Frames in the current period. */
+  uint32_t missed;        /**< Of those, frames well over budget. */
+  uint32_t gpu_frames;    /**< GPU-timed frames in the current period. */
+  double gpu_ms;          /**< Their summed GPU time. */
+  uint32_t cooldown;      /**< Periods ignored after a change. */
+  uint32_t calm;          /**< Consecutive periods with headroom. */
+  uint32_t upscale_delay; /**< Calm periods needed before scaling up. */
+  bool upscaled;          /**< The last change raised the scale. */
+} glps_ResolutionController;
+
+/**
+ * @struct glps_ScaledFramebuffer
+ * @brief Offscreen target rendered at the render scale and blitted to the
+ * window at swap, where the compositor can't scale the window's buffers.
+ */
+typedef struct
+{
+  uint32_t framebuffer;   /**< Framebuffer object, 0 until created. */
+  uint32_t color;         /**< Color renderbuffer. */
+  uint32_t depth_stencil; /**< Depth and stencil renderbuffer. */
+  int width;
+  int height;
+  bool bound;       /**< The frame being drawn renders into it. */
+  bool unsupported; /**< No framebuffer blits, or a multisampled window. */
+} glps_ScaledFramebuffer;
+
+#define GLPS_GPU_TIMER_QUERIES 6 /**< Timer queries per window, i.e. how many
+                                    frames a result may lag behind. */
+
+/**
+ * @struct glps_GpuTimer
+ * @brief Ring of GL_TIME_ELAPSED queries measuring a window's GPU frame time.
+ */
+typedef struct
+{
+  bool enabled;     /**< Timing requested by the application. */
+  bool initialized; /**< Query objects exist in the current context. */
+  bool active;      /**< A query is open. */
+  uint32_t queries[GLPS_GPU_TIMER_QUERIES]; /**< Query object names. */
+  bool discarded[GLPS_GPU_TIMER_QUERIES];  /**< Query cut short by another
+                                              window, its result unused. */
+  uint32_t head;    /**< Next query to begin. */
+  uint32_t tail;    /**< Oldest query not read back. */
+  uint32_t in_use;  /**< Queries open or awaiting read back. */
+} glps_GpuTimer;
+
+#define GLPS_LATENCY_HISTORY 256      /**< Latency samples kept per window. */
+#define GLPS_LATENCY_BUCKETS 32       /**< Latency histogram buckets. */
+#define GLPS_LATENCY_BUCKET_MS 4      /**< Width of a histogram bucket in ms. */
+#define GLPS_LATENCY_MAX_IN_FLIGHT 4  /**< Frames awaiting feedback per window. */
+
+/**
+ * @struct glps_InputTimestamp
+ * @brief Timestamps of the input event being dispatched.
+ */
+typedef struct
+{
+  uint32_t time_ms;    /**< Compositor/server event time in ms, 0 if none. */
+  uint64_t receive_ns; /**< Local time the event was read, on the monotonic
+                          clock used for presentation timestamps. */
+} glps_InputTimestamp;
+
+/**
+ * @struct glps_InputDevice
+ * @brief Device that sent the input event being dispatched.
+ */
+typedef struct
+{
+  uint32_t id;   /**< Backend device ID, 0 if the backend doesn't tell. */
+  char name[64]; /**< Device name, empty if unknown. */
+} glps_InputDevice;
+
+/**
+ * @struct glps_LatencyStats
+ * @brief Input-to-photon latency of a window.
+ *
+ * A sample is taken for every presented frame that follows at least one input
+ * event, and measures from the oldest such event to the moment the frame was
+ * presented. When the compositor doesn't support presentation feedback, the
+ * sample ends when the frame is submitted instead. Percentiles, the mean and
+ * the histogram cover the last `GLPS_LATENCY_HISTORY` samples; histogram
+ * bucket `i` counts samples in
+ * `[i * GLPS_LATENCY_BUCKET_MS, (i + 1) * GLPS_LATENCY_BUCKET_MS)` ms.
+ */
+typedef struct
+{
+  uint64_t sample_count;      /**< Samples since creation or reset. */
+  uint64_t discarded_count;   /**< Frames carrying input that were never shown. */
+  bool presentation_feedback; /**< Whether the last sample ended at presentation. */
+  double last_ms;             /**< Most recent latency. */
+  double mean_ms;             /**< Mean latency. */
+  double min_ms;              /**< Lowest latency. */
+  double max_ms;              /**< Highest latency. */
+  double p50_ms;              /**< Median latency. */
+  double p90_ms;              /**< 90th percentile latency. */
+  double p99_ms;              /**< 99th percentile latency. */
+  double mean_dispatch_ms;    /**< Mean delay between event time and receipt. */
+  uint32_t window_samples;    /**< Samples covered by the fields above. */
+  uint32_t histogram[GLPS_LATENCY_BUCKETS]; /**< Latency histogram. */
+} glps_LatencyStats;
+
+/**
+ * @struct glps_LatencyTracker
+ * @brief Per-window ring of latency samples backing `glps_LatencyStats`.
+ */
+typedef struct
+{
+  uint64_t pending_input_ns;   /**< Oldest input not yet in a frame, 0 if none. */
+  uint64_t pending_receive_ns; /**< Receive time of that input. */
+  float latency_ms[GLPS_LATENCY_HISTORY]; /**< Ring of latencies. */
+  float dispatch_ms[GLPS_LATENCY_HISTORY]; /**< Ring of dispatch delays. */
+  uint32_t head;               /**< Next slot to write. */
+  uint32_t count;              /**< Samples currently in the ring. */
+  uint32_t histogram[GLPS_LATENCY_BUCKETS];
+  uint64_t sample_count;
+  uint64_t discarded_count;
+  bool presented;
+} glps_LatencyTracker;
+
 /**
  * @enum GLPS_SCROLL_AXES
  * @brief Scroll axis definitions.
@@ -84,6 +304,217 @@ typedef enum
   GLPS_SCROLL_SOURCE_OTHER       /**< Other scroll source. */
 } GLPS_SCROLL_SOURCE;
 
+/**
+ * @enum GLPS_CONTEXT_API
+ * @brief Client API of the rendering context.
+ */
+typedef enum
+{
+  GLPS_CONTEXT_API_OPENGL,    /**< Desktop OpenGL. */
+  GLPS_CONTEXT_API_OPENGL_ES, /**< OpenGL ES. */
+} GLPS_CONTEXT_API;
+
+/**
+ * @struct glps_SurfaceDesc
+ * @brief Framebuffer format requested for window surfaces.
+ */
+typedef struct
+{
+  int red_bits;     /**< Bits of the red channel. */
+  int green_bits;   /**< Bits of the green channel. */
+  int blue_bits;    /**< Bits of the blue channel. */
+  int alpha_bits;   /**< Bits of the alpha channel, 0 for opaque. */
+  int depth_bits;   /**< Bits of the depth buffer, 0 for none. */
+  int stencil_bits; /**< Bits of the stencil buffer, 0 for none. */
+  int samples;      /**< MSAA samples per pixel, 0 to disable. */
+  bool srgb;        /**< sRGB-encoded color buffer, if supported. */
+} glps_SurfaceDesc;
+
+/**
+ * @struct glps_ContextDesc
+ * @brief Rendering context requested for all windows.
+ */
+typedef struct
+{
+  GLPS_CONTEXT_API api; /**< OpenGL or OpenGL ES. */
+  int major;            /**< Major version. */
+  int minor;            /**< Minor version. */
+  bool core_profile;    /**< Core instead of compatibility profile, GL only. */
+  bool debug;           /**< Debug context. */
+  bool robust;          /**< Robust buffer access. */
+  bool no_error;        /**< No error reporting, for lower driver overhead.
+                             Ignored with debug or robust, or if the driver
+                             lacks EGL_KHR_create_context_no_error. */
+} glps_ContextDesc;
+
+/** Format used unless glps_wm_set_surface_desc was called. */
+#define GLPS_SURFACE_DESC_DEFAULT                                              \
+  ((glps_SurfaceDesc){.red_bits = 8, .green_bits = 8, .blue_bits = 8,          \
+                      .alpha_bits = 8})
+
+/** Context used unless glps_wm_set_context_desc was called. */
+#define GLPS_CONTEXT_DESC_DEFAULT                                              \
+  ((glps_ContextDesc){.api = GLPS_CONTEXT_API_OPENGL, .major = 4, .minor = 5,  \
+                      .core_profile = true})
+
+/** Additional context sharing objects with the windows' context. */
+typedef struct glps_SharedContext glps_SharedContext;
+
+/** GPU fence for handing resources between contexts, NULL if invalid. */
+typedef void *glps_Fence;
+
+/**
+ * @struct glps_Rect
+ * @brief Rectangle in window pixels, from the top-left corner.
+ */
+typedef struct
+{
+  int x;
+  int y;
+  int width;
+  int height;
+} glps_Rect;
+
+/**
+ * @struct glps_PixelBuffer
+ * @brief CPU-writable framebuffer of a software window.
+ *
+ * Pixels are 32-bit 0xXXRRGGBB in native byte order, the top byte ignored.
+ */
+typedef struct
+{
+  uint32_t *pixels; /**< Top-left pixel, NULL if no buffer is free. */
+  int width;        /**< Width in pixels. */
+  int height;       /**< Height in pixels. */
+  int stride;       /**< Pixels from the start of one row to the next. */
+  int age; /**< Frames since these contents were presented: 1 if the buffer
+                holds the previous frame, 0 if its contents are undefined. */
+} glps_PixelBuffer;
+
+#define GLPS_SHM_BUFFERS 2 /**< Buffers a software window alternates. */
+
+/**
+ * @struct glps_DroppedFile
+ * @brief One entry of a dropped text/uri-list.
+ *
+ * Local files can be memory-mapped, so large files are processed in place
+ * without being copied. Everything stays valid until the callback returns.
+ */
+typedef struct
+{
+  const char *uri;  /**< URI as dropped. */
+  const char *path; /**< Decoded local path, NULL for remote URIs. */
+  const void *data; /**< Mapped file content, NULL if not mapped. */
+  size_t size;      /**< Size of the mapped file in bytes. */
+} glps_DroppedFile;
+
+/**
+ * @struct glps_Output
+ * @brief A monitor and its current mode.
+ */
+typedef struct
+{
+  uint32_t id;             /**< Stays the same while the output exists. */
+  char name[64];           /**< Connector name such as "DP-1", may be empty. */
+  char description[128];   /**< Human-readable, or make and model. */
+  int x;                   /**< Position in the compositor's space. */
+  int y;
+  int width;               /**< Current mode in pixels. */
+  int height;
+  int refresh_mhz;         /**< Refresh of the current mode in mHz. */
+  int scale;               /**< Integer scale factor of the output. */
+  int physical_width_mm;   /**< Physical size, 0 if unknown. */
+  int physical_height_mm;
+} glps_Output;
+
+/**
+ * @enum GLPS_OUTPUT_EVENT
+ * @brief What happened to an output.
+ */
+typedef enum
+{
+  GLPS_OUTPUT_ADDED,   /**< Output appeared, its properties are complete. */
+  GLPS_OUTPUT_CHANGED, /**< Mode, scale or position changed. */
+  GLPS_OUTPUT_REMOVED, /**< Output is gone, last known properties. */
+} GLPS_OUTPUT_EVENT;
+
+/**
+ * @enum GLPS_WINDOW_EVENT_TYPE
+ * @brief Kinds of window events handed to a render thread.
+ */
+typedef enum
+{
+  GLPS_WINDOW_EVENT_FRAME,          /**< Time to draw the next frame. */
+  GLPS_WINDOW_EVENT_RESIZE,         /**< Window was resized. */
+  GLPS_WINDOW_EVENT_MOUSE_ENTER,    /**< Pointer entered the window. */
+  GLPS_WINDOW_EVENT_MOUSE_LEAVE,    /**< Pointer left the window. */
+  GLPS_WINDOW_EVENT_MOUSE_MOVE,     /**< Pointer moved. */
+  GLPS_WINDOW_EVENT_MOUSE_CLICK,    /**< Pointer button changed state. */
+  GLPS_WINDOW_EVENT_MOUSE_SCROLL,   /**< Scroll on one axis. */
+  GLPS_WINDOW_EVENT_KEYBOARD_ENTER, /**< Window gained keyboard focus. */
+  GLPS_WINDOW_EVENT_KEYBOARD_LEAVE, /**< Window lost keyboard focus. */
+  GLPS_WINDOW_EVENT_KEY,            /**< Key pressed or released. */
+  GLPS_WINDOW_EVENT_TOUCH,          /**< Touch point changed. */
+  GLPS_WINDOW_EVENT_OUTPUT, /**< Refresh or scale of the window changed. */
+} GLPS_WINDOW_EVENT_TYPE;
+
+/**
+ * @struct glps_WindowEvent
+ * @brief A window callback invocation, recorded so it can run on another
+ * thread.
+ */
+typedef struct
+{
+  GLPS_WINDOW_EVENT_TYPE type;   /**< Which callback to run. */
+  size_t window_id;              /**< Window the event is for. */
+  glps_InputTimestamp timestamp; /**< Input events only, zero otherwise. */
+  union
+  {
+    struct
+    {
+      int width, height; /**< Buffer size, what the callback reports. */
+      int logical_width, logical_height; /**< Surface size. */
+      int buffer_scale; /**< Integer scale, 1 if the viewport scales. */
+    } resize;
+    struct
+    {
+      double x, y;
+    } pointer; /**< Mouse enter and move. */
+    struct
+    {
+      bool state;
+    } click;
+    struct
+    {
+      GLPS_SCROLL_AXES axis;
+      GLPS_SCROLL_SOURCE source;
+      double value;
+      int discrete;
+      bool is_stopped;
+    } scroll;
+    struct
+    {
+      bool state;
+      char value[64]; /**< UTF-8 text of the key, or its name. */
+    } key;
+    struct
+    {
+      int id;
+      double x, y;
+      bool state;
+      double major, minor, orientation;
+    } touch;
+    struct
+    {
+      int refresh_mhz;
+      int scale;
+    } output;
+  };
+} glps_WindowEvent;
+
+/** Thread rendering one window, see glps_wm_window_start_render_thread. */
+typedef struct glps_RenderThread glps_RenderThread;
+
 struct glps_Callback
 {
   void (*keyboard_enter_callback)(
@@ -108,9 +539,20 @@ struct glps_Callback
                          double touch_y, bool state, double major, double minor,
                          double orientation,
                          void *data); /**< Callback for touch events. */
+  void (*raw_motion_callback)(
+      size_t window_id, double dx, double dy,
+      void *data); /**< Callback for unaccelerated pointer motion. */
   void (*drag_n_drop_callback)(
       size_t window_id, char *mime, char *buff,
       void *data); /**< Callback for drag & drop events. */
+  void (*clipboard_callback)(
+      const char *mime, const char *buff, size_t size,
+      void *data); /**< Callback for received clipboard content. */
+  void (*selection_callback)(
+      void *data); /**< Callback for clipboard selection changes. */
+  void (*drop_files_callback)(size_t window_id, const glps_DroppedFile *files,
+                              size_t count,
+                              void *data); /**< Callback for dropped files. */
   void (*window_resize_callback)(
       size_t window_id, int width, int height,
       void *data); /**< Callback for resize events. */
@@ -118,6 +560,11 @@ struct glps_Callback
       size_t window_id, void *data); /**< Callback for window close event. */
   void (*window_frame_update_callback)(
       size_t window_id, void *data); /**< Callback for window update event. */
+  void (*window_output_callback)(
+      size_t window_id, double refresh_hz, int scale,
+      void *data); /**< Callback for refresh and scale changes of a window. */
+  void (*output_callback)(const glps_Output *output, GLPS_OUTPUT_EVENT event,
+                          void *data); /**< Callback for output changes. */
 
   void *mouse_enter_data;
   void *mouse_leave_data;
@@ -128,12 +575,85 @@ struct glps_Callback
   void *keyboard_leave_data;
   void *keyboard_data;
   void *touch_data;
+  void *raw_motion_data;
   void *drag_n_drop_data;
+  void *clipboard_data;
+  void *selection_data;
+  void *drop_files_data;
   void *window_resize_data;
   void *window_frame_update_data;
   void *window_close_data;
+  void *window_output_data;
+  void *output_data;
 };
 
+#define GLPS_MAX_CLIPBOARD_TYPES 8
+
+/**
+ * @brief Produces one representation of the Clipboard content on demand.
+ *
+ * Called only when another client asks for that MIME type. The returned
+ * buffer must stay valid until the provider is called again or the selection
+ * is replaced.
+ */
+typedef bool (*glps_ClipboardProviderFn)(const char *mime, const void **buff,
+                                         size_t *size, void *data);
+
+/**
+ * @struct glps_ClipboardProvider
+ * @brief A MIME type offered on the Clipboard and its provider.
+ */
+typedef struct
+{
+  const char *mime;                  /**< MIME type to offer. */
+  glps_ClipboardProviderFn provider; /**< Serializes the data lazily. */
+  void *data;                        /**< User data passed to provider. */
+} glps_ClipboardProvider;
+
+/**
+ * @struct glps_ClipboardSource
+ * @brief One representation of the data this client offers as the selection.
+ *
+ * Either backed by a file descriptor (a memfd or a caller's file),
+ * which is spliced into the receiving pipe, by a caller-owned buffer that
+ * must stay valid until the selection is replaced, or by a provider.
+ */
+typedef struct
+{
+  char mime_type[64]; /**< MIME type offered to other clients. */
+  int fd;             /**< Descriptor holding the data, -1 if buffer-backed. */
+  const void *data;   /**< Caller-owned data, NULL if fd-backed. */
+  size_t size;        /**< Size of the data in bytes. */
+  glps_ClipboardProviderFn provider; /**< Provider, NULL if not lazy. */
+  void *provider_data;               /**< User data of the provider. */
+} glps_ClipboardSource;
+
+/**
+ * @struct glps_ClipboardSend
+ * @brief Selection being written to another client's pipe.
+ */
+typedef struct
+{
+  int fd;            /**< Non-blocking write end of the pipe. */
+  int source_fd;     /**< Duplicate of the source descriptor, -1 if none. */
+  const char *data;  /**< Data written from memory, NULL if fd-backed. */
+  bool owned;        /**< data is a copy freed with the send. */
+  bool bounce;       /**< source_fd is copied through a buffer. */
+  size_t size;       /**< Bytes to send. */
+  size_t offset;     /**< Bytes sent so far. */
+} glps_ClipboardSend;
+
+/**
+ * @struct glps_ClipboardBuffer
+ * @brief Growable, NUL-terminated buffer received data is read into.
+ */
+typedef struct
+{
+  char *data;      /**< Received bytes followed by a NUL terminator. */
+  size_t size;     /**< Number of bytes received. */
+  size_t capacity; /**< Allocated size of data. */
+} glps_ClipboardBuffer;
+
 #ifdef GLPS_USE_WAYLAND
 
 /**
@@ -219,16 +739,85 @@ struct touch_event
   size_t window_id;
 };
 
+/** 64-bit words a seqlock cell needs to hold a value of the given type. */
+#define GLPS_SEQLOCK_WORDS(type)                                               \
+  ((sizeof(type) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+
 /**
- * @struct glps_EGLContext
- * @brief EGL context for rendering.
+ * @struct glps_PropertiesCell
+ * @brief Window properties published for readers on any thread.
  */
 typedef struct
 {
-  EGLDisplay dpy; /**< EGL display. */
-  EGLContext ctx; /**< EGL context. */
-  EGLConfig conf; /**< EGL configuration. */
-} glps_EGLContext;
+  _Atomic uint32_t seq; /**< Odd while the dispatching thread writes. */
+  _Atomic uint64_t words[GLPS_SEQLOCK_WORDS(glps_WindowProperties)];
+} glps_PropertiesCell;
+
+/**
+ * @struct glps_FrameStatsCell
+ * @brief Frame-time statistics published for readers on any thread.
+ */
+typedef struct
+{
+  _Atomic uint32_t seq; /**< Odd while the rendering thread writes. */
+  _Atomic uint64_t words[GLPS_SEQLOCK_WORDS(glps_FrameStatsTracker)];
+} glps_FrameStatsCell;
+
+/**
+ * @struct glps_PresentationFeedback
+ * @brief Presentation feedback requested for a frame that carries input.
+ */
+typedef struct
+{
+  struct wp_presentation_feedback *feedback; /**< Pending feedback, NULL if
+                                                the slot is free. */
+  glps_LatencyTracker *latency; /**< Tracker of the owning window. */
+  pthread_mutex_t *latency_lock; /**< Guards the tracker. */
+  uint64_t input_ns;            /**< Oldest input shown by the frame. */
+  uint64_t receive_ns;          /**< Receive time of that input. */
+} glps_PresentationFeedback;
+
+/**
+ * @struct glps_WaylandShmBuffer
+ * @brief wl_shm buffer of a software window.
+ */
+typedef struct
+{
+  struct wl_buffer *buffer; /**< NULL until first mapped. */
+  uint32_t *pixels;         /**< Mapping of the buffer's memfd. */
+  size_t size;              /**< Bytes mapped. */
+  int width;
+  int height;
+  bool busy;      /**< Attached, the compositor hasn't released it yet. */
+  uint64_t frame; /**< Frame it was presented with, 0 if never. */
+} glps_WaylandShmBuffer;
+
+#define GLPS_MAX_OUTPUTS 16
+
+/**
+ * @struct glps_WaylandOutput
+ * @brief A bound wl_output and the properties it announced.
+ */
+typedef struct
+{
+  struct wl_output *wl_output;
+  glps_Output output;  /**< Properties as of the last done event. */
+  glps_Output pending; /**< Properties being announced. */
+  bool announced;      /**< The output callback was told it was added. */
+} glps_WaylandOutput;
+
+/**
+ * @struct glps_WaylandSurfaceScale
+ * @brief How buffers map to the surface. Set by the thread that commits, right
+ * before the commit attaching a buffer of the matching size.
+ */
+typedef struct
+{
+  int width;        /**< Viewport destination, the logical size. */
+  int height;
+  int buffer_scale; /**< Integer buffer scale, used without a viewport. */
+  bool dirty;       /**< Changed since the last commit. */
+} glps_WaylandSurfaceScale;
 
 /**
  * @struct glps_WaylandWindow
@@ -245,13 +834,87 @@ typedef struct
   glps_WindowProperties properties; /**< Window properties. */
   struct zxdg_toplevel_decoration_v1 *zxdg_toplevel_decoration;
   struct wl_callback *frame_callback;
-  // FPS COUNTER
-  struct timespec fps_start_time;
-  bool fps_is_init;
+  glps_FrameStatsTracker frame_stats; /**< Frame-time statistics. */
+  glps_LatencyTracker latency;        /**< Input-to-photon latency. */
+  glps_GpuTimer gpu_timer;            /**< GPU frame-time queries. */
+  glps_ResolutionController resolution; /**< Dynamic resolution. */
+  glps_PresentationFeedback
+      presentation_feedback[GLPS_LATENCY_MAX_IN_FLIGHT]; /**< In-flight
+                                                            feedback. */
   void *frame_args;
   uint32_t serial;
+  uint32_t handle; /**< Unlike its ID, never reused while the window lives. */
+  glps_RenderThread *render_thread; /**< NULL if rendered on the dispatch
+                                       thread. */
+  pthread_mutex_t latency_lock; /**< Input is marked on the dispatching
+                                   thread, frames on the rendering one. */
+  glps_PropertiesCell properties_cell;  /**< Published properties. */
+  glps_FrameStatsCell frame_stats_cell; /**< Published frame_stats. */
+  bool software; /**< Presented from shared memory, without EGL. */
+  glps_WaylandShmBuffer shm_buffers[GLPS_SHM_BUFFERS];
+  glps_WaylandShmBuffer *shm_mapped; /**< Handed out by map_pixels and not
+                                        presented yet, NULL if none. */
+  uint64_t shm_frame;                /**< Software frames presented. */
+  glps_WaylandOutput *outputs[GLPS_MAX_OUTPUTS]; /**< Outputs the surface
+                                                    entered. */
+  size_t output_count;
+  struct wp_viewport *viewport; /**< NULL without wp_viewporter. */
+  struct wp_fractional_scale_v1 *fractional_scale; /**< NULL without
+                                                      fractional scaling. */
+  uint32_t preferred_scale; /**< Fractional scale in 120ths, 0 until the
+                               compositor sends one. */
+  glps_WaylandSurfaceScale surface_scale; /**< Owned by the committing
+                                             thread. */
 } glps_WaylandWindow;
 
+#define GLPS_MAX_CLIPBOARD_TRANSFERS 8
+#define GLPS_MAX_OFFER_MIME_TYPES 16
+
+/**
+ * @struct glps_DataOffer
+ * @brief Offer from another client and the MIME types it advertised.
+ */
+typedef struct
+{
+  struct wl_data_offer *offer; /**< The offer, NULL if none. */
+  struct zwlr_data_control_offer_v1
+      *control_offer; /**< Offer of the data-control device instead. */
+  char mime_types[GLPS_MAX_OFFER_MIME_TYPES][64]; /**< Advertised types. */
+  size_t mime_count;                              /**< Number of types. */
+} glps_DataOffer;
+
+/**
+ * @struct glps_ClipboardTransfer
+ * @brief Selection or drop being read from another client's pipe.
+ */
+typedef struct
+{
+  struct wl_data_offer *offer; /**< Dropped offer, destroyed when done. */
+  int fd;                      /**< Non-blocking read end of the pipe. */
+  int out_fd;                  /**< Descriptor streamed to, -1 if buffered. */
+  size_t written;              /**< Bytes streamed to out_fd. */
+  bool is_drop;                /**< Drag & drop rather than selection. */
+  size_t window_id;            /**< Window a drop landed on. */
+  char mime_type[64];          /**< MIME type being received. */
+  glps_ClipboardBuffer buffer; /**< Data received so far. */
+  void (*callback)(const char *mime, const char *buff, size_t size,
+                   void *data); /**< Completion callback of a request. */
+  void *callback_data;          /**< User data of the callback. */
+} glps_ClipboardTransfer;
+
+#define GLPS_EVENT_QUEUE_SIZE 256 /**< Events a queue holds, a power of 2. */
+
+/**
+ * @struct glps_EventQueue
+ * @brief Window events handed from one producer thread to one consumer.
+ */
+typedef struct
+{
+  _Atomic size_t head; /**< Next slot the producer writes. */
+  _Atomic size_t tail; /**< Next slot the consumer reads. */
+  glps_WindowEvent events[GLPS_EVENT_QUEUE_SIZE];
+} glps_EventQueue;
+
 /**
  * @struct glps_WaylandContext
  * @brief Represents the Wayland context for GLPS.
@@ -261,6 +924,7 @@ typedef struct
   struct wl_display *wl_display;       /**< Wayland display. */
   struct wl_registry *wl_registry;     /**< Wayland registry. */
   struct wl_compositor *wl_compositor; /**< Wayland compositor. */
+  struct wl_shm *wl_shm;               /**< Buffers of software windows. */
   struct wl_seat *wl_seat;             /**< Wayland seat. */
   struct xdg_wm_base *xdg_wm_base;     /**< XDG WM base. */
   struct zxdg_decoration_manager_v1
@@ -269,6 +933,14 @@ typedef struct
   struct wl_data_device *data_dvc;                 /**< Data device to interact with Clipboard
                                                       and Drag&Drop operations. */
   struct wl_data_source *data_src;                 /**< Clipboard data source.*/
+  struct zwlr_data_control_manager_v1
+      *data_control_manager; /**< wlr data-control manager, NULL if
+                                unsupported. */
+  struct zwlr_data_control_device_v1
+      *data_control_device; /**< Data-control device, NULL unless the
+                               data-control mode is enabled. */
+  struct zwlr_data_control_source_v1
+      *data_control_src; /**< Selection set through data-control. */
   struct wl_pointer *wl_pointer;                   /**< Wayland pointer. */
   struct wl_keyboard *wl_keyboard;                 /**< Wayland keyboard. */
   struct xkb_state *xkb_state;                     /**< Keyboard state. */
@@ -276,16 +948,103 @@ typedef struct
   struct xkb_keymap *xkb_keymap;                   /**< Keyboard keymap. */
   struct wl_touch *wl_touch;                       /**< Wayland touch interface. */
   struct wl_data_offer *current_drag_offer;
+  struct wp_presentation *presentation;            /**< Presentation-time
+                                                      interface, NULL if
+                                                      unsupported. */
+  uint32_t presentation_clock;                     /**< Clock of presentation
+                                                      timestamps. */
+  struct wp_viewporter *viewporter;                /**< NULL if
+                                                      unsupported. */
+  struct wp_fractional_scale_manager_v1
+      *fractional_scale_manager;                   /**< NULL if
+                                                      unsupported. */
+  glps_WaylandOutput *outputs[GLPS_MAX_OUTPUTS];   /**< Bound outputs. */
+  size_t output_count;
+  glps_ClipboardTransfer
+      transfers[GLPS_MAX_CLIPBOARD_TRANSFERS];     /**< Receives in flight. */
+  size_t transfer_count;
+  glps_ClipboardSend sends[GLPS_MAX_CLIPBOARD_TRANSFERS]; /**< Sends in
+                                                            flight. */
+  size_t send_count;
+  glps_DataOffer incoming_offer; /**< Offer whose types are being announced. */
+  glps_DataOffer selection;      /**< Current selection, fetched on demand. */
+  glps_DataOffer drag;           /**< Types of the drag over our surfaces. */
+  char drag_mime_type[64];       /**< Type accepted for the drag, or empty. */
+  char drop_mime_types[GLPS_MAX_OFFER_MIME_TYPES][64]; /**< Types accepted
+                                                          for drops, in order
+                                                          of preference. */
+  size_t drop_mime_count;
+  bool map_dropped_files; /**< mmap local files of dropped URI lists. */
   uint32_t current_serial;
   uint32_t keyboard_serial;
   size_t keyboard_window_id;
   size_t mouse_window_id;
   size_t touch_window_id;
   size_t current_drag_n_drop_window;
+  struct wl_event_queue *input_queue; /**< Queue of the seat objects, NULL
+                                         unless the input thread runs. */
+  pthread_t input_thread;             /**< Reads and dispatches input_queue. */
+  pthread_mutex_t input_lock; /**< Held by the input thread while it
+                                 dispatches, and while windows are added or
+                                 removed. */
+  int input_wake_fd;          /**< eventfd signaled for queued input. */
+  int input_stop_fd;          /**< eventfd stopping the input thread. */
+  glps_EventQueue input_events; /**< Input waiting for the dispatch thread. */
 } glps_WaylandContext;
 
 #endif
 
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+
+/**
+ * @struct glps_EGLContext
+ * @brief EGL context for rendering.
+ */
+typedef struct
+{
+  glps_SurfaceDesc desc; /**< Descriptor the config was chosen for. */
+  EGLint renderable;     /**< EGL_RENDERABLE_TYPE it was chosen for. */
+  EGLConfig config;      /**< Chosen config. */
+} glps_EGLConfigCacheEntry;
+
+#define GLPS_EGL_CONFIG_CACHE_SIZE 8
+
+typedef struct
+{
+  EGLDisplay dpy; /**< EGL display. */
+  EGLContext ctx; /**< EGL context. */
+  EGLConfig conf; /**< Config of the context, EGL_NO_CONFIG_KHR if it works
+                       with any. */
+  EGLint context_attribs[16]; /**< Attributes the context was created with,
+                                   reused for shared contexts. */
+  bool has_no_config_context; /**< EGL_KHR_no_config_context. */
+  bool has_gl_colorspace;     /**< EGL_KHR_gl_colorspace. */
+  bool has_no_error;          /**< EGL_KHR_create_context_no_error. */
+  bool has_robustness;        /**< EGL_EXT_create_context_robustness. */
+  bool has_surfaceless;       /**< EGL_KHR_surfaceless_context. */
+  PFNEGLCREATESYNCKHRPROC create_sync; /**< EGL_KHR_fence_sync, or NULL. */
+  PFNEGLDESTROYSYNCKHRPROC destroy_sync;
+  PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync;
+  PFNEGLWAITSYNCKHRPROC wait_sync; /**< EGL_KHR_wait_sync, or NULL. */
+  PFNEGLCREATEPLATFORMWINDOWSURFACEEXTPROC
+      create_platform_window_surface; /**< Set when the display came from
+                                         eglGetPlatformDisplayEXT, takes a
+                                         pointer to the native window. */
+  glps_EGLConfigCacheEntry
+      config_cache[GLPS_EGL_CONFIG_CACHE_SIZE]; /**< Configs chosen so far,
+                                                   keyed by descriptor. */
+  size_t config_cache_count;
+  size_t config_cache_next; /**< Entry replaced when the cache is full. */
+} glps_EGLContext;
+
+struct glps_SharedContext
+{
+  EGLContext ctx;     /**< Context sharing objects with glps_EGLContext. */
+  EGLSurface surface; /**< 1x1 pbuffer, EGL_NO_SURFACE if surfaceless. */
+};
+
+#endif
+
 #ifdef GLPS_USE_WIN32
 
 typedef struct
@@ -293,9 +1052,11 @@ typedef struct
   HWND hwnd;
   HDC hdc;
   glps_WindowProperties properties;
-  LARGE_INTEGER fps_start_time;
-  LARGE_INTEGER fps_freq;
-  bool fps_is_init;
+  glps_FrameStatsTracker frame_stats; /**< Frame-time statistics. */
+  glps_LatencyTracker latency;        /**< Input-to-photon latency. */
+  glps_GpuTimer gpu_timer;            /**< GPU frame-time queries. */
+  glps_ResolutionController resolution; /**< Dynamic resolution. */
+  glps_ScaledFramebuffer scaled_fb; /**< Target below full resolution. */
 } glps_Win32Window;
 
 typedef struct
@@ -309,27 +1070,125 @@ typedef struct
 
 #ifdef GLPS_USE_X11
 
+#ifdef GLPS_HAVE_XINPUT2
+
+#define GLPS_X11_MAX_DEVICES 32     /**< Input devices whose names are kept. */
+#define GLPS_X11_MAX_SCROLL_AXES 16 /**< Scroll valuators tracked. */
+
 typedef struct
 {
-  Display *display;      /**< X11 display connection. */
-  GC gc;                 /**< Graphics context for rendering. */
-  Atom wm_delete_window; /**< Atom for handling window close events. */
-  XFontStruct *font;     /**< X11 font structure for text rendering. */
+  uint16_t id;   /**< XInput2 device ID. */
+  char name[64]; /**< Name reported by the server. */
+  bool absolute; /**< Reports positions rather than motion, as tablets and
+                      touchscreens do. */
+} glps_X11Device;
+
+/**
+ * Smooth-scrolling valuator of a device. The valuator is absolute, scrolling
+ * is the change since the last value seen.
+ */
+typedef struct
+{
+  uint16_t device_id;    /**< Device the valuator belongs to. */
+  uint16_t number;       /**< Valuator number in the device's events. */
+  GLPS_SCROLL_AXES axis; /**< Scrolled axis. */
+  double increment;      /**< Valuator change of one wheel click. */
+  double last;           /**< Last value seen. */
+  bool known;            /**< last is current, false once the pointer left
+                              and others may have scrolled. */
+} glps_X11ScrollAxis;
+
+#endif
+
+typedef struct
+{
+  xcb_connection_t *connection; /**< Carries all window and event traffic. */
+  xcb_screen_t *screen;         /**< Screen windows are created on. */
+  int screen_number;
+  Display *egl_display; /**< Opened for EGL without EGL_EXT_platform_xcb,
+                             NULL otherwise. */
+  xcb_atom_t wm_protocols;     /**< Atom of client messages from the window
+                                    manager. */
+  xcb_atom_t wm_delete_window; /**< Atom for handling window close events. */
+  xcb_atom_t net_wm_name;      /**< _NET_WM_NAME, the UTF-8 title. */
+  xcb_atom_t utf8_string;      /**< Type of _NET_WM_NAME. */
+  xcb_keysym_t *keysyms; /**< Core keyboard mapping, keysyms_per_keycode
+                              entries per keycode from min_keycode. */
+  xcb_keycode_t min_keycode;
+  xcb_keycode_t max_keycode;
+  uint8_t keysyms_per_keycode;
+#ifdef GLPS_HAVE_XINPUT2
+  uint8_t xi_opcode; /**< Major opcode of XInput2, 0 when the server lacks
+                          version 2.2. */
+  glps_X11Device devices[GLPS_X11_MAX_DEVICES];
+  size_t device_count;
+  glps_X11ScrollAxis scroll_axes[GLPS_X11_MAX_SCROLL_AXES];
+  size_t scroll_axis_count;
+  double raw_dx; /**< Raw motion since the last dispatch. */
+  double raw_dy;
+  bool raw_pending;            /**< raw_dx and raw_dy hold motion. */
+  xcb_window_t pointer_window; /**< Window under the pointer, 0 if none. */
+  xcb_window_t focus_window;   /**< Window with keyboard focus, 0 if none. */
+#endif
+#ifdef GLPS_HAVE_XCB_SHM
+  bool has_shm;           /**< MIT-SHM works, cleared once attaching fails,
+                               as it does for remote displays. */
+  uint8_t shm_completion; /**< Event type of MIT-SHM completions. */
+#endif
 } glps_X11Context;
 
+/**
+ * @struct glps_X11ShmBuffer
+ * @brief Pixels of a software window, shared with the server through MIT-SHM
+ * if it can, copied into put-image requests otherwise.
+ */
 typedef struct
 {
-  Window window; /**< X11 window identifier. */
-  bool fps_is_init;
+  uint32_t *pixels; /**< Attached segment, or heap memory without MIT-SHM. */
+  int width;
+  int height;
+  bool busy;      /**< The server hasn't finished reading the segment. */
+  uint64_t frame; /**< Frame it was presented with, 0 if never. */
+#ifdef GLPS_HAVE_XCB_SHM
+  xcb_shm_seg_t segment; /**< 0 for heap memory. */
+#endif
+} glps_X11ShmBuffer;
 
+typedef struct
+{
+  xcb_window_t window;     /**< X11 window identifier. */
+  xcb_colormap_t colormap; /**< Colormap of the EGL config's visual. */
+  EGLSurface egl_surface; /**< EGL surface of the window. */
+  glps_WindowProperties properties;
+  bool frame_pending; /**< Swapped or exposed, the frame callback runs on
+                           the next dispatch. */
+  bool resize_pending; /**< Resized since the last dispatch, reported once
+                            with the latest size. */
+  glps_FrameStatsTracker frame_stats; /**< Frame-time statistics. */
+  glps_LatencyTracker latency;        /**< Input-to-photon latency. */
+  glps_GpuTimer gpu_timer;            /**< GPU frame-time queries. */
+  glps_ResolutionController resolution; /**< Dynamic resolution. */
+  glps_ScaledFramebuffer scaled_fb; /**< Target below full resolution. */
+  bool software;       /**< Presented from client memory, without EGL. */
+  bool exposed;        /**< Contents were lost, the next software frame is
+                            copied whole whatever its damage. */
+  xcb_gcontext_t gc;   /**< Copies software frames, 0 for EGL windows. */
+  glps_X11ShmBuffer shm_buffers[GLPS_SHM_BUFFERS];
+  glps_X11ShmBuffer *shm_mapped; /**< Handed out by map_pixels and not
+                                      presented yet, NULL if none. */
+  uint64_t shm_frame;            /**< Software frames presented. */
 } glps_X11Window;
 
 #endif
 
 struct clipboard_data
 {
-  char mime_type[64];
-  char buff[1024];
+  glps_ClipboardSource sources[GLPS_MAX_CLIPBOARD_TYPES]; /**< Selection owned
+                                                             by this client. */
+  size_t source_count;           /**< Number of offered representations. */
+  glps_ClipboardBuffer received; /**< Last selection fetched. */
+  char received_mime[64];        /**< MIME type of the fetched data. */
+  bool cached;                   /**< received holds the current selection. */
 };
 
 struct glps_debug
@@ -346,12 +1205,22 @@ typedef struct
 
 #ifdef GLPS_USE_WAYLAND
   glps_WaylandContext *wayland_ctx;   /**< Wayland context. */
-  glps_WaylandWindow **windows;       /**< Array of Wayland window pointers. */
+  _Atomic(glps_WaylandWindow *) *windows; /**< Array of Wayland window
+                                             pointers, also read by render
+                                             threads. */
   glps_EGLContext *egl_ctx;           /**< EGL context. */
   struct touch_event touch_event;     /**< Current touch event data. */
   struct pointer_event pointer_event; /**< Current pointer event data. */
   struct clipboard_data clipboard;    /**< Current clipboard data. */
 
+  pthread_t owner_thread; /**< Thread that called glps_wm_init, the only one
+                             mutating the window manager. */
+  _Atomic unsigned reader_epoch;  /**< Selects the reader count to enter. */
+  _Atomic unsigned readers[2];    /**< Threads reading published windows. */
+  pthread_mutex_t task_lock;      /**< Guards the task list. */
+  struct glps_Task *tasks;        /**< Posted to the owner, oldest first. */
+  struct glps_Task *last_task;    /**< Where new tasks are appended. */
+  int task_wake_fd;               /**< eventfd signaled for posted tasks. */
 #endif
 
 #ifdef GLPS_USE_WIN32
@@ -363,10 +1232,21 @@ typedef struct
 #ifdef GLPS_USE_X11
   glps_X11Context *x11_ctx;
   glps_X11Window **windows; /**< Array of X11 window pointers. */
+  glps_EGLContext *egl_ctx; /**< EGL context. */
 #endif
 
+  glps_SurfaceDesc surface_desc;       /**< Format of new window surfaces. */
+  glps_ContextDesc context_desc;       /**< Context created with the first
+                                            window. */
+  glps_InputTimestamp input_timestamp; /**< Event being dispatched. */
+  glps_InputDevice input_device;       /**< Sender of the event being
+                                            dispatched. */
   char font_path[256];         /**< Path to the font file. */
+#ifdef GLPS_USE_WAYLAND
+  _Atomic size_t window_count; /**< Number of managed windows. */
+#else
   size_t window_count;         /**< Number of managed windows. */
+#endif
   bool inhibit_reset;          /**< Indicates if reset should be inhibited. */
   unsigned int selected_color; /**< Selected color value. */
   struct glps_debug debug_utilities;
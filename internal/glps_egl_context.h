@@ -4,8 +4,27 @@
 #include <glps_common.h>
 
 void glps_egl_init(glps_WindowManager *wm);
+bool glps_egl_choose_config(glps_WindowManager *wm,
+                            const glps_SurfaceDesc *desc, EGLConfig *config);
+bool glps_egl_surface_config(glps_WindowManager *wm, EGLConfig *config);
+EGLSurface glps_egl_create_surface(glps_WindowManager *wm,
+                                   EGLNativeWindowType native_window,
+                                   void *platform_window);
 void glps_egl_create_ctx(glps_WindowManager *wm);
 void glps_egl_make_ctx_current(glps_WindowManager *wm, size_t window_id);
+EGLContext glps_egl_create_thread_ctx(glps_WindowManager *wm);
+bool glps_egl_make_thread_ctx_current(glps_WindowManager *wm,
+                                      EGLSurface surface, EGLContext ctx);
+glps_SharedContext *glps_egl_create_shared_ctx(glps_WindowManager *wm);
+bool glps_egl_make_shared_ctx_current(glps_WindowManager *wm,
+                                      glps_SharedContext *shared);
+void glps_egl_destroy_shared_ctx(glps_WindowManager *wm,
+                                 glps_SharedContext *shared);
+glps_Fence glps_egl_fence_create(glps_WindowManager *wm);
+bool glps_egl_fence_wait(glps_WindowManager *wm, glps_Fence fence,
+                         uint64_t timeout_ns);
+bool glps_egl_fence_wait_gpu(glps_WindowManager *wm, glps_Fence fence);
+void glps_egl_fence_destroy(glps_WindowManager *wm, glps_Fence fence);
 void *glps_egl_get_proc_addr(const char *name);
 void glps_egl_swap_buffers(glps_WindowManager *wm, size_t window_id);
 void glps_egl_destroy(glps_WindowManager *wm);
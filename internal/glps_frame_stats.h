@@ -0,0 +1,22 @@
+#ifndef GLPS_FRAME_STATS_H
+#define GLPS_FRAME_STATS_H
+
+#include "glps_common.h"
+
+#define GLPS_FRAME_STATS_DEFAULT_WINDOW 120
+#define GLPS_FRAME_STATS_DEFAULT_BUDGET_MS (1000.0 / 60.0)
+
+void glps_frame_stats_init(glps_FrameStatsTracker *tracker);
+void glps_frame_stats_tick(glps_FrameStatsTracker *tracker, uint64_t now_ns);
+void glps_frame_stats_gpu_sample(glps_FrameStatsTracker *tracker,
+                                 float gpu_ms);
+void glps_frame_stats_get(const glps_FrameStatsTracker *tracker,
+                          glps_FrameStats *stats);
+void glps_frame_stats_set_budget(glps_FrameStatsTracker *tracker,
+                                 double budget_ms);
+void glps_frame_stats_set_refresh(glps_FrameStatsTracker *tracker,
+                                  double refresh_hz);
+void glps_frame_stats_set_window(glps_FrameStatsTracker *tracker,
+                                 size_t frames);
+
+#endif
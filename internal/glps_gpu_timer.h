@@ -0,0 +1,14 @@
+#ifndef GLPS_GPU_TIMER_H
+#define GLPS_GPU_TIMER_H
+
+#include "glps_common.h"
+
+void glps_gpu_timer_set_enabled(glps_GpuTimer *timer, bool enabled);
+void glps_gpu_timer_frame_end(glps_WindowManager *wm, glps_GpuTimer *timer,
+                              glps_FrameStatsTracker *stats);
+void glps_gpu_timer_frame_begin(glps_WindowManager *wm, glps_GpuTimer *timer);
+void glps_gpu_timer_make_current(glps_GpuTimer *timer);
+void glps_gpu_timer_release(glps_WindowManager *wm, glps_GpuTimer *timer);
+void glps_gpu_timer_destroy(glps_WindowManager *wm, glps_GpuTimer *timer);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef GLPS_INPUT_LATENCY_H
+#define GLPS_INPUT_LATENCY_H
+
+#include "glps_common.h"
+
+/**
+ * Event times further than this in the past are assumed to be on a clock other
+ * than the presentation clock, and the receive time is used instead.
+ */
+#define GLPS_LATENCY_MAX_EVENT_AGE_MS 10000
+
+void glps_latency_init(glps_LatencyTracker *tracker);
+uint64_t glps_latency_event_time_ns(uint32_t time_ms, uint64_t receive_ns);
+void glps_latency_input(glps_LatencyTracker *tracker, uint64_t input_ns,
+                        uint64_t receive_ns);
+bool glps_latency_take_pending(glps_LatencyTracker *tracker,
+                               uint64_t *input_ns, uint64_t *receive_ns);
+void glps_latency_record(glps_LatencyTracker *tracker, uint64_t input_ns,
+                         uint64_t receive_ns, uint64_t shown_ns,
+                         bool presented);
+void glps_latency_frame_submitted(glps_LatencyTracker *tracker,
+                                  uint64_t now_ns);
+void glps_latency_discard(glps_LatencyTracker *tracker);
+void glps_latency_get(const glps_LatencyTracker *tracker,
+                      glps_LatencyStats *stats);
+void glps_latency_reset(glps_LatencyTracker *tracker);
+
+#endif
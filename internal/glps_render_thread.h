@@ -0,0 +1,35 @@
+#ifndef GLPS_RENDER_THREAD_H
+#define GLPS_RENDER_THREAD_H
+
+#include "glps_common.h"
+
+glps_RenderThread *glps_render_thread_start(glps_WindowManager *wm,
+                                            size_t window_id);
+bool glps_render_thread_post(glps_RenderThread *thread,
+                             const glps_WindowEvent *event);
+void glps_render_thread_stop(glps_RenderThread *thread);
+
+/**
+ * @brief The window rendered by the calling thread if it has the given ID,
+ * which may be the ID its callback got before the window shifted. NULL on
+ * other threads and for other windows, which are read from wm->windows.
+ */
+glps_WaylandWindow *glps_render_thread_window(size_t window_id);
+
+/**
+ * @brief Tells a render thread the new ID of its window. Called by the owner
+ * after compacting the windows.
+ */
+void glps_render_thread_set_window_id(glps_RenderThread *thread,
+                                      size_t window_id);
+
+void glps_event_queue_init(glps_EventQueue *queue);
+bool glps_event_queue_push(glps_EventQueue *queue,
+                           const glps_WindowEvent *event);
+bool glps_event_queue_pop(glps_EventQueue *queue, glps_WindowEvent *event);
+
+void glps_window_event_dispatch(glps_WindowManager *wm,
+                                const glps_WindowEvent *event);
+glps_InputTimestamp glps_window_event_input_timestamp(void);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef GLPS_RESOLUTION_H
+#define GLPS_RESOLUTION_H
+
+#include "glps_common.h"
+
+#define GLPS_RESOLUTION_MIN_SCALE 0.1 /**< Smallest render scale allowed. */
+
+void glps_resolution_init(glps_ResolutionController *controller);
+void glps_resolution_configure(glps_ResolutionController *controller,
+                               bool enabled, double min_scale,
+                               double max_scale, double current_scale);
+double glps_resolution_frame(glps_ResolutionController *controller,
+                             const glps_FrameStatsTracker *stats);
+void glps_resolution_scaled_size(double render_scale, int width, int height,
+                                 int *scaled_width, int *scaled_height);
+
+void glps_scaled_framebuffer_begin(glps_ScaledFramebuffer *fb, int width,
+                                   int height);
+void glps_scaled_framebuffer_end(glps_ScaledFramebuffer *fb, int width,
+                                 int height);
+void glps_scaled_framebuffer_make_current(glps_ScaledFramebuffer *fb);
+void glps_scaled_framebuffer_destroy(glps_ScaledFramebuffer *fb);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef GLPS_SYNC_H
+#define GLPS_SYNC_H
+
+#include "glps_common.h"
+
+void glps_seqlock_write(_Atomic uint32_t *seq, _Atomic uint64_t *words,
+                        const void *data, size_t size);
+void glps_seqlock_read(_Atomic uint32_t *seq, _Atomic uint64_t *words,
+                       void *data, size_t size);
+
+/** Publishes *value into a cell, from the one thread writing it. */
+#define GLPS_SEQLOCK_PUBLISH(cell, value)                                      \
+  glps_seqlock_write(&(cell)->seq, (cell)->words, (value), sizeof(*(value)))
+
+/** Copies a consistent snapshot of a cell into *value, from any thread. */
+#define GLPS_SEQLOCK_SNAPSHOT(cell, value)                                     \
+  glps_seqlock_read(&(cell)->seq, (cell)->words, (value), sizeof(*(value)))
+
+bool glps_sync_init(glps_WindowManager *wm);
+void glps_sync_destroy(glps_WindowManager *wm);
+bool glps_sync_is_owner(glps_WindowManager *wm);
+
+/**
+ * @brief Waits until no reader on another thread holds a window removed from
+ * wm->windows, so it can be freed.
+ */
+void glps_sync_synchronize(glps_WindowManager *wm);
+glps_WaylandWindow *glps_sync_read_begin(glps_WindowManager *wm,
+                                         size_t window_id, unsigned *epoch);
+void glps_sync_read_end(glps_WindowManager *wm, unsigned epoch);
+
+bool glps_sync_post(glps_WindowManager *wm,
+                    void (*task)(glps_WindowManager *wm, void *data),
+                    void *data);
+size_t glps_sync_run_tasks(glps_WindowManager *wm);
+
+#endif
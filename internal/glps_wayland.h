@@ -16,6 +16,21 @@ ssize_t __get_window_id_from_xdg_surface(glps_WindowManager *wm,
 ssize_t __get_window_id_from_xdg_toplevel(glps_WindowManager *wm,
                                           struct xdg_toplevel *toplevel);
 
+/**
+ * @brief Reads the clock the compositor uses for presentation timestamps.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return The current time in nanoseconds.
+ */
+uint64_t glps_wl_clock_now_ns(glps_WindowManager *wm);
+
+/**
+ * @brief Records the timestamps of an input event for a window.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window receiving the event.
+ * @param time Compositor event time in milliseconds.
+ */
+glps_InputTimestamp __wl_stamp_input(glps_WindowManager *wm, uint32_t time);
+
 /**
  * @brief Updates the specified window, handling rendering and events.
  * @param wm Pointer to the GLPS Window Manager.
@@ -117,6 +132,101 @@ void data_device_handle_motion(void *data, struct wl_data_device *data_device,
 void data_device_handle_leave(void *data, struct wl_data_device *data_device);
 void data_device_handle_drop(void *data, struct wl_data_device *data_device);
 
+// Presentation feedback handlers
+void presentation_clock_id(void *data, struct wp_presentation *presentation,
+                           uint32_t clk_id);
+void presentation_feedback_sync_output(
+    void *data, struct wp_presentation_feedback *feedback,
+    struct wl_output *output);
+void presentation_feedback_presented(void *data,
+                                     struct wp_presentation_feedback *feedback,
+                                     uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                     uint32_t tv_nsec, uint32_t refresh,
+                                     uint32_t seq_hi, uint32_t seq_lo,
+                                     uint32_t flags);
+void presentation_feedback_discarded(
+    void *data, struct wp_presentation_feedback *feedback);
+
+/**
+ * @brief Asks for presentation feedback on the next commit of a window if it
+ * has input waiting to be shown. Must be called before the buffer swap.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param window_id ID of the window.
+ * @return true if the compositor supports presentation feedback.
+ */
+bool glps_wl_request_presentation_feedback(glps_WindowManager *wm,
+                                           size_t window_id);
+
+/**
+ * @brief Copies the outputs whose properties are complete.
+ * @param outputs Receives up to max_outputs outputs.
+ * @return Number of outputs, which may exceed max_outputs.
+ */
+size_t glps_wl_get_outputs(glps_WindowManager *wm, glps_Output *outputs,
+                           size_t max_outputs);
+
+/**
+ * @brief Offers sources as the selection, replacing any selection previously
+ * set by this client. Takes ownership of the sources, even on failure.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param sources Representations to offer, one per MIME type.
+ * @param count Number of sources, at most GLPS_MAX_CLIPBOARD_TYPES.
+ * @return true if the selection was set.
+ */
+bool glps_wl_set_selection(glps_WindowManager *wm,
+                           glps_ClipboardSource *sources, size_t count);
+
+/**
+ * @brief Reads the current selection into wm->clipboard.received, blocking
+ * until it arrived. Cached until the selection changes.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @param mime_type MIME type to fetch, NULL for the preferred text type.
+ * @return true if the selection is available in that type.
+ */
+bool glps_wl_fetch_selection(glps_WindowManager *wm, const char *mime_type);
+
+size_t glps_wl_get_selection_types(glps_WindowManager *wm,
+                                   const char **mime_types, size_t max);
+void glps_wl_set_drop_types(glps_WindowManager *wm,
+                            const char *const *mime_types, size_t count);
+void glps_wl_set_map_dropped_files(glps_WindowManager *wm, bool map_files);
+
+/**
+ * @brief Reads the current selection from the event loop and calls callback,
+ * or the clipboard callback if NULL, once it arrived.
+ * @return true if the request was started or served from the cache.
+ */
+bool glps_wl_request_selection(
+    glps_WindowManager *wm, const char *mime_type,
+    void (*callback)(const char *mime, const char *buff, size_t size,
+                     void *data),
+    void *data);
+
+/**
+ * @brief Like glps_wl_request_selection, but streams the data into fd instead
+ * of memory. The callback gets a NULL buffer and the number of bytes written.
+ */
+bool glps_wl_request_selection_to_fd(
+    glps_WindowManager *wm, const char *mime_type, int fd,
+    void (*callback)(const char *mime, const char *buff, size_t size,
+                     void *data),
+    void *data);
+
+/**
+ * @brief Follows and sets the selection through wlr-data-control, which works
+ * without keyboard focus or a window, as clipboard managers need.
+ * @param wm Pointer to the GLPS Window Manager.
+ * @return true if the compositor supports the protocol.
+ */
+bool glps_wl_enable_data_control(glps_WindowManager *wm);
+
+/**
+ * @brief Waits up to timeout_ms for events and clipboard data, then dispatches
+ * them. A negative timeout waits indefinitely.
+ * @return -1 if the connection to the compositor failed.
+ */
+int glps_wl_dispatch(glps_WindowManager *wm, int timeout_ms);
+
 // Registry and global object handlers
 void handle_global(void *data, struct wl_registry *registry, uint32_t id,
                    const char *interface, uint32_t version);
@@ -136,12 +246,75 @@ void xdg_surface_configure(void *data, struct xdg_surface *xdg_surface,
 bool glps_wl_init(glps_WindowManager* wm);
 
 ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
-                             int width, int height);
+                              int width, int height, bool software);
+
+/**
+ * @brief Hands out the free wl_shm buffer of a software window, sized to the
+ * window. Allocates only for the first frame and after resizes.
+ * @return The buffer, with NULL pixels if the compositor holds every buffer.
+ */
+glps_PixelBuffer glps_wl_window_map_pixels(glps_WindowManager *wm,
+                                           size_t window_id);
+
+/**
+ * @brief Attaches the mapped buffer of a software window, damages the given
+ * rectangles, or all of it if none, and commits.
+ * @param presentation_feedback Set if the compositor reports presentation.
+ * @return false if no buffer was mapped.
+ */
+bool glps_wl_window_present_pixels(glps_WindowManager *wm, size_t window_id,
+                                   const glps_Rect *damage,
+                                   size_t damage_count,
+                                   bool *presentation_feedback);
+
+/**
+ * @brief Resizes the EGL window to the buffer size of a resize event and keeps
+ * the surface scale for the next commit. Called by the thread that commits.
+ */
+void glps_wl_window_resize_buffers(glps_WaylandWindow *window,
+                                   const glps_WindowEvent *event);
+
+/**
+ * @brief Sets the viewport destination or buffer scale of the last resize.
+ * Must be called by the thread that commits, before the buffer swap.
+ */
+void glps_wl_window_apply_scale(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Renders a window at a fraction of its device pixels, upscaled by the
+ * compositor. The window gets a resize event with the new buffer size.
+ * @return false if the compositor lacks wp_viewporter.
+ */
+bool glps_wl_window_set_render_scale(glps_WindowManager *wm, size_t window_id,
+                                     double render_scale);
 
 bool glps_wl_should_close(glps_WindowManager *wm);
 
+bool glps_wl_start_input_thread(glps_WindowManager *wm);
+void glps_wl_stop_input_thread(glps_WindowManager *wm);
+size_t glps_wl_dispatch_input(glps_WindowManager *wm);
+
+bool glps_wl_window_start_render_thread(glps_WindowManager *wm,
+                                        size_t window_id);
+void glps_wl_window_stop_render_thread(glps_WindowManager *wm,
+                                       size_t window_id);
+
 void glps_wl_window_destroy(glps_WindowManager *wm, size_t window_id);
 
+/**
+ * @brief Looks up a window by ID. On a render thread this is always the window
+ * it renders, whatever ID it was given.
+ */
+glps_WaylandWindow *glps_wl_window(glps_WindowManager *wm, size_t window_id);
+
+/**
+ * @brief Finds the current ID of a window by its handle. Must be called by the
+ * owner.
+ * @return false if the window was destroyed.
+ */
+bool glps_wl_window_find(glps_WindowManager *wm, uint32_t handle,
+                         size_t *window_id);
+
 void glps_wl_destroy();
 
 extern struct xdg_wm_base_listener xdg_wm_base_listener;
@@ -164,10 +337,20 @@ extern struct wl_data_offer_listener data_offer_listener;
 
 extern struct wl_data_device_listener data_device_listener;
 
+extern struct zwlr_data_control_device_v1_listener data_control_device_listener;
+
+extern struct zwlr_data_control_offer_v1_listener data_control_offer_listener;
+
+extern struct zwlr_data_control_source_v1_listener data_control_source_listener;
+
 extern struct wl_registry_listener registry_listener;
 
 extern struct wl_callback_listener frame_callback_listener;
 
+extern struct wp_presentation_listener presentation_listener;
+
+extern struct wp_presentation_feedback_listener presentation_feedback_listener;
+
 #endif
 
 #endif
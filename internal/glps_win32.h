@@ -14,8 +14,8 @@ void glps_win32_get_window_dimensions(glps_WindowManager *wm, size_t window_id,
 
 HDC glps_win32_get_window_hdc(glps_WindowManager *wm, size_t window_id);
 
-void glps_win32_attach_to_clipboard(glps_WindowManager *wm, char *mime,
-                                 char *data);
+bool glps_win32_attach_to_clipboard(glps_WindowManager *wm, const char *mime,
+                                    const void *data, size_t size);
 
 void glps_win32_get_from_clipboard(glps_WindowManager *wm, char *data,
                                 size_t data_size);
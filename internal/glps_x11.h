@@ -6,7 +6,8 @@
 void glps_x11_init(glps_WindowManager *wm);
 
 ssize_t glps_x11_window_create(glps_WindowManager *wm, const char *title,
-                               int width, int height);
+                               int width, int height, bool software);
+void glps_x11_window_destroy(glps_WindowManager *wm, size_t window_id);
 
 void glps_x11_destroy(glps_WindowManager *wm);
 void glps_x11_get_window_dimensions(glps_WindowManager *wm, size_t window_id,
@@ -18,7 +19,16 @@ void glps_x11_attach_to_clipboard(glps_WindowManager *wm, char *mime,
 void glps_x11_get_from_clipboard(glps_WindowManager *wm, char *data,
                                  size_t data_size);
 
+int glps_x11_get_fd(glps_WindowManager *wm);
+int glps_x11_dispatch(glps_WindowManager *wm, int timeout_ms);
 bool glps_x11_should_close(glps_WindowManager *wm);
+void glps_x11_swap_buffers(glps_WindowManager *wm, size_t window_id);
 void glps_x11_window_update(glps_WindowManager *wm, size_t window_id);
 
-#endif
\ No newline at end of file
+glps_PixelBuffer glps_x11_window_map_pixels(glps_WindowManager *wm,
+                                            size_t window_id);
+bool glps_x11_window_present_pixels(glps_WindowManager *wm, size_t window_id,
+                                    const glps_Rect *damage,
+                                    size_t damage_count);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file pico_log_format.h
+ * @brief On-disk layout of binary log files written by `save_binary_log_file`.
+ *
+ * A file starts with `PICO_LOG_BINARY_MAGIC`, followed by a `uint32_t` string
+ * count and that many string entries (`uint64_t` address, `uint32_t` length,
+ * bytes). Then comes a `uint64_t` byte count and the records. Each record is a
+ * `PicoLogRecord` followed by `payload_size` bytes of tagged arguments. All
+ * values use the byte order of the machine that wrote the file.
+ */
+
+#ifndef PICO_LOG_FORMAT_H
+#define PICO_LOG_FORMAT_H
+
+#include <stdint.h>
+
+#define PICO_LOG_BINARY_MAGIC "PICOLOG1" /**< 8-byte file signature */
+#define PICO_LOG_BINARY_MAGIC_SIZE 8
+
+/**
+ * @struct PicoLogRecord
+ * @brief Fixed-size header of a binary log record.
+ *
+ * `fmt`, `file` and `func` hold the addresses of the strings in the process
+ * that wrote the log; they are resolved through the file's string table.
+ */
+typedef struct
+{
+    uint64_t timestamp_ns; /**< Wall-clock time in nanoseconds since the epoch */
+    uint64_t fmt;          /**< Address of the format string */
+    uint64_t file;         /**< Address of the source file name */
+    uint64_t func;         /**< Address of the function name */
+    uint32_t line;         /**< Source line */
+    uint32_t payload_size; /**< Size of the argument payload in bytes */
+    uint8_t level;         /**< DebugLevel of the record */
+    uint8_t arg_count;     /**< Number of tagged arguments in the payload */
+    uint8_t reserved[6];
+} PicoLogRecord;
+
+/**
+ * @enum PicoLogArgTag
+ * @brief Tag byte preceding every argument in a record payload.
+ *
+ * Integers, doubles and pointers are stored as 8 bytes. Strings are stored as
+ * a `uint32_t` length followed by the bytes, without the terminator.
+ */
+typedef enum
+{
+    PICO_LOG_ARG_INT = 'i',     /**< Signed integer, stored as int64_t */
+    PICO_LOG_ARG_UINT = 'u',    /**< Unsigned integer, stored as uint64_t */
+    PICO_LOG_ARG_DOUBLE = 'f',  /**< Floating point, stored as double */
+    PICO_LOG_ARG_STRING = 's',  /**< Copied string */
+    PICO_LOG_ARG_POINTER = 'p'  /**< Pointer value, stored as uint64_t */
+} PicoLogArgTag;
+
+#endif
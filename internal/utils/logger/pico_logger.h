@@ -46,6 +46,29 @@
 #define KCYN "\x1B[36m" /**< Cyan color for debug messages */
 #define KWHT "\x1B[37m" /**< White color for general text */
 
+/**
+ * @brief Numeric log levels usable in preprocessor conditionals.
+ *
+ * These mirror the `DebugLevel` enumerators so that `PICO_LOG_MIN_LEVEL` can
+ * be compared with `#if`.
+ */
+#define PICO_LOG_LEVEL_INFO 0     /**< Matches DEBUG_LEVEL_INFO */
+#define PICO_LOG_LEVEL_WARNING 1  /**< Matches DEBUG_LEVEL_WARNING */
+#define PICO_LOG_LEVEL_ERROR 2    /**< Matches DEBUG_LEVEL_ERROR */
+#define PICO_LOG_LEVEL_CRITICAL 3 /**< Matches DEBUG_LEVEL_CRITICAL */
+#define PICO_LOG_LEVEL_NONE 4     /**< Disables every log site */
+
+/**
+ * @brief Compile-time minimum log level.
+ *
+ * Log sites below this level expand to nothing: no call is emitted and their
+ * arguments are never evaluated. Define it (e.g. `-DPICO_LOG_MIN_LEVEL=2`) to
+ * one of the `PICO_LOG_LEVEL_*` values before including this header.
+ */
+#ifndef PICO_LOG_MIN_LEVEL
+#define PICO_LOG_MIN_LEVEL PICO_LOG_LEVEL_INFO
+#endif
+
 /**
  * @enum DebugLevel
  * @brief Log levels used for message categorization.
@@ -55,24 +78,43 @@
  */
 typedef enum
 {
-    DEBUG_LEVEL_INFO,    /**< Informational messages */
-    DEBUG_LEVEL_WARNING, /**< Warnings indicating potential issues */
-    DEBUG_LEVEL_ERROR,   /**< Error messages indicating a problem */
-    DEBUG_LEVEL_CRITICAL /**< Critical error messages indicating a failure */
+    DEBUG_LEVEL_INFO = PICO_LOG_LEVEL_INFO,        /**< Informational messages */
+    DEBUG_LEVEL_WARNING = PICO_LOG_LEVEL_WARNING,  /**< Warnings indicating potential issues */
+    DEBUG_LEVEL_ERROR = PICO_LOG_LEVEL_ERROR,      /**< Error messages indicating a problem */
+    DEBUG_LEVEL_CRITICAL = PICO_LOG_LEVEL_CRITICAL /**< Critical error messages indicating a failure */
 } DebugLevel;
 
+/**
+ * @brief Expands to the function that records a single log site.
+ *
+ * When `PICO_LOGGER_BINARY` is defined, log sites call `log_binary()`, which
+ * stores the format string pointer and the raw arguments instead of
+ * formatting them. Otherwise they call `log_message()`.
+ */
+#ifdef PICO_LOGGER_BINARY
+#define PICO_LOG_EMIT log_binary
+#else
+#define PICO_LOG_EMIT log_message
+#endif
+
 /**
  * @brief Macro to log a message with the specified log level.
  *
  * This macro logs messages at various levels, such as informational, warning,
  * error, or critical. It includes the file name, line number, and function name
- * where the log was generated.
+ * where the log was generated. Levels below `PICO_LOG_MIN_LEVEL` are compiled
+ * out.
  *
  * @param level The log level (e.g., DEBUG_LEVEL_INFO).
  * @param fmt The format string for the log message.
  * @param ... Additional arguments for the format string.
  */
-#define LOG_MESSAGE(level, fmt, ...) log_message(level, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__)
+#define LOG_MESSAGE(level, fmt, ...)                                                  \
+    do                                                                                \
+    {                                                                                 \
+        if ((int)(level) >= PICO_LOG_MIN_LEVEL)                                       \
+            PICO_LOG_EMIT(level, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__); \
+    } while (0)
 
 /**
  * @brief Macro to log an informational message.
@@ -82,7 +124,11 @@ typedef enum
  * @param fmt The format string for the log message.
  * @param ... Additional arguments for the format string.
  */
+#if PICO_LOG_MIN_LEVEL <= PICO_LOG_LEVEL_INFO
 #define LOG_INFO(fmt, ...) LOG_MESSAGE(DEBUG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) ((void)0)
+#endif
 
 /**
  * @brief Macro to log a warning message.
@@ -92,7 +138,11 @@ typedef enum
  * @param fmt The format string for the log message.
  * @param ... Additional arguments for the format string.
  */
+#if PICO_LOG_MIN_LEVEL <= PICO_LOG_LEVEL_WARNING
 #define LOG_WARNING(fmt, ...) LOG_MESSAGE(DEBUG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARNING(fmt, ...) ((void)0)
+#endif
 
 /**
  * @brief Macro to log an error message.
@@ -102,7 +152,11 @@ typedef enum
  * @param fmt The format string for the log message.
  * @param ... Additional arguments for the format string.
  */
+#if PICO_LOG_MIN_LEVEL <= PICO_LOG_LEVEL_ERROR
 #define LOG_ERROR(fmt, ...) LOG_MESSAGE(DEBUG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) ((void)0)
+#endif
 
 /**
  * @brief Macro to log a critical error message.
@@ -112,7 +166,11 @@ typedef enum
  * @param fmt The format string for the log message.
  * @param ... Additional arguments for the format string.
  */
+#if PICO_LOG_MIN_LEVEL <= PICO_LOG_LEVEL_CRITICAL
 #define LOG_CRITICAL(fmt, ...) LOG_MESSAGE(DEBUG_LEVEL_CRITICAL, fmt, ##__VA_ARGS__)
+#else
+#define LOG_CRITICAL(fmt, ...) ((void)0)
+#endif
 
 /**
  * @brief Logs a message with detailed information.
@@ -130,18 +188,39 @@ typedef enum
 void log_message(DebugLevel level, const char *file, int line, const char *func, const char *fmt, ...);
 
 /**
- * @brief Logs a performance metric message.
+ * @brief Records a log message in binary form without formatting it.
  *
- * This function logs a performance-related message, useful for timing and profiling.
+ * The record keeps the format string, file and function pointers together
+ * with the raw argument values; formatting is deferred to the offline
+ * `pico_log_decode` tool. Nothing is printed. Only `printf`-style conversions
+ * are supported, and `%n` is ignored.
  *
- * @param message The performance-related message to log.
+ * @param level The log level (e.g., DEBUG_LEVEL_INFO).
+ * @param file The source file where the log was generated.
+ * @param line The line number in the source file.
+ * @param func The function name where the log was generated.
+ * @param fmt The format string for the log message. Must have static storage.
+ * @param ... Additional arguments for the format string.
+ */
+void log_binary(DebugLevel level, const char *file, int line, const char *func, const char *fmt, ...);
+
+/**
+ * @brief Measures the time between two calls.
+ *
+ * Calling it with NULL starts a measurement on the calling thread. Calling it
+ * with a message ends the innermost measurement and records the duration in
+ * the profiler zone named after the message. Results are reported by
+ * `perf_report()` rather than printed immediately.
+ *
+ * @param message NULL to start a measurement, or the zone name to end it.
  */
 void log_performance(char *message);
 
 /**
  * @brief Macro to log a performance-related message.
  *
- * This macro wraps the `log_performance` function for easier usage.
+ * This macro wraps the `log_performance` function for easier usage. New code
+ * should prefer `PERF_SCOPE` from `pico_profiler.h`.
  *
  * @param message The performance-related message to log.
  */
@@ -200,4 +279,15 @@ void dump_memory(const char *label, const void *buffer, size_t size);
  */
 void save_log_file(const char *path);
 
+/**
+ * @brief Saves the binary log records to a file.
+ *
+ * The file contains a table of every string referenced by the records
+ * followed by the records themselves. Use the `pico_log_decode` tool to turn
+ * it back into text.
+ *
+ * @param path The path to the file where the records will be saved.
+ */
+void save_binary_log_file(const char *path);
+
 #endif
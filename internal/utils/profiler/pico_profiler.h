@@ -0,0 +1,199 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file pico_profiler.h
+ * @brief Scoped, nestable performance zones with per-zone statistics.
+ *
+ * Every thread keeps its own stack of open zones, so measurements may nest and
+ * overlap across threads. Closing a zone only updates atomic counters; nothing
+ * is printed until `perf_report()` is called, which keeps instrumentation cheap
+ * enough to leave enabled in production.
+ */
+
+#ifndef PICO_PROFILER_H
+#define PICO_PROFILER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PICO_PROFILER_MAX_ZONES 256 /**< Maximum number of distinct zone names */
+#define PICO_PROFILER_MAX_DEPTH 64  /**< Maximum nesting depth per thread */
+
+/**
+ * @brief Number of histogram buckets per zone.
+ *
+ * Bucket `i` counts durations in `[2^i, 2^(i+1))` nanoseconds; the last bucket
+ * also holds everything longer.
+ */
+#define PICO_PROFILER_HISTOGRAM_BUCKETS 32
+
+/**
+ * @struct PerfZoneStats
+ * @brief Aggregated statistics of a zone.
+ */
+typedef struct
+{
+    const char *name;                                      /**< Zone name */
+    uint64_t count;                                        /**< Number of closed measurements */
+    uint64_t total_ns;                                     /**< Sum of all durations */
+    uint64_t min_ns;                                       /**< Shortest duration */
+    uint64_t max_ns;                                       /**< Longest duration */
+    uint64_t histogram[PICO_PROFILER_HISTOGRAM_BUCKETS];   /**< Log2 duration histogram */
+} PerfZoneStats;
+
+/**
+ * @struct PerfScope
+ * @brief An open zone on the current thread, used by `PERF_SCOPE`.
+ */
+typedef struct
+{
+    int zone_id; /**< Zone the scope belongs to, or -1 when inactive */
+} PerfScope;
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return The current time in nanoseconds.
+ */
+uint64_t perf_now_ns(void);
+
+/**
+ * @brief Registers a zone, or finds it if the name is already registered.
+ * @param name Name of the zone. It is copied.
+ * @return The zone ID, or -1 if the zone table is full.
+ */
+int perf_zone_register(const char *name);
+
+/**
+ * @brief Opens a zone on the calling thread's stack.
+ * @param zone_id ID returned by `perf_zone_register`.
+ */
+void perf_zone_begin(int zone_id);
+
+/**
+ * @brief Closes the innermost open instance of a zone on the calling thread.
+ *
+ * Zones opened after it and still open are closed too.
+ *
+ * @param zone_id ID returned by `perf_zone_register`.
+ * @return The measured duration in nanoseconds, or 0 if the zone was not open.
+ */
+uint64_t perf_zone_end(int zone_id);
+
+/**
+ * @brief Adds an externally measured duration to a zone.
+ * @param zone_id ID returned by `perf_zone_register`.
+ * @param duration_ns The duration in nanoseconds.
+ */
+void perf_zone_record(int zone_id, uint64_t duration_ns);
+
+/**
+ * @brief Copies the statistics of a zone.
+ * @param zone_id ID returned by `perf_zone_register`.
+ * @param stats Output statistics.
+ * @return true if the zone exists.
+ */
+bool perf_zone_get_stats(int zone_id, PerfZoneStats *stats);
+
+/**
+ * @brief Returns the number of registered zones.
+ *
+ * Zone IDs range from 0 to the returned value minus one.
+ */
+size_t perf_zone_count(void);
+
+/**
+ * @brief Clears the statistics of every zone. Registered names are kept.
+ */
+void perf_zone_reset(void);
+
+/**
+ * @brief Enables or disables measurements at runtime.
+ *
+ * When disabled, opening and closing zones only costs one atomic load.
+ */
+void perf_set_enabled(bool enabled);
+
+/**
+ * @brief Prints a table of every zone that recorded at least one measurement.
+ * @param fp The stream to write to.
+ */
+void perf_report(FILE *fp);
+
+/**
+ * @brief Begins a scope for `PERF_SCOPE`.
+ */
+PerfScope perf_scope_begin(int zone_id);
+
+/**
+ * @brief Cleanup handler of `PERF_SCOPE`.
+ */
+void perf_scope_end(PerfScope *scope);
+
+#define PICO_PERF_CONCAT_(a, b) a##b
+#define PICO_PERF_CONCAT(a, b) PICO_PERF_CONCAT_(a, b)
+
+/**
+ * @brief Resolves a zone name to its ID once per call site.
+ */
+#define PERF_ZONE_ID(name)                                                                      \
+    ({                                                                                          \
+        static atomic_int perf_zone_id_ = -1;                                                   \
+        int perf_id_ = atomic_load_explicit(&perf_zone_id_, memory_order_relaxed);              \
+        if (perf_id_ < 0)                                                                       \
+        {                                                                                       \
+            perf_id_ = perf_zone_register(name);                                                \
+            atomic_store_explicit(&perf_zone_id_, perf_id_, memory_order_relaxed);              \
+        }                                                                                       \
+        perf_id_;                                                                               \
+    })
+
+#ifndef PICO_PROFILER_DISABLED
+
+/**
+ * @brief Measures the rest of the enclosing block as the zone `name`.
+ */
+#define PERF_SCOPE(name)                                                               \
+    PerfScope PICO_PERF_CONCAT(perf_scope_, __LINE__) __attribute__((cleanup(perf_scope_end))) = \
+        perf_scope_begin(PERF_ZONE_ID(name))
+
+/**
+ * @brief Opens the zone `name`. Must be matched by `PERF_ZONE_END(name)`.
+ */
+#define PERF_ZONE_BEGIN(name) perf_zone_begin(PERF_ZONE_ID(name))
+
+/**
+ * @brief Closes the zone `name` opened by `PERF_ZONE_BEGIN(name)`.
+ */
+#define PERF_ZONE_END(name) ((void)perf_zone_end(PERF_ZONE_ID(name)))
+
+#else
+
+#define PERF_SCOPE(name) ((void)0)
+#define PERF_ZONE_BEGIN(name) ((void)0)
+#define PERF_ZONE_END(name) ((void)0)
+
+#endif
+
+#endif
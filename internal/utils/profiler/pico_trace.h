@@ -0,0 +1,94 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file pico_trace.h
+ * @brief In-memory trace of profiler zones, exported as Chrome Trace Event JSON.
+ *
+ * While tracing is active, every closed profiler zone is stored as a complete
+ * ("X") event in a fixed-size ring buffer. The buffer is only formatted when
+ * it is dumped, and the resulting file opens in `chrome://tracing` and in the
+ * Perfetto UI. When tracing is inactive, closing a zone costs one atomic load.
+ */
+
+#ifndef PICO_TRACE_H
+#define PICO_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Allocates the event buffer and starts tracing.
+ *
+ * When the buffer is full, the oldest events are overwritten.
+ *
+ * @param capacity Number of events kept in memory.
+ * @return true on success.
+ */
+bool pico_trace_start(size_t capacity);
+
+/**
+ * @brief Stops recording events. The buffer is kept until the next start.
+ */
+void pico_trace_stop(void);
+
+/**
+ * @brief Returns true while events are being recorded.
+ */
+bool pico_trace_is_enabled(void);
+
+/**
+ * @brief Records a complete event for a profiler zone.
+ *
+ * Called by the profiler when a zone closes; applications normally don't call
+ * it directly.
+ *
+ * @param zone_id Profiler zone ID.
+ * @param start_ns Start of the event on the profiler clock.
+ * @param duration_ns Duration of the event.
+ */
+void pico_trace_complete(int zone_id, uint64_t start_ns, uint64_t duration_ns);
+
+/**
+ * @brief Writes the buffered events to a file as Chrome Trace Event JSON.
+ * @param path Destination path.
+ * @return true on success.
+ */
+bool pico_trace_dump(const char *path);
+
+/**
+ * @brief Requests a dump to `path` whenever the process receives `signo`.
+ *
+ * The signal handler only sets a flag; the file is written by the next call
+ * to `pico_trace_poll()`, which GLPS makes from `glps_wm_should_close()`.
+ *
+ * @param signo Signal number, e.g. SIGUSR1.
+ * @param path Destination path. It is copied.
+ */
+void pico_trace_dump_on_signal(int signo, const char *path);
+
+/**
+ * @brief Performs a dump requested by a signal, if any.
+ */
+void pico_trace_poll(void);
+
+#endif
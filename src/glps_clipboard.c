@@ -0,0 +1,575 @@
+#define _GNU_SOURCE
+#include "glps_clipboard.h"
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+
+static bool wait_for_fd(int fd, short events) {
+  struct pollfd pfd = {.fd = fd, .events = events};
+  int ret;
+  while ((ret = poll(&pfd, 1, -1)) < 0 && errno == EINTR) {
+  }
+  return ret > 0;
+}
+
+static bool write_all(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = write(fd, data, size);
+    if (n > 0) {
+      data += n;
+      size -= (size_t)n;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else if (n < 0 && errno == EAGAIN) {
+      if (!wait_for_fd(fd, POLLOUT))
+        return false;
+    } else {
+      LOG_ERROR("Error writing clipboard data: %s", strerror(errno));
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool buffer_reserve(glps_ClipboardBuffer *buffer, size_t capacity) {
+  if (capacity <= buffer->capacity)
+    return true;
+
+  size_t new_capacity = buffer->capacity ? buffer->capacity
+                                         : GLPS_CLIPBOARD_INITIAL_CAPACITY;
+  while (new_capacity < capacity) {
+    if (new_capacity > SIZE_MAX / 2) {
+      new_capacity = capacity;
+      break;
+    }
+    new_capacity *= 2;
+  }
+
+  char *data = realloc(buffer->data, new_capacity);
+  if (data == NULL) {
+    LOG_ERROR("Failed to allocate %zu bytes for clipboard data.", new_capacity);
+    return false;
+  }
+
+  buffer->data = data;
+  buffer->capacity = new_capacity;
+  return true;
+}
+
+static void set_mime_type(glps_ClipboardSource *source, const char *mime) {
+  strncpy(source->mime_type, mime ? mime : "text/plain",
+          sizeof(source->mime_type) - 1);
+  source->mime_type[sizeof(source->mime_type) - 1] = '\0';
+}
+
+void glps_clipboard_source_init(glps_ClipboardSource *source) {
+  memset(source, 0, sizeof(*source));
+  source->fd = -1;
+}
+
+bool glps_clipboard_source_copy(glps_ClipboardSource *source, const char *mime,
+                                const void *data, size_t size) {
+  int fd = memfd_create("glps-clipboard", MFD_CLOEXEC);
+  if (fd < 0) {
+    LOG_ERROR("Failed to create clipboard memfd: %s", strerror(errno));
+    return false;
+  }
+
+  if (!write_all(fd, data, size)) {
+    close(fd);
+    return false;
+  }
+
+  glps_clipboard_source_release(source);
+  set_mime_type(source, mime);
+  source->fd = fd;
+  source->size = size;
+  return true;
+}
+
+bool glps_clipboard_source_set_buffer(glps_ClipboardSource *source,
+                                      const char *mime, const void *data,
+                                      size_t size) {
+  if (data == NULL && size > 0) {
+    LOG_ERROR("Clipboard buffer is NULL.");
+    return false;
+  }
+
+  glps_clipboard_source_release(source);
+  set_mime_type(source, mime);
+  source->data = data;
+  source->size = size;
+  return true;
+}
+
+bool glps_clipboard_source_set_fd(glps_ClipboardSource *source,
+                                  const char *mime, int fd, size_t size) {
+  if (size == 0) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+      LOG_ERROR("Failed to stat clipboard descriptor: %s", strerror(errno));
+      return false;
+    }
+    size = (size_t)st.st_size;
+  }
+
+  int dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if (dup_fd < 0) {
+    LOG_ERROR("Failed to duplicate clipboard descriptor: %s", strerror(errno));
+    return false;
+  }
+
+  glps_clipboard_source_release(source);
+  set_mime_type(source, mime);
+  source->fd = dup_fd;
+  source->size = size;
+  return true;
+}
+
+bool glps_clipboard_source_set_provider(glps_ClipboardSource *source,
+                                        const char *mime,
+                                        glps_ClipboardProviderFn provider,
+                                        void *data) {
+  if (provider == NULL) {
+    LOG_ERROR("Clipboard provider is NULL.");
+    return false;
+  }
+
+  glps_clipboard_source_release(source);
+  set_mime_type(source, mime);
+  source->provider = provider;
+  source->provider_data = data;
+  return true;
+}
+
+static bool provide(const glps_ClipboardSource *source, const char *mime,
+                    const void **data, size_t *size) {
+  *data = source->data;
+  *size = source->size;
+  if (source->provider == NULL)
+    return true;
+
+  *data = NULL;
+  *size = 0;
+  if (!source->provider(mime, data, size, source->provider_data) ||
+      (*data == NULL && *size > 0)) {
+    LOG_WARNING("Clipboard provider for %s produced no data.", mime);
+    return false;
+  }
+  return true;
+}
+
+bool glps_clipboard_send_begin(glps_ClipboardSend *send,
+                               const glps_ClipboardSource *source,
+                               const char *mime, int fd) {
+  *send = (glps_ClipboardSend){.fd = fd, .source_fd = -1};
+
+  // The pipe is written from the event loop, a slow reader must not stall it.
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+    LOG_ERROR("Failed to make clipboard pipe non-blocking: %s",
+              strerror(errno));
+    return false;
+  }
+
+  if (source->fd >= 0) {
+    // The duplicate outlives a selection replaced mid-send.
+    send->source_fd = fcntl(source->fd, F_DUPFD_CLOEXEC, 0);
+    if (send->source_fd < 0) {
+      LOG_ERROR("Failed to duplicate clipboard descriptor: %s",
+                strerror(errno));
+      return false;
+    }
+    send->size = source->size;
+    return true;
+  }
+
+  const void *data;
+  size_t size;
+  if (!provide(source, mime, &data, &size))
+    return false;
+  send->size = size;
+  if (source->provider == NULL) {
+    // Caller buffers live until the selection is replaced, which ends sends.
+    send->data = data;
+    return true;
+  }
+
+  // Provided data only lives until the next call, another paste may come
+  // before this one is written.
+  char *copy = malloc(size > 0 ? size : 1);
+  if (copy == NULL) {
+    LOG_ERROR("Failed to allocate %zu bytes for clipboard data.", size);
+    return false;
+  }
+  if (size > 0)
+    memcpy(copy, data, size);
+  send->data = copy;
+  send->owned = true;
+  return true;
+}
+
+// A reader closing early must fail writes with EPIPE instead of raising
+// SIGPIPE, whose default action kills the application.
+static bool block_sigpipe(sigset_t *old_mask) {
+  sigset_t set, pending;
+  sigemptyset(&set);
+  sigaddset(&set, SIGPIPE);
+  sigpending(&pending);
+  pthread_sigmask(SIG_BLOCK, &set, old_mask);
+  return sigismember(&pending, SIGPIPE);
+}
+
+static void restore_sigpipe(const sigset_t *old_mask, bool was_pending,
+                            bool raised) {
+  // Only the SIGPIPE this thread raised is consumed.
+  if (raised && !was_pending) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    struct timespec zero = {0};
+    while (sigtimedwait(&set, NULL, &zero) < 0 && errno == EINTR) {
+    }
+  }
+  pthread_sigmask(SIG_SETMASK, old_mask, NULL);
+}
+
+static ssize_t send_chunk(glps_ClipboardSend *send, size_t count) {
+  if (send->source_fd < 0)
+    return write(send->fd, send->data + send->offset, count);
+
+  if (!send->bounce) {
+    // The kernel moves the pages straight from the memfd into the pipe.
+    off_t offset = (off_t)send->offset;
+    ssize_t n = sendfile(send->fd, send->source_fd, &offset, count);
+    if (n >= 0 || (errno != EINVAL && errno != ENOSYS))
+      return n;
+    // Descriptors sendfile can't read from fall back to a bounce buffer.
+    send->bounce = true;
+  }
+
+  // A partial write is read again next time, pread leaves no state behind.
+  char chunk[65536];
+  ssize_t got = pread(send->source_fd, chunk,
+                      count < sizeof(chunk) ? count : sizeof(chunk),
+                      (off_t)send->offset);
+  if (got <= 0)
+    return got;
+  return write(send->fd, chunk, (size_t)got);
+}
+
+int glps_clipboard_send_some(glps_ClipboardSend *send) {
+  size_t budget = GLPS_CLIPBOARD_WRITE_BUDGET;
+  sigset_t old_mask;
+  bool was_pending = block_sigpipe(&old_mask);
+  bool raised = false;
+  int result = 1;
+
+  while (send->offset < send->size && budget > 0) {
+    size_t count = send->size - send->offset;
+    ssize_t n = send_chunk(send, count < budget ? count : budget);
+    if (n > 0) {
+      send->offset += (size_t)n;
+      budget = (size_t)n < budget ? budget - (size_t)n : 0;
+    } else if (n == 0) {
+      // Sources shorter than announced end the data early.
+      LOG_WARNING("Clipboard source ended after %zu of %zu bytes.",
+                  send->offset, send->size);
+      send->size = send->offset;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN) {
+      break;
+    } else if (errno == EPIPE) {
+      raised = true;
+      LOG_INFO("Clipboard reader closed the pipe after %zu bytes.",
+               send->offset);
+      send->size = send->offset;
+    } else {
+      LOG_ERROR("Error sending clipboard data: %s", strerror(errno));
+      result = -1;
+      break;
+    }
+  }
+
+  restore_sigpipe(&old_mask, was_pending, raised);
+  if (result > 0 && send->offset >= send->size)
+    result = 0;
+  return result;
+}
+
+void glps_clipboard_send_end(glps_ClipboardSend *send) {
+  close(send->fd);
+  if (send->source_fd >= 0)
+    close(send->source_fd);
+  if (send->owned)
+    free((void *)send->data);
+  *send = (glps_ClipboardSend){.fd = -1, .source_fd = -1};
+}
+
+bool glps_clipboard_source_read(const glps_ClipboardSource *source,
+                                const char *mime,
+                                glps_ClipboardBuffer *buffer) {
+  if (source->fd < 0) {
+    const void *data;
+    size_t size;
+    if (!provide(source, mime, &data, &size) ||
+        !buffer_reserve(buffer, size + 1))
+      return false;
+
+    if (size > 0)
+      memcpy(buffer->data, data, size);
+    buffer->size = size;
+    buffer->data[buffer->size] = '\0';
+    return true;
+  }
+
+  if (!buffer_reserve(buffer, source->size + 1))
+    return false;
+
+  buffer->size = 0;
+  while (buffer->size < source->size) {
+    ssize_t n = pread(source->fd, buffer->data + buffer->size,
+                      source->size - buffer->size, (off_t)buffer->size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    buffer->size += (size_t)n;
+  }
+  buffer->data[buffer->size] = '\0';
+
+  return buffer->size == source->size;
+}
+
+void glps_clipboard_source_release(glps_ClipboardSource *source) {
+  if (source->fd >= 0)
+    close(source->fd);
+  glps_clipboard_source_init(source);
+}
+
+void glps_clipboard_sources_release(glps_ClipboardSource *sources,
+                                    size_t count) {
+  for (size_t i = 0; i < count; ++i)
+    glps_clipboard_source_release(&sources[i]);
+}
+
+int glps_clipboard_buffer_read_some(glps_ClipboardBuffer *buffer, int fd) {
+  size_t budget = GLPS_CLIPBOARD_READ_BUDGET;
+
+  // Read straight into the buffer, one byte is always kept for the NUL.
+  while (budget > 0) {
+    if (buffer->capacity - buffer->size < 2 &&
+        !buffer_reserve(buffer, buffer->capacity + 1))
+      return -1;
+
+    ssize_t n = read(fd, buffer->data + buffer->size,
+                     buffer->capacity - buffer->size - 1);
+    if (n > 0) {
+      buffer->size += (size_t)n;
+      buffer->data[buffer->size] = '\0';
+      budget = (size_t)n < budget ? budget - (size_t)n : 0;
+    } else if (n == 0) {
+      buffer->data[buffer->size] = '\0';
+      return 0;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN) {
+      return 1;
+    } else {
+      LOG_ERROR("Error reading clipboard data: %s", strerror(errno));
+      buffer->data[buffer->size] = '\0';
+      return -1;
+    }
+  }
+
+  return 1;
+}
+
+int glps_clipboard_splice_some(int fd, int out_fd, size_t *written) {
+  size_t budget = GLPS_CLIPBOARD_READ_BUDGET;
+  bool can_splice = true;
+
+  // Pages move from the pipe into the file without passing through userspace.
+  while (budget > 0) {
+    ssize_t n;
+    if (can_splice) {
+      n = splice(fd, NULL, out_fd, NULL, budget,
+                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (n < 0 && errno == EINVAL) {
+        // Descriptors splice can't write to, e.g. O_APPEND files.
+        can_splice = false;
+        continue;
+      }
+    } else {
+      char chunk[65536];
+      n = read(fd, chunk, budget < sizeof(chunk) ? budget : sizeof(chunk));
+      if (n > 0 && !write_all(out_fd, chunk, (size_t)n))
+        return -1;
+    }
+
+    if (n > 0) {
+      *written += (size_t)n;
+      budget = (size_t)n < budget ? budget - (size_t)n : 0;
+    } else if (n == 0) {
+      return 0;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN) {
+      return 1;
+    } else {
+      LOG_ERROR("Error streaming clipboard data: %s", strerror(errno));
+      return -1;
+    }
+  }
+
+  return 1;
+}
+
+bool glps_clipboard_buffer_write(const glps_ClipboardBuffer *buffer, int fd) {
+  return write_all(fd, buffer->data, buffer->size);
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Decodes a file URI into out, which has room for the whole URI.
+static bool decode_file_uri(const char *uri, char *out) {
+  if (strncmp(uri, "file://", 7) != 0)
+    return false;
+
+  // Only files on this host can be opened.
+  const char *path = strchr(uri + 7, '/');
+  if (path == NULL)
+    return false;
+  size_t host_len = (size_t)(path - (uri + 7));
+  if (host_len > 0) {
+    char host[256];
+    if ((host_len != 9 || strncmp(uri + 7, "localhost", 9) != 0) &&
+        (gethostname(host, sizeof(host)) != 0 || strlen(host) != host_len ||
+         strncmp(uri + 7, host, host_len) != 0))
+      return false;
+  }
+
+  for (; *path != '\0'; ++path) {
+    if (*path == '%') {
+      int high = hex_value(path[1]);
+      int low = high < 0 ? -1 : hex_value(path[2]);
+      if (low < 0 || (high == 0 && low == 0))
+        return false;
+      *out++ = (char)(high << 4 | low);
+      path += 2;
+    } else {
+      *out++ = *path;
+    }
+  }
+  *out = '\0';
+  return true;
+}
+
+glps_DroppedFile *glps_clipboard_parse_uri_list(char *list, size_t size,
+                                                size_t *count) {
+  *count = 0;
+
+  size_t max_count = 1;
+  for (size_t i = 0; i < size; ++i)
+    max_count += list[i] == '\n';
+
+  // One allocation holds the entries followed by the decoded paths.
+  glps_DroppedFile *files =
+      malloc(max_count * sizeof(glps_DroppedFile) + size + 1);
+  if (files == NULL) {
+    LOG_ERROR("Failed to allocate the dropped file list.");
+    return NULL;
+  }
+  char *paths = (char *)(files + max_count);
+
+  char *line = list;
+  char *end = list + size;
+  while (line < end) {
+    char *next = memchr(line, '\n', (size_t)(end - line));
+    char *line_end = next ? next : end;
+    if (line_end > line && line_end[-1] == '\r')
+      line_end--;
+    *line_end = '\0';
+
+    // Lines starting with # are comments (RFC 2483).
+    if (line[0] != '\0' && line[0] != '#') {
+      glps_DroppedFile *file = &files[(*count)++];
+      *file = (glps_DroppedFile){.uri = line};
+      if (decode_file_uri(line, paths)) {
+        file->path = paths;
+        paths += strlen(paths) + 1;
+      }
+    }
+
+    if (next == NULL)
+      break;
+    line = next + 1;
+  }
+
+  return files;
+}
+
+void glps_clipboard_map_files(glps_DroppedFile *files, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (files[i].path == NULL)
+      continue;
+
+    int fd = open(files[i].path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      LOG_WARNING("Failed to open dropped file %s: %s", files[i].path,
+                  strerror(errno));
+      continue;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+      void *data =
+          mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        // Pages are faulted in as the application reads, ahead of it.
+        madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+        files[i].data = data;
+        files[i].size = (size_t)st.st_size;
+      } else {
+        LOG_WARNING("Failed to map dropped file %s: %s", files[i].path,
+                    strerror(errno));
+      }
+    }
+    close(fd);
+  }
+}
+
+void glps_clipboard_unmap_files(glps_DroppedFile *files, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (files[i].data != NULL)
+      munmap((void *)files[i].data, files[i].size);
+    files[i].data = NULL;
+    files[i].size = 0;
+  }
+}
+
+void glps_clipboard_buffer_clear(glps_ClipboardBuffer *buffer) {
+  buffer->size = 0;
+  if (buffer->data != NULL)
+    buffer->data[0] = '\0';
+}
+
+void glps_clipboard_buffer_free(glps_ClipboardBuffer *buffer) {
+  free(buffer->data);
+  memset(buffer, 0, sizeof(*buffer));
+}
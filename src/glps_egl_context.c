@@ -1,75 +1,479 @@
 
-#ifdef GLPS_USE_WAYLAND
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
 
 #include <glps_egl_context.h>
 
+#ifdef GLPS_USE_WAYLAND
+#include "glps_wayland.h"
+#endif
+
+static bool __egl_has_extension(const char *extensions, const char *name) {
+  size_t len = strlen(name);
+  for (const char *ext = extensions; ext != NULL && *ext != '\0';) {
+    if (strncmp(ext, name, len) == 0 && (ext[len] == ' ' || ext[len] == '\0'))
+      return true;
+    ext = strchr(ext, ' ');
+    if (ext != NULL)
+      ext++;
+  }
+  return false;
+}
+
+static EGLenum __egl_api(const glps_ContextDesc *desc) {
+  return desc->api == GLPS_CONTEXT_API_OPENGL ? EGL_OPENGL_API
+                                              : EGL_OPENGL_ES_API;
+}
+
+static EGLint __egl_renderable_type(const glps_ContextDesc *desc) {
+  if (desc->api == GLPS_CONTEXT_API_OPENGL)
+    return EGL_OPENGL_BIT;
+  return desc->major >= 3 ? EGL_OPENGL_ES3_BIT : EGL_OPENGL_ES2_BIT;
+}
+
+#ifdef GLPS_USE_X11
+// Renders to windows of the XCB connection, without an Xlib display.
+static EGLDisplay __egl_get_xcb_display(glps_WindowManager *wm) {
+  const char *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (!__egl_has_extension(client_extensions, "EGL_EXT_platform_xcb"))
+    return EGL_NO_DISPLAY;
+
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+          "eglGetPlatformDisplayEXT");
+  PFNEGLCREATEPLATFORMWINDOWSURFACEEXTPROC create_platform_window_surface =
+      (PFNEGLCREATEPLATFORMWINDOWSURFACEEXTPROC)eglGetProcAddress(
+          "eglCreatePlatformWindowSurfaceEXT");
+  if (get_platform_display == NULL || create_platform_window_surface == NULL)
+    return EGL_NO_DISPLAY;
+
+  EGLint attribs[] = {EGL_PLATFORM_XCB_SCREEN_EXT,
+                      wm->x11_ctx->screen_number, EGL_NONE};
+  EGLDisplay dpy = get_platform_display(EGL_PLATFORM_XCB_EXT,
+                                        wm->x11_ctx->connection, attribs);
+  if (dpy != EGL_NO_DISPLAY)
+    wm->egl_ctx->create_platform_window_surface =
+        create_platform_window_surface;
+  return dpy;
+}
+#endif
+
 void glps_egl_init(glps_WindowManager *wm) {
 
-  wm->egl_ctx = malloc(sizeof(glps_EGLContext));
+  wm->egl_ctx = calloc(1, sizeof(glps_EGLContext));
+
+  EGLint major, minor;
 
+#ifdef GLPS_USE_WAYLAND
+  wm->egl_ctx->dpy =
+      eglGetDisplay((EGLNativeDisplayType)wm->wayland_ctx->wl_display);
+#else
+  wm->egl_ctx->dpy = __egl_get_xcb_display(wm);
+  if (wm->egl_ctx->dpy == EGL_NO_DISPLAY) {
+    LOG_WARNING("EGL_EXT_platform_xcb unsupported, opening an Xlib display "
+                "for EGL.");
+    wm->x11_ctx->egl_display = XOpenDisplay(NULL);
+    if (wm->x11_ctx->egl_display == NULL) {
+      LOG_ERROR("Failed to open X display for EGL");
+      exit(EXIT_FAILURE);
+    }
+    wm->egl_ctx->dpy =
+        eglGetDisplay((EGLNativeDisplayType)wm->x11_ctx->egl_display);
+  }
+#endif
+  assert(wm->egl_ctx->dpy);
+
+  if (!eglInitialize(wm->egl_ctx->dpy, &major, &minor)) {
+    LOG_ERROR("Failed to initialize EGL");
+    exit(EXIT_FAILURE);
+  }
+
+  LOG_INFO("EGL initialized successfully (version %d.%d)", major, minor);
+
+  const char *extensions = eglQueryString(wm->egl_ctx->dpy, EGL_EXTENSIONS);
+  wm->egl_ctx->has_no_config_context =
+      __egl_has_extension(extensions, "EGL_KHR_no_config_context") ||
+      __egl_has_extension(extensions, "EGL_MESA_configless_context");
+  wm->egl_ctx->has_gl_colorspace =
+      __egl_has_extension(extensions, "EGL_KHR_gl_colorspace");
+  wm->egl_ctx->has_no_error =
+      __egl_has_extension(extensions, "EGL_KHR_create_context_no_error");
+  wm->egl_ctx->has_robustness =
+      __egl_has_extension(extensions, "EGL_EXT_create_context_robustness");
+  wm->egl_ctx->has_surfaceless =
+      __egl_has_extension(extensions, "EGL_KHR_surfaceless_context");
+  wm->egl_ctx->conf = EGL_NO_CONFIG_KHR;
+
+  if (__egl_has_extension(extensions, "EGL_KHR_fence_sync")) {
+    wm->egl_ctx->create_sync =
+        (PFNEGLCREATESYNCKHRPROC)eglGetProcAddress("eglCreateSyncKHR");
+    wm->egl_ctx->destroy_sync =
+        (PFNEGLDESTROYSYNCKHRPROC)eglGetProcAddress("eglDestroySyncKHR");
+    wm->egl_ctx->client_wait_sync =
+        (PFNEGLCLIENTWAITSYNCKHRPROC)eglGetProcAddress("eglClientWaitSyncKHR");
+  }
+  if (__egl_has_extension(extensions, "EGL_KHR_wait_sync")) {
+    wm->egl_ctx->wait_sync =
+        (PFNEGLWAITSYNCKHRPROC)eglGetProcAddress("eglWaitSyncKHR");
+  }
+}
+
+// Compared field by field, padding after srgb isn't preserved by copies.
+static bool __egl_same_surface_desc(const glps_SurfaceDesc *a,
+                                    const glps_SurfaceDesc *b) {
+  return a->red_bits == b->red_bits && a->green_bits == b->green_bits &&
+         a->blue_bits == b->blue_bits && a->alpha_bits == b->alpha_bits &&
+         a->depth_bits == b->depth_bits &&
+         a->stencil_bits == b->stencil_bits && a->samples == b->samples &&
+         a->srgb == b->srgb;
+}
+
+bool glps_egl_choose_config(glps_WindowManager *wm,
+                            const glps_SurfaceDesc *desc, EGLConfig *config) {
+  glps_EGLContext *egl = wm->egl_ctx;
+  EGLint renderable = __egl_renderable_type(&wm->context_desc);
+
+  for (size_t i = 0; i < egl->config_cache_count; ++i) {
+    glps_EGLConfigCacheEntry *entry = &egl->config_cache[i];
+    if (entry->renderable == renderable &&
+        __egl_same_surface_desc(&entry->desc, desc)) {
+      *config = entry->config;
+      return true;
+    }
+  }
+
+  PERF_SCOPE("eglChooseConfig");
   EGLint config_attribs[] = {EGL_SURFACE_TYPE,
                              EGL_WINDOW_BIT,
                              EGL_RED_SIZE,
-                             8,
+                             desc->red_bits,
                              EGL_GREEN_SIZE,
-                             8,
+                             desc->green_bits,
                              EGL_BLUE_SIZE,
-                             8,
+                             desc->blue_bits,
                              EGL_ALPHA_SIZE,
-                             8,
+                             desc->alpha_bits,
+                             EGL_DEPTH_SIZE,
+                             desc->depth_bits,
+                             EGL_STENCIL_SIZE,
+                             desc->stencil_bits,
+                             EGL_SAMPLE_BUFFERS,
+                             desc->samples > 0 ? 1 : 0,
+                             EGL_SAMPLES,
+                             desc->samples,
                              EGL_RENDERABLE_TYPE,
-                             EGL_OPENGL_BIT,
+                             renderable,
                              EGL_NONE};
 
-  EGLint major, minor, n;
+  EGLint n = 0;
+  EGLConfig configs[64];
+  if (!eglChooseConfig(egl->dpy, config_attribs, configs, 64, &n) || n < 1) {
+    LOG_ERROR("No EGL config matches the surface descriptor: 0x%x",
+              eglGetError());
+    return false;
+  }
 
-  wm->egl_ctx->dpy =
-      eglGetDisplay((EGLNativeDisplayType)wm->wayland_ctx->wl_display);
-  assert(wm->egl_ctx->dpy);
+  // Configs are sorted deepest color first, prefer the exact channel sizes so
+  // RGBA8 isn't answered with a 10-bit config.
+  *config = configs[0];
+  for (EGLint i = 0; i < n; ++i) {
+    EGLint r, g, b, a;
+    eglGetConfigAttrib(egl->dpy, configs[i], EGL_RED_SIZE, &r);
+    eglGetConfigAttrib(egl->dpy, configs[i], EGL_GREEN_SIZE, &g);
+    eglGetConfigAttrib(egl->dpy, configs[i], EGL_BLUE_SIZE, &b);
+    eglGetConfigAttrib(egl->dpy, configs[i], EGL_ALPHA_SIZE, &a);
+    if (r == desc->red_bits && g == desc->green_bits &&
+        b == desc->blue_bits && a == desc->alpha_bits) {
+      *config = configs[i];
+      break;
+    }
+  }
 
-  if (!eglInitialize(wm->egl_ctx->dpy, &major, &minor)) {
-    LOG_ERROR("Failed to initialize EGL");
-    exit(EXIT_FAILURE);
+  glps_EGLConfigCacheEntry *entry;
+  if (egl->config_cache_count < GLPS_EGL_CONFIG_CACHE_SIZE) {
+    entry = &egl->config_cache[egl->config_cache_count++];
+  } else {
+    entry = &egl->config_cache[egl->config_cache_next];
+    egl->config_cache_next =
+        (egl->config_cache_next + 1) % GLPS_EGL_CONFIG_CACHE_SIZE;
   }
+  *entry = (glps_EGLConfigCacheEntry){
+      .desc = *desc, .renderable = renderable, .config = *config};
+  return true;
+}
 
-  LOG_INFO("EGL initialized successfully (version %d.%d)", major, minor);
+bool glps_egl_surface_config(glps_WindowManager *wm, EGLConfig *config) {
+  glps_EGLContext *egl = wm->egl_ctx;
+  if (!glps_egl_choose_config(wm, &wm->surface_desc, config)) {
+    return false;
+  }
 
-  if (!eglChooseConfig(wm->egl_ctx->dpy, config_attribs, &wm->egl_ctx->conf, 1,
-                       &n) ||
-      n != 1) {
-    LOG_ERROR("Failed to choose a valid EGL config");
-    exit(EXIT_FAILURE);
+  // Without EGL_KHR_no_config_context every surface must match the context.
+  if (egl->ctx == EGL_NO_CONTEXT) {
+    egl->conf = *config;
+  } else if (egl->conf != EGL_NO_CONFIG_KHR && egl->conf != *config) {
+    LOG_WARNING("Surface descriptor differs from the context's, using the "
+                "context's config.");
+    *config = egl->conf;
   }
+  return true;
+}
 
-  if (!eglBindAPI(EGL_OPENGL_API)) {
-    LOG_ERROR("Failed to bind OpenGL API");
-    exit(EXIT_FAILURE);
+EGLSurface glps_egl_create_surface(glps_WindowManager *wm,
+                                   EGLNativeWindowType native_window,
+                                   void *platform_window) {
+  glps_EGLContext *egl = wm->egl_ctx;
+  EGLConfig config;
+  if (!glps_egl_surface_config(wm, &config)) {
+    return EGL_NO_SURFACE;
   }
-  EGLint error = eglGetError();
-  if (error != EGL_SUCCESS) {
-    LOG_ERROR("EGL error: %x", error);
+
+  EGLint surface_attribs[3] = {EGL_NONE};
+  if (wm->surface_desc.srgb) {
+    if (egl->has_gl_colorspace) {
+      surface_attribs[0] = EGL_GL_COLORSPACE_KHR;
+      surface_attribs[1] = EGL_GL_COLORSPACE_SRGB_KHR;
+      surface_attribs[2] = EGL_NONE;
+    } else {
+      LOG_WARNING("EGL_KHR_gl_colorspace unsupported, surface is not sRGB.");
+    }
   }
+
+  if (egl->create_platform_window_surface != NULL) {
+    return egl->create_platform_window_surface(egl->dpy, config,
+                                               platform_window, surface_attribs);
+  }
+  return eglCreateWindowSurface(egl->dpy, config, native_window,
+                                surface_attribs);
 }
 
 void glps_egl_create_ctx(glps_WindowManager *wm) {
-  static const EGLint context_attribs[] = {
-      EGL_CONTEXT_MAJOR_VERSION,
-      4,
-      EGL_CONTEXT_MINOR_VERSION,
-      5,
-      EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR,
-      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
-      EGL_NONE};
-
-  wm->egl_ctx->ctx = eglCreateContext(wm->egl_ctx->dpy, wm->egl_ctx->conf,
-                                      EGL_NO_CONTEXT, context_attribs);
-  if (wm->egl_ctx->ctx == EGL_NO_CONTEXT) {
-    fprintf(stderr, "Failed to create EGL context\n");
+  glps_EGLContext *egl = wm->egl_ctx;
+  const glps_ContextDesc *desc = &wm->context_desc;
+
+  EGLenum api = __egl_api(desc);
+  if (!eglBindAPI(api)) {
+    LOG_ERROR("Failed to bind %s API",
+              api == EGL_OPENGL_API ? "OpenGL" : "OpenGL ES");
     exit(EXIT_FAILURE);
   }
+
+  bool no_error = desc->no_error && egl->has_no_error;
+  if (desc->no_error && !egl->has_no_error) {
+    LOG_WARNING("EGL_KHR_create_context_no_error unsupported.");
+  }
+  if (no_error && (desc->debug || desc->robust)) {
+    LOG_WARNING("No-error contexts can't be debug or robust, ignoring.");
+    no_error = false;
+  }
+
+  EGLint *context_attribs = egl->context_attribs;
+  size_t n = 0;
+  context_attribs[n++] = EGL_CONTEXT_MAJOR_VERSION;
+  context_attribs[n++] = desc->major;
+  context_attribs[n++] = EGL_CONTEXT_MINOR_VERSION;
+  context_attribs[n++] = desc->minor;
+  if (desc->api == GLPS_CONTEXT_API_OPENGL) {
+    context_attribs[n++] = EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR;
+    context_attribs[n++] = desc->core_profile
+                               ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR
+                               : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR;
+  }
+  if (desc->debug) {
+    context_attribs[n++] = EGL_CONTEXT_OPENGL_DEBUG;
+    context_attribs[n++] = EGL_TRUE;
+  }
+  if (desc->robust) {
+    context_attribs[n++] = egl->has_robustness
+                               ? EGL_CONTEXT_OPENGL_ROBUST_ACCESS_EXT
+                               : EGL_CONTEXT_OPENGL_ROBUST_ACCESS;
+    context_attribs[n++] = EGL_TRUE;
+  }
+  size_t no_error_attrib = n;
+  if (no_error) {
+    context_attribs[n++] = EGL_CONTEXT_OPENGL_NO_ERROR_KHR;
+    context_attribs[n++] = EGL_TRUE;
+  }
+  context_attribs[n] = EGL_NONE;
+
+  EGLConfig config = egl->has_no_config_context ? EGL_NO_CONFIG_KHR : egl->conf;
+  egl->ctx = eglCreateContext(egl->dpy, config, EGL_NO_CONTEXT, context_attribs);
+  if (egl->ctx == EGL_NO_CONTEXT && no_error) {
+    // Some drivers advertise the extension but refuse it for this API.
+    LOG_WARNING("No-error context refused, retrying without it.");
+    context_attribs[no_error_attrib] = EGL_NONE;
+    egl->ctx =
+        eglCreateContext(egl->dpy, config, EGL_NO_CONTEXT, context_attribs);
+  }
+  if (egl->ctx == EGL_NO_CONTEXT) {
+    LOG_ERROR("Failed to create EGL context: 0x%x", eglGetError());
+    exit(EXIT_FAILURE);
+  }
+  egl->conf = config;
+}
+
+EGLContext glps_egl_create_thread_ctx(glps_WindowManager *wm) {
+  glps_EGLContext *egl = wm->egl_ctx;
+  if (egl->ctx == EGL_NO_CONTEXT) {
+    LOG_ERROR("Shared contexts need the main context, create a window first.");
+    return EGL_NO_CONTEXT;
+  }
+
+  // Sharing requires the same robustness and no-error state, so the
+  // attributes the main context was created with are reused.
+  eglBindAPI(__egl_api(&wm->context_desc));
+  EGLContext ctx =
+      eglCreateContext(egl->dpy, egl->conf, egl->ctx, egl->context_attribs);
+  if (ctx == EGL_NO_CONTEXT) {
+    LOG_ERROR("Failed to create shared EGL context: 0x%x", eglGetError());
+  }
+  return ctx;
+}
+
+bool glps_egl_make_thread_ctx_current(glps_WindowManager *wm,
+                                      EGLSurface surface, EGLContext ctx) {
+  // The client API is per thread and new threads start out with GLES.
+  if (ctx != EGL_NO_CONTEXT) {
+    eglBindAPI(__egl_api(&wm->context_desc));
+  }
+  if (!eglMakeCurrent(wm->egl_ctx->dpy, surface, surface, ctx)) {
+    LOG_ERROR("eglMakeCurrent failed on thread context: 0x%x", eglGetError());
+    return false;
+  }
+  return true;
+}
+
+glps_SharedContext *glps_egl_create_shared_ctx(glps_WindowManager *wm) {
+  glps_EGLContext *egl = wm->egl_ctx;
+  if (egl->ctx == EGL_NO_CONTEXT) {
+    LOG_ERROR("Shared contexts need the main context, create a window first.");
+    return NULL;
+  }
+
+  glps_SharedContext *shared = calloc(1, sizeof(glps_SharedContext));
+  if (shared == NULL) {
+    LOG_ERROR("Failed to allocate shared context.");
+    return NULL;
+  }
+  shared->surface = EGL_NO_SURFACE;
+
+  EGLConfig config = egl->conf;
+  if (!egl->has_surfaceless) {
+    if (config == EGL_NO_CONFIG_KHR) {
+      glps_SurfaceDesc desc = GLPS_SURFACE_DESC_DEFAULT;
+      EGLint n = 0;
+      EGLint pbuffer_attribs[] = {EGL_SURFACE_TYPE,
+                                  EGL_PBUFFER_BIT,
+                                  EGL_RED_SIZE,
+                                  desc.red_bits,
+                                  EGL_GREEN_SIZE,
+                                  desc.green_bits,
+                                  EGL_BLUE_SIZE,
+                                  desc.blue_bits,
+                                  EGL_RENDERABLE_TYPE,
+                                  __egl_renderable_type(&wm->context_desc),
+                                  EGL_NONE};
+      if (!eglChooseConfig(egl->dpy, pbuffer_attribs, &config, 1, &n) ||
+          n != 1) {
+        LOG_ERROR("No EGL config supports pbuffers.");
+        free(shared);
+        return NULL;
+      }
+    }
+
+    EGLint surface_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    shared->surface =
+        eglCreatePbufferSurface(egl->dpy, config, surface_attribs);
+    if (shared->surface == EGL_NO_SURFACE) {
+      LOG_ERROR("Failed to create pbuffer for shared context: 0x%x",
+                eglGetError());
+      free(shared);
+      return NULL;
+    }
+  }
+
+  shared->ctx = glps_egl_create_thread_ctx(wm);
+  if (shared->ctx == EGL_NO_CONTEXT) {
+    if (shared->surface != EGL_NO_SURFACE) {
+      eglDestroySurface(egl->dpy, shared->surface);
+    }
+    free(shared);
+    return NULL;
+  }
+
+  return shared;
+}
+
+bool glps_egl_make_shared_ctx_current(glps_WindowManager *wm,
+                                      glps_SharedContext *shared) {
+  return glps_egl_make_thread_ctx_current(
+      wm, shared ? shared->surface : EGL_NO_SURFACE,
+      shared ? shared->ctx : EGL_NO_CONTEXT);
+}
+
+void glps_egl_destroy_shared_ctx(glps_WindowManager *wm,
+                                 glps_SharedContext *shared) {
+  if (shared->ctx != EGL_NO_CONTEXT) {
+    eglDestroyContext(wm->egl_ctx->dpy, shared->ctx);
+  }
+  if (shared->surface != EGL_NO_SURFACE) {
+    eglDestroySurface(wm->egl_ctx->dpy, shared->surface);
+  }
+  free(shared);
+}
+
+glps_Fence glps_egl_fence_create(glps_WindowManager *wm) {
+  glps_EGLContext *egl = wm->egl_ctx;
+  if (egl->create_sync == NULL) {
+    LOG_ERROR("EGL_KHR_fence_sync is not supported.");
+    return NULL;
+  }
+
+  EGLSyncKHR sync = egl->create_sync(egl->dpy, EGL_SYNC_FENCE_KHR, NULL);
+  if (sync == EGL_NO_SYNC_KHR) {
+    LOG_ERROR("Failed to create fence: 0x%x", eglGetError());
+    return NULL;
+  }
+
+  // Flush so another context waiting on the fence can't wait forever.
+  egl->client_wait_sync(egl->dpy, sync, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, 0);
+  return (glps_Fence)sync;
+}
+
+bool glps_egl_fence_wait(glps_WindowManager *wm, glps_Fence fence,
+                         uint64_t timeout_ns) {
+  glps_EGLContext *egl = wm->egl_ctx;
+  PERF_SCOPE("fence_wait");
+  EGLint status = egl->client_wait_sync(
+      egl->dpy, (EGLSyncKHR)fence, 0,
+      timeout_ns == UINT64_MAX ? EGL_FOREVER_KHR : (EGLTimeKHR)timeout_ns);
+  if (status == EGL_FALSE) {
+    LOG_ERROR("Failed to wait for fence: 0x%x", eglGetError());
+  }
+  return status == EGL_CONDITION_SATISFIED_KHR;
+}
+
+bool glps_egl_fence_wait_gpu(glps_WindowManager *wm, glps_Fence fence) {
+  glps_EGLContext *egl = wm->egl_ctx;
+  if (egl->wait_sync == NULL) {
+    return glps_egl_fence_wait(wm, fence, UINT64_MAX);
+  }
+
+  // The GPU waits, the calling thread goes on queueing commands.
+  if (egl->wait_sync(egl->dpy, (EGLSyncKHR)fence, 0) != EGL_TRUE) {
+    LOG_ERROR("Failed to queue fence wait: 0x%x", eglGetError());
+    return false;
+  }
+  return true;
+}
+
+void glps_egl_fence_destroy(glps_WindowManager *wm, glps_Fence fence) {
+  if (fence != NULL && wm->egl_ctx->destroy_sync != NULL) {
+    wm->egl_ctx->destroy_sync(wm->egl_ctx->dpy, (EGLSyncKHR)fence);
+  }
 }
 
 void glps_egl_make_ctx_current(glps_WindowManager *wm, size_t window_id) {
+  PERF_SCOPE("eglMakeCurrent");
   if (!eglMakeCurrent(wm->egl_ctx->dpy, wm->windows[window_id]->egl_surface,
                       wm->windows[window_id]->egl_surface, wm->egl_ctx->ctx)) {
     EGLint error = eglGetError();
@@ -86,7 +490,9 @@ void glps_egl_make_ctx_current(glps_WindowManager *wm, size_t window_id) {
   }
 }
 
-void *glps_egl_get_proc_addr(const char* name) { return eglGetProcAddress; }
+void *glps_egl_get_proc_addr(const char *name) {
+  return (void *)eglGetProcAddress(name);
+}
 
 void glps_egl_destroy(glps_WindowManager *wm) {
 
@@ -103,7 +509,14 @@ void glps_egl_destroy(glps_WindowManager *wm) {
 }
 
 void glps_egl_swap_buffers(glps_WindowManager *wm, size_t window_id) {
-  eglSwapBuffers(wm->egl_ctx->dpy, wm->windows[window_id]->egl_surface);
+  PERF_SCOPE("eglSwapBuffers");
+#ifdef GLPS_USE_WAYLAND
+  // Render threads swap the window they render, IDs can shift under them.
+  EGLSurface surface = glps_wl_window(wm, window_id)->egl_surface;
+#else
+  EGLSurface surface = wm->windows[window_id]->egl_surface;
+#endif
+  eglSwapBuffers(wm->egl_ctx->dpy, surface);
 }
 
 #endif
@@ -0,0 +1,173 @@
+#include "glps_frame_stats.h"
+
+static uint32_t frame_bucket(float frame_ms) {
+  uint32_t bucket = (uint32_t)(frame_ms / GLPS_FRAME_STATS_BUCKET_MS);
+  return bucket < GLPS_FRAME_STATS_BUCKETS ? bucket
+                                           : GLPS_FRAME_STATS_BUCKETS - 1;
+}
+
+static int compare_frame_ms(const void *a, const void *b) {
+  float lhs = *(const float *)a;
+  float rhs = *(const float *)b;
+  return (lhs > rhs) - (lhs < rhs);
+}
+
+static void clear_window(glps_FrameStatsTracker *tracker) {
+  tracker->head = 0;
+  tracker->count = 0;
+  tracker->window_over_budget = 0;
+  memset(tracker->histogram, 0, sizeof(tracker->histogram));
+  tracker->gpu_head = 0;
+  tracker->gpu_count = 0;
+}
+
+void glps_frame_stats_init(glps_FrameStatsTracker *tracker) {
+  memset(tracker, 0, sizeof(*tracker));
+  tracker->window = GLPS_FRAME_STATS_DEFAULT_WINDOW;
+  tracker->budget_ms = GLPS_FRAME_STATS_DEFAULT_BUDGET_MS;
+}
+
+void glps_frame_stats_tick(glps_FrameStatsTracker *tracker, uint64_t now_ns) {
+  if (tracker->last_frame_ns == 0 || now_ns <= tracker->last_frame_ns) {
+    tracker->last_frame_ns = now_ns;
+    return;
+  }
+
+  float frame_ms = (float)((now_ns - tracker->last_frame_ns) / 1e6);
+  tracker->last_frame_ns = now_ns;
+
+  bool over_budget = frame_ms > tracker->budget_ms;
+  tracker->frame_count++;
+  if (over_budget)
+    tracker->over_budget_count++;
+
+  // Evict the oldest frame once the window is full.
+  if (tracker->count == tracker->window) {
+    uint32_t oldest =
+        (tracker->head + GLPS_FRAME_STATS_HISTORY - tracker->count) %
+        GLPS_FRAME_STATS_HISTORY;
+    float evicted = tracker->frame_ms[oldest];
+    tracker->histogram[frame_bucket(evicted)]--;
+    if (evicted > tracker->budget_ms)
+      tracker->window_over_budget--;
+    tracker->count--;
+  }
+
+  tracker->frame_ms[tracker->head] = frame_ms;
+  tracker->head = (tracker->head + 1) % GLPS_FRAME_STATS_HISTORY;
+  tracker->count++;
+  tracker->histogram[frame_bucket(frame_ms)]++;
+  if (over_budget)
+    tracker->window_over_budget++;
+}
+
+void glps_frame_stats_gpu_sample(glps_FrameStatsTracker *tracker,
+                                 float gpu_ms) {
+  tracker->gpu_frame_count++;
+  if (tracker->gpu_count == tracker->window)
+    tracker->gpu_count--;
+
+  tracker->gpu_ms[tracker->gpu_head] = gpu_ms;
+  tracker->gpu_head = (tracker->gpu_head + 1) % GLPS_FRAME_STATS_HISTORY;
+  tracker->gpu_count++;
+}
+
+static void get_gpu_stats(const glps_FrameStatsTracker *tracker,
+                          glps_FrameStats *stats) {
+  stats->gpu_frame_count = tracker->gpu_frame_count;
+  stats->window_gpu_frames = tracker->gpu_count;
+  if (tracker->gpu_count == 0)
+    return;
+
+  float sorted[GLPS_FRAME_STATS_HISTORY];
+  double total_ms = 0.0;
+  for (uint32_t i = 0; i < tracker->gpu_count; ++i) {
+    uint32_t index = (tracker->gpu_head + GLPS_FRAME_STATS_HISTORY -
+                      tracker->gpu_count + i) %
+                     GLPS_FRAME_STATS_HISTORY;
+    sorted[i] = tracker->gpu_ms[index];
+    total_ms += sorted[i];
+  }
+  stats->last_gpu_ms = sorted[tracker->gpu_count - 1];
+
+  qsort(sorted, tracker->gpu_count, sizeof(float), compare_frame_ms);
+
+  stats->mean_gpu_ms = total_ms / tracker->gpu_count;
+  stats->max_gpu_ms = sorted[tracker->gpu_count - 1];
+  stats->p99_gpu_ms = sorted[(tracker->gpu_count - 1) * 99 / 100];
+}
+
+void glps_frame_stats_get(const glps_FrameStatsTracker *tracker,
+                          glps_FrameStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->frame_count = tracker->frame_count;
+  stats->over_budget_count = tracker->over_budget_count;
+  stats->budget_ms = tracker->budget_ms;
+  stats->refresh_hz = tracker->refresh_hz;
+  stats->window_frames = tracker->count;
+  stats->window_over_budget = tracker->window_over_budget;
+  memcpy(stats->histogram, tracker->histogram, sizeof(stats->histogram));
+  get_gpu_stats(tracker, stats);
+
+  if (tracker->count == 0)
+    return;
+
+  float sorted[GLPS_FRAME_STATS_HISTORY];
+  double total_ms = 0.0;
+  for (uint32_t i = 0; i < tracker->count; ++i) {
+    uint32_t index =
+        (tracker->head + GLPS_FRAME_STATS_HISTORY - tracker->count + i) %
+        GLPS_FRAME_STATS_HISTORY;
+    sorted[i] = tracker->frame_ms[index];
+    total_ms += sorted[i];
+  }
+  stats->last_frame_ms =
+      tracker->frame_ms[(tracker->head + GLPS_FRAME_STATS_HISTORY - 1) %
+                        GLPS_FRAME_STATS_HISTORY];
+
+  qsort(sorted, tracker->count, sizeof(float), compare_frame_ms);
+
+  stats->mean_frame_ms = total_ms / tracker->count;
+  stats->mean_fps = total_ms > 0.0 ? 1000.0 * tracker->count / total_ms : 0.0;
+  stats->min_frame_ms = sorted[0];
+  stats->max_frame_ms = sorted[tracker->count - 1];
+  stats->p50_frame_ms = sorted[(tracker->count - 1) * 50 / 100];
+  stats->p90_frame_ms = sorted[(tracker->count - 1) * 90 / 100];
+  stats->p99_frame_ms = sorted[(tracker->count - 1) * 99 / 100];
+}
+
+// One refresh period, or the default while the refresh is unknown.
+static double refresh_budget(const glps_FrameStatsTracker *tracker) {
+  return tracker->refresh_hz > 0.0 ? 1000.0 / tracker->refresh_hz
+                                   : GLPS_FRAME_STATS_DEFAULT_BUDGET_MS;
+}
+
+void glps_frame_stats_set_budget(glps_FrameStatsTracker *tracker,
+                                 double budget_ms) {
+  tracker->budget_set = budget_ms > 0.0;
+  tracker->budget_ms = tracker->budget_set ? budget_ms : refresh_budget(tracker);
+  clear_window(tracker);
+}
+
+void glps_frame_stats_set_refresh(glps_FrameStatsTracker *tracker,
+                                  double refresh_hz) {
+  if (refresh_hz == tracker->refresh_hz)
+    return;
+
+  tracker->refresh_hz = refresh_hz;
+  if (!tracker->budget_set) {
+    tracker->budget_ms = refresh_budget(tracker);
+    clear_window(tracker);
+  }
+}
+
+void glps_frame_stats_set_window(glps_FrameStatsTracker *tracker,
+                                 size_t frames) {
+  if (frames == 0)
+    frames = 1;
+  if (frames > GLPS_FRAME_STATS_HISTORY)
+    frames = GLPS_FRAME_STATS_HISTORY;
+
+  tracker->window = (uint32_t)frames;
+  clear_window(tracker);
+}
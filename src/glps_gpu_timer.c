@@ -0,0 +1,156 @@
+#include "glps_gpu_timer.h"
+#include "glps_frame_stats.h"
+#include "glps_window_manager.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+static PFNGLGENQUERIESPROC gen_queries = NULL;
+static PFNGLDELETEQUERIESPROC delete_queries = NULL;
+static PFNGLBEGINQUERYPROC begin_query = NULL;
+static PFNGLENDQUERYPROC end_query = NULL;
+static PFNGLGETQUERYOBJECTIVPROC get_query_objectiv = NULL;
+static PFNGLGETQUERYOBJECTUI64VPROC get_query_objectui64v = NULL;
+
+// Only one GL_TIME_ELAPSED query may be open per context, and render threads
+// each have their own context. Windows sharing a context each time their own
+// frame: a query another window cuts short is discarded rather than reported.
+static _Thread_local glps_GpuTimer *active_timer = NULL;
+
+static bool load_query_functions(void) {
+  static bool attempted = false, loaded = false;
+  if (attempted)
+    return loaded;
+  attempted = true;
+
+  gen_queries = (PFNGLGENQUERIESPROC)glps_get_proc_addr("glGenQueries");
+  delete_queries =
+      (PFNGLDELETEQUERIESPROC)glps_get_proc_addr("glDeleteQueries");
+  begin_query = (PFNGLBEGINQUERYPROC)glps_get_proc_addr("glBeginQuery");
+  end_query = (PFNGLENDQUERYPROC)glps_get_proc_addr("glEndQuery");
+  get_query_objectiv =
+      (PFNGLGETQUERYOBJECTIVPROC)glps_get_proc_addr("glGetQueryObjectiv");
+  get_query_objectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)glps_get_proc_addr(
+      "glGetQueryObjectui64v");
+
+  loaded = gen_queries && delete_queries && begin_query && end_query &&
+           get_query_objectiv && get_query_objectui64v;
+  if (!loaded) {
+    LOG_WARNING("GPU timing unavailable: timer query functions not found.");
+  }
+  return loaded;
+}
+
+static void end_active_query(bool keep) {
+  if (active_timer == NULL)
+    return;
+
+  end_query(GL_TIME_ELAPSED);
+  if (!keep) {
+    uint32_t last = (active_timer->head + GLPS_GPU_TIMER_QUERIES - 1) %
+                    GLPS_GPU_TIMER_QUERIES;
+    active_timer->discarded[last] = true;
+  }
+  active_timer->active = false;
+  active_timer = NULL;
+}
+
+static void begin_frame_query(glps_GpuTimer *timer) {
+  // Every query is still in flight: skip this frame rather than stall.
+  if (timer->in_use == GLPS_GPU_TIMER_QUERIES)
+    return;
+
+  timer->discarded[timer->head] = false;
+  begin_query(GL_TIME_ELAPSED, timer->queries[timer->head]);
+  timer->head = (timer->head + 1) % GLPS_GPU_TIMER_QUERIES;
+  timer->in_use++;
+  timer->active = true;
+  active_timer = timer;
+}
+
+static void release_queries(glps_WindowManager *wm, glps_GpuTimer *timer) {
+  if (!timer->initialized)
+    return;
+
+  if (active_timer == timer)
+    end_active_query(false);
+
+  delete_queries(GLPS_GPU_TIMER_QUERIES, timer->queries);
+  timer->initialized = false;
+  timer->head = timer->tail = timer->in_use = 0;
+}
+
+void glps_gpu_timer_set_enabled(glps_GpuTimer *timer, bool enabled) {
+  // Query objects are created and deleted at the next swap, where the
+  // window's context is known to be current.
+  timer->enabled = enabled;
+}
+
+void glps_gpu_timer_frame_end(glps_WindowManager *wm, glps_GpuTimer *timer,
+                              glps_FrameStatsTracker *stats) {
+  if (!timer->initialized)
+    return;
+
+  if (timer->active)
+    end_active_query(true);
+
+  // Read back every finished query without waiting on the GPU.
+  while (timer->in_use > 0) {
+    GLuint query = timer->queries[timer->tail];
+    GLint available = 0;
+    get_query_objectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      break;
+
+    if (!timer->discarded[timer->tail]) {
+      GLuint64 elapsed_ns = 0;
+      get_query_objectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+      glps_frame_stats_gpu_sample(stats, (float)(elapsed_ns / 1e6));
+    }
+
+    timer->tail = (timer->tail + 1) % GLPS_GPU_TIMER_QUERIES;
+    timer->in_use--;
+  }
+
+  if (!timer->enabled)
+    release_queries(wm, timer);
+}
+
+void glps_gpu_timer_frame_begin(glps_WindowManager *wm,
+                                glps_GpuTimer *timer) {
+  if (!timer->enabled)
+    return;
+
+  if (!timer->initialized) {
+    if (!load_query_functions()) {
+      timer->enabled = false;
+      return;
+    }
+    gen_queries(GLPS_GPU_TIMER_QUERIES, timer->queries);
+    timer->initialized = true;
+    timer->head = timer->tail = timer->in_use = 0;
+  }
+
+  // A query still open was begun at another window's swap, and would take
+  // in the frame this window just drew.
+  end_active_query(false);
+  begin_frame_query(timer);
+}
+
+void glps_gpu_timer_make_current(glps_GpuTimer *timer) {
+  if (active_timer == timer || !timer->initialized || !timer->enabled)
+    return;
+
+  // The window about to be drawn shares the context with the open query.
+  end_active_query(false);
+  begin_frame_query(timer);
+}
+
+void glps_gpu_timer_release(glps_WindowManager *wm, glps_GpuTimer *timer) {
+  // Created again at the next swap if timing stays enabled.
+  release_queries(wm, timer);
+}
+
+void glps_gpu_timer_destroy(glps_WindowManager *wm, glps_GpuTimer *timer) {
+  release_queries(wm, timer);
+  timer->enabled = false;
+}
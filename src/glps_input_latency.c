@@ -0,0 +1,136 @@
+#include "glps_input_latency.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t latency_bucket(float latency_ms) {
+  uint32_t bucket = (uint32_t)(latency_ms / GLPS_LATENCY_BUCKET_MS);
+  return bucket < GLPS_LATENCY_BUCKETS ? bucket : GLPS_LATENCY_BUCKETS - 1;
+}
+
+static int compare_latency_ms(const void *a, const void *b) {
+  float lhs = *(const float *)a;
+  float rhs = *(const float *)b;
+  return (lhs > rhs) - (lhs < rhs);
+}
+
+void glps_latency_init(glps_LatencyTracker *tracker) {
+  memset(tracker, 0, sizeof(*tracker));
+}
+
+uint64_t glps_latency_event_time_ns(uint32_t time_ms, uint64_t receive_ns) {
+  // Event times are the low 32 bits of a millisecond clock; rebuild the high
+  // bits from the receive time, which is always later.
+  uint64_t receive_ms = receive_ns / 1000000;
+  uint64_t event_ms = (receive_ms & ~(uint64_t)UINT32_MAX) | time_ms;
+  if (event_ms > receive_ms) {
+    if (event_ms <= UINT32_MAX)
+      return receive_ns;
+    event_ms -= (uint64_t)UINT32_MAX + 1;
+  }
+
+  if (receive_ms - event_ms > GLPS_LATENCY_MAX_EVENT_AGE_MS)
+    return receive_ns;
+
+  return event_ms * 1000000;
+}
+
+void glps_latency_input(glps_LatencyTracker *tracker, uint64_t input_ns,
+                        uint64_t receive_ns) {
+  // Only the oldest input counts: the frame that shows it shows the rest too.
+  if (tracker->pending_input_ns != 0)
+    return;
+
+  tracker->pending_input_ns = input_ns;
+  tracker->pending_receive_ns = receive_ns;
+}
+
+bool glps_latency_take_pending(glps_LatencyTracker *tracker,
+                               uint64_t *input_ns, uint64_t *receive_ns) {
+  if (tracker->pending_input_ns == 0)
+    return false;
+
+  *input_ns = tracker->pending_input_ns;
+  *receive_ns = tracker->pending_receive_ns;
+  tracker->pending_input_ns = 0;
+  tracker->pending_receive_ns = 0;
+  return true;
+}
+
+void glps_latency_record(glps_LatencyTracker *tracker, uint64_t input_ns,
+                         uint64_t receive_ns, uint64_t shown_ns,
+                         bool presented) {
+  float latency_ms =
+      shown_ns > input_ns ? (float)((shown_ns - input_ns) / 1e6) : 0.0f;
+  float dispatch_ms =
+      receive_ns > input_ns ? (float)((receive_ns - input_ns) / 1e6) : 0.0f;
+
+  if (tracker->count == GLPS_LATENCY_HISTORY) {
+    tracker->histogram[latency_bucket(tracker->latency_ms[tracker->head])]--;
+    tracker->count--;
+  }
+
+  tracker->latency_ms[tracker->head] = latency_ms;
+  tracker->dispatch_ms[tracker->head] = dispatch_ms;
+  tracker->head = (tracker->head + 1) % GLPS_LATENCY_HISTORY;
+  tracker->count++;
+  tracker->histogram[latency_bucket(latency_ms)]++;
+  tracker->sample_count++;
+  tracker->presented = presented;
+}
+
+void glps_latency_frame_submitted(glps_LatencyTracker *tracker,
+                                  uint64_t now_ns) {
+  uint64_t input_ns, receive_ns;
+  if (glps_latency_take_pending(tracker, &input_ns, &receive_ns))
+    glps_latency_record(tracker, input_ns, receive_ns, now_ns, false);
+}
+
+void glps_latency_discard(glps_LatencyTracker *tracker) {
+  tracker->discarded_count++;
+}
+
+void glps_latency_get(const glps_LatencyTracker *tracker,
+                      glps_LatencyStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->sample_count = tracker->sample_count;
+  stats->discarded_count = tracker->discarded_count;
+  stats->presentation_feedback = tracker->presented;
+  stats->window_samples = tracker->count;
+  memcpy(stats->histogram, tracker->histogram, sizeof(stats->histogram));
+
+  if (tracker->count == 0)
+    return;
+
+  float sorted[GLPS_LATENCY_HISTORY];
+  double total_ms = 0.0, total_dispatch_ms = 0.0;
+  for (uint32_t i = 0; i < tracker->count; ++i) {
+    uint32_t index =
+        (tracker->head + GLPS_LATENCY_HISTORY - tracker->count + i) %
+        GLPS_LATENCY_HISTORY;
+    sorted[i] = tracker->latency_ms[index];
+    total_ms += sorted[i];
+    total_dispatch_ms += tracker->dispatch_ms[index];
+  }
+  stats->last_ms = tracker->latency_ms[(tracker->head + GLPS_LATENCY_HISTORY -
+                                        1) %
+                                       GLPS_LATENCY_HISTORY];
+
+  qsort(sorted, tracker->count, sizeof(float), compare_latency_ms);
+
+  stats->mean_ms = total_ms / tracker->count;
+  stats->mean_dispatch_ms = total_dispatch_ms / tracker->count;
+  stats->min_ms = sorted[0];
+  stats->max_ms = sorted[tracker->count - 1];
+  stats->p50_ms = sorted[(tracker->count - 1) * 50 / 100];
+  stats->p90_ms = sorted[(tracker->count - 1) * 90 / 100];
+  stats->p99_ms = sorted[(tracker->count - 1) * 99 / 100];
+}
+
+void glps_latency_reset(glps_LatencyTracker *tracker) {
+  uint64_t input_ns = tracker->pending_input_ns;
+  uint64_t receive_ns = tracker->pending_receive_ns;
+  glps_latency_init(tracker);
+  tracker->pending_input_ns = input_ns;
+  tracker->pending_receive_ns = receive_ns;
+}
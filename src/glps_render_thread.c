@@ -0,0 +1,309 @@
+#ifdef GLPS_USE_WAYLAND
+
+#include "glps_render_thread.h"
+#include "glps_egl_context.h"
+#include "glps_frame_stats.h"
+#include "glps_gpu_timer.h"
+#include "glps_sync.h"
+#include "glps_wayland.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+struct glps_RenderThread {
+  glps_WindowManager *wm;
+  glps_WaylandWindow *window; /**< Stable even when window ids shift. */
+  atomic_size_t window_id;    /**< Set by the owner when ids shift. */
+  size_t dispatched_id;       /**< ID given to the callback running. */
+  EGLContext ctx;             /**< Shares objects with the main context. */
+  pthread_t thread;
+  sem_t wake;          /**< Posted per queued event, frame, resize and stop. */
+  sem_t started;       /**< Posted once the thread tried its context. */
+  atomic_bool running; /**< Cleared to make the thread exit. */
+  atomic_bool frame_pending;  /**< A frame callback is waiting to be drawn. */
+  atomic_bool resize_pending; /**< resize holds a resize not handled yet. */
+  struct {
+    _Atomic uint32_t seq;
+    _Atomic uint64_t words[GLPS_SEQLOCK_WORDS(glps_WindowEvent)];
+  } resize;          /**< Latest resize, written by the owner only. */
+  atomic_bool ready; /**< The thread made its context current. */
+  glps_EventQueue queue; /**< Input filled by the dispatch thread. */
+};
+
+void glps_event_queue_init(glps_EventQueue *queue) {
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+}
+
+bool glps_event_queue_push(glps_EventQueue *queue,
+                           const glps_WindowEvent *event) {
+  size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+  if (head - tail == GLPS_EVENT_QUEUE_SIZE)
+    return false;
+
+  queue->events[head & (GLPS_EVENT_QUEUE_SIZE - 1)] = *event;
+  atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  return true;
+}
+
+bool glps_event_queue_pop(glps_EventQueue *queue, glps_WindowEvent *event) {
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+  if (tail == head)
+    return false;
+
+  *event = queue->events[tail & (GLPS_EVENT_QUEUE_SIZE - 1)];
+  atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// Input callbacks run on several threads, each sees its own event.
+static _Thread_local glps_InputTimestamp input_timestamp;
+
+glps_InputTimestamp glps_window_event_input_timestamp(void) {
+  return input_timestamp;
+}
+
+void glps_window_event_dispatch(glps_WindowManager *wm,
+                                const glps_WindowEvent *event) {
+  struct glps_Callback *cb = &wm->callbacks;
+  size_t id = event->window_id;
+
+  if (event->timestamp.receive_ns != 0)
+    input_timestamp = event->timestamp;
+
+  switch (event->type) {
+  case GLPS_WINDOW_EVENT_FRAME:
+    if (cb->window_frame_update_callback) {
+      PERF_SCOPE("frame_update_callback");
+      cb->window_frame_update_callback(id, cb->window_frame_update_data);
+    }
+    break;
+  case GLPS_WINDOW_EVENT_RESIZE:
+    if (cb->window_resize_callback)
+      cb->window_resize_callback(id, event->resize.width, event->resize.height,
+                                 cb->window_resize_data);
+    break;
+  case GLPS_WINDOW_EVENT_MOUSE_ENTER:
+    if (cb->mouse_enter_callback)
+      cb->mouse_enter_callback(id, event->pointer.x, event->pointer.y,
+                               cb->mouse_enter_data);
+    break;
+  case GLPS_WINDOW_EVENT_MOUSE_LEAVE:
+    if (cb->mouse_leave_callback)
+      cb->mouse_leave_callback(id, cb->mouse_leave_data);
+    break;
+  case GLPS_WINDOW_EVENT_MOUSE_MOVE:
+    if (cb->mouse_move_callback)
+      cb->mouse_move_callback(id, event->pointer.x, event->pointer.y,
+                              cb->mouse_move_data);
+    break;
+  case GLPS_WINDOW_EVENT_MOUSE_CLICK:
+    if (cb->mouse_click_callback)
+      cb->mouse_click_callback(id, event->click.state, cb->mouse_click_data);
+    break;
+  case GLPS_WINDOW_EVENT_MOUSE_SCROLL:
+    if (cb->mouse_scroll_callback)
+      cb->mouse_scroll_callback(id, event->scroll.axis, event->scroll.source,
+                                event->scroll.value, event->scroll.discrete,
+                                event->scroll.is_stopped,
+                                cb->mouse_scroll_data);
+    break;
+  case GLPS_WINDOW_EVENT_KEYBOARD_ENTER:
+    if (cb->keyboard_enter_callback)
+      cb->keyboard_enter_callback(id, cb->keyboard_enter_data);
+    break;
+  case GLPS_WINDOW_EVENT_KEYBOARD_LEAVE:
+    if (cb->keyboard_leave_callback)
+      cb->keyboard_leave_callback(id, cb->keyboard_leave_data);
+    break;
+  case GLPS_WINDOW_EVENT_KEY:
+    if (cb->keyboard_callback) {
+      PERF_SCOPE("keyboard_callback");
+      cb->keyboard_callback(id, event->key.state, event->key.value,
+                            cb->keyboard_data);
+    }
+    break;
+  case GLPS_WINDOW_EVENT_TOUCH:
+    if (cb->touch_callback)
+      cb->touch_callback(id, event->touch.id, event->touch.x, event->touch.y,
+                         event->touch.state, event->touch.major,
+                         event->touch.minor, event->touch.orientation,
+                         cb->touch_data);
+    break;
+  case GLPS_WINDOW_EVENT_OUTPUT: {
+    // Frame statistics belong to the thread that renders the window.
+    glps_WaylandWindow *window = glps_wl_window(wm, id);
+    glps_frame_stats_set_refresh(&window->frame_stats,
+                                 event->output.refresh_mhz / 1000.0);
+    GLPS_SEQLOCK_PUBLISH(&window->frame_stats_cell, &window->frame_stats);
+    if (cb->window_output_callback)
+      cb->window_output_callback(id, event->output.refresh_mhz / 1000.0,
+                                 event->output.scale, cb->window_output_data);
+    break;
+  }
+  }
+}
+
+// Set on render threads only, which never read the windows the owner compacts.
+static _Thread_local glps_RenderThread *current_thread;
+
+glps_WaylandWindow *glps_render_thread_window(size_t window_id) {
+  // The ID a callback got stays its window's until it returns, even if the
+  // owner shifted it meanwhile. Other IDs are read like on any thread.
+  if (current_thread == NULL ||
+      (window_id != current_thread->dispatched_id &&
+       window_id != atomic_load(&current_thread->window_id)))
+    return NULL;
+  return current_thread->window;
+}
+
+void glps_render_thread_set_window_id(glps_RenderThread *thread,
+                                      size_t window_id) {
+  atomic_store(&thread->window_id, window_id);
+}
+
+// IDs shift down when a window created before this one is destroyed.
+static void dispatch(glps_RenderThread *thread, glps_WindowEvent *event) {
+  event->window_id = atomic_load(&thread->window_id);
+  thread->dispatched_id = event->window_id;
+  glps_window_event_dispatch(thread->wm, event);
+}
+
+static void *render_thread_main(void *data) {
+  glps_RenderThread *thread = (glps_RenderThread *)data;
+  glps_WindowManager *wm = thread->wm;
+  current_thread = thread;
+
+  bool current = glps_egl_make_thread_ctx_current(
+      wm, thread->window->egl_surface, thread->ctx);
+  atomic_store(&thread->ready, current);
+  // Not wake, which the loop below could take before the starter does.
+  sem_post(&thread->started);
+  if (!current)
+    return NULL;
+
+  while (atomic_load(&thread->running)) {
+    while (sem_wait(&thread->wake) < 0 && errno == EINTR) {
+    }
+
+    glps_WindowEvent event;
+    while (glps_event_queue_pop(&thread->queue, &event)) {
+      dispatch(thread, &event);
+    }
+
+    // Resizing the EGL window between swaps, on the thread that swaps.
+    if (atomic_exchange(&thread->resize_pending, false)) {
+      GLPS_SEQLOCK_SNAPSHOT(&thread->resize, &event);
+      glps_wl_window_resize_buffers(thread->window, &event);
+      dispatch(thread, &event);
+    }
+
+    if (atomic_exchange(&thread->frame_pending, false)) {
+      event = (glps_WindowEvent){.type = GLPS_WINDOW_EVENT_FRAME};
+      dispatch(thread, &event);
+    }
+  }
+
+  // Query objects aren't shared, only this context can delete them.
+  glps_gpu_timer_release(wm, &thread->window->gpu_timer);
+  glps_egl_make_thread_ctx_current(wm, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  return NULL;
+}
+
+glps_RenderThread *glps_render_thread_start(glps_WindowManager *wm,
+                                            size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+
+  glps_RenderThread *thread = calloc(1, sizeof(glps_RenderThread));
+  if (thread == NULL) {
+    LOG_ERROR("Failed to allocate render thread.");
+    return NULL;
+  }
+  thread->wm = wm;
+  thread->window = window;
+  atomic_init(&thread->window_id, window_id);
+  thread->dispatched_id = window_id;
+  atomic_init(&thread->running, true);
+  atomic_init(&thread->frame_pending, false);
+  atomic_init(&thread->resize_pending, false);
+  atomic_init(&thread->ready, false);
+  glps_event_queue_init(&thread->queue);
+  sem_init(&thread->wake, 0, 0);
+  sem_init(&thread->started, 0, 0);
+
+  thread->ctx = glps_egl_create_thread_ctx(wm);
+  if (thread->ctx == EGL_NO_CONTEXT) {
+    sem_destroy(&thread->wake);
+    sem_destroy(&thread->started);
+    free(thread);
+    return NULL;
+  }
+
+  // A surface can only be current on one thread.
+  if (eglGetCurrentSurface(EGL_DRAW) == window->egl_surface) {
+    eglMakeCurrent(wm->egl_ctx->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                   wm->egl_ctx->has_surfaceless ? wm->egl_ctx->ctx
+                                                : EGL_NO_CONTEXT);
+  }
+
+  if (pthread_create(&thread->thread, NULL, render_thread_main, thread) != 0) {
+    LOG_ERROR("Failed to create render thread.");
+    eglDestroyContext(wm->egl_ctx->dpy, thread->ctx);
+    sem_destroy(&thread->wake);
+    sem_destroy(&thread->started);
+    free(thread);
+    return NULL;
+  }
+
+  while (sem_wait(&thread->started) < 0 && errno == EINTR) {
+  }
+  sem_destroy(&thread->started);
+  if (!atomic_load(&thread->ready)) {
+    pthread_join(thread->thread, NULL);
+    eglDestroyContext(wm->egl_ctx->dpy, thread->ctx);
+    sem_destroy(&thread->wake);
+    free(thread);
+    return NULL;
+  }
+
+  return thread;
+}
+
+bool glps_render_thread_post(glps_RenderThread *thread,
+                             const glps_WindowEvent *event) {
+  // Losing a frame or a resize would stall the window, they bypass the queue
+  // and only the latest of each is kept.
+  if (event->type == GLPS_WINDOW_EVENT_FRAME) {
+    if (!atomic_exchange(&thread->frame_pending, true))
+      sem_post(&thread->wake);
+    return true;
+  }
+  if (event->type == GLPS_WINDOW_EVENT_RESIZE) {
+    GLPS_SEQLOCK_PUBLISH(&thread->resize, event);
+    atomic_store(&thread->resize_pending, true);
+    sem_post(&thread->wake);
+    return true;
+  }
+
+  if (!glps_event_queue_push(&thread->queue, event)) {
+    LOG_WARNING("Render thread queue is full, input event dropped.");
+    return false;
+  }
+
+  sem_post(&thread->wake);
+  return true;
+}
+
+void glps_render_thread_stop(glps_RenderThread *thread) {
+  atomic_store(&thread->running, false);
+  sem_post(&thread->wake);
+  pthread_join(thread->thread, NULL);
+
+  eglDestroyContext(thread->wm->egl_ctx->dpy, thread->ctx);
+  sem_destroy(&thread->wake);
+  free(thread);
+}
+
+#endif
@@ -0,0 +1,315 @@
+#include "glps_resolution.h"
+#include "glps_window_manager.h"
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <math.h>
+#include <string.h>
+
+#define GLPS_RESOLUTION_PERIOD 30 /**< Frames judged together. */
+#define GLPS_RESOLUTION_MISSED_SLACK 1.25 /**< Budgets past which a frame
+                                             missed, above vsync jitter. */
+#define GLPS_RESOLUTION_MISSED_RATIO 0.1 /**< Missed frames lowering the
+                                            scale. */
+#define GLPS_RESOLUTION_HIGH_LOAD 0.9  /**< GPU load lowering the scale. */
+#define GLPS_RESOLUTION_LOW_LOAD 0.6   /**< GPU load leaving headroom. */
+#define GLPS_RESOLUTION_TARGET_LOAD 0.75 /**< GPU load aimed for. */
+#define GLPS_RESOLUTION_STEP 0.05      /**< Scales are multiples of it. */
+#define GLPS_RESOLUTION_COOLDOWN 2     /**< Periods ignored after a change. */
+#define GLPS_RESOLUTION_MIN_DELAY 4    /**< Calm periods before a rise. */
+#define GLPS_RESOLUTION_MAX_DELAY 64
+
+// GL 1.0 entry points are loaded too, GLPS doesn't link against libGL.
+typedef void(APIENTRYP get_integerv_proc)(GLenum pname, GLint *data);
+typedef GLboolean(APIENTRYP is_enabled_proc)(GLenum cap);
+typedef void(APIENTRYP capability_proc)(GLenum cap);
+
+static PFNGLGENFRAMEBUFFERSPROC gen_framebuffers = NULL;
+static PFNGLDELETEFRAMEBUFFERSPROC delete_framebuffers = NULL;
+static PFNGLBINDFRAMEBUFFERPROC bind_framebuffer = NULL;
+static PFNGLCHECKFRAMEBUFFERSTATUSPROC check_framebuffer_status = NULL;
+static PFNGLFRAMEBUFFERRENDERBUFFERPROC framebuffer_renderbuffer = NULL;
+static PFNGLBLITFRAMEBUFFERPROC blit_framebuffer = NULL;
+static PFNGLGENRENDERBUFFERSPROC gen_renderbuffers = NULL;
+static PFNGLDELETERENDERBUFFERSPROC delete_renderbuffers = NULL;
+static PFNGLBINDRENDERBUFFERPROC bind_renderbuffer = NULL;
+static PFNGLRENDERBUFFERSTORAGEPROC renderbuffer_storage = NULL;
+static get_integerv_proc get_integerv = NULL;
+static is_enabled_proc is_enabled = NULL;
+static capability_proc enable = NULL;
+static capability_proc disable = NULL;
+
+void glps_resolution_init(glps_ResolutionController *controller) {
+  memset(controller, 0, sizeof(*controller));
+  controller->min_scale = 0.5;
+  controller->max_scale = 1.0;
+  controller->scale = 1.0;
+  controller->upscale_delay = GLPS_RESOLUTION_MIN_DELAY;
+}
+
+void glps_resolution_configure(glps_ResolutionController *controller,
+                               bool enabled, double min_scale,
+                               double max_scale, double current_scale) {
+  controller->enabled = enabled;
+  controller->min_scale = min_scale;
+  controller->max_scale = max_scale;
+  controller->scale = fmin(fmax(current_scale, min_scale), max_scale);
+  controller->frames = controller->missed = 0;
+  controller->gpu_frames = 0;
+  controller->gpu_ms = 0.0;
+  controller->cooldown = 0;
+  controller->calm = 0;
+  controller->upscale_delay = GLPS_RESOLUTION_MIN_DELAY;
+  controller->upscaled = false;
+}
+
+static double quantize(const glps_ResolutionController *controller,
+                       double scale) {
+  scale = round(scale / GLPS_RESOLUTION_STEP) * GLPS_RESOLUTION_STEP;
+  return fmin(fmax(scale, controller->min_scale), controller->max_scale);
+}
+
+// Returns the scale to switch to, or 0 to keep the current one.
+static double judge_period(glps_ResolutionController *controller,
+                           double budget_ms) {
+  // Frames drawn right after a change still show the previous scale.
+  if (controller->cooldown > 0) {
+    controller->cooldown--;
+    return 0.0;
+  }
+
+  double missed = (double)controller->missed / controller->frames;
+  bool timed = controller->gpu_frames > 0;
+  double gpu_load =
+      timed ? controller->gpu_ms / controller->gpu_frames / budget_ms : 0.0;
+  double scale = controller->scale;
+
+  if (missed > GLPS_RESOLUTION_MISSED_RATIO ||
+      gpu_load > GLPS_RESOLUTION_HIGH_LOAD) {
+    // A frame costs about its pixel count, the square of the scale. Missed
+    // frames alone don't tell by how much, so those back off by two steps.
+    if (timed && gpu_load > GLPS_RESOLUTION_HIGH_LOAD)
+      scale = fmin(scale * sqrt(GLPS_RESOLUTION_TARGET_LOAD / gpu_load),
+                   scale - GLPS_RESOLUTION_STEP);
+    else
+      scale -= 2 * GLPS_RESOLUTION_STEP;
+    // A rise that had to be undone makes the next ones wait twice as long,
+    // while a drop from a steady scale means the load itself changed.
+    if (!controller->upscaled)
+      controller->upscale_delay = GLPS_RESOLUTION_MIN_DELAY;
+    else if (controller->upscale_delay * 2 <= GLPS_RESOLUTION_MAX_DELAY)
+      controller->upscale_delay *= 2;
+    controller->calm = 0;
+  } else if (controller->missed == 0 &&
+             (!timed || gpu_load < GLPS_RESOLUTION_LOW_LOAD)) {
+    if (++controller->calm < controller->upscale_delay)
+      return 0.0;
+    controller->calm = 0;
+    scale += GLPS_RESOLUTION_STEP;
+    // Untimed frames only show headroom by trying, timed ones predict it.
+    double growth = scale / controller->scale;
+    if (timed && gpu_load * growth * growth > GLPS_RESOLUTION_HIGH_LOAD)
+      return 0.0;
+  } else {
+    // Between the thresholds the scale holds.
+    controller->calm = 0;
+    return 0.0;
+  }
+
+  scale = quantize(controller, scale);
+  if (fabs(scale - controller->scale) < GLPS_RESOLUTION_STEP / 2)
+    return 0.0;
+  controller->upscaled = scale > controller->scale;
+  controller->scale = scale;
+  controller->cooldown = GLPS_RESOLUTION_COOLDOWN;
+  return scale;
+}
+
+double glps_resolution_frame(glps_ResolutionController *controller,
+                             const glps_FrameStatsTracker *stats) {
+  uint64_t new_frames = stats->frame_count - controller->frames_seen;
+  uint64_t new_gpu_frames = stats->gpu_frame_count - controller->gpu_seen;
+  controller->frames_seen = stats->frame_count;
+  controller->gpu_seen = stats->gpu_frame_count;
+  if (!controller->enabled)
+    return 0.0;
+
+  // The newest frames are the last ones written to the rings.
+  if (new_frames > stats->count)
+    new_frames = stats->count;
+  for (uint64_t i = new_frames; i > 0; --i) {
+    uint32_t index = (stats->head + GLPS_FRAME_STATS_HISTORY - i) %
+                     GLPS_FRAME_STATS_HISTORY;
+    controller->frames++;
+    if (stats->frame_ms[index] >
+        stats->budget_ms * GLPS_RESOLUTION_MISSED_SLACK)
+      controller->missed++;
+  }
+  if (new_gpu_frames > stats->gpu_count)
+    new_gpu_frames = stats->gpu_count;
+  for (uint64_t i = new_gpu_frames; i > 0; --i) {
+    uint32_t index = (stats->gpu_head + GLPS_FRAME_STATS_HISTORY - i) %
+                     GLPS_FRAME_STATS_HISTORY;
+    controller->gpu_frames++;
+    controller->gpu_ms += stats->gpu_ms[index];
+  }
+
+  if (controller->frames < GLPS_RESOLUTION_PERIOD)
+    return 0.0;
+
+  double scale = judge_period(controller, stats->budget_ms);
+  controller->frames = controller->missed = 0;
+  controller->gpu_frames = 0;
+  controller->gpu_ms = 0.0;
+  return scale;
+}
+
+void glps_resolution_scaled_size(double render_scale, int width, int height,
+                                 int *scaled_width, int *scaled_height) {
+  if (!(render_scale > 0.0))
+    render_scale = 1.0;
+  *scaled_width = (int)fmax(lround(width * render_scale), 1);
+  *scaled_height = (int)fmax(lround(height * render_scale), 1);
+}
+
+static bool load_framebuffer_functions(void) {
+  static bool attempted = false, loaded = false;
+  if (attempted)
+    return loaded;
+  attempted = true;
+
+  gen_framebuffers =
+      (PFNGLGENFRAMEBUFFERSPROC)glps_get_proc_addr("glGenFramebuffers");
+  delete_framebuffers =
+      (PFNGLDELETEFRAMEBUFFERSPROC)glps_get_proc_addr("glDeleteFramebuffers");
+  bind_framebuffer =
+      (PFNGLBINDFRAMEBUFFERPROC)glps_get_proc_addr("glBindFramebuffer");
+  check_framebuffer_status = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)glps_get_proc_addr(
+      "glCheckFramebufferStatus");
+  framebuffer_renderbuffer = (PFNGLFRAMEBUFFERRENDERBUFFERPROC)glps_get_proc_addr(
+      "glFramebufferRenderbuffer");
+  blit_framebuffer =
+      (PFNGLBLITFRAMEBUFFERPROC)glps_get_proc_addr("glBlitFramebuffer");
+  gen_renderbuffers =
+      (PFNGLGENRENDERBUFFERSPROC)glps_get_proc_addr("glGenRenderbuffers");
+  delete_renderbuffers = (PFNGLDELETERENDERBUFFERSPROC)glps_get_proc_addr(
+      "glDeleteRenderbuffers");
+  bind_renderbuffer =
+      (PFNGLBINDRENDERBUFFERPROC)glps_get_proc_addr("glBindRenderbuffer");
+  renderbuffer_storage =
+      (PFNGLRENDERBUFFERSTORAGEPROC)glps_get_proc_addr("glRenderbufferStorage");
+  get_integerv = (get_integerv_proc)glps_get_proc_addr("glGetIntegerv");
+  is_enabled = (is_enabled_proc)glps_get_proc_addr("glIsEnabled");
+  enable = (capability_proc)glps_get_proc_addr("glEnable");
+  disable = (capability_proc)glps_get_proc_addr("glDisable");
+
+  loaded = gen_framebuffers && delete_framebuffers && bind_framebuffer &&
+           check_framebuffer_status && framebuffer_renderbuffer &&
+           blit_framebuffer && gen_renderbuffers && delete_renderbuffers &&
+           bind_renderbuffer && renderbuffer_storage && get_integerv &&
+           is_enabled && enable && disable;
+  if (!loaded) {
+    LOG_WARNING("Render scales unavailable: framebuffer blits not found.");
+  }
+  return loaded;
+}
+
+static bool allocate_storage(glps_ScaledFramebuffer *fb, int width,
+                             int height) {
+  bind_renderbuffer(GL_RENDERBUFFER, fb->color);
+  renderbuffer_storage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  bind_renderbuffer(GL_RENDERBUFFER, fb->depth_stencil);
+  renderbuffer_storage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  bind_renderbuffer(GL_RENDERBUFFER, 0);
+  fb->width = width;
+  fb->height = height;
+
+  bind_framebuffer(GL_FRAMEBUFFER, fb->framebuffer);
+  return check_framebuffer_status(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static bool create_framebuffer(glps_ScaledFramebuffer *fb, int width,
+                               int height) {
+  // Blits can't resolve into a multisampled window.
+  GLint sample_buffers = 0;
+  get_integerv(GL_SAMPLE_BUFFERS, &sample_buffers);
+  if (sample_buffers > 0) {
+    LOG_WARNING("Render scales unavailable for multisampled windows.");
+    return false;
+  }
+
+  gen_framebuffers(1, &fb->framebuffer);
+  gen_renderbuffers(1, &fb->color);
+  gen_renderbuffers(1, &fb->depth_stencil);
+  bind_framebuffer(GL_FRAMEBUFFER, fb->framebuffer);
+  framebuffer_renderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_RENDERBUFFER, fb->color);
+  framebuffer_renderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                           GL_RENDERBUFFER, fb->depth_stencil);
+  return allocate_storage(fb, width, height);
+}
+
+void glps_scaled_framebuffer_begin(glps_ScaledFramebuffer *fb, int width,
+                                   int height) {
+  // Created and resized at swaps, where the window's context is current.
+  if (fb->unsupported || !load_framebuffer_functions()) {
+    fb->unsupported = true;
+    return;
+  }
+
+  bool complete = true;
+  if (fb->framebuffer == 0) {
+    complete = create_framebuffer(fb, width, height);
+  } else if (fb->width != width || fb->height != height) {
+    complete = allocate_storage(fb, width, height);
+  } else {
+    bind_framebuffer(GL_FRAMEBUFFER, fb->framebuffer);
+  }
+
+  if (!complete) {
+    LOG_ERROR("Scaled framebuffer of %dx%d is incomplete.", width, height);
+    glps_scaled_framebuffer_destroy(fb);
+    fb->unsupported = true;
+    return;
+  }
+  fb->bound = true;
+}
+
+void glps_scaled_framebuffer_end(glps_ScaledFramebuffer *fb, int width,
+                                 int height) {
+  if (!fb->bound)
+    return;
+
+  // The scissor test is the only per-fragment state blits go through.
+  bool scissor = is_enabled(GL_SCISSOR_TEST);
+  if (scissor)
+    disable(GL_SCISSOR_TEST);
+  bind_framebuffer(GL_READ_FRAMEBUFFER, fb->framebuffer);
+  bind_framebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  blit_framebuffer(0, 0, fb->width, fb->height, 0, 0, width, height,
+                   GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  bind_framebuffer(GL_FRAMEBUFFER, 0);
+  if (scissor)
+    enable(GL_SCISSOR_TEST);
+  fb->bound = false;
+}
+
+void glps_scaled_framebuffer_make_current(glps_ScaledFramebuffer *fb) {
+  // Windows sharing a context share its binding, another window's target may
+  // be bound. Without the functions loaded no target was ever bound.
+  if (bind_framebuffer == NULL)
+    return;
+  bind_framebuffer(GL_FRAMEBUFFER, fb->bound ? fb->framebuffer : 0);
+}
+
+void glps_scaled_framebuffer_destroy(glps_ScaledFramebuffer *fb) {
+  if (fb->framebuffer != 0) {
+    if (fb->bound)
+      bind_framebuffer(GL_FRAMEBUFFER, 0);
+    delete_framebuffers(1, &fb->framebuffer);
+    delete_renderbuffers(1, &fb->color);
+    delete_renderbuffers(1, &fb->depth_stencil);
+  }
+  bool unsupported = fb->unsupported;
+  memset(fb, 0, sizeof(*fb));
+  fb->unsupported = unsupported;
+}
@@ -0,0 +1,173 @@
+#ifdef GLPS_USE_WAYLAND
+
+#include "glps_sync.h"
+#include "glps_render_thread.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+
+struct glps_Task {
+  void (*run)(glps_WindowManager *wm, void *data);
+  void *data;
+  struct glps_Task *next;
+};
+
+// Every word goes through an atomic, so a torn read is retried rather than
+// being a data race.
+void glps_seqlock_write(_Atomic uint32_t *seq, _Atomic uint64_t *words,
+                        const void *data, size_t size) {
+  uint32_t start = atomic_load_explicit(seq, memory_order_relaxed);
+  atomic_store_explicit(seq, start + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  const unsigned char *bytes = (const unsigned char *)data;
+  for (size_t i = 0; i * sizeof(uint64_t) < size; ++i) {
+    uint64_t word = 0;
+    size_t offset = i * sizeof(uint64_t);
+    size_t len = size - offset < sizeof(uint64_t) ? size - offset
+                                                  : sizeof(uint64_t);
+    memcpy(&word, bytes + offset, len);
+    atomic_store_explicit(&words[i], word, memory_order_relaxed);
+  }
+
+  atomic_store_explicit(seq, start + 2, memory_order_release);
+}
+
+void glps_seqlock_read(_Atomic uint32_t *seq, _Atomic uint64_t *words,
+                       void *data, size_t size) {
+  unsigned char *bytes = (unsigned char *)data;
+  uint32_t start, end;
+  do {
+    while ((start = atomic_load_explicit(seq, memory_order_acquire)) & 1) {
+      sched_yield();
+    }
+
+    for (size_t i = 0; i * sizeof(uint64_t) < size; ++i) {
+      uint64_t word = atomic_load_explicit(&words[i], memory_order_relaxed);
+      size_t offset = i * sizeof(uint64_t);
+      size_t len = size - offset < sizeof(uint64_t) ? size - offset
+                                                    : sizeof(uint64_t);
+      memcpy(bytes + offset, &word, len);
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    end = atomic_load_explicit(seq, memory_order_relaxed);
+  } while (start != end);
+}
+
+bool glps_sync_init(glps_WindowManager *wm) {
+  wm->owner_thread = pthread_self();
+  wm->task_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wm->task_wake_fd < 0) {
+    LOG_ERROR("Failed to create task eventfd: %s", strerror(errno));
+    return false;
+  }
+
+  pthread_mutex_init(&wm->task_lock, NULL);
+  atomic_init(&wm->reader_epoch, 0);
+  atomic_init(&wm->readers[0], 0);
+  atomic_init(&wm->readers[1], 0);
+  wm->tasks = wm->last_task = NULL;
+  return true;
+}
+
+void glps_sync_destroy(glps_WindowManager *wm) {
+  // Tasks posted too late are dropped, their data is the poster's.
+  struct glps_Task *task = wm->tasks;
+  while (task != NULL) {
+    struct glps_Task *next = task->next;
+    free(task);
+    task = next;
+  }
+  wm->tasks = wm->last_task = NULL;
+
+  pthread_mutex_destroy(&wm->task_lock);
+  if (wm->task_wake_fd >= 0) {
+    close(wm->task_wake_fd);
+    wm->task_wake_fd = -1;
+  }
+}
+
+bool glps_sync_is_owner(glps_WindowManager *wm) {
+  return pthread_equal(pthread_self(), wm->owner_thread);
+}
+
+void glps_sync_synchronize(glps_WindowManager *wm) {
+  // Readers that entered before the flip may still see old windows; flipping
+  // twice waits for those that read the epoch before the first flip too.
+  for (int i = 0; i < 2; ++i) {
+    unsigned epoch = atomic_fetch_xor(&wm->reader_epoch, 1);
+    while (atomic_load(&wm->readers[epoch & 1]) != 0) {
+      sched_yield();
+    }
+  }
+}
+
+glps_WaylandWindow *glps_sync_read_begin(glps_WindowManager *wm,
+                                         size_t window_id, unsigned *epoch) {
+  *epoch = atomic_load(&wm->reader_epoch) & 1;
+  atomic_fetch_add(&wm->readers[*epoch], 1);
+
+  // A render thread reads its own window, which outlives the thread.
+  glps_WaylandWindow *window = glps_render_thread_window(window_id);
+  if (window != NULL)
+    return window;
+  if (window_id >= wm->window_count)
+    return NULL;
+  return wm->windows[window_id];
+}
+
+void glps_sync_read_end(glps_WindowManager *wm, unsigned epoch) {
+  atomic_fetch_sub_explicit(&wm->readers[epoch], 1, memory_order_release);
+}
+
+bool glps_sync_post(glps_WindowManager *wm,
+                    void (*task)(glps_WindowManager *wm, void *data),
+                    void *data) {
+  if (glps_sync_is_owner(wm)) {
+    task(wm, data);
+    return true;
+  }
+
+  struct glps_Task *node = malloc(sizeof(struct glps_Task));
+  if (node == NULL) {
+    LOG_ERROR("Failed to allocate task.");
+    return false;
+  }
+  *node = (struct glps_Task){.run = task, .data = data};
+
+  pthread_mutex_lock(&wm->task_lock);
+  if (wm->last_task != NULL) {
+    wm->last_task->next = node;
+  } else {
+    wm->tasks = node;
+  }
+  wm->last_task = node;
+  pthread_mutex_unlock(&wm->task_lock);
+
+  eventfd_write(wm->task_wake_fd, 1);
+  return true;
+}
+
+size_t glps_sync_run_tasks(glps_WindowManager *wm) {
+  eventfd_t count;
+  eventfd_read(wm->task_wake_fd, &count);
+
+  pthread_mutex_lock(&wm->task_lock);
+  struct glps_Task *task = wm->tasks;
+  wm->tasks = wm->last_task = NULL;
+  pthread_mutex_unlock(&wm->task_lock);
+
+  // Run unlocked, so tasks may post more tasks.
+  size_t ran = 0;
+  while (task != NULL) {
+    struct glps_Task *next = task->next;
+    task->run(wm, task->data);
+    free(task);
+    task = next;
+    ran++;
+  }
+  return ran;
+}
+
+#endif
@@ -1,7 +1,17 @@
+#define _GNU_SOURCE
 
 #ifdef GLPS_USE_WAYLAND
+#include <glps_clipboard.h>
 #include <glps_egl_context.h>
+#include "glps_render_thread.h"
+#include "glps_sync.h"
+#include <glps_frame_stats.h>
+#include <glps_input_latency.h>
+#include <glps_resolution.h>
 #include <glps_wayland.h>
+#include <math.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 void xdg_wm_base_ping(void *data, struct xdg_wm_base *xdg_wm_base,
                       uint32_t serial) {
@@ -20,6 +30,70 @@ glps_WaylandContext *__get_wl_context(glps_WindowManager *wm) {
   return wm->wayland_ctx;
 }
 
+uint64_t glps_wl_clock_now_ns(glps_WindowManager *wm) {
+  struct timespec now;
+  clockid_t clock = CLOCK_MONOTONIC;
+  if (wm != NULL && wm->wayland_ctx != NULL)
+    clock = (clockid_t)wm->wayland_ctx->presentation_clock;
+  clock_gettime(clock, &now);
+  return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+glps_InputTimestamp __wl_stamp_input(glps_WindowManager *wm, uint32_t time) {
+  return (glps_InputTimestamp){.time_ms = time,
+                               .receive_ns = glps_wl_clock_now_ns(wm)};
+}
+
+static bool __wl_on_input_thread(glps_WaylandContext *context) {
+  return context->input_queue != NULL &&
+         pthread_equal(pthread_self(), context->input_thread);
+}
+
+// Keeps the input thread from looking up windows while they are changed.
+static void __wl_lock_windows(glps_WindowManager *wm) {
+  if (wm->wayland_ctx->input_queue != NULL)
+    pthread_mutex_lock(&wm->wayland_ctx->input_lock);
+}
+
+static void __wl_unlock_windows(glps_WindowManager *wm) {
+  if (wm->wayland_ctx->input_queue != NULL)
+    pthread_mutex_unlock(&wm->wayland_ctx->input_lock);
+}
+
+// Runs a window callback here, or on the window's render thread.
+static void __wl_deliver_event(glps_WindowManager *wm,
+                               const glps_WindowEvent *event) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  // Input read by the input thread waits for the dispatch thread.
+  if (__wl_on_input_thread(context)) {
+    if (!glps_event_queue_push(&context->input_events, event)) {
+      LOG_WARNING("Input queue is full, event dropped.");
+      return;
+    }
+    eventfd_write(context->input_wake_fd, 1);
+    return;
+  }
+
+  glps_WaylandWindow *window = event->window_id < wm->window_count
+                                   ? wm->windows[event->window_id]
+                                   : NULL;
+  if (event->timestamp.receive_ns != 0 && window != NULL) {
+    pthread_mutex_lock(&window->latency_lock);
+    glps_latency_input(&window->latency,
+                       glps_latency_event_time_ns(event->timestamp.time_ms,
+                                                  event->timestamp.receive_ns),
+                       event->timestamp.receive_ns);
+    pthread_mutex_unlock(&window->latency_lock);
+  }
+
+  if (window != NULL && window->render_thread != NULL) {
+    glps_render_thread_post(window->render_thread, event);
+  } else {
+    glps_window_event_dispatch(wm, event);
+  }
+}
+
 ssize_t __get_window_id_from_surface(glps_WindowManager *wm,
                                      struct wl_surface *surface) {
 
@@ -59,10 +133,16 @@ void wl_update(glps_WindowManager *wm, size_t window_id) {
     return;
   }
 
-  int width = wm->windows[window_id]->properties.width,
-      height = wm->windows[window_id]->properties.height;
-  wl_surface_damage(wm->windows[window_id]->wl_surface, 0, 0, width, height);
-  wl_surface_commit(wm->windows[window_id]->wl_surface);
+  glps_WaylandWindow *window = wm->windows[window_id];
+  int width = window->properties.width, height = window->properties.height;
+  // Software windows only ask for frames when they commit.
+  if (window->software && window->frame_callback == NULL) {
+    window->frame_callback = wl_surface_frame(window->wl_surface);
+    wl_callback_add_listener(window->frame_callback, &frame_callback_listener,
+                             window->frame_args);
+  }
+  wl_surface_damage(window->wl_surface, 0, 0, width, height);
+  wl_surface_commit(window->wl_surface);
 }
 
 ssize_t __get_window_id_from_xdg_toplevel(glps_WindowManager *wm,
@@ -169,6 +249,7 @@ void wl_pointer_axis_discrete(void *data, struct wl_pointer *wl_pointer,
 }
 
 void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
+  PERF_SCOPE("pointer_callbacks");
   glps_WindowManager *context = (glps_WindowManager *)data;
   struct pointer_event *event = &context->pointer_event;
   glps_WaylandContext *wayland_context = __get_wl_context(context);
@@ -177,48 +258,48 @@ void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
     LOG_ERROR("Couldn't fetch wayland context.");
     return;
   }
+  glps_InputTimestamp timestamp = {0};
+  if (event->event_mask & ~(POINTER_EVENT_ENTER | POINTER_EVENT_LEAVE)) {
+    timestamp = __wl_stamp_input(context, event->time);
+  }
+  size_t window_id = wayland_context->mouse_window_id;
   if (event->event_mask & POINTER_EVENT_ENTER) {
     // Mouse enter callback
-    if (context->callbacks.mouse_enter_callback) {
-      context->callbacks.mouse_enter_callback(
-          wayland_context->mouse_window_id,
-          wl_fixed_to_double(event->surface_x),
-          wl_fixed_to_double(event->surface_y),
-          context->callbacks.mouse_enter_data);
-    }
+    __wl_deliver_event(
+        context,
+        &(glps_WindowEvent){.type = GLPS_WINDOW_EVENT_MOUSE_ENTER,
+                            .window_id = window_id,
+                            .timestamp = timestamp,
+                            .pointer = {wl_fixed_to_double(event->surface_x),
+                                        wl_fixed_to_double(event->surface_y)}});
   }
 
   if (event->event_mask & POINTER_EVENT_LEAVE) {
     // Mouse leave callback
-    if (context->callbacks.mouse_leave_callback) {
-      context->callbacks.mouse_leave_callback(
-          wayland_context->mouse_window_id,
-          context->callbacks.mouse_leave_data);
-    }
+    __wl_deliver_event(context,
+                       &(glps_WindowEvent){.type = GLPS_WINDOW_EVENT_MOUSE_LEAVE,
+                                           .window_id = window_id});
   }
 
   if (event->event_mask & POINTER_EVENT_MOTION) {
     // Mouse move callback
-    if (context->callbacks.mouse_move_callback) {
-      context->callbacks.mouse_move_callback(
-          wayland_context->mouse_window_id,
-          wl_fixed_to_double(event->surface_x),
-          wl_fixed_to_double(event->surface_y),
-          context->callbacks.mouse_move_data);
-    }
+    __wl_deliver_event(
+        context,
+        &(glps_WindowEvent){.type = GLPS_WINDOW_EVENT_MOUSE_MOVE,
+                            .window_id = window_id,
+                            .timestamp = timestamp,
+                            .pointer = {wl_fixed_to_double(event->surface_x),
+                                        wl_fixed_to_double(event->surface_y)}});
   }
 
   if (event->event_mask & POINTER_EVENT_BUTTON) {
-    char *state = event->state == WL_POINTER_BUTTON_STATE_RELEASED ? "released"
-                                                                   : "pressed";
-
     // Mouse click callback
-    if (context->callbacks.mouse_click_callback) {
-      context->callbacks.mouse_click_callback(
-          wayland_context->mouse_window_id,
-          event->state == WL_POINTER_BUTTON_STATE_RELEASED ? false : true,
-          context->callbacks.mouse_click_data);
-    }
+    __wl_deliver_event(
+        context, &(glps_WindowEvent){
+                     .type = GLPS_WINDOW_EVENT_MOUSE_CLICK,
+                     .window_id = window_id,
+                     .timestamp = timestamp,
+                     .click = {event->state != WL_POINTER_BUTTON_STATE_RELEASED}});
   }
 
   uint32_t axis_events = POINTER_EVENT_AXIS | POINTER_EVENT_AXIS_SOURCE |
@@ -230,7 +311,7 @@ void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
         continue;
       }
       // Mouse scroll callback.
-      if (context->callbacks.mouse_scroll_callback) {
+      {
         GLPS_SCROLL_AXES axis_name[2] = {
             [WL_POINTER_AXIS_VERTICAL_SCROLL] = GLPS_SCROLL_V_AXIS,
             [WL_POINTER_AXIS_HORIZONTAL_SCROLL] = GLPS_SCROLL_H_AXIS,
@@ -256,11 +337,12 @@ void wl_pointer_frame(void *data, struct wl_pointer *wl_pointer) {
                            : -1;
         bool is_stopped = event->event_mask & POINTER_EVENT_AXIS_STOP;
 
-        context->callbacks.mouse_scroll_callback(
-            wayland_context->mouse_window_id,
-
-            axe, source, value, discrete, is_stopped,
-            context->callbacks.mouse_scroll_data);
+        __wl_deliver_event(
+            context, &(glps_WindowEvent){
+                         .type = GLPS_WINDOW_EVENT_MOUSE_SCROLL,
+                         .window_id = window_id,
+                         .timestamp = timestamp,
+                         .scroll = {axe, source, value, discrete, is_stopped}});
       }
     }
   }
@@ -310,10 +392,6 @@ void wl_keyboard_enter(void *data, struct wl_keyboard *wl_keyboard,
     return;
 
   glps_WindowManager *wm = (glps_WindowManager *)data;
-  if (wm->callbacks.keyboard_enter_callback != NULL) {
-    wm->callbacks.keyboard_enter_callback(context->keyboard_window_id,
-                                          wm->callbacks.keyboard_enter_data);
-  }
   ssize_t window_id = __get_window_id_from_surface(wm, surface);
 
   if (window_id < 0) {
@@ -323,6 +401,9 @@ void wl_keyboard_enter(void *data, struct wl_keyboard *wl_keyboard,
   }
   context->keyboard_serial = serial;
   context->keyboard_window_id = (size_t)window_id;
+  __wl_deliver_event(wm,
+                     &(glps_WindowEvent){.type = GLPS_WINDOW_EVENT_KEYBOARD_ENTER,
+                                         .window_id = (size_t)window_id});
 
   uint32_t *key;
   wl_array_for_each(key, keys) {
@@ -355,21 +436,21 @@ void wl_keyboard_key(void *data, struct wl_keyboard *wl_keyboard,
     utf8[0] = '\0';
   }
   glps_WindowManager *wm = (glps_WindowManager *)data;
-  if (wm->callbacks.keyboard_callback != NULL) {
-    wm->callbacks.keyboard_callback(
-        context->keyboard_window_id,
-        state == WL_KEYBOARD_KEY_STATE_PRESSED ? true : false,
-        (utf8[0] != '\0' ? utf8 : name), wm->callbacks.keyboard_data);
-  }
+  glps_WindowEvent event = {.type = GLPS_WINDOW_EVENT_KEY,
+                            .window_id = context->keyboard_window_id,
+                            .timestamp = __wl_stamp_input(wm, time),
+                            .key.state = state == WL_KEYBOARD_KEY_STATE_PRESSED};
+  strncpy(event.key.value, utf8[0] != '\0' ? utf8 : name,
+          sizeof(event.key.value) - 1);
+  __wl_deliver_event(wm, &event);
 }
 
 void wl_keyboard_leave(void *data, struct wl_keyboard *wl_keyboard,
                        uint32_t serial, struct wl_surface *surface) {
   glps_WindowManager *wm = (glps_WindowManager *)data;
-  if (wm->callbacks.keyboard_leave_callback != NULL) {
-    wm->callbacks.keyboard_leave_callback(wm->wayland_ctx->keyboard_window_id,
-                                          wm->callbacks.keyboard_leave_data);
-  }
+  __wl_deliver_event(
+      wm, &(glps_WindowEvent){.type = GLPS_WINDOW_EVENT_KEYBOARD_LEAVE,
+                              .window_id = wm->wayland_ctx->keyboard_window_id});
 }
 void wl_keyboard_modifiers(void *data, struct wl_keyboard *wl_keyboard,
                            uint32_t serial, uint32_t mods_depressed,
@@ -533,31 +614,39 @@ void wl_touch_frame(void *data, struct wl_touch *wl_touch) {
   if (data == NULL)
     return;
 
+  PERF_SCOPE("touch_callbacks");
   glps_WindowManager *wm = (glps_WindowManager *)data;
 
   struct touch_event *touch = &wm->touch_event;
   const size_t nmemb = sizeof(touch->points) / sizeof(struct touch_point);
   fprintf(stderr, "touch event @ %d:\n", touch->time);
 
+  glps_InputTimestamp timestamp = {0};
+  if (touch->time != 0) {
+    timestamp = __wl_stamp_input(wm, touch->time);
+  }
+
   for (size_t i = 0; i < nmemb; ++i) {
     struct touch_point *point = &touch->points[i];
     if (!point->valid) {
       continue;
     }
-    if (wm->callbacks.touch_callback) {
-      wm->callbacks.touch_callback(
-          touch->window_id,
-          touch->points[i].id,                  // id
-          wl_fixed_to_double(point->surface_x), // touch_x
-          wl_fixed_to_double(point->surface_y), // touch_y
-          (point->event_mask & (TOUCH_EVENT_DOWN | TOUCH_EVENT_UP))
-              ? true
-              : false,                            // state (down/up)
-          wl_fixed_to_double(point->major),       // major
-          wl_fixed_to_double(point->minor),       // minor
-          wl_fixed_to_double(point->orientation), // orientation
-          wm->callbacks.touch_data);
-    }
+    __wl_deliver_event(
+        wm, &(glps_WindowEvent){
+                .type = GLPS_WINDOW_EVENT_TOUCH,
+                .window_id = touch->window_id,
+                .timestamp = timestamp,
+                .touch = {
+                    touch->points[i].id,                  // id
+                    wl_fixed_to_double(point->surface_x), // touch_x
+                    wl_fixed_to_double(point->surface_y), // touch_y
+                    (point->event_mask & (TOUCH_EVENT_DOWN | TOUCH_EVENT_UP))
+                        ? true
+                        : false,                           // state (down/up)
+                    wl_fixed_to_double(point->major),      // major
+                    wl_fixed_to_double(point->minor),      // minor
+                    wl_fixed_to_double(point->orientation) // orientation
+                }});
     point->valid = false;
   }
 }
@@ -619,6 +708,87 @@ struct wl_seat_listener wl_seat_listener = {
     .name = wl_seat_name,
 };
 
+static const glps_ClipboardSource *
+__wl_find_source(glps_WindowManager *wm, const char *mime_type) {
+  for (size_t i = 0; i < wm->clipboard.source_count; ++i) {
+    if (strcmp(mime_type, wm->clipboard.sources[i].mime_type) == 0)
+      return &wm->clipboard.sources[i];
+  }
+
+  // Plain text is also offered under its explicit charset.
+  if (strcmp(mime_type, "text/plain;charset=utf-8") == 0)
+    return __wl_find_source(wm, "text/plain");
+
+  return NULL;
+}
+
+static void __wl_end_send(glps_WindowManager *wm, size_t index) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  glps_clipboard_send_end(&context->sends[index]);
+  memmove(&context->sends[index], &context->sends[index + 1],
+          (context->send_count - index - 1) * sizeof(context->sends[0]));
+  context->send_count--;
+}
+
+static void __wl_progress_send(glps_WindowManager *wm, size_t index) {
+  PERF_SCOPE("clipboard_send");
+  if (glps_clipboard_send_some(&wm->wayland_ctx->sends[index]) <= 0) {
+    __wl_end_send(wm, index);
+  }
+}
+
+// Sends of caller buffers stop before the buffers are released.
+static void __wl_release_sources(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  for (size_t i = context->send_count; i-- > 0;) {
+    if (context->sends[i].data != NULL && !context->sends[i].owned) {
+      __wl_end_send(wm, i);
+    }
+  }
+  glps_clipboard_sources_release(wm->clipboard.sources,
+                                 wm->clipboard.source_count);
+  wm->clipboard.source_count = 0;
+}
+
+static void __wl_cancel_sends(glps_WindowManager *wm) {
+  for (size_t i = wm->wayland_ctx->send_count; i-- > 0;) {
+    __wl_end_send(wm, i);
+  }
+}
+
+static void __wl_send_selection(glps_WindowManager *wm, const char *mime_type,
+                                int fd) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (fd < 0) {
+    LOG_ERROR("Invalid file descriptor: %d", fd);
+    return;
+  }
+
+  const glps_ClipboardSource *clipboard_source =
+      __wl_find_source(wm, mime_type);
+  if (clipboard_source == NULL) {
+    LOG_WARNING("Unsupported MIME type: %s", mime_type);
+    close(fd);
+    return;
+  }
+  if (context->send_count == GLPS_MAX_CLIPBOARD_TRANSFERS) {
+    LOG_WARNING("Too many clipboard sends in flight, dropping request.");
+    close(fd);
+    return;
+  }
+
+  LOG_INFO("Copying to clipboard: MIME type=%s", mime_type);
+  glps_ClipboardSend *send = &context->sends[context->send_count];
+  if (!glps_clipboard_send_begin(send, clipboard_source, mime_type, fd)) {
+    close(fd);
+    return;
+  }
+  context->send_count++;
+
+  // Small selections fit the pipe at once, the rest follows as it drains.
+  __wl_progress_send(wm, context->send_count - 1);
+}
+
 void data_source_handle_send(void *data, struct wl_data_source *source,
                              const char *mime_type, int fd) {
   glps_WindowManager *wm = (glps_WindowManager *)data;
@@ -634,29 +804,92 @@ void data_source_handle_send(void *data, struct wl_data_source *source,
     return;
   }
 
-  if (fd < 0) {
-    LOG_ERROR("Invalid file descriptor: %d", fd);
-    return;
+  __wl_send_selection(wm, mime_type, fd);
+}
+
+void data_source_handle_cancelled(void *data, struct wl_data_source *source) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandContext *context = NULL;
+
+  if (wm != NULL && (context = __get_wl_context(wm)) != NULL &&
+      context->data_src == source) {
+    context->data_src = NULL;
+    __wl_release_sources(wm);
   }
 
-  LOG_INFO("Copying to clipboard: MIME type=%s, Data Preview=%s", mime_type,
-           wm->clipboard.buff);
+  wl_data_source_destroy(source);
+}
+
+bool glps_wl_set_selection(glps_WindowManager *wm,
+                           glps_ClipboardSource *sources, size_t count) {
+  glps_WaylandContext *context = NULL;
+
+  if (wm == NULL || (context = __get_wl_context(wm)) == NULL) {
+    LOG_ERROR("Couldn't set selection, context is NULL.");
+    glps_clipboard_sources_release(sources, count);
+    return false;
+  }
+
+  if (context->data_control_device == NULL &&
+      (context->data_dvc_manager == NULL || context->data_dvc == NULL)) {
+    LOG_ERROR("Compositor has no data device, clipboard unavailable.");
+    glps_clipboard_sources_release(sources, count);
+    return false;
+  }
+
+  __wl_release_sources(wm);
+  memcpy(wm->clipboard.sources, sources, count * sizeof(*sources));
+  wm->clipboard.source_count = count;
+
+  bool has_plain = false, has_utf8 = false;
+  for (size_t i = 0; i < count; ++i) {
+    has_plain |= strcmp(sources[i].mime_type, "text/plain") == 0;
+    has_utf8 |= strcmp(sources[i].mime_type, "text/plain;charset=utf-8") == 0;
+  }
 
-  if (strcmp(mime_type, wm->clipboard.mime_type) == 0) {
-    if (write(fd, wm->clipboard.buff, strlen(wm->clipboard.buff)) < 0) {
-      LOG_ERROR("Error writing data to clipboard pipe.");
+  // Data-control sets the selection without keyboard focus or a serial.
+  if (context->data_control_device != NULL) {
+    struct zwlr_data_control_source_v1 *old_control_src =
+        context->data_control_src;
+    context->data_control_src = zwlr_data_control_manager_v1_create_data_source(
+        context->data_control_manager);
+    zwlr_data_control_source_v1_add_listener(
+        context->data_control_src, &data_control_source_listener, wm);
+    for (size_t i = 0; i < count; ++i) {
+      zwlr_data_control_source_v1_offer(context->data_control_src,
+                                        sources[i].mime_type);
     }
-  } else {
-    LOG_WARNING("Unsupported MIME type: %s", mime_type);
+    if (has_plain && !has_utf8) {
+      zwlr_data_control_source_v1_offer(context->data_control_src,
+                                        "text/plain;charset=utf-8");
+    }
+    zwlr_data_control_device_v1_set_selection(context->data_control_device,
+                                              context->data_control_src);
+
+    if (old_control_src != NULL) {
+      zwlr_data_control_source_v1_destroy(old_control_src);
+    }
+    return true;
   }
 
-  if (close(fd) < 0) {
-    LOG_ERROR("Error closing file descriptor.");
+  struct wl_data_source *old_src = context->data_src;
+  context->data_src =
+      wl_data_device_manager_create_data_source(context->data_dvc_manager);
+  wl_data_source_add_listener(context->data_src, &data_source_listener, wm);
+  for (size_t i = 0; i < count; ++i) {
+    wl_data_source_offer(context->data_src, sources[i].mime_type);
   }
-}
+  if (has_plain && !has_utf8) {
+    wl_data_source_offer(context->data_src, "text/plain;charset=utf-8");
+  }
+  wl_data_device_set_selection(context->data_dvc, context->data_src,
+                               context->keyboard_serial);
 
-void data_source_handle_cancelled(void *data, struct wl_data_source *source) {
-  wl_data_source_destroy(source);
+  if (old_src != NULL) {
+    wl_data_source_destroy(old_src);
+  }
+
+  return true;
 }
 
 void data_source_handle_target(void *data, struct wl_data_source *source,
@@ -714,6 +947,16 @@ struct wl_data_source_listener data_source_listener = {
     .dnd_finished = data_source_handle_dnd_finished,
 };
 
+static void __wl_record_mime_type(glps_DataOffer *incoming,
+                                  const char *mime_type) {
+  if (incoming->mime_count == GLPS_MAX_OFFER_MIME_TYPES)
+    return;
+
+  char *slot = incoming->mime_types[incoming->mime_count++];
+  strncpy(slot, mime_type, sizeof(incoming->mime_types[0]) - 1);
+  slot[sizeof(incoming->mime_types[0]) - 1] = '\0';
+}
+
 void data_offer_handle_offer(void *data, struct wl_data_offer *offer,
                              const char *mime_type) {
   glps_WindowManager *wm = (glps_WindowManager *)data;
@@ -729,10 +972,8 @@ void data_offer_handle_offer(void *data, struct wl_data_offer *offer,
     return;
   }
 
-  //  LOG_INFO("Offered MIME type: %s", mime_type);
-
-  if (strcmp(mime_type, "text/plain") == 0) {
-    wl_data_offer_accept(offer, context->current_serial, "text/plain");
+  if (context->incoming_offer.offer == offer) {
+    __wl_record_mime_type(&context->incoming_offer, mime_type);
   }
 }
 void data_offer_handle_source_actions(void *data, struct wl_data_offer *offer,
@@ -751,6 +992,256 @@ struct wl_data_offer_listener data_offer_listener = {
     .action = data_offer_handle_action,
 };
 
+static const char *__wl_find_offered_type(const glps_DataOffer *offer,
+                                          const char *mime_type) {
+  for (size_t i = 0; i < offer->mime_count; ++i) {
+    if (strcmp(offer->mime_types[i], mime_type) == 0)
+      return offer->mime_types[i];
+  }
+  return NULL;
+}
+
+static const char *__wl_pick_mime_type(const glps_DataOffer *offer,
+                                       const char *mime_type) {
+  static const char *text_types[] = {"text/plain;charset=utf-8",
+                                     "text/plain", "UTF8_STRING", "STRING",
+                                     "TEXT"};
+
+  if (mime_type != NULL)
+    return __wl_find_offered_type(offer, mime_type);
+
+  for (size_t t = 0; t < sizeof(text_types) / sizeof(text_types[0]); ++t) {
+    const char *offered = __wl_find_offered_type(offer, text_types[t]);
+    if (offered != NULL)
+      return offered;
+  }
+  return NULL;
+}
+
+static void __wl_cache_selection(glps_WindowManager *wm, const char *mime_type,
+                                 glps_ClipboardBuffer *buffer) {
+  glps_clipboard_buffer_free(&wm->clipboard.received);
+  wm->clipboard.received = *buffer;
+  *buffer = (glps_ClipboardBuffer){0};
+  strncpy(wm->clipboard.received_mime, mime_type,
+          sizeof(wm->clipboard.received_mime) - 1);
+  wm->clipboard.cached = true;
+}
+
+static void __wl_notify_selection(
+    glps_WindowManager *wm,
+    void (*callback)(const char *mime, const char *buff, size_t size,
+                     void *data),
+    void *data) {
+  if (callback == NULL) {
+    callback = wm->callbacks.clipboard_callback;
+    data = wm->callbacks.clipboard_data;
+  }
+
+  if (callback != NULL) {
+    callback(wm->clipboard.received_mime, wm->clipboard.received.data,
+             wm->clipboard.received.size, data);
+  }
+}
+
+static bool __wl_offer_valid(const glps_DataOffer *offer) {
+  return offer->offer != NULL || offer->control_offer != NULL;
+}
+
+static void __wl_offer_receive(const glps_DataOffer *offer,
+                               const char *mime_type, int fd) {
+  if (offer->control_offer != NULL) {
+    zwlr_data_control_offer_v1_receive(offer->control_offer, mime_type, fd);
+  } else {
+    wl_data_offer_receive(offer->offer, mime_type, fd);
+  }
+}
+
+static void __wl_offer_destroy(glps_DataOffer *offer) {
+  if (offer->control_offer != NULL) {
+    zwlr_data_control_offer_v1_destroy(offer->control_offer);
+  } else if (offer->offer != NULL) {
+    wl_data_offer_destroy(offer->offer);
+  }
+  *offer = (glps_DataOffer){0};
+}
+
+static bool __wl_owns_selection(glps_WaylandContext *context) {
+  return context->data_src != NULL || context->data_control_src != NULL;
+}
+
+static void __wl_notify_stream(
+    glps_WindowManager *wm, const char *mime_type, size_t size,
+    void (*callback)(const char *mime, const char *buff, size_t size,
+                     void *data),
+    void *data) {
+  if (callback == NULL) {
+    callback = wm->callbacks.clipboard_callback;
+    data = wm->callbacks.clipboard_data;
+  }
+
+  if (callback != NULL) {
+    callback(mime_type, NULL, size, data);
+  }
+}
+
+// Serves the selection from the cache or, if we own it, from our source.
+// The pipe would fill up before we get to read our own data.
+static bool __wl_selection_local(glps_WindowManager *wm,
+                                 const char *mime_type) {
+  if (wm->clipboard.cached &&
+      strcmp(wm->clipboard.received_mime, mime_type) == 0)
+    return true;
+
+  if (!__wl_owns_selection(wm->wayland_ctx))
+    return false;
+
+  const glps_ClipboardSource *source = __wl_find_source(wm, mime_type);
+  glps_ClipboardBuffer buffer = {0};
+  if (source == NULL ||
+      !glps_clipboard_source_read(source, mime_type, &buffer)) {
+    glps_clipboard_buffer_free(&buffer);
+    return false;
+  }
+
+  __wl_cache_selection(wm, mime_type, &buffer);
+  return true;
+}
+
+static glps_ClipboardTransfer *
+__wl_begin_transfer(glps_WindowManager *wm, const glps_DataOffer *offer,
+                    const char *mime_type) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context->transfer_count == GLPS_MAX_CLIPBOARD_TRANSFERS) {
+    LOG_WARNING("Too many clipboard transfers in flight, dropping offer.");
+    return NULL;
+  }
+
+  int fds[2];
+  if (pipe(fds) < 0) {
+    LOG_ERROR("Failed to create pipe for clipboard data: %s", strerror(errno));
+    return NULL;
+  }
+  // Only our end is non-blocking, the sender keeps its blocking write end.
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+  __wl_offer_receive(offer, mime_type, fds[1]);
+  close(fds[1]);
+
+  glps_ClipboardTransfer *transfer =
+      &context->transfers[context->transfer_count++];
+  *transfer = (glps_ClipboardTransfer){0};
+  transfer->offer = offer->offer;
+  transfer->fd = fds[0];
+  transfer->out_fd = -1;
+  strncpy(transfer->mime_type, mime_type, sizeof(transfer->mime_type) - 1);
+
+  return transfer;
+}
+
+static void __wl_notify_drop_files(glps_WindowManager *wm, size_t window_id,
+                                   glps_ClipboardBuffer *buffer) {
+  size_t count = 0;
+  glps_DroppedFile *files =
+      glps_clipboard_parse_uri_list(buffer->data, buffer->size, &count);
+  if (files == NULL) {
+    return;
+  }
+
+  if (wm->wayland_ctx->map_dropped_files) {
+    PERF_SCOPE("drop_map_files");
+    glps_clipboard_map_files(files, count);
+  }
+  wm->callbacks.drop_files_callback(window_id, files, count,
+                                    wm->callbacks.drop_files_data);
+  glps_clipboard_unmap_files(files, count);
+  free(files);
+}
+
+static void __wl_end_transfer(glps_WindowManager *wm, size_t index,
+                              bool completed) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  // Take the transfer out first, the callbacks may start new ones.
+  glps_ClipboardTransfer transfer = context->transfers[index];
+  memmove(&context->transfers[index], &context->transfers[index + 1],
+          (context->transfer_count - index - 1) *
+              sizeof(glps_ClipboardTransfer));
+  context->transfer_count--;
+
+  close(transfer.fd);
+  if (transfer.out_fd >= 0) {
+    close(transfer.out_fd);
+  }
+  if (transfer.is_drop) {
+    if (completed) {
+      wl_data_offer_finish(transfer.offer);
+    }
+    wl_data_offer_destroy(transfer.offer);
+  }
+
+  if (!completed) {
+    glps_clipboard_buffer_free(&transfer.buffer);
+    return;
+  }
+
+  if (transfer.out_fd >= 0) {
+    __wl_notify_stream(wm, transfer.mime_type, transfer.written,
+                       transfer.callback, transfer.callback_data);
+    return;
+  }
+
+  if (transfer.is_drop && wm->callbacks.drop_files_callback &&
+      strcmp(transfer.mime_type, "text/uri-list") == 0) {
+    __wl_notify_drop_files(wm, transfer.window_id, &transfer.buffer);
+    glps_clipboard_buffer_free(&transfer.buffer);
+    return;
+  }
+
+  if (transfer.is_drop) {
+    if (wm->callbacks.drag_n_drop_callback) {
+      wm->callbacks.drag_n_drop_callback(transfer.window_id,
+                                         transfer.mime_type,
+                                         transfer.buffer.data,
+                                         wm->callbacks.drag_n_drop_data);
+    }
+    glps_clipboard_buffer_free(&transfer.buffer);
+    return;
+  }
+
+  __wl_cache_selection(wm, transfer.mime_type, &transfer.buffer);
+  __wl_notify_selection(wm, transfer.callback, transfer.callback_data);
+}
+
+static void __wl_cancel_transfers(glps_WindowManager *wm, bool drops) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  for (size_t i = context->transfer_count; i-- > 0;) {
+    if (context->transfers[i].is_drop == drops) {
+      __wl_end_transfer(wm, i, false);
+    }
+  }
+}
+
+static void __wl_progress_transfer(glps_WindowManager *wm, size_t index) {
+  glps_ClipboardTransfer *transfer = &wm->wayland_ctx->transfers[index];
+
+  PERF_SCOPE("clipboard_read");
+  int result = transfer->out_fd >= 0
+                   ? glps_clipboard_splice_some(transfer->fd, transfer->out_fd,
+                                                &transfer->written)
+                   : glps_clipboard_buffer_read_some(&transfer->buffer,
+                                                     transfer->fd);
+  if (result > 0) {
+    return;
+  }
+
+  if (result < 0) {
+    LOG_ERROR("Clipboard transfer of %s failed.", transfer->mime_type);
+  }
+  __wl_end_transfer(wm, index, result == 0);
+}
+
 void data_device_handle_drop(void *data, struct wl_data_device *data_device) {
   glps_WindowManager *wm = (glps_WindowManager *)data;
   glps_WaylandContext *context = NULL;
@@ -769,25 +1260,20 @@ void data_device_handle_drop(void *data, struct wl_data_device *data_device) {
   }
 
   assert(context->current_drag_offer != NULL);
-  int fds[2];
-  pipe(fds);
-  wl_data_offer_receive(context->current_drag_offer, "text/plain", fds[1]);
-  close(fds[1]);
-
-  wl_display_roundtrip(context->wl_display);
-
-  char buffer[4096];
-  ssize_t bytes_read = read(fds[0], buffer, sizeof(buffer));
-
-  if (wm->callbacks.drag_n_drop_callback) {
-
-    wm->callbacks.drag_n_drop_callback(context->mouse_window_id, "text/plain",
-                                       buffer, wm->callbacks.drag_n_drop_data);
+  PERF_SCOPE("dnd_receive");
+  glps_ClipboardTransfer *transfer = NULL;
+  if (context->drag_mime_type[0] != '\0') {
+    glps_DataOffer drop = {.offer = context->current_drag_offer};
+    transfer = __wl_begin_transfer(wm, &drop, context->drag_mime_type);
+  }
+  if (transfer != NULL) {
+    transfer->is_drop = true;
+    transfer->window_id = context->mouse_window_id;
+  } else {
+    wl_data_offer_destroy(context->current_drag_offer);
   }
-  close(fds[0]);
 
-  wl_data_offer_finish(context->current_drag_offer);
-  wl_data_offer_destroy(context->current_drag_offer);
+  // The transfer owns the offer now and finishes it once the data is read.
   context->current_drag_offer = NULL;
 }
 
@@ -816,8 +1302,32 @@ void data_device_handle_data_offer(void *data,
     return;
   }
 
+  // The offer's MIME types follow right away, remember them for later.
+  wm->wayland_ctx->incoming_offer = (glps_DataOffer){.offer = offer};
   wl_data_offer_add_listener(offer, &data_offer_listener, data);
 }
+static void __wl_selection_changed(glps_WindowManager *wm,
+                                   glps_DataOffer offer) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  // Whatever is still being read belongs to a selection that is gone.
+  __wl_cancel_transfers(wm, false);
+  __wl_offer_destroy(&context->selection);
+  wm->clipboard.cached = false;
+  glps_clipboard_buffer_clear(&wm->clipboard.received);
+
+  // Only the offer is kept, its data is read when the application asks.
+  if (!__wl_offer_valid(&offer)) {
+    LOG_INFO("Clipboard is empty.");
+  }
+  context->selection = offer;
+  context->incoming_offer = (glps_DataOffer){0};
+
+  if (wm->callbacks.selection_callback) {
+    wm->callbacks.selection_callback(wm->callbacks.selection_data);
+  }
+}
+
 void data_device_handle_selection(void *data,
                                   struct wl_data_device *data_device,
                                   struct wl_data_offer *offer) {
@@ -828,51 +1338,220 @@ void data_device_handle_selection(void *data,
     return;
   }
 
-  if (offer == NULL) {
-    LOG_INFO("Clipboard is empty.");
-    memset(&wm->clipboard, 0, sizeof(wm->clipboard));
+  glps_WaylandContext *context = __get_wl_context(wm);
+  if (context == NULL || context->data_control_device != NULL) {
+    // In data-control mode the selection is followed through that device.
+    if (offer != NULL) {
+      wl_data_offer_destroy(offer);
+    }
     return;
   }
 
+  __wl_selection_changed(wm, offer != NULL && context->incoming_offer.offer ==
+                                                  offer
+                                 ? context->incoming_offer
+                                 : (glps_DataOffer){.offer = offer});
+}
+
+bool glps_wl_fetch_selection(glps_WindowManager *wm, const char *mime_type) {
+  glps_WaylandContext *context = __get_wl_context(wm);
+  if (context == NULL || !__wl_offer_valid(&context->selection)) {
+    return false;
+  }
+
+  const char *offered = __wl_pick_mime_type(&context->selection, mime_type);
+  if (offered == NULL) {
+    LOG_INFO("Clipboard has no %s content.", mime_type ? mime_type : "text");
+    return false;
+  }
+
+  if (__wl_selection_local(wm, offered)) {
+    return true;
+  }
+
+  PERF_SCOPE("clipboard_fetch");
   int fds[2];
   if (pipe(fds) < 0) {
-    perror("Failed to create pipe for clipboard data");
-    return;
+    LOG_ERROR("Failed to create pipe for clipboard data: %s", strerror(errno));
+    return false;
   }
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
 
-  wl_data_offer_receive(offer, "text/plain", fds[1]);
+  __wl_offer_receive(&context->selection, offered, fds[1]);
   close(fds[1]);
+  wl_display_flush(context->wl_display);
+
+  glps_ClipboardBuffer buffer = {0};
+  int result;
+  while ((result = glps_clipboard_buffer_read_some(&buffer, fds[0])) > 0) {
+    struct pollfd pfd = {.fd = fds[0], .events = POLLIN};
+    if (poll(&pfd, 1, GLPS_CLIPBOARD_FETCH_TIMEOUT_MS) == 0) {
+      LOG_WARNING("Clipboard source stopped sending %s.", offered);
+      result = -1;
+      break;
+    }
+  }
+  close(fds[0]);
 
-  glps_WaylandContext *context = __get_wl_context(wm);
-  if (context == NULL) {
-    LOG_ERROR("Failed to get Wayland context.");
-    close(fds[0]);
-    return;
+  if (result < 0) {
+    glps_clipboard_buffer_free(&buffer);
+    return false;
   }
 
-  wl_display_roundtrip(context->wl_display);
-  char buf[1024];
-  size_t buff_size = sizeof(wm->clipboard.buff) - 1;
+  __wl_cache_selection(wm, offered, &buffer);
+  return true;
+}
 
-  ssize_t n;
-  wm->clipboard.buff[0] = '\0';
+size_t glps_wl_get_selection_types(glps_WindowManager *wm,
+                                   const char **mime_types, size_t max) {
+  glps_WaylandContext *context = __get_wl_context(wm);
+  if (context == NULL || !__wl_offer_valid(&context->selection)) {
+    return 0;
+  }
 
-  while ((n = read(fds[0], buf, sizeof(buf) - 1)) > 0) {
-    buf[n] = '\0';
+  for (size_t i = 0; i < context->selection.mime_count && i < max; ++i) {
+    mime_types[i] = context->selection.mime_types[i];
+  }
+  return context->selection.mime_count;
+}
 
-    if (buff_size > 0) {
-      size_t to_copy = ((size_t)n < buff_size) ? (size_t)n : buff_size;
-      strncat(wm->clipboard.buff, buf, to_copy);
-      buff_size -= to_copy;
-    }
+void glps_wl_set_map_dropped_files(glps_WindowManager *wm, bool map_files) {
+  glps_WaylandContext *context = __get_wl_context(wm);
+  if (context != NULL) {
+    context->map_dropped_files = map_files;
   }
+}
 
-  if (n < 0) {
-    LOG_ERROR("Error reading clipboard data.");
+void glps_wl_set_drop_types(glps_WindowManager *wm,
+                            const char *const *mime_types, size_t count) {
+  glps_WaylandContext *context = __get_wl_context(wm);
+  if (context == NULL) {
+    return;
   }
 
-  wl_data_offer_destroy(offer);
+  if (count > GLPS_MAX_OFFER_MIME_TYPES) {
+    LOG_WARNING("Only the first %d drop types are used.",
+                GLPS_MAX_OFFER_MIME_TYPES);
+    count = GLPS_MAX_OFFER_MIME_TYPES;
+  }
+
+  memset(context->drop_mime_types, 0, sizeof(context->drop_mime_types));
+  for (size_t i = 0; i < count; ++i) {
+    strncpy(context->drop_mime_types[i], mime_types[i],
+            sizeof(context->drop_mime_types[i]) - 1);
+  }
+  context->drop_mime_count = count;
+}
+
+bool glps_wl_request_selection(
+    glps_WindowManager *wm, const char *mime_type,
+    void (*callback)(const char *mime, const char *buff, size_t size,
+                     void *data),
+    void *data) {
+  glps_WaylandContext *context = __get_wl_context(wm);
+  if (context == NULL || !__wl_offer_valid(&context->selection)) {
+    return false;
+  }
+
+  const char *offered = __wl_pick_mime_type(&context->selection, mime_type);
+  if (offered == NULL) {
+    LOG_INFO("Clipboard has no %s content.", mime_type ? mime_type : "text");
+    return false;
+  }
+
+  if (__wl_selection_local(wm, offered)) {
+    __wl_notify_selection(wm, callback, data);
+    return true;
+  }
+
+  // Read as data arrives from the event loop, a slow source must not block.
+  glps_ClipboardTransfer *transfer =
+      __wl_begin_transfer(wm, &context->selection, offered);
+  if (transfer == NULL) {
+    return false;
+  }
+
+  transfer->callback = callback;
+  transfer->callback_data = data;
+  return true;
 }
+
+bool glps_wl_request_selection_to_fd(
+    glps_WindowManager *wm, const char *mime_type, int fd,
+    void (*callback)(const char *mime, const char *buff, size_t size,
+                     void *data),
+    void *data) {
+  glps_WaylandContext *context = __get_wl_context(wm);
+  if (context == NULL || !__wl_offer_valid(&context->selection)) {
+    return false;
+  }
+
+  const char *offered = __wl_pick_mime_type(&context->selection, mime_type);
+  if (offered == NULL) {
+    LOG_INFO("Clipboard has no %s content.", mime_type ? mime_type : "text");
+    return false;
+  }
+
+  if (__wl_selection_local(wm, offered)) {
+    if (!glps_clipboard_buffer_write(&wm->clipboard.received, fd)) {
+      return false;
+    }
+    __wl_notify_stream(wm, offered, wm->clipboard.received.size, callback,
+                       data);
+    return true;
+  }
+
+  int out_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if (out_fd < 0) {
+    LOG_ERROR("Failed to duplicate clipboard descriptor: %s", strerror(errno));
+    return false;
+  }
+
+  // The data goes from the pipe to fd as it arrives and is never cached.
+  glps_ClipboardTransfer *transfer =
+      __wl_begin_transfer(wm, &context->selection, offered);
+  if (transfer == NULL) {
+    close(out_fd);
+    return false;
+  }
+
+  transfer->out_fd = out_fd;
+  transfer->callback = callback;
+  transfer->callback_data = data;
+  return true;
+}
+
+bool glps_wl_enable_data_control(glps_WindowManager *wm) {
+  glps_WaylandContext *context = __get_wl_context(wm);
+  if (context == NULL) {
+    return false;
+  }
+
+  if (context->data_control_device != NULL) {
+    return true;
+  }
+
+  if (context->data_control_manager == NULL || context->wl_seat == NULL) {
+    LOG_WARNING("Compositor does not support wlr-data-control.");
+    return false;
+  }
+
+  context->data_control_device = zwlr_data_control_manager_v1_get_data_device(
+      context->data_control_manager, context->wl_seat);
+  if (context->data_control_device == NULL) {
+    LOG_ERROR("Failed to get data-control device.");
+    return false;
+  }
+  zwlr_data_control_device_v1_add_listener(context->data_control_device,
+                                           &data_control_device_listener, wm);
+
+  // The regular device only reports the selection while we have focus.
+  __wl_selection_changed(wm, (glps_DataOffer){0});
+  wl_display_roundtrip(context->wl_display);
+  return true;
+}
+
 void data_device_handle_enter(void *data, struct wl_data_device *data_device,
                               uint32_t serial, struct wl_surface *surface,
                               wl_fixed_t x, wl_fixed_t y,
@@ -880,9 +1559,37 @@ void data_device_handle_enter(void *data, struct wl_data_device *data_device,
   printf("Drag entered surface: %fx%f\n", wl_fixed_to_double(x),
          wl_fixed_to_double(y));
   // Set the current offer
-  glps_WaylandContext *ctx = __get_wl_context((glps_WindowManager *)data);
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandContext *ctx = __get_wl_context(wm);
   ctx->current_drag_offer = offer;
   ctx->current_serial = serial;
+
+  if (offer == NULL) {
+    return;
+  }
+
+  ctx->drag = ctx->incoming_offer.offer == offer
+                  ? ctx->incoming_offer
+                  : (glps_DataOffer){.offer = offer};
+  ctx->incoming_offer = (glps_DataOffer){0};
+
+  // Accept the first type the application prefers, or reject the drag.
+  const char *accepted = NULL;
+  for (size_t i = 0; i < ctx->drop_mime_count && accepted == NULL; ++i) {
+    accepted = __wl_find_offered_type(&ctx->drag, ctx->drop_mime_types[i]);
+  }
+  if (ctx->drop_mime_count == 0 && wm->callbacks.drop_files_callback) {
+    accepted = __wl_find_offered_type(&ctx->drag, "text/uri-list");
+  }
+  if (ctx->drop_mime_count == 0 && accepted == NULL) {
+    accepted = __wl_pick_mime_type(&ctx->drag, NULL);
+  }
+
+  ctx->drag_mime_type[0] = '\0';
+  if (accepted != NULL) {
+    strncpy(ctx->drag_mime_type, accepted, sizeof(ctx->drag_mime_type) - 1);
+  }
+  wl_data_offer_accept(offer, serial, accepted);
   wl_data_offer_set_actions(offer, WL_DATA_DEVICE_MANAGER_DND_ACTION_COPY,
                             WL_DATA_DEVICE_MANAGER_DND_ACTION_COPY);
 }
@@ -905,7 +1612,12 @@ void data_device_handle_leave(void *data, struct wl_data_device *data_device) {
     return;
   }
   printf("Drag left our surface\n");
+  // A dropped offer belongs to its transfer, any other one is done with.
+  if (ctx->current_drag_offer != NULL) {
+    wl_data_offer_destroy(ctx->current_drag_offer);
+  }
   ctx->current_drag_offer = NULL;
+  ctx->drag = (glps_DataOffer){0};
 }
 
 struct wl_data_device_listener data_device_listener = {
@@ -918,6 +1630,599 @@ struct wl_data_device_listener data_device_listener = {
 
 };
 
+void data_control_offer_handle_offer(void *data,
+                                     struct zwlr_data_control_offer_v1 *offer,
+                                     const char *mime_type) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  if (wm->wayland_ctx->incoming_offer.control_offer == offer) {
+    __wl_record_mime_type(&wm->wayland_ctx->incoming_offer, mime_type);
+  }
+}
+
+struct zwlr_data_control_offer_v1_listener data_control_offer_listener = {
+    .offer = data_control_offer_handle_offer,
+};
+
+void data_control_device_handle_data_offer(
+    void *data, struct zwlr_data_control_device_v1 *device,
+    struct zwlr_data_control_offer_v1 *offer) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  wm->wayland_ctx->incoming_offer = (glps_DataOffer){.control_offer = offer};
+  zwlr_data_control_offer_v1_add_listener(offer, &data_control_offer_listener,
+                                          wm);
+}
+
+void data_control_device_handle_selection(
+    void *data, struct zwlr_data_control_device_v1 *device,
+    struct zwlr_data_control_offer_v1 *offer) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandContext *context = wm->wayland_ctx;
+
+  __wl_selection_changed(wm, offer != NULL &&
+                                     context->incoming_offer.control_offer ==
+                                         offer
+                                 ? context->incoming_offer
+                                 : (glps_DataOffer){.control_offer = offer});
+}
+
+void data_control_device_handle_primary_selection(
+    void *data, struct zwlr_data_control_device_v1 *device,
+    struct zwlr_data_control_offer_v1 *offer) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  // Only the regular selection is tracked.
+  if (offer != NULL) {
+    if (wm->wayland_ctx->incoming_offer.control_offer == offer) {
+      wm->wayland_ctx->incoming_offer = (glps_DataOffer){0};
+    }
+    zwlr_data_control_offer_v1_destroy(offer);
+  }
+}
+
+void data_control_device_handle_finished(
+    void *data, struct zwlr_data_control_device_v1 *device) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  LOG_WARNING("Data-control device is no longer valid.");
+  __wl_selection_changed(wm, (glps_DataOffer){0});
+  zwlr_data_control_device_v1_destroy(device);
+  wm->wayland_ctx->data_control_device = NULL;
+}
+
+struct zwlr_data_control_device_v1_listener data_control_device_listener = {
+    .data_offer = data_control_device_handle_data_offer,
+    .selection = data_control_device_handle_selection,
+    .finished = data_control_device_handle_finished,
+    .primary_selection = data_control_device_handle_primary_selection,
+};
+
+void data_control_source_handle_send(
+    void *data, struct zwlr_data_control_source_v1 *source,
+    const char *mime_type, int fd) {
+  __wl_send_selection((glps_WindowManager *)data, mime_type, fd);
+}
+
+void data_control_source_handle_cancelled(
+    void *data, struct zwlr_data_control_source_v1 *source) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  if (wm->wayland_ctx->data_control_src == source) {
+    __wl_release_sources(wm);
+    wm->wayland_ctx->data_control_src = NULL;
+  }
+  zwlr_data_control_source_v1_destroy(source);
+}
+
+struct zwlr_data_control_source_v1_listener data_control_source_listener = {
+    .send = data_control_source_handle_send,
+    .cancelled = data_control_source_handle_cancelled,
+};
+
+void presentation_clock_id(void *data, struct wp_presentation *presentation,
+                           uint32_t clk_id) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  wm->wayland_ctx->presentation_clock = clk_id;
+}
+
+struct wp_presentation_listener presentation_listener = {
+    .clock_id = presentation_clock_id,
+};
+
+void presentation_feedback_sync_output(
+    void *data, struct wp_presentation_feedback *feedback,
+    struct wl_output *output) {}
+
+void presentation_feedback_presented(void *data,
+                                     struct wp_presentation_feedback *feedback,
+                                     uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                     uint32_t tv_nsec, uint32_t refresh,
+                                     uint32_t seq_hi, uint32_t seq_lo,
+                                     uint32_t flags) {
+  glps_PresentationFeedback *slot = (glps_PresentationFeedback *)data;
+  uint64_t presented_ns =
+      (((uint64_t)tv_sec_hi << 32) | tv_sec_lo) * 1000000000ull + tv_nsec;
+
+  pthread_mutex_lock(slot->latency_lock);
+  glps_latency_record(slot->latency, slot->input_ns, slot->receive_ns,
+                      presented_ns, true);
+  wp_presentation_feedback_destroy(feedback);
+  slot->feedback = NULL;
+  pthread_mutex_unlock(slot->latency_lock);
+}
+
+void presentation_feedback_discarded(
+    void *data, struct wp_presentation_feedback *feedback) {
+  glps_PresentationFeedback *slot = (glps_PresentationFeedback *)data;
+
+  pthread_mutex_lock(slot->latency_lock);
+  glps_latency_discard(slot->latency);
+  wp_presentation_feedback_destroy(feedback);
+  slot->feedback = NULL;
+  pthread_mutex_unlock(slot->latency_lock);
+}
+
+struct wp_presentation_feedback_listener presentation_feedback_listener = {
+    .sync_output = presentation_feedback_sync_output,
+    .presented = presentation_feedback_presented,
+    .discarded = presentation_feedback_discarded,
+};
+
+bool glps_wl_request_presentation_feedback(glps_WindowManager *wm,
+                                           size_t window_id) {
+  glps_WaylandContext *ctx = __get_wl_context(wm);
+  if (ctx == NULL || ctx->presentation == NULL)
+    return false;
+
+  glps_WaylandWindow *window = glps_wl_window(wm, window_id);
+  pthread_mutex_lock(&window->latency_lock);
+  for (size_t i = 0; i < GLPS_LATENCY_MAX_IN_FLIGHT; ++i) {
+    glps_PresentationFeedback *slot = &window->presentation_feedback[i];
+    if (slot->feedback != NULL)
+      continue;
+
+    if (!glps_latency_take_pending(&window->latency, &slot->input_ns,
+                                   &slot->receive_ns))
+      break;
+
+    slot->feedback =
+        wp_presentation_feedback(ctx->presentation, window->wl_surface);
+    if (slot->feedback == NULL) {
+      LOG_ERROR("Failed to request presentation feedback.");
+      break;
+    }
+    slot->latency = &window->latency;
+    slot->latency_lock = &window->latency_lock;
+    wp_presentation_feedback_add_listener(
+        slot->feedback, &presentation_feedback_listener, slot);
+    break;
+  }
+  pthread_mutex_unlock(&window->latency_lock);
+
+  // Every slot may be waiting on a frame; the input rides on a later one.
+  return true;
+}
+
+static void _destroy_presentation_feedback(glps_WaylandWindow *window) {
+  for (size_t i = 0; i < GLPS_LATENCY_MAX_IN_FLIGHT; ++i) {
+    if (window->presentation_feedback[i].feedback != NULL) {
+      wp_presentation_feedback_destroy(window->presentation_feedback[i].feedback);
+      window->presentation_feedback[i].feedback = NULL;
+    }
+  }
+}
+
+static glps_WaylandOutput *__wl_get_output(glps_WaylandContext *context,
+                                           struct wl_output *wl_output) {
+  for (size_t i = 0; i < context->output_count; ++i) {
+    if (context->outputs[i]->wl_output == wl_output)
+      return context->outputs[i];
+  }
+  return NULL;
+}
+
+// Buffers cover the device pixels of the surface: at the preferred fractional
+// scale through the viewport, or at the integer output scale without one.
+// The render scale shrinks them further and the compositor upscales.
+static void __wl_buffer_size(glps_WaylandWindow *window, int *width,
+                             int *height, int *buffer_scale) {
+  const glps_WindowProperties *properties = &window->properties;
+  int scale = properties->scale > 0 ? properties->scale : 1;
+
+  if (window->viewport == NULL) {
+    if (wl_surface_get_version(window->wl_surface) <
+        WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION)
+      scale = 1;
+    *width = properties->width * scale;
+    *height = properties->height * scale;
+    *buffer_scale = scale;
+    return;
+  }
+
+  // Device pixels are rounded halfway away from zero, as the compositor does.
+  double device_scale = window->preferred_scale != 0
+                            ? window->preferred_scale / 120.0
+                            : (double)scale;
+  long device_width = lround(properties->width * device_scale);
+  long device_height = lround(properties->height * device_scale);
+  *width = (int)fmax(1.0, round(device_width * properties->render_scale));
+  *height = (int)fmax(1.0, round(device_height * properties->render_scale));
+  *buffer_scale = 1;
+}
+
+void glps_wl_window_resize_buffers(glps_WaylandWindow *window,
+                                   const glps_WindowEvent *event) {
+  // Software windows get buffers of the new size when mapped next.
+  if (window->egl_window != NULL) {
+    wl_egl_window_resize(window->egl_window, event->resize.width,
+                         event->resize.height, 0, 0);
+  }
+  window->surface_scale = (glps_WaylandSurfaceScale){
+      .width = event->resize.logical_width,
+      .height = event->resize.logical_height,
+      .buffer_scale = event->resize.buffer_scale,
+      .dirty = true,
+  };
+}
+
+void glps_wl_window_apply_scale(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandWindow *window = glps_wl_window(wm, window_id);
+  glps_WaylandSurfaceScale *scale = &window->surface_scale;
+  if (!scale->dirty || scale->width <= 0 || scale->height <= 0)
+    return;
+
+  if (window->viewport != NULL) {
+    wp_viewport_set_destination(window->viewport, scale->width, scale->height);
+  } else if (wl_surface_get_version(window->wl_surface) >=
+             WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION) {
+    wl_surface_set_buffer_scale(window->wl_surface, scale->buffer_scale);
+  }
+  scale->dirty = false;
+}
+
+// The resize callback gets the buffer size, which is what glViewport and
+// map_pixels need; the dimensions of the window stay in surface units.
+static void __wl_resize(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  glps_WindowEvent event = {.type = GLPS_WINDOW_EVENT_RESIZE,
+                            .window_id = window_id};
+  __wl_buffer_size(window, &event.resize.width, &event.resize.height,
+                   &event.resize.buffer_scale);
+  event.resize.logical_width = window->properties.width;
+  event.resize.logical_height = window->properties.height;
+
+  window->properties.buffer_width = event.resize.width;
+  window->properties.buffer_height = event.resize.height;
+  GLPS_SEQLOCK_PUBLISH(&window->properties_cell, &window->properties);
+
+  // The render thread resizes its EGL window itself and commits on its own.
+  if (window->render_thread != NULL) {
+    glps_render_thread_post(window->render_thread, &event);
+    return;
+  }
+
+  glps_wl_window_resize_buffers(window, &event);
+  if (wm->callbacks.window_resize_callback) {
+    wm->callbacks.window_resize_callback(window_id, event.resize.width,
+                                         event.resize.height,
+                                         wm->callbacks.window_resize_data);
+  }
+  wl_update(wm, window_id);
+}
+
+// Scale changes only matter to the application if the buffers change size.
+static void __wl_rescale(glps_WindowManager *wm, size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  int width, height, buffer_scale;
+  __wl_buffer_size(window, &width, &height, &buffer_scale);
+  if (width != window->properties.buffer_width ||
+      height != window->properties.buffer_height)
+    __wl_resize(wm, window_id);
+}
+
+bool glps_wl_window_set_render_scale(glps_WindowManager *wm, size_t window_id,
+                                     double render_scale) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  if (window->viewport == NULL) {
+    LOG_WARNING("The compositor lacks wp_viewporter, window %zu renders at "
+                "full size.",
+                window_id);
+    return false;
+  }
+
+  if (render_scale == window->properties.render_scale)
+    return true;
+  window->properties.render_scale = render_scale;
+  GLPS_SEQLOCK_PUBLISH(&window->properties_cell, &window->properties);
+  __wl_rescale(wm, window_id);
+  return true;
+}
+
+static void
+fractional_scale_handle_preferred_scale(void *data,
+                                        struct wp_fractional_scale_v1 *scale,
+                                        uint32_t preferred_scale) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  for (size_t i = 0; i < wm->window_count; ++i) {
+    glps_WaylandWindow *window = wm->windows[i];
+    if (window->fractional_scale != scale)
+      continue;
+    if (window->preferred_scale != preferred_scale) {
+      window->preferred_scale = preferred_scale;
+      __wl_rescale(wm, i);
+    }
+    return;
+  }
+}
+
+static const struct wp_fractional_scale_v1_listener fractional_scale_listener =
+    {
+        .preferred_scale = fractional_scale_handle_preferred_scale,
+};
+
+static void __wl_destroy_scaling(glps_WaylandWindow *window) {
+  if (window->fractional_scale != NULL) {
+    wp_fractional_scale_v1_destroy(window->fractional_scale);
+    window->fractional_scale = NULL;
+  }
+  if (window->viewport != NULL) {
+    wp_viewport_destroy(window->viewport);
+    window->viewport = NULL;
+  }
+}
+
+// A window shown on several outputs follows the fastest and sharpest one.
+static void __wl_update_window_output(glps_WindowManager *wm,
+                                      size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  if (window->output_count == 0)
+    return;
+
+  int refresh_mhz = 0, scale = 0;
+  for (size_t i = 0; i < window->output_count; ++i) {
+    const glps_Output *output = &window->outputs[i]->output;
+    if (output->refresh_mhz > refresh_mhz)
+      refresh_mhz = output->refresh_mhz;
+    if (output->scale > scale)
+      scale = output->scale;
+  }
+  if (refresh_mhz == window->properties.refresh_mhz &&
+      scale == window->properties.scale)
+    return;
+
+  window->properties.refresh_mhz = refresh_mhz;
+  window->properties.scale = scale;
+  GLPS_SEQLOCK_PUBLISH(&window->properties_cell, &window->properties);
+  __wl_deliver_event(wm, &(glps_WindowEvent){
+                             .type = GLPS_WINDOW_EVENT_OUTPUT,
+                             .window_id = window_id,
+                             .output = {refresh_mhz, scale}});
+  // The output scale is a fallback until a fractional one is preferred.
+  __wl_rescale(wm, window_id);
+}
+
+static void __wl_output_changed(glps_WindowManager *wm,
+                                glps_WaylandOutput *output) {
+  GLPS_OUTPUT_EVENT event =
+      output->announced ? GLPS_OUTPUT_CHANGED : GLPS_OUTPUT_ADDED;
+  output->output = output->pending;
+  output->announced = true;
+
+  for (size_t i = 0; i < wm->window_count; ++i) {
+    glps_WaylandWindow *window = wm->windows[i];
+    for (size_t j = 0; j < window->output_count; ++j) {
+      if (window->outputs[j] == output) {
+        __wl_update_window_output(wm, i);
+        break;
+      }
+    }
+  }
+
+  if (wm->callbacks.output_callback)
+    wm->callbacks.output_callback(&output->output, event,
+                                  wm->callbacks.output_data);
+}
+
+// Outputs older than version 2 send no done event, every change is final.
+static void __wl_output_update(glps_WindowManager *wm,
+                               glps_WaylandOutput *output) {
+  if (wl_output_get_version(output->wl_output) < 2)
+    __wl_output_changed(wm, output);
+}
+
+static void output_handle_geometry(void *data, struct wl_output *wl_output,
+                                   int32_t x, int32_t y,
+                                   int32_t physical_width,
+                                   int32_t physical_height, int32_t subpixel,
+                                   const char *make, const char *model,
+                                   int32_t transform) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandOutput *output = __wl_get_output(wm->wayland_ctx, wl_output);
+  if (output == NULL)
+    return;
+
+  output->pending.x = x;
+  output->pending.y = y;
+  output->pending.physical_width_mm = physical_width;
+  output->pending.physical_height_mm = physical_height;
+  // Version 4 sends a proper description after this.
+  snprintf(output->pending.description, sizeof(output->pending.description),
+           "%s %s", make, model);
+  __wl_output_update(wm, output);
+}
+
+static void output_handle_mode(void *data, struct wl_output *wl_output,
+                               uint32_t flags, int32_t width, int32_t height,
+                               int32_t refresh) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandOutput *output = __wl_get_output(wm->wayland_ctx, wl_output);
+  if (output == NULL || !(flags & WL_OUTPUT_MODE_CURRENT))
+    return;
+
+  output->pending.width = width;
+  output->pending.height = height;
+  output->pending.refresh_mhz = refresh;
+  __wl_output_update(wm, output);
+}
+
+static void output_handle_done(void *data, struct wl_output *wl_output) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandOutput *output = __wl_get_output(wm->wayland_ctx, wl_output);
+  if (output != NULL)
+    __wl_output_changed(wm, output);
+}
+
+static void output_handle_scale(void *data, struct wl_output *wl_output,
+                                int32_t factor) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandOutput *output = __wl_get_output(wm->wayland_ctx, wl_output);
+  if (output != NULL)
+    output->pending.scale = factor;
+}
+
+static void output_handle_name(void *data, struct wl_output *wl_output,
+                               const char *name) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandOutput *output = __wl_get_output(wm->wayland_ctx, wl_output);
+  if (output != NULL)
+    snprintf(output->pending.name, sizeof(output->pending.name), "%s", name);
+}
+
+static void output_handle_description(void *data, struct wl_output *wl_output,
+                                      const char *description) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandOutput *output = __wl_get_output(wm->wayland_ctx, wl_output);
+  if (output != NULL)
+    snprintf(output->pending.description, sizeof(output->pending.description),
+             "%s", description);
+}
+
+static const struct wl_output_listener output_listener = {
+    .geometry = output_handle_geometry,
+    .mode = output_handle_mode,
+    .done = output_handle_done,
+    .scale = output_handle_scale,
+    .name = output_handle_name,
+    .description = output_handle_description,
+};
+
+static void __wl_bind_output(glps_WindowManager *wm,
+                             struct wl_registry *registry, uint32_t id,
+                             uint32_t version) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context->output_count == GLPS_MAX_OUTPUTS) {
+    LOG_WARNING("Too many outputs, output %u is ignored.", id);
+    return;
+  }
+
+  glps_WaylandOutput *output = calloc(1, sizeof(glps_WaylandOutput));
+  if (output == NULL) {
+    LOG_ERROR("Failed to allocate output.");
+    return;
+  }
+  output->wl_output = wl_registry_bind(registry, id, &wl_output_interface,
+                                       version < 4 ? version : 4);
+  if (output->wl_output == NULL) {
+    LOG_ERROR("Failed to bind wl_output.");
+    free(output);
+    return;
+  }
+  output->pending.id = id;
+  output->pending.scale = 1;
+  context->outputs[context->output_count++] = output;
+  wl_output_add_listener(output->wl_output, &output_listener, wm);
+}
+
+static void __wl_destroy_output(glps_WaylandOutput *output) {
+  if (wl_output_get_version(output->wl_output) >= 3)
+    wl_output_release(output->wl_output);
+  else
+    wl_output_destroy(output->wl_output);
+  free(output);
+}
+
+static void __wl_remove_output(glps_WindowManager *wm, uint32_t id) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  size_t index = 0;
+  while (index < context->output_count &&
+         context->outputs[index]->pending.id != id)
+    index++;
+  if (index == context->output_count)
+    return;
+
+  glps_WaylandOutput *output = context->outputs[index];
+  for (size_t i = index; i + 1 < context->output_count; ++i)
+    context->outputs[i] = context->outputs[i + 1];
+  context->output_count--;
+
+  // Windows keep the refresh they had until they enter another output.
+  for (size_t i = 0; i < wm->window_count; ++i) {
+    glps_WaylandWindow *window = wm->windows[i];
+    for (size_t j = 0; j < window->output_count; ++j) {
+      if (window->outputs[j] != output)
+        continue;
+      window->outputs[j] = window->outputs[--window->output_count];
+      __wl_update_window_output(wm, i);
+      break;
+    }
+  }
+
+  if (output->announced && wm->callbacks.output_callback)
+    wm->callbacks.output_callback(&output->output, GLPS_OUTPUT_REMOVED,
+                                  wm->callbacks.output_data);
+  __wl_destroy_output(output);
+}
+
+static void surface_handle_enter(void *data, struct wl_surface *surface,
+                                 struct wl_output *wl_output) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  ssize_t window_id = __get_window_id_from_surface(wm, surface);
+  glps_WaylandOutput *output = __wl_get_output(wm->wayland_ctx, wl_output);
+  if (window_id < 0 || output == NULL)
+    return;
+
+  glps_WaylandWindow *window = wm->windows[window_id];
+  for (size_t i = 0; i < window->output_count; ++i) {
+    if (window->outputs[i] == output)
+      return;
+  }
+  window->outputs[window->output_count++] = output;
+  __wl_update_window_output(wm, window_id);
+}
+
+static void surface_handle_leave(void *data, struct wl_surface *surface,
+                                 struct wl_output *wl_output) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  ssize_t window_id = __get_window_id_from_surface(wm, surface);
+  glps_WaylandOutput *output = __wl_get_output(wm->wayland_ctx, wl_output);
+  if (window_id < 0 || output == NULL)
+    return;
+
+  glps_WaylandWindow *window = wm->windows[window_id];
+  for (size_t i = 0; i < window->output_count; ++i) {
+    if (window->outputs[i] == output) {
+      window->outputs[i] = window->outputs[--window->output_count];
+      __wl_update_window_output(wm, window_id);
+      return;
+    }
+  }
+}
+
+static const struct wl_surface_listener surface_listener = {
+    .enter = surface_handle_enter,
+    .leave = surface_handle_leave,
+};
+
+size_t glps_wl_get_outputs(glps_WindowManager *wm, glps_Output *outputs,
+                           size_t max_outputs) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  size_t count = 0;
+  for (size_t i = 0; i < context->output_count; ++i) {
+    if (!context->outputs[i]->announced)
+      continue;
+    if (count < max_outputs)
+      outputs[count] = context->outputs[i]->output;
+    count++;
+  }
+  return count;
+}
+
 void handle_global(void *data, struct wl_registry *registry, uint32_t id,
                    const char *interface, uint32_t version) {
   glps_WindowManager *context = (glps_WindowManager *)data;
@@ -927,13 +2232,21 @@ void handle_global(void *data, struct wl_registry *registry, uint32_t id,
            id, version);
 
   if (strcmp(interface, "wl_compositor") == 0) {
-    s->wl_compositor =
-        wl_registry_bind(registry, id, &wl_compositor_interface, 1);
+    // Version 4 damages in buffer coordinates.
+    s->wl_compositor = wl_registry_bind(registry, id, &wl_compositor_interface,
+                                        version < 4 ? version : 4);
     if (!s->wl_compositor) {
       LOG_ERROR("Failed to bind wl_compositor.");
     } else {
       LOG_INFO("Successfully bound wl_compositor.");
     }
+  } else if (strcmp(interface, wl_output_interface.name) == 0) {
+    __wl_bind_output(context, registry, id, version);
+  } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+    s->wl_shm = wl_registry_bind(registry, id, &wl_shm_interface, 1);
+    if (!s->wl_shm) {
+      LOG_ERROR("Failed to bind wl_shm.");
+    }
   } else if (strcmp(interface, "xdg_wm_base") == 0) {
     s->xdg_wm_base = wl_registry_bind(registry, id, &xdg_wm_base_interface, 1);
     if (!s->xdg_wm_base) {
@@ -950,6 +2263,28 @@ void handle_global(void *data, struct wl_registry *registry, uint32_t id,
       LOG_INFO("Successfully bound zxdg_decoration_manager_v1.");
     }
 
+  } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+    s->viewporter = wl_registry_bind(registry, id, &wp_viewporter_interface, 1);
+    if (!s->viewporter) {
+      LOG_ERROR("Failed to bind wp_viewporter.");
+    }
+  } else if (strcmp(interface, wp_fractional_scale_manager_v1_interface.name) ==
+             0) {
+    s->fractional_scale_manager = wl_registry_bind(
+        registry, id, &wp_fractional_scale_manager_v1_interface, 1);
+    if (!s->fractional_scale_manager) {
+      LOG_ERROR("Failed to bind wp_fractional_scale_manager_v1.");
+    }
+  } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+    s->presentation =
+        wl_registry_bind(registry, id, &wp_presentation_interface, 1);
+    if (s->presentation) {
+      wp_presentation_add_listener(s->presentation, &presentation_listener,
+                                   context);
+      LOG_INFO("Successfully bound wp_presentation.");
+    } else {
+      LOG_ERROR("Failed to bind wp_presentation.");
+    }
   } else if (strcmp(interface, wl_seat_interface.name) == 0) {
     s->wl_seat = wl_registry_bind(registry, id, &wl_seat_interface, version);
     if (s->wl_seat) {
@@ -977,13 +2312,24 @@ void handle_global(void *data, struct wl_registry *registry, uint32_t id,
     } else {
       LOG_ERROR("Failed to bind wl_data_device_manager_interface.");
     }
+  } else if (strcmp(interface, zwlr_data_control_manager_v1_interface.name) ==
+             0) {
+    s->data_control_manager = wl_registry_bind(
+        registry, id, &zwlr_data_control_manager_v1_interface,
+        version < 2 ? version : 2);
+    if (s->data_control_manager == NULL) {
+      LOG_ERROR("Failed to bind zwlr_data_control_manager_v1.");
+    }
   } else {
     LOG_WARNING("Unhandled interface: %s", interface);
   }
 }
 
 void handle_global_remove(void *data, struct wl_registry *registry,
-                          uint32_t name) {}
+                          uint32_t name) {
+  // Outputs are the only globals expected to go away, when unplugged.
+  __wl_remove_output((glps_WindowManager *)data, name);
+}
 
 struct wl_registry_listener registry_listener = {
     .global = handle_global,
@@ -1000,7 +2346,32 @@ void frame_callback_done(void *data, struct wl_callback *callback,
     return;
   }
 
+  // The next frame is requested before the render thread commits this one.
+  if (window->render_thread != NULL) {
+    wl_callback_destroy(callback);
+    window->frame_callback = wl_surface_frame(window->wl_surface);
+    wl_callback_add_listener(window->frame_callback, &frame_callback_listener,
+                             args);
+    glps_render_thread_post(window->render_thread,
+                            &(glps_WindowEvent){.type = GLPS_WINDOW_EVENT_FRAME,
+                                                .window_id = args->window_id});
+    return;
+  }
+
+  // Presenting pixels asks for the next frame, before its commit.
+  if (window->software) {
+    wl_callback_destroy(callback);
+    window->frame_callback = NULL;
+    if (args->wm->callbacks.window_frame_update_callback) {
+      PERF_SCOPE("frame_update_callback");
+      args->wm->callbacks.window_frame_update_callback(
+          args->window_id, args->wm->callbacks.window_frame_update_data);
+    }
+    return;
+  }
+
   if (args->wm->callbacks.window_frame_update_callback) {
+    PERF_SCOPE("frame_update_callback");
     args->wm->callbacks.window_frame_update_callback(
         args->window_id, args->wm->callbacks.window_frame_update_data);
   }
@@ -1036,15 +2407,7 @@ void handle_toplevel_configure(void *data, struct xdg_toplevel *toplevel,
     window->properties.height = height;
     window->properties.width = width;
   }
-
-  wl_egl_window_resize(window->egl_window, width, height, 0, 0);
-
-  if (wm->callbacks.window_resize_callback) {
-    wm->callbacks.window_resize_callback(window_id, window->properties.width,
-                                         window->properties.height,
-                                         wm->callbacks.window_resize_data);
-  }
-  wl_update(wm, window_id);
+  __wl_resize(wm, (size_t)window_id);
 }
 
 void handle_toplevel_close(void *data, struct xdg_toplevel *toplevel) {
@@ -1100,9 +2463,190 @@ struct xdg_surface_listener xdg_surface_listener = {
     .configure = xdg_surface_configure,
 };
 
+static void __wl_shm_buffer_destroy(glps_WaylandShmBuffer *buffer) {
+  if (buffer->buffer != NULL) {
+    wl_buffer_destroy(buffer->buffer);
+    munmap(buffer->pixels, buffer->size);
+  }
+  *buffer = (glps_WaylandShmBuffer){0};
+}
+
+static void __wl_shm_buffer_release(void *data, struct wl_buffer *buffer) {
+  ((glps_WaylandShmBuffer *)data)->busy = false;
+}
+
+static const struct wl_buffer_listener shm_buffer_listener = {
+    .release = __wl_shm_buffer_release,
+};
+
+// Only happens for the first frame and after resizes, never per frame.
+static bool __wl_shm_buffer_create(glps_WaylandContext *ctx,
+                                   glps_WaylandShmBuffer *buffer, int width,
+                                   int height) {
+  __wl_shm_buffer_destroy(buffer);
+
+  size_t size = (size_t)width * height * sizeof(uint32_t);
+  int fd = memfd_create("glps-shm", MFD_CLOEXEC);
+  if (fd < 0) {
+    LOG_ERROR("Failed to create shm memfd: %s", strerror(errno));
+    return false;
+  }
+  if (ftruncate(fd, size) < 0) {
+    LOG_ERROR("Failed to size shm memfd: %s", strerror(errno));
+    close(fd);
+    return false;
+  }
+  void *pixels = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (pixels == MAP_FAILED) {
+    LOG_ERROR("Failed to map shm memfd: %s", strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  // The buffer keeps the pool's memory alive on its own.
+  struct wl_shm_pool *pool = wl_shm_create_pool(ctx->wl_shm, fd, size);
+  buffer->buffer =
+      wl_shm_pool_create_buffer(pool, 0, width, height,
+                                width * sizeof(uint32_t),
+                                WL_SHM_FORMAT_XRGB8888);
+  wl_shm_pool_destroy(pool);
+  close(fd);
+  if (buffer->buffer == NULL) {
+    LOG_ERROR("Failed to create shm buffer.");
+    munmap(pixels, size);
+    return false;
+  }
+  wl_buffer_add_listener(buffer->buffer, &shm_buffer_listener, buffer);
+
+  buffer->pixels = pixels;
+  buffer->size = size;
+  buffer->width = width;
+  buffer->height = height;
+  return true;
+}
+
+// Compositors older than wl_surface version 4 take damage in surface
+// coordinates, rounded outward. A buffer of the size before a resize is
+// damaged whole, its scale isn't known.
+static void __wl_damage_buffer(glps_WaylandWindow *window,
+                               const glps_WaylandShmBuffer *buffer,
+                               const glps_Rect *rect) {
+  if (wl_surface_get_version(window->wl_surface) >=
+      WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION) {
+    wl_surface_damage_buffer(window->wl_surface, rect->x, rect->y,
+                             rect->width, rect->height);
+    return;
+  }
+
+  if (buffer->width != window->properties.buffer_width ||
+      buffer->height != window->properties.buffer_height) {
+    wl_surface_damage(window->wl_surface, 0, 0, INT32_MAX, INT32_MAX);
+    return;
+  }
+
+  double scale_x = (double)window->properties.width / buffer->width;
+  double scale_y = (double)window->properties.height / buffer->height;
+  int left = (int)floor(rect->x * scale_x);
+  int top = (int)floor(rect->y * scale_y);
+  int right = (int)ceil((rect->x + rect->width) * scale_x);
+  int bottom = (int)ceil((rect->y + rect->height) * scale_y);
+  wl_surface_damage(window->wl_surface, left, top, right - left, bottom - top);
+}
+
+glps_PixelBuffer glps_wl_window_map_pixels(glps_WindowManager *wm,
+                                           size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  glps_PixelBuffer pixels = {0};
+
+  if (window->shm_mapped == NULL) {
+    // The free buffer presented last needs the least redrawing.
+    glps_WaylandShmBuffer *buffer = NULL;
+    for (size_t i = 0; i < GLPS_SHM_BUFFERS; ++i) {
+      glps_WaylandShmBuffer *candidate = &window->shm_buffers[i];
+      if (!candidate->busy &&
+          (buffer == NULL || candidate->frame > buffer->frame)) {
+        buffer = candidate;
+      }
+    }
+    if (buffer == NULL) {
+      LOG_WARNING("Every buffer of window %zu is still read by the "
+                  "compositor.",
+                  window_id);
+      return pixels;
+    }
+
+    if (buffer->buffer == NULL ||
+        buffer->width != window->properties.buffer_width ||
+        buffer->height != window->properties.buffer_height) {
+      if (!__wl_shm_buffer_create(wm->wayland_ctx, buffer,
+                                  window->properties.buffer_width,
+                                  window->properties.buffer_height)) {
+        return pixels;
+      }
+    }
+    window->shm_mapped = buffer;
+  }
+
+  glps_WaylandShmBuffer *buffer = window->shm_mapped;
+  pixels.pixels = buffer->pixels;
+  pixels.width = buffer->width;
+  pixels.height = buffer->height;
+  pixels.stride = buffer->width;
+  pixels.age = buffer->frame != 0 ? (int)(window->shm_frame - buffer->frame + 1)
+                                  : 0;
+  return pixels;
+}
+
+bool glps_wl_window_present_pixels(glps_WindowManager *wm, size_t window_id,
+                                   const glps_Rect *damage,
+                                   size_t damage_count,
+                                   bool *presentation_feedback) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  glps_WaylandShmBuffer *buffer = window->shm_mapped;
+  if (buffer == NULL) {
+    LOG_ERROR("No pixels of window %zu are mapped.", window_id);
+    return false;
+  }
+
+  *presentation_feedback = glps_wl_request_presentation_feedback(wm, window_id);
+  if (window->frame_callback == NULL) {
+    window->frame_callback = wl_surface_frame(window->wl_surface);
+    wl_callback_add_listener(window->frame_callback, &frame_callback_listener,
+                             window->frame_args);
+  }
+
+  // A buffer mapped before a resize keeps the old scale for one more frame.
+  if (buffer->width == window->properties.buffer_width &&
+      buffer->height == window->properties.buffer_height) {
+    glps_wl_window_apply_scale(wm, window_id);
+  }
+
+  // The compositor keeps the previous contents, only the damage is read.
+  wl_surface_attach(window->wl_surface, buffer->buffer, 0, 0);
+  if (damage == NULL || damage_count == 0 || buffer->frame == 0) {
+    __wl_damage_buffer(window, buffer,
+                       &(glps_Rect){0, 0, buffer->width, buffer->height});
+  } else {
+    for (size_t i = 0; i < damage_count; ++i) {
+      __wl_damage_buffer(window, buffer, &damage[i]);
+    }
+  }
+  wl_surface_commit(window->wl_surface);
+
+  buffer->busy = true;
+  buffer->frame = ++window->shm_frame;
+  window->shm_mapped = NULL;
+  return true;
+}
+
 static void _cleanup_wl(glps_WindowManager *wm) {
   for (size_t i = 0; i < wm->window_count; ++i) {
     if (wm->windows[i]) {
+      _destroy_presentation_feedback(wm->windows[i]);
+      __wl_destroy_scaling(wm->windows[i]);
+      for (size_t j = 0; j < GLPS_SHM_BUFFERS; ++j) {
+        __wl_shm_buffer_destroy(&wm->windows[i]->shm_buffers[j]);
+      }
       if (wm->windows[i]->wl_surface) {
         wl_surface_destroy(wm->windows[i]->wl_surface);
         wm->windows[i]->wl_surface = NULL;
@@ -1133,7 +2677,28 @@ static void _cleanup_wl(glps_WindowManager *wm) {
     if (wm->wayland_ctx->decoration_manager != NULL) {
       zxdg_decoration_manager_v1_destroy(wm->wayland_ctx->decoration_manager);
     }
+    if (wm->wayland_ctx->presentation != NULL) {
+      wp_presentation_destroy(wm->wayland_ctx->presentation);
+      wm->wayland_ctx->presentation = NULL;
+    }
+    if (wm->wayland_ctx->fractional_scale_manager != NULL) {
+      wp_fractional_scale_manager_v1_destroy(
+          wm->wayland_ctx->fractional_scale_manager);
+      wm->wayland_ctx->fractional_scale_manager = NULL;
+    }
+    if (wm->wayland_ctx->viewporter != NULL) {
+      wp_viewporter_destroy(wm->wayland_ctx->viewporter);
+      wm->wayland_ctx->viewporter = NULL;
+    }
 
+    if (wm->wayland_ctx->wl_shm != NULL) {
+      wl_shm_destroy(wm->wayland_ctx->wl_shm);
+      wm->wayland_ctx->wl_shm = NULL;
+    }
+    for (size_t i = 0; i < wm->wayland_ctx->output_count; ++i) {
+      __wl_destroy_output(wm->wayland_ctx->outputs[i]);
+    }
+    wm->wayland_ctx->output_count = 0;
     if (wm->wayland_ctx->wl_compositor != NULL) {
       wl_compositor_destroy(wm->wayland_ctx->wl_compositor);
       wm->wayland_ctx->wl_compositor = NULL;
@@ -1142,6 +2707,24 @@ static void _cleanup_wl(glps_WindowManager *wm) {
       wl_registry_destroy(wm->wayland_ctx->wl_registry);
       wm->wayland_ctx->wl_registry = NULL;
     }
+    __wl_cancel_transfers(wm, false);
+    __wl_cancel_transfers(wm, true);
+    __wl_cancel_sends(wm);
+    __wl_offer_destroy(&wm->wayland_ctx->selection);
+    if (wm->wayland_ctx->data_control_src != NULL) {
+      zwlr_data_control_source_v1_destroy(wm->wayland_ctx->data_control_src);
+      wm->wayland_ctx->data_control_src = NULL;
+    }
+    if (wm->wayland_ctx->data_control_device != NULL) {
+      zwlr_data_control_device_v1_destroy(
+          wm->wayland_ctx->data_control_device);
+      wm->wayland_ctx->data_control_device = NULL;
+    }
+    if (wm->wayland_ctx->data_control_manager != NULL) {
+      zwlr_data_control_manager_v1_destroy(
+          wm->wayland_ctx->data_control_manager);
+      wm->wayland_ctx->data_control_manager = NULL;
+    }
     if (wm->wayland_ctx->data_dvc != NULL) {
       wl_data_device_destroy(wm->wayland_ctx->data_dvc);
       wm->wayland_ctx->data_dvc = NULL;
@@ -1192,7 +2775,12 @@ static void _cleanup_wl(glps_WindowManager *wm) {
 }
 
 ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
-                              int width, int height) {
+                              int width, int height, bool software) {
+  if (software && wm->wayland_ctx->wl_shm == NULL) {
+    LOG_ERROR("The compositor lacks wl_shm, no software windows.");
+    return -1;
+  }
+
   glps_WaylandWindow *window = malloc(sizeof(glps_WaylandWindow));
   if (window == NULL) {
     LOG_ERROR("Wayland window allocation failed.");
@@ -1208,9 +2796,45 @@ ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
 
   window->properties.width = width;
   window->properties.height = height;
+  window->properties.refresh_mhz = 0;
+  window->properties.scale = 0;
+  window->properties.render_scale = 1.0;
+  window->output_count = 0;
+  wl_surface_add_listener(window->wl_surface, &surface_listener, wm);
+
+  // Both before the first commit, which the compositor may scale already.
+  window->viewport = NULL;
+  window->fractional_scale = NULL;
+  window->preferred_scale = 0;
+  if (wm->wayland_ctx->viewporter != NULL) {
+    window->viewport = wp_viewporter_get_viewport(wm->wayland_ctx->viewporter,
+                                                  window->wl_surface);
+    if (wm->wayland_ctx->fractional_scale_manager != NULL) {
+      window->fractional_scale =
+          wp_fractional_scale_manager_v1_get_fractional_scale(
+              wm->wayland_ctx->fractional_scale_manager, window->wl_surface);
+      wp_fractional_scale_v1_add_listener(window->fractional_scale,
+                                          &fractional_scale_listener, wm);
+    }
+  }
 
-  window->fps_start_time = (struct timespec){0};
-  window->fps_is_init = false;
+  glps_frame_stats_init(&window->frame_stats);
+  glps_resolution_init(&window->resolution);
+  glps_latency_init(&window->latency);
+  memset(&window->gpu_timer, 0, sizeof(window->gpu_timer));
+  memset(window->presentation_feedback, 0,
+         sizeof(window->presentation_feedback));
+  window->render_thread = NULL;
+  window->software = software;
+  memset(window->shm_buffers, 0, sizeof(window->shm_buffers));
+  window->shm_mapped = NULL;
+  window->shm_frame = 0;
+  window->egl_window = NULL;
+  window->egl_surface = EGL_NO_SURFACE;
+  window->zxdg_toplevel_decoration = NULL;
+  pthread_mutex_init(&window->latency_lock, NULL);
+  atomic_init(&window->properties_cell.seq, 0);
+  atomic_init(&window->frame_stats_cell.seq, 0);
 
   window->xdg_surface = xdg_wm_base_get_xdg_surface(
       wm->wayland_ctx->xdg_wm_base, window->wl_surface);
@@ -1247,46 +2871,285 @@ ssize_t glps_wl_window_create(glps_WindowManager *wm, const char *title,
 
   wl_surface_commit(window->wl_surface);
 
-  wl_display_roundtrip(wm->wayland_ctx->wl_display);
-
-  window->egl_window = wl_egl_window_create(
-      window->wl_surface, window->properties.width, window->properties.height);
-  if (!window->egl_window) {
-    LOG_ERROR("Failed to create EGL window");
-    exit(EXIT_FAILURE);
-  }
+  {
+    PERF_SCOPE("window_create_roundtrip");
+    wl_display_roundtrip(wm->wayland_ctx->wl_display);
+  }
+
+  int buffer_scale;
+  __wl_buffer_size(window, &window->properties.buffer_width,
+                   &window->properties.buffer_height, &buffer_scale);
+  window->surface_scale = (glps_WaylandSurfaceScale){
+      .width = window->properties.width,
+      .height = window->properties.height,
+      .buffer_scale = buffer_scale,
+      .dirty = true,
+  };
+
+  // Software windows need neither an EGL surface nor the context.
+  if (!software) {
+    window->egl_window = wl_egl_window_create(
+        window->wl_surface, window->properties.buffer_width,
+        window->properties.buffer_height);
+    if (!window->egl_window) {
+      LOG_ERROR("Failed to create EGL window");
+      exit(EXIT_FAILURE);
+    }
 
-  window->egl_surface =
-      eglCreateWindowSurface(wm->egl_ctx->dpy, wm->egl_ctx->conf,
-                             (NativeWindowType)window->egl_window, NULL);
-  if (window->egl_surface == EGL_NO_SURFACE) {
-    LOG_ERROR("Failed to create EGL surface");
-    exit(EXIT_FAILURE);
+    window->egl_surface = glps_egl_create_surface(
+        wm, (EGLNativeWindowType)window->egl_window, window->egl_window);
+    if (window->egl_surface == EGL_NO_SURFACE) {
+      LOG_ERROR("Failed to create EGL surface");
+      exit(EXIT_FAILURE);
+    }
   }
 
+  static atomic_uint window_handles;
+  window->handle = atomic_fetch_add(&window_handles, 1) + 1;
   wm->windows[wm->window_count] = window;
 
-  if (wm->window_count == 0) {
+  if (!software && wm->egl_ctx->ctx == EGL_NO_CONTEXT) {
     glps_egl_create_ctx(wm);
-    glps_egl_make_ctx_current(wm, 0);
+    glps_egl_make_ctx_current(wm, wm->window_count);
   }
 
   // setup frame callback
   frame_callback_args *frame_args =
       (frame_callback_args *)malloc(sizeof(frame_callback_args));
-  window->frame_callback = wl_surface_frame(window->wl_surface);
   frame_args->wm = wm;
   frame_args->window_id = wm->window_count;
   window->frame_args = (void *)frame_args;
 
-  wl_callback_add_listener(window->frame_callback, &frame_callback_listener,
-                           frame_args);
+  window->frame_callback = NULL;
+  if (!software) {
+    window->frame_callback = wl_surface_frame(window->wl_surface);
+    wl_callback_add_listener(window->frame_callback, &frame_callback_listener,
+                             frame_args);
+  }
+
+  GLPS_SEQLOCK_PUBLISH(&window->properties_cell, &window->properties);
+  GLPS_SEQLOCK_PUBLISH(&window->frame_stats_cell, &window->frame_stats);
+
+  __wl_lock_windows(wm);
+  size_t window_id = wm->window_count++;
+  __wl_unlock_windows(wm);
+  return window_id;
+}
+
+int glps_wl_dispatch(glps_WindowManager *wm, int timeout_ms) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  struct wl_display *display = context->wl_display;
+  struct pollfd fds[3 + 2 * GLPS_MAX_CLIPBOARD_TRANSFERS];
+
+  while (wl_display_prepare_read(display) != 0) {
+    if (wl_display_dispatch_pending(display) < 0)
+      return -1;
+  }
+
+  if (wl_display_flush(display) < 0 && errno != EAGAIN) {
+    wl_display_cancel_read(display);
+    return -1;
+  }
+
+  // Clipboard pipes are polled together with the display socket, and so are
+  // the input thread, which may read the events this thread waits for, and
+  // tasks posted from other threads.
+  size_t transfer_count = context->transfer_count;
+  size_t send_count = context->send_count;
+  size_t pipe_count = transfer_count + send_count;
+  fds[0] = (struct pollfd){.fd = wl_display_get_fd(display), .events = POLLIN};
+  for (size_t i = 0; i < transfer_count; ++i) {
+    fds[i + 1] =
+        (struct pollfd){.fd = context->transfers[i].fd, .events = POLLIN};
+  }
+  for (size_t i = 0; i < send_count; ++i) {
+    fds[transfer_count + i + 1] =
+        (struct pollfd){.fd = context->sends[i].fd, .events = POLLOUT};
+  }
+  fds[pipe_count + 1] = (struct pollfd){
+      .fd = context->input_queue != NULL ? context->input_wake_fd : -1,
+      .events = POLLIN};
+  fds[pipe_count + 2] =
+      (struct pollfd){.fd = wm->task_wake_fd, .events = POLLIN};
+
+  int ret;
+  while ((ret = poll(fds, pipe_count + 3, timeout_ms)) < 0 &&
+         errno == EINTR) {
+  }
+  if (ret < 0) {
+    wl_display_cancel_read(display);
+    return -1;
+  }
+
+  if (fds[0].revents & POLLIN) {
+    if (wl_display_read_events(display) < 0)
+      return -1;
+  } else {
+    wl_display_cancel_read(display);
+  }
+
+  // Backwards, so finished transfers only shift the ones already handled.
+  for (size_t i = transfer_count; i-- > 0;) {
+    if (fds[i + 1].revents != 0) {
+      __wl_progress_transfer(wm, i);
+    }
+  }
+  // Callbacks above may have replaced the selection and ended sends.
+  for (size_t i = send_count; i-- > 0;) {
+    if (fds[transfer_count + i + 1].revents != 0 &&
+        i < context->send_count &&
+        context->sends[i].fd == fds[transfer_count + i + 1].fd) {
+      __wl_progress_send(wm, i);
+    }
+  }
+
+  int dispatched = wl_display_dispatch_pending(display);
+  if (dispatched < 0)
+    return -1;
+  dispatched += (int)glps_wl_dispatch_input(wm);
+  if (fds[pipe_count + 2].revents & POLLIN) {
+    dispatched += (int)glps_sync_run_tasks(wm);
+  }
+  return dispatched;
+}
+
+size_t glps_wl_dispatch_input(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context->input_queue == NULL)
+    return 0;
+
+  eventfd_t count;
+  eventfd_read(context->input_wake_fd, &count);
+
+  size_t dispatched = 0;
+  glps_WindowEvent event;
+  while (glps_event_queue_pop(&context->input_events, &event)) {
+    __wl_deliver_event(wm, &event);
+    dispatched++;
+  }
+  return dispatched;
+}
+
+static void *__wl_input_thread_main(void *data) {
+  glps_WindowManager *wm = (glps_WindowManager *)data;
+  glps_WaylandContext *context = wm->wayland_ctx;
+  struct wl_display *display = context->wl_display;
+  struct wl_event_queue *queue = context->input_queue;
+
+  for (;;) {
+    while (wl_display_prepare_read_queue(display, queue) != 0) {
+      pthread_mutex_lock(&context->input_lock);
+      int ret = wl_display_dispatch_queue_pending(display, queue);
+      pthread_mutex_unlock(&context->input_lock);
+      if (ret < 0)
+        return NULL;
+    }
+    wl_display_flush(display);
+
+    struct pollfd fds[2] = {
+        {.fd = wl_display_get_fd(display), .events = POLLIN},
+        {.fd = context->input_stop_fd, .events = POLLIN},
+    };
+    int ret;
+    while ((ret = poll(fds, 2, -1)) < 0 && errno == EINTR) {
+    }
+    if (ret < 0 || fds[1].revents != 0) {
+      wl_display_cancel_read(display);
+      return NULL;
+    }
+
+    // Stamped as soon as they are read, whatever the render loop is doing.
+    if (wl_display_read_events(display) < 0)
+      return NULL;
+    pthread_mutex_lock(&context->input_lock);
+    ret = wl_display_dispatch_queue_pending(display, queue);
+    pthread_mutex_unlock(&context->input_lock);
+    if (ret < 0)
+      return NULL;
+  }
+}
+
+static void __wl_set_seat_queue(glps_WaylandContext *context,
+                                struct wl_event_queue *queue) {
+  wl_proxy_set_queue((struct wl_proxy *)context->wl_seat, queue);
+  if (context->wl_pointer != NULL)
+    wl_proxy_set_queue((struct wl_proxy *)context->wl_pointer, queue);
+  if (context->wl_keyboard != NULL)
+    wl_proxy_set_queue((struct wl_proxy *)context->wl_keyboard, queue);
+  if (context->wl_touch != NULL)
+    wl_proxy_set_queue((struct wl_proxy *)context->wl_touch, queue);
+}
+
+bool glps_wl_start_input_thread(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context->input_queue != NULL)
+    return true;
+  if (context->wl_seat == NULL) {
+    LOG_ERROR("No seat, can't start the input thread.");
+    return false;
+  }
+
+  context->input_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  context->input_stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (context->input_wake_fd < 0 || context->input_stop_fd < 0) {
+    LOG_ERROR("Failed to create input thread eventfds: %s", strerror(errno));
+    if (context->input_wake_fd >= 0)
+      close(context->input_wake_fd);
+    if (context->input_stop_fd >= 0)
+      close(context->input_stop_fd);
+    return false;
+  }
+
+  // Objects created from the seat later on inherit its queue.
+  context->input_queue = wl_display_create_queue(context->wl_display);
+  glps_event_queue_init(&context->input_events);
+  pthread_mutex_init(&context->input_lock, NULL);
+  __wl_set_seat_queue(context, context->input_queue);
+
+  if (pthread_create(&context->input_thread, NULL, __wl_input_thread_main,
+                     wm) != 0) {
+    LOG_ERROR("Failed to create the input thread.");
+    __wl_set_seat_queue(context, NULL);
+    wl_event_queue_destroy(context->input_queue);
+    context->input_queue = NULL;
+    pthread_mutex_destroy(&context->input_lock);
+    close(context->input_wake_fd);
+    close(context->input_stop_fd);
+    return false;
+  }
+
+  return true;
+}
+
+void glps_wl_stop_input_thread(glps_WindowManager *wm) {
+  glps_WaylandContext *context = wm->wayland_ctx;
+  if (context->input_queue == NULL)
+    return;
+
+  eventfd_write(context->input_stop_fd, 1);
+  pthread_join(context->input_thread, NULL);
 
-  return wm->window_count++;
+  // Nothing read so far is lost: queued callbacks run, then the events the
+  // thread did not dispatch yet run here directly.
+  glps_wl_dispatch_input(wm);
+  wl_display_dispatch_queue_pending(context->wl_display, context->input_queue);
+  __wl_set_seat_queue(context, NULL);
+
+  wl_event_queue_destroy(context->input_queue);
+  context->input_queue = NULL;
+  pthread_mutex_destroy(&context->input_lock);
+  close(context->input_wake_fd);
+  close(context->input_stop_fd);
 }
 
 bool glps_wl_should_close(glps_WindowManager *wm) {
-  if (wl_display_dispatch(wm->wayland_ctx->wl_display) == -1)
+  int result;
+  {
+    PERF_SCOPE("wl_display_dispatch");
+    result = glps_wl_dispatch(wm, -1);
+  }
+
+  if (result == -1)
     return true;
   else if (wm->window_count == 0)
     return true;
@@ -1299,17 +3162,52 @@ void glps_wl_destroy(glps_WindowManager *wm) {
     return;
   }
 
+  glps_wl_stop_input_thread(wm);
+  for (size_t i = 0; i < wm->window_count; ++i) {
+    glps_wl_window_stop_render_thread(wm, i);
+  }
   glps_egl_destroy(wm);
   _cleanup_wl(wm);
+  glps_clipboard_sources_release(wm->clipboard.sources,
+                                 wm->clipboard.source_count);
+  glps_clipboard_buffer_free(&wm->clipboard.received);
+  glps_sync_destroy(wm);
   if (wm != NULL) {
     free(wm);
     wm = NULL;
   }
 }
 
+bool glps_wl_window_start_render_thread(glps_WindowManager *wm,
+                                        size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  if (window->render_thread != NULL) {
+    return true;
+  }
+
+  window->render_thread = glps_render_thread_start(wm, window_id);
+  return window->render_thread != NULL;
+}
+
+void glps_wl_window_stop_render_thread(glps_WindowManager *wm,
+                                       size_t window_id) {
+  glps_WaylandWindow *window = wm->windows[window_id];
+  if (window == NULL || window->render_thread == NULL) {
+    return;
+  }
+
+  glps_render_thread_stop(window->render_thread);
+  window->render_thread = NULL;
+}
+
 void glps_wl_window_destroy(glps_WindowManager *wm, size_t window_id) {
 
   glps_WaylandWindow *window = wm->windows[window_id];
+  if (window->render_thread != NULL) {
+    glps_render_thread_stop(window->render_thread);
+    window->render_thread = NULL;
+  }
+
   if (window->frame_args != NULL) {
     free(window->frame_args);
     window->frame_args = NULL;
@@ -1325,28 +3223,63 @@ void glps_wl_window_destroy(glps_WindowManager *wm, size_t window_id) {
     window->frame_callback = NULL;
   }
 
-  eglDestroySurface(wm->egl_ctx->dpy, window->egl_surface);
-  wl_egl_window_destroy(window->egl_window);
+  _destroy_presentation_feedback(window);
+  __wl_destroy_scaling(window);
+
+  if (window->software) {
+    for (size_t i = 0; i < GLPS_SHM_BUFFERS; ++i) {
+      __wl_shm_buffer_destroy(&window->shm_buffers[i]);
+    }
+  } else {
+    eglDestroySurface(wm->egl_ctx->dpy, window->egl_surface);
+    wl_egl_window_destroy(window->egl_window);
+  }
 
+  __wl_lock_windows(wm);
   xdg_toplevel_destroy(window->xdg_toplevel);
   xdg_surface_destroy(window->xdg_surface);
   wl_surface_destroy(window->wl_surface);
 
-  free(window);
-
   wm->windows[window_id] = NULL;
 
   for (size_t i = window_id; i < wm->window_count - 1; ++i) {
     wm->windows[i] = wm->windows[i + 1];
+    // Frame callbacks and render threads name the window by its new ID.
+    ((frame_callback_args *)wm->windows[i]->frame_args)->window_id = i;
+    if (wm->windows[i]->render_thread != NULL)
+      glps_render_thread_set_window_id(wm->windows[i]->render_thread, i);
   }
   if (wm->window_count > 0)
     wm->window_count--;
+  __wl_unlock_windows(wm);
+
+  // Freed once no reader on another thread can still hold it.
+  glps_sync_synchronize(wm);
+  pthread_mutex_destroy(&window->latency_lock);
+  free(window);
 
   if (wm->window_count == 0) {
     LOG_INFO("All windows destroyed. Exiting program.");
   }
 }
 
+glps_WaylandWindow *glps_wl_window(glps_WindowManager *wm, size_t window_id) {
+  // Only the owner compacts the windows, render threads don't read their own.
+  glps_WaylandWindow *window = glps_render_thread_window(window_id);
+  return window != NULL ? window : wm->windows[window_id];
+}
+
+bool glps_wl_window_find(glps_WindowManager *wm, uint32_t handle,
+                         size_t *window_id) {
+  for (size_t i = 0; i < wm->window_count; ++i) {
+    if (wm->windows[i] != NULL && wm->windows[i]->handle == handle) {
+      *window_id = i;
+      return true;
+    }
+  }
+  return false;
+}
+
 bool glps_wl_init(glps_WindowManager *wm) {
 
   wm->windows = malloc(sizeof(glps_WaylandWindow *) * MAX_WINDOWS);
@@ -1366,6 +3299,15 @@ bool glps_wl_init(glps_WindowManager *wm) {
   }
 
   wm->window_count = 0;
+  if (!glps_sync_init(wm)) {
+    free(wm->wayland_ctx);
+    free(wm->windows);
+    free(wm);
+    return false;
+  }
+  for (size_t i = 0; i < GLPS_MAX_CLIPBOARD_TYPES; ++i) {
+    glps_clipboard_source_init(&wm->clipboard.sources[i]);
+  }
   wm->wayland_ctx->wl_touch = NULL;
   wm->wayland_ctx->wl_pointer = NULL;
   wm->wayland_ctx->wl_keyboard = NULL;
@@ -1373,6 +3315,8 @@ bool glps_wl_init(glps_WindowManager *wm) {
   wm->wayland_ctx->xkb_keymap = NULL;
   wm->wayland_ctx->xkb_context = NULL;
   wm->wayland_ctx->decoration_manager = NULL;
+  wm->wayland_ctx->presentation = NULL;
+  wm->wayland_ctx->presentation_clock = CLOCK_MONOTONIC;
   wm->wayland_ctx->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
 
   wm->wayland_ctx->wl_display = wl_display_connect(NULL);
@@ -1411,6 +3355,14 @@ bool glps_wl_init(glps_WindowManager *wm) {
     LOG_WARNING("xdg-decoration protocol not supported by compositor");
   }
 
+  if (!wm->wayland_ctx->presentation) {
+    LOG_WARNING("presentation-time protocol not supported by compositor, "
+                "input latency is measured up to buffer submission");
+  } else {
+    // Receive the clock_id event before any timestamp is taken.
+    wl_display_roundtrip(wm->wayland_ctx->wl_display);
+  }
+
   if (!wm->wayland_ctx->wl_compositor || !wm->wayland_ctx->xdg_wm_base) {
     LOG_ERROR("Failed to retrieve Wayland compositor or xdg_wm_base");
     wl_registry_destroy(wm->wayland_ctx->wl_registry);
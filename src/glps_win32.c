@@ -1,4 +1,7 @@
 #include <glps_common.h>
+#include <glps_frame_stats.h>
+#include <glps_input_latency.h>
+#include <glps_resolution.h>
 #define MAX_KEY_LENGTH 255
 #define MAX_VALUE_NAME 16383
 #define MAX_FILES 128
@@ -103,43 +106,47 @@ void __get_special_key_name(UINT wParam, char *char_value, size_t size) {
   }
 }
 
-void glps_win32_attach_to_clipboard(glps_WindowManager *wm, char *mime,
-                                    char *data) {
+bool glps_win32_attach_to_clipboard(glps_WindowManager *wm, const char *mime,
+                                    const void *data, size_t size) {
 
   if (!OpenClipboard(NULL)) {
     LOG_ERROR("Failed to open clipboard.");
-    return;
+    return false;
   }
 
   if (!EmptyClipboard()) {
     LOG_ERROR("Failed to empty clipboard.");
     CloseClipboard();
-    return;
+    return false;
   }
 
-  HGLOBAL hGlobal = GlobalAlloc(GMEM_MOVEABLE, strlen(data) + 1);
+  HGLOBAL hGlobal = GlobalAlloc(GMEM_MOVEABLE, size + 1);
   if (!hGlobal) {
     LOG_ERROR("Failed to allocate global memory.");
     CloseClipboard();
-    return;
+    return false;
   }
 
   char *pGlobal = (char *)GlobalLock(hGlobal);
   if (pGlobal) {
-    strcpy(pGlobal, data);
+    memcpy(pGlobal, data, size);
+    pGlobal[size] = '\0';
     GlobalUnlock(hGlobal);
   } else {
     LOG_ERROR("Failed to lock global memory.\n");
     GlobalFree(hGlobal);
     CloseClipboard();
-    return;
+    return false;
   }
 
   if (!SetClipboardData(CF_TEXT, hGlobal)) {
     LOG_ERROR("Failed to set clipboard data.");
     GlobalFree(hGlobal);
+    CloseClipboard();
+    return false;
   }
   CloseClipboard();
+  return true;
 }
 
 void glps_win32_get_from_clipboard(glps_WindowManager *wm, char *data,
@@ -163,7 +170,7 @@ void glps_win32_get_from_clipboard(glps_WindowManager *wm, char *data,
     return;
   }
 
-  strncpy(data, strdup(pText), data_size - 1);
+  strncpy(data, pText, data_size - 1);
   data[data_size - 1] = '\0';
 
   GlobalUnlock(hData);
@@ -337,6 +344,9 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     if (GetWindowRect(hwnd, &rect)) {
       int width = rect.right - rect.left;
       int height = rect.bottom - rect.top;
+      double render_scale = wm->windows[window_id]->properties.render_scale;
+      glps_resolution_scaled_size(render_scale, width, height, &width,
+                                  &height);
       if (wm->callbacks.window_resize_callback) {
         wm->callbacks.window_resize_callback(window_id, width, height,
                                              wm->callbacks.window_resize_data);
@@ -436,6 +446,9 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
     WCHAR mime[MAX_MIME_LENGTH] = {0};
     CHAR files[MAX_PATH_LENGTH * MAX_FILES] = {0};
     CHAR mime_types[MAX_MIME_LENGTH * MAX_FILES] = {0};
+    CHAR paths[MAX_FILES][MAX_PATH_LENGTH];
+    glps_DroppedFile dropped[MAX_FILES];
+    size_t dropped_count = 0;
 
     UINT count = DragQueryFileW(hDropInfo, 0xFFFFFFFF, NULL, 0);
     if (count == 0) {
@@ -456,6 +469,13 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
 
       strcat(files, utf8_filename);
 
+      if (dropped_count < MAX_FILES) {
+        strcpy(paths[dropped_count], utf8_filename);
+        dropped[dropped_count] = (glps_DroppedFile){
+            .uri = paths[dropped_count], .path = paths[dropped_count]};
+        dropped_count++;
+      }
+
       WCHAR *extension = wcsrchr(filename, L'.');
       if (extension == NULL) {
         LOG_ERROR("File %s has no extension.\n", utf8_filename);
@@ -487,6 +507,12 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam,
                                          wm->callbacks.drag_n_drop_data);
     }
 
+    // Paths only, dropped files are not mapped on Win32.
+    if (wm->callbacks.drop_files_callback) {
+      wm->callbacks.drop_files_callback(window_id, dropped, dropped_count,
+                                        wm->callbacks.drop_files_data);
+    }
+
     DragFinish(hDropInfo);
     break;
   }
@@ -640,11 +666,18 @@ ssize_t glps_win32_window_create(glps_WindowManager *wm, const char *title,
 
   wglMakeCurrent(win32_window->hdc, wm->win32_ctx->hglrc);
 
+  memset(&win32_window->properties, 0, sizeof(win32_window->properties));
   snprintf(win32_window->properties.title,
            sizeof(win32_window->properties.title), "%s", title);
 
   win32_window->properties.width = width;
   win32_window->properties.height = height;
+  win32_window->properties.render_scale = 1.0;
+  glps_frame_stats_init(&win32_window->frame_stats);
+  glps_resolution_init(&win32_window->resolution);
+  memset(&win32_window->scaled_fb, 0, sizeof(win32_window->scaled_fb));
+  glps_latency_init(&win32_window->latency);
+  memset(&win32_window->gpu_timer, 0, sizeof(win32_window->gpu_timer));
   wm->windows[wm->window_count] = win32_window;
 
   SetWindowLongPtr(win32_window->hwnd, GWLP_USERDATA, (LONG_PTR)wm);
@@ -1,4 +1,9 @@
 #include "glps_window_manager.h"
+#include "glps_clipboard.h"
+#include "glps_frame_stats.h"
+#include "glps_gpu_timer.h"
+#include "glps_input_latency.h"
+#include "glps_resolution.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -12,6 +17,8 @@
 
 // *=========== WAYLAND ===========* //
 #ifdef GLPS_USE_WAYLAND
+#include "glps_render_thread.h"
+#include "glps_sync.h"
 #include "glps_wayland.h"
 #include <EGL/eglplatform.h>
 #include <glps_egl_context.h>
@@ -23,7 +30,10 @@
 #endif
 
 // *=========== X11 ===========* //
+#ifdef GLPS_USE_X11
 #include "glps_x11.h"
+#include <glps_egl_context.h>
+#endif
 
 void glps_wm_set_mouse_enter_callback(
     glps_WindowManager *wm,
@@ -174,35 +184,148 @@ void glps_wm_set_touch_callback(
   wm->callbacks.touch_data = data;
 }
 
+void glps_wm_set_raw_motion_callback(
+    glps_WindowManager *wm,
+    void (*raw_motion_callback)(size_t window_id, double dx, double dy,
+                                void *data),
+    void *data)
+{
+
+  if (wm == NULL || raw_motion_callback == NULL)
+  {
+    LOG_ERROR("Window Manager and/or Raw Motion Callback NULL");
+    return;
+  }
+
+  wm->callbacks.raw_motion_callback = raw_motion_callback;
+  wm->callbacks.raw_motion_data = data;
+}
+
+void glps_wm_set_clipboard_callback(
+    glps_WindowManager *wm,
+    void (*clipboard_callback)(const char *mime, const char *buff, size_t size,
+                               void *data),
+    void *data)
+{
+
+  if (wm == NULL || clipboard_callback == NULL)
+  {
+    LOG_ERROR("Window Manager and/or Clipboard Callback NULL");
+    return;
+  }
+
+  wm->callbacks.clipboard_callback = clipboard_callback;
+  wm->callbacks.clipboard_data = data;
+}
+
 void glps_wm_attach_to_clipboard(glps_WindowManager *wm, char *mime,
                                  char *data)
 {
+  if (data == NULL)
+  {
+    LOG_ERROR("Couldn't attach data to clipboard, data is NULL.");
+    return;
+  }
 
 #ifdef GLPS_USE_WAYLAND
-  glps_WaylandContext *context = NULL;
-  if (wm == NULL || (context = __get_wl_context(wm)) == NULL)
+  if (wm == NULL)
   {
     LOG_ERROR("Couldn't attach data to clipboard, context is NULL.");
     return;
   }
 
-  memset(&wm->clipboard, 0, sizeof(wm->clipboard));
-  strcat(wm->clipboard.buff, data);
-  strcat(wm->clipboard.mime_type, mime);
-  context->data_src =
-      wl_data_device_manager_create_data_source(context->data_dvc_manager);
-  wl_data_source_add_listener(context->data_src, &data_source_listener, wm);
-  wl_data_source_offer(context->data_src, "text/plain");
-  wl_data_source_offer(context->data_src, "text/html");
-  wl_data_device_set_selection(context->data_dvc, context->data_src,
-                               context->keyboard_serial);
+  glps_ClipboardSource source;
+  glps_clipboard_source_init(&source);
+  if (glps_clipboard_source_copy(&source, mime, data, strlen(data)))
+  {
+    glps_wl_set_selection(wm, &source, 1);
+  }
 
 #endif
 
 #ifdef GLPS_USE_WIN32
 
-  glps_win32_attach_to_clipboard(wm, "unknown", data);
+  glps_win32_attach_to_clipboard(wm, "unknown", data, strlen(data));
+
+#endif
+}
+
+bool glps_wm_attach_buffer_to_clipboard(glps_WindowManager *wm,
+                                        const char *mime, const void *data,
+                                        size_t size)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Couldn't attach data to clipboard, context is NULL.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  glps_ClipboardSource source;
+  glps_clipboard_source_init(&source);
+  return glps_clipboard_source_set_buffer(&source, mime, data, size) &&
+         glps_wl_set_selection(wm, &source, 1);
+#elif defined(GLPS_USE_WIN32)
+  return glps_win32_attach_to_clipboard(wm, mime, data, size);
+#else
+  LOG_WARNING("Clipboard is not supported on this backend.");
+  return false;
+#endif
+}
+
+bool glps_wm_attach_fd_to_clipboard(glps_WindowManager *wm, const char *mime,
+                                    int fd, size_t size)
+{
+  if (wm == NULL || fd < 0)
+  {
+    LOG_ERROR("Couldn't attach descriptor to clipboard, invalid arguments.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  glps_ClipboardSource source;
+  glps_clipboard_source_init(&source);
+  return glps_clipboard_source_set_fd(&source, mime, fd, size) &&
+         glps_wl_set_selection(wm, &source, 1);
+#else
+  LOG_WARNING("Clipboard descriptors are not supported on this backend.");
+  return false;
+#endif
+}
+
+bool glps_wm_attach_providers_to_clipboard(
+    glps_WindowManager *wm, const glps_ClipboardProvider *providers,
+    size_t count)
+{
+  if (wm == NULL || providers == NULL || count == 0)
+  {
+    LOG_ERROR("Couldn't attach providers to clipboard, invalid arguments.");
+    return false;
+  }
+
+  if (count > GLPS_MAX_CLIPBOARD_TYPES)
+  {
+    LOG_ERROR("Clipboard supports at most %d types.", GLPS_MAX_CLIPBOARD_TYPES);
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  glps_ClipboardSource sources[GLPS_MAX_CLIPBOARD_TYPES];
+  for (size_t i = 0; i < count; ++i)
+  {
+    glps_clipboard_source_init(&sources[i]);
+    if (!glps_clipboard_source_set_provider(&sources[i], providers[i].mime,
+                                            providers[i].provider,
+                                            providers[i].data))
+    {
+      return false;
+    }
+  }
 
+  return glps_wl_set_selection(wm, sources, count);
+#else
+  LOG_WARNING("Clipboard providers are not supported on this backend.");
+  return false;
 #endif
 }
 
@@ -210,21 +333,189 @@ void glps_wm_get_from_clipboard(glps_WindowManager *wm, char *data,
                                 size_t data_size)
 {
 #ifdef GLPS_USE_WAYLAND
-  if (wm == NULL || data == NULL)
+  if (wm == NULL || data == NULL || data_size == 0)
   {
     LOG_ERROR("Window Manager and/or data NULL.");
     return;
   }
 
-  memset(data, 0, data_size);
-  strncpy(data, wm->clipboard.buff, data_size - 1);
-  data[data_size - 1] = '\0';
+  if (!glps_wl_fetch_selection(wm, NULL))
+  {
+    data[0] = '\0';
+    return;
+  }
+
+  size_t size = wm->clipboard.received.size < data_size - 1
+                    ? wm->clipboard.received.size
+                    : data_size - 1;
+  if (size > 0)
+  {
+    memcpy(data, wm->clipboard.received.data, size);
+  }
+  data[size] = '\0';
 #endif
 #ifdef GLPS_USE_WIN32
   glps_win32_get_from_clipboard(wm, data, data_size);
 #endif
 }
 
+bool glps_wm_request_from_clipboard(
+    glps_WindowManager *wm, const char *mime,
+    void (*clipboard_callback)(const char *mime, const char *buff, size_t size,
+                               void *data),
+    void *data)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return glps_wl_request_selection(wm, mime, clipboard_callback, data);
+#else
+  LOG_WARNING("Asynchronous clipboard requests are not supported on this "
+              "backend.");
+  return false;
+#endif
+}
+
+bool glps_wm_request_from_clipboard_to_fd(
+    glps_WindowManager *wm, const char *mime, int fd,
+    void (*clipboard_callback)(const char *mime, const char *buff, size_t size,
+                               void *data),
+    void *data)
+{
+  if (wm == NULL || fd < 0)
+  {
+    LOG_ERROR("Window Manager NULL and/or invalid descriptor.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return glps_wl_request_selection_to_fd(wm, mime, fd, clipboard_callback,
+                                         data);
+#else
+  LOG_WARNING("Streaming clipboard requests are not supported on this "
+              "backend.");
+  return false;
+#endif
+}
+
+void glps_wm_set_selection_callback(glps_WindowManager *wm,
+                                    void (*selection_callback)(void *data),
+                                    void *data)
+{
+  if (wm == NULL || selection_callback == NULL)
+  {
+    LOG_ERROR("Window Manager and/or Selection Callback NULL");
+    return;
+  }
+
+  wm->callbacks.selection_callback = selection_callback;
+  wm->callbacks.selection_data = data;
+}
+
+bool glps_wm_enable_data_control(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return glps_wl_enable_data_control(wm);
+#else
+  LOG_WARNING("Clipboard manager mode is only supported on Wayland.");
+  return false;
+#endif
+}
+
+size_t glps_wm_get_clipboard_mime_types(glps_WindowManager *wm,
+                                        const char **mime_types, size_t max)
+{
+  if (wm == NULL || (mime_types == NULL && max > 0))
+  {
+    LOG_ERROR("Window Manager and/or mime_types NULL.");
+    return 0;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return glps_wl_get_selection_types(wm, mime_types, max);
+#else
+  return 0;
+#endif
+}
+
+void glps_wm_set_drag_n_drop_mime_types(glps_WindowManager *wm,
+                                        const char *const *mime_types,
+                                        size_t count)
+{
+  if (wm == NULL || (mime_types == NULL && count > 0))
+  {
+    LOG_ERROR("Window Manager and/or mime_types NULL.");
+    return;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  glps_wl_set_drop_types(wm, mime_types, count);
+#endif
+}
+
+void glps_wm_set_drop_files_callback(
+    glps_WindowManager *wm, bool map_files,
+    void (*drop_files_callback)(size_t window_id,
+                                const glps_DroppedFile *files, size_t count,
+                                void *data),
+    void *data)
+{
+  if (wm == NULL || drop_files_callback == NULL)
+  {
+    LOG_ERROR("Window Manager and/or Drop Files Callback NULL");
+    return;
+  }
+
+  wm->callbacks.drop_files_callback = drop_files_callback;
+  wm->callbacks.drop_files_data = data;
+#ifdef GLPS_USE_WAYLAND
+  glps_wl_set_map_dropped_files(wm, map_files);
+#else
+  (void)map_files;
+#endif
+}
+
+const void *glps_wm_get_clipboard_data(glps_WindowManager *wm,
+                                       const char *mime, size_t *size)
+{
+  if (size != NULL)
+  {
+    *size = 0;
+  }
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return NULL;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_wl_fetch_selection(wm, mime))
+  {
+    return NULL;
+  }
+
+  if (size != NULL)
+  {
+    *size = wm->clipboard.received.size;
+  }
+  return wm->clipboard.received.data;
+#else
+  LOG_WARNING("Clipboard data is not available on this backend.");
+  return NULL;
+#endif
+}
+
 void glps_wm_start_drag_n_drop(
     glps_WindowManager *wm, size_t origin_window_id,
     void (*drag_n_drop_callback)(size_t origin_window_id, char *mime,
@@ -280,160 +571,698 @@ void glps_wm_start_drag_n_drop(
 #endif
 }
 
-void glps_wm_swap_interval(glps_WindowManager *wm, unsigned int swap_interval)
-{
-#ifdef GLPS_USE_WAYLAND
-  eglSwapInterval(wm->egl_ctx->dpy, 0);
-#endif
-}
-
-void glps_wm_swap_buffers(glps_WindowManager *wm, size_t window_id)
+glps_SharedContext *glps_wm_create_shared_context(glps_WindowManager *wm)
 {
-#ifdef GLPS_USE_WAYLAND
-  glps_egl_swap_buffers(wm, window_id);
-#endif
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return NULL;
+  }
 
-#ifdef GLPS_USE_WIN32
-  glps_wgl_swap_buffers(wm, window_id);
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  return glps_egl_create_shared_ctx(wm);
+#else
+  LOG_WARNING("Shared contexts are not supported on this backend.");
+  return NULL;
 #endif
 }
 
-void glps_wm_window_set_resize_callback(
-    glps_WindowManager *wm,
-    void (*window_resize_callback)(size_t window_id, int width, int height,
-                                   void *data),
-    void *data)
+bool glps_wm_make_shared_context_current(glps_WindowManager *wm,
+                                         glps_SharedContext *shared)
 {
-
   if (wm == NULL)
   {
     LOG_ERROR("Window Manager is NULL.");
-    return;
+    return false;
   }
 
-  wm->callbacks.window_resize_callback = window_resize_callback;
-  wm->callbacks.window_resize_data = data;
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  return glps_egl_make_shared_ctx_current(wm, shared);
+#else
+  return false;
+#endif
 }
 
-void glps_wm_window_set_frame_update_callback(
-    glps_WindowManager *wm,
-    void (*window_frame_update_callback)(size_t window_id, void *data),
-    void *data)
+void glps_wm_destroy_shared_context(glps_WindowManager *wm,
+                                    glps_SharedContext *shared)
 {
-
-  if (wm == NULL)
+  if (wm == NULL || shared == NULL)
   {
-    LOG_ERROR("Window Manager is NULL.");
+    LOG_ERROR("Window Manager and/or shared context NULL.");
     return;
   }
 
-  wm->callbacks.window_frame_update_callback = window_frame_update_callback;
-  wm->callbacks.window_frame_update_data = data;
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  glps_egl_destroy_shared_ctx(wm, shared);
+#endif
 }
 
-void glps_wm_window_set_close_callback(
-    glps_WindowManager *wm,
-    void (*window_close_callback)(size_t window_id, void *data), void *data)
+glps_Fence glps_wm_fence_create(glps_WindowManager *wm)
 {
-
   if (wm == NULL)
   {
     LOG_ERROR("Window Manager is NULL.");
-    return;
+    return NULL;
   }
 
-  wm->callbacks.window_close_callback = window_close_callback;
-  wm->callbacks.window_close_data = data;
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  return glps_egl_fence_create(wm);
+#else
+  LOG_WARNING("Fences are not supported on this backend.");
+  return NULL;
+#endif
 }
 
-glps_WindowManager *glps_wm_init(void)
+bool glps_wm_fence_wait(glps_WindowManager *wm, glps_Fence fence,
+                        uint64_t timeout_ns)
 {
-
-  glps_WindowManager *wm = malloc(sizeof(glps_WindowManager));
-  *wm = (glps_WindowManager){0};
-  if (!wm)
-  {
-    LOG_ERROR("Failed to allocate memory for glps_WindowManager");
-    return NULL;
-  }
-#ifdef GLPS_USE_WAYLAND
-  if (!glps_wl_init(wm))
+  if (wm == NULL || fence == NULL)
   {
-    LOG_ERROR("Wayland init failed. exiting...");
-    exit(EXIT_FAILURE);
+    LOG_ERROR("Window Manager and/or fence NULL.");
+    return false;
   }
-  glps_egl_init(wm);
 
-#elif defined(GLPS_USE_WIN32)
-  glps_win32_init(wm);
-#elif defined(GLPS_USE_X11)
-  glps_x11_init(wm);
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  return glps_egl_fence_wait(wm, fence, timeout_ns);
+#else
+  return false;
 #endif
-
-  return wm;
 }
 
-void glps_wm_set_window_ctx_curr(glps_WindowManager *wm, size_t window_id)
+bool glps_wm_fence_wait_gpu(glps_WindowManager *wm, glps_Fence fence)
 {
-#ifdef GLPS_USE_WAYLAND
-  glps_egl_make_ctx_current(wm, window_id);
-#endif
+  if (wm == NULL || fence == NULL)
+  {
+    LOG_ERROR("Window Manager and/or fence NULL.");
+    return false;
+  }
 
-#ifdef GLPS_USE_WIN32
-  glps_wgl_make_ctx_current(wm, window_id);
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  return glps_egl_fence_wait_gpu(wm, fence);
+#else
+  return false;
 #endif
 }
 
-void glps_wm_window_get_dimensions(glps_WindowManager *wm, size_t window_id,
-                                   int *width, int *height)
+void glps_wm_fence_destroy(glps_WindowManager *wm, glps_Fence fence)
 {
-
   if (wm == NULL)
   {
-    LOG_ERROR("Couldn't get window dimensions. Window Manager NULL. ");
+    LOG_ERROR("Window Manager is NULL.");
     return;
   }
-#ifdef GLPS_USE_WAYLAND
-  glps_WaylandWindow *window = (glps_WaylandWindow *)wm->windows[window_id];
-
-  *width = window->properties.width;
-  *height = window->properties.height;
-#endif
-
-#ifdef GLPS_USE_WIN32
-
-  glps_win32_get_window_dimensions(wm, window_id, width, height);
 
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  glps_egl_fence_destroy(wm, fence);
 #endif
 }
 
-void *glps_get_proc_addr(const char *name)
-{
+// A render thread resolves its own window without reading the windows the
+// owner compacts, its ID shifts when a window created before it is destroyed.
 #ifdef GLPS_USE_WAYLAND
-  return glps_egl_get_proc_addr(name);
-#endif
-#ifdef GLPS_USE_WIN32
-  return glps_wgl_get_proc_addr(name);
+#define __WINDOW(wm, window_id) glps_wl_window(wm, window_id)
+#else
+#define __WINDOW(wm, window_id) ((wm)->windows[window_id])
 #endif
 
-return NULL;
+static bool __has_window(glps_WindowManager *wm, size_t window_id)
+{
+  if (wm == NULL)
+  {
+    return false;
+  }
+#ifdef GLPS_USE_WAYLAND
+  if (glps_render_thread_window(window_id) != NULL)
+  {
+    return true;
+  }
+#endif
+  return window_id < wm->window_count && wm->windows[window_id] != NULL;
+}
+
+static bool __is_software(glps_WindowManager *wm, size_t window_id)
+{
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  return __has_window(wm, window_id) && __WINDOW(wm, window_id)->software;
+#else
+  return false;
+#endif
+}
+
+bool glps_wm_window_start_render_thread(glps_WindowManager *wm,
+                                        size_t window_id)
+{
+  if (wm == NULL || window_id >= wm->window_count)
+  {
+    LOG_ERROR("Invalid window, can't start its render thread.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  if (__is_software(wm, window_id))
+  {
+    LOG_ERROR("Software windows present on the thread that owns them.");
+    return false;
+  }
+  return glps_wl_window_start_render_thread(wm, window_id);
+#else
+  LOG_WARNING("Render threads are only implemented on Wayland.");
+  return false;
+#endif
+}
+
+void glps_wm_window_stop_render_thread(glps_WindowManager *wm,
+                                       size_t window_id)
+{
+  if (wm == NULL || window_id >= wm->window_count)
+  {
+    LOG_ERROR("Invalid window, can't stop its render thread.");
+    return;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  glps_wl_window_stop_render_thread(wm, window_id);
+#endif
+}
+
+bool glps_wm_post_task(glps_WindowManager *wm,
+                       void (*task)(glps_WindowManager *wm, void *data),
+                       void *data)
+{
+  if (wm == NULL || task == NULL)
+  {
+    LOG_ERROR("Window Manager and/or task is NULL.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return glps_sync_post(wm, task, data);
+#else
+  task(wm, data);
+  return true;
+#endif
+}
+
+bool glps_wm_start_input_thread(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return false;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return glps_wl_start_input_thread(wm);
+#else
+  LOG_WARNING("The input thread is only implemented on Wayland.");
+  return false;
+#endif
+}
+
+void glps_wm_stop_input_thread(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  glps_wl_stop_input_thread(wm);
+#endif
+}
+
+size_t glps_wm_dispatch_input(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return 0;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return glps_wl_dispatch_input(wm);
+#else
+  return 0;
+#endif
+}
+
+void glps_wm_swap_interval(glps_WindowManager *wm, unsigned int swap_interval)
+{
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  if (!eglSwapInterval(wm->egl_ctx->dpy, (EGLint)swap_interval))
+  {
+    LOG_WARNING("Failed to set swap interval %u: 0x%x", swap_interval,
+                eglGetError());
+  }
+#endif
+}
+
+// Latency is marked by the dispatching thread and read by the rendering one.
+static void __lock_latency(glps_WindowManager *wm, size_t window_id)
+{
+#ifdef GLPS_USE_WAYLAND
+  pthread_mutex_lock(&__WINDOW(wm, window_id)->latency_lock);
+#endif
+}
+
+static void __unlock_latency(glps_WindowManager *wm, size_t window_id)
+{
+#ifdef GLPS_USE_WAYLAND
+  pthread_mutex_unlock(&__WINDOW(wm, window_id)->latency_lock);
+#endif
+}
+
+static void __publish_frame_stats(glps_WindowManager *wm, size_t window_id)
+{
+#ifdef GLPS_USE_WAYLAND
+  glps_WaylandWindow *window = __WINDOW(wm, window_id);
+  GLPS_SEQLOCK_PUBLISH(&window->frame_stats_cell, &window->frame_stats);
+#endif
+}
+
+// Bookkeeping shared by GL swaps and software presents.
+static void __frame_presented(glps_WindowManager *wm, size_t window_id,
+                              bool presentation_feedback)
+{
+  uint64_t now_ns = perf_now_ns();
+  glps_frame_stats_tick(&__WINDOW(wm, window_id)->frame_stats, now_ns);
+  __publish_frame_stats(wm, window_id);
+  double render_scale =
+      glps_resolution_frame(&__WINDOW(wm, window_id)->resolution,
+                            &__WINDOW(wm, window_id)->frame_stats);
+  if (render_scale > 0.0)
+  {
+    glps_wm_window_set_render_scale(wm, window_id, render_scale);
+  }
+  if (!presentation_feedback)
+  {
+    __lock_latency(wm, window_id);
+    glps_latency_frame_submitted(&__WINDOW(wm, window_id)->latency, now_ns);
+    __unlock_latency(wm, window_id);
+  }
+}
+
+void glps_wm_swap_buffers(glps_WindowManager *wm, size_t window_id)
+{
+  bool presentation_feedback = false;
+
+  if (__is_software(wm, window_id))
+  {
+    LOG_ERROR("Window %zu is a software window, present its pixels instead.",
+              window_id);
+    return;
+  }
+
+  glps_gpu_timer_frame_end(wm, &__WINDOW(wm, window_id)->gpu_timer,
+                           &__WINDOW(wm, window_id)->frame_stats);
+
+#ifdef GLPS_USE_WAYLAND
+  glps_wl_window_apply_scale(wm, window_id);
+  presentation_feedback = glps_wl_request_presentation_feedback(wm, window_id);
+  glps_egl_swap_buffers(wm, window_id);
+#endif
+
+#if defined(GLPS_USE_WIN32) || defined(GLPS_USE_X11)
+  int width = 0, height = 0;
+  glps_wm_window_get_dimensions(wm, window_id, &width, &height);
+  glps_scaled_framebuffer_end(&__WINDOW(wm, window_id)->scaled_fb, width,
+                              height);
+#endif
+
+#ifdef GLPS_USE_WIN32
+  glps_wgl_swap_buffers(wm, window_id);
+#endif
+
+#ifdef GLPS_USE_X11
+  glps_x11_swap_buffers(wm, window_id);
+#endif
+
+  glps_gpu_timer_frame_begin(wm, &__WINDOW(wm, window_id)->gpu_timer);
+
+  __frame_presented(wm, window_id, presentation_feedback);
+
+#if defined(GLPS_USE_WIN32) || defined(GLPS_USE_X11)
+  // Without a compositor to scale buffers, the next frame draws offscreen.
+  double render_scale = __WINDOW(wm, window_id)->properties.render_scale;
+  if (render_scale > 0.0 && render_scale < 1.0)
+  {
+    glps_resolution_scaled_size(render_scale, width, height, &width, &height);
+    glps_scaled_framebuffer_begin(&__WINDOW(wm, window_id)->scaled_fb, width,
+                                  height);
+  }
+  else if (__WINDOW(wm, window_id)->scaled_fb.framebuffer != 0)
+  {
+    glps_scaled_framebuffer_destroy(&__WINDOW(wm, window_id)->scaled_fb);
+  }
+#endif
+}
+
+glps_PixelBuffer glps_wm_window_map_pixels(glps_WindowManager *wm,
+                                           size_t window_id)
+{
+  glps_PixelBuffer pixels = {0};
+
+  if (wm == NULL || window_id >= wm->window_count ||
+      !__is_software(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or not a software window.");
+    return pixels;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  pixels = glps_wl_window_map_pixels(wm, window_id);
+#endif
+
+#ifdef GLPS_USE_X11
+  pixels = glps_x11_window_map_pixels(wm, window_id);
+#endif
+
+  return pixels;
+}
+
+bool glps_wm_window_present_pixels(glps_WindowManager *wm, size_t window_id,
+                                   const glps_Rect *damage,
+                                   size_t damage_count)
+{
+  bool presentation_feedback = false;
+  bool presented = false;
+
+  if (wm == NULL || window_id >= wm->window_count ||
+      !__is_software(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or not a software window.");
+    return false;
+  }
+
+  PERF_SCOPE("glps_wm_window_present_pixels");
+#ifdef GLPS_USE_WAYLAND
+  presented = glps_wl_window_present_pixels(wm, window_id, damage,
+                                            damage_count,
+                                            &presentation_feedback);
+#endif
+
+#ifdef GLPS_USE_X11
+  presented =
+      glps_x11_window_present_pixels(wm, window_id, damage, damage_count);
+#endif
+
+  if (presented)
+  {
+    __frame_presented(wm, window_id, presentation_feedback);
+  }
+  return presented;
+}
+
+void glps_wm_window_set_resize_callback(
+    glps_WindowManager *wm,
+    void (*window_resize_callback)(size_t window_id, int width, int height,
+                                   void *data),
+    void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_resize_callback = window_resize_callback;
+  wm->callbacks.window_resize_data = data;
+}
+
+void glps_wm_window_set_frame_update_callback(
+    glps_WindowManager *wm,
+    void (*window_frame_update_callback)(size_t window_id, void *data),
+    void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_frame_update_callback = window_frame_update_callback;
+  wm->callbacks.window_frame_update_data = data;
+}
+
+void glps_wm_window_set_close_callback(
+    glps_WindowManager *wm,
+    void (*window_close_callback)(size_t window_id, void *data), void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_close_callback = window_close_callback;
+  wm->callbacks.window_close_data = data;
+}
+
+void glps_wm_window_set_output_callback(
+    glps_WindowManager *wm,
+    void (*window_output_callback)(size_t window_id, double refresh_hz,
+                                   int scale, void *data),
+    void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.window_output_callback = window_output_callback;
+  wm->callbacks.window_output_data = data;
+}
+
+void glps_wm_set_output_callback(
+    glps_WindowManager *wm,
+    void (*output_callback)(const glps_Output *output, GLPS_OUTPUT_EVENT event,
+                            void *data),
+    void *data)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return;
+  }
+
+  wm->callbacks.output_callback = output_callback;
+  wm->callbacks.output_data = data;
+}
+
+size_t glps_wm_get_outputs(glps_WindowManager *wm, glps_Output *outputs,
+                           size_t max_outputs)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return 0;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return glps_wl_get_outputs(wm, outputs, max_outputs);
+#else
+  return 0;
+#endif
+}
+
+glps_WindowManager *glps_wm_init(void)
+{
+
+  glps_WindowManager *wm = malloc(sizeof(glps_WindowManager));
+  *wm = (glps_WindowManager){0};
+  if (!wm)
+  {
+    LOG_ERROR("Failed to allocate memory for glps_WindowManager");
+    return NULL;
+  }
+  wm->surface_desc = GLPS_SURFACE_DESC_DEFAULT;
+  wm->context_desc = GLPS_CONTEXT_DESC_DEFAULT;
+#ifdef GLPS_USE_WAYLAND
+  if (!glps_wl_init(wm))
+  {
+    LOG_ERROR("Wayland init failed. exiting...");
+    exit(EXIT_FAILURE);
+  }
+  glps_egl_init(wm);
+
+#elif defined(GLPS_USE_WIN32)
+  glps_win32_init(wm);
+#elif defined(GLPS_USE_X11)
+  glps_x11_init(wm);
+  glps_egl_init(wm);
+#endif
+
+  return wm;
+}
+
+void glps_wm_set_surface_desc(glps_WindowManager *wm,
+                              const glps_SurfaceDesc *desc)
+{
+  if (wm == NULL || desc == NULL)
+  {
+    LOG_ERROR("Window Manager and/or surface descriptor NULL.");
+    return;
+  }
+
+  wm->surface_desc = *desc;
+}
+
+bool glps_wm_set_context_desc(glps_WindowManager *wm,
+                              const glps_ContextDesc *desc)
+{
+  if (wm == NULL || desc == NULL)
+  {
+    LOG_ERROR("Window Manager and/or context descriptor NULL.");
+    return false;
+  }
+
+  // The EGL context outlives the windows, destroying them all doesn't
+  // bring the descriptor back into play.
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  bool context_exists =
+      wm->egl_ctx != NULL && wm->egl_ctx->ctx != EGL_NO_CONTEXT;
+#else
+  bool context_exists = wm->window_count > 0;
+#endif
+  if (context_exists)
+  {
+    LOG_ERROR("The context already exists, set its descriptor before "
+              "creating windows.");
+    return false;
+  }
+
+  wm->context_desc = *desc;
+  return true;
+}
+
+void glps_wm_set_window_ctx_curr(glps_WindowManager *wm, size_t window_id)
+{
+  if (__is_software(wm, window_id))
+  {
+    LOG_ERROR("Window %zu is a software window without a GL context.",
+              window_id);
+    return;
+  }
+
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  glps_egl_make_ctx_current(wm, window_id);
+#endif
+
+#ifdef GLPS_USE_WIN32
+  glps_wgl_make_ctx_current(wm, window_id);
+#endif
+
+  glps_gpu_timer_make_current(&__WINDOW(wm, window_id)->gpu_timer);
+#if defined(GLPS_USE_WIN32) || defined(GLPS_USE_X11)
+  glps_scaled_framebuffer_make_current(&__WINDOW(wm, window_id)->scaled_fb);
+#endif
+}
+
+void glps_wm_window_get_dimensions(glps_WindowManager *wm, size_t window_id,
+                                   int *width, int *height)
+{
+
+  if (wm == NULL)
+  {
+    LOG_ERROR("Couldn't get window dimensions. Window Manager NULL. ");
+    return;
+  }
+#ifdef GLPS_USE_WAYLAND
+  unsigned epoch;
+  glps_WaylandWindow *window = glps_sync_read_begin(wm, window_id, &epoch);
+  if (window != NULL)
+  {
+    glps_WindowProperties properties;
+    GLPS_SEQLOCK_SNAPSHOT(&window->properties_cell, &properties);
+    *width = properties.width;
+    *height = properties.height;
+  }
+  glps_sync_read_end(wm, epoch);
+#endif
+
+#ifdef GLPS_USE_WIN32
+
+  glps_win32_get_window_dimensions(wm, window_id, width, height);
+
+#endif
+
+#ifdef GLPS_USE_X11
+  if (window_id < wm->window_count)
+  {
+    glps_x11_get_window_dimensions(wm, window_id, width, height);
+  }
+#endif
 }
 
-size_t glps_wm_window_create(glps_WindowManager *wm, const char *title,
-                             int width, int height)
+void glps_wm_window_get_framebuffer_size(glps_WindowManager *wm,
+                                         size_t window_id, int *width,
+                                         int *height)
+{
+#ifdef GLPS_USE_WAYLAND
+  if (wm == NULL)
+  {
+    LOG_ERROR("Couldn't get framebuffer size. Window Manager NULL. ");
+    return;
+  }
+  unsigned epoch;
+  glps_WaylandWindow *window = glps_sync_read_begin(wm, window_id, &epoch);
+  if (window != NULL)
+  {
+    glps_WindowProperties properties;
+    GLPS_SEQLOCK_SNAPSHOT(&window->properties_cell, &properties);
+    *width = properties.buffer_width;
+    *height = properties.buffer_height;
+  }
+  glps_sync_read_end(wm, epoch);
+#else
+  // Outside Wayland, the window is drawn at its size times the render scale.
+  int window_width = 0, window_height = 0;
+  glps_wm_window_get_dimensions(wm, window_id, &window_width, &window_height);
+  glps_resolution_scaled_size(glps_wm_window_get_render_scale(wm, window_id),
+                              window_width, window_height, width, height);
+#endif
+}
+
+void *glps_get_proc_addr(const char *name)
 {
+#if defined(GLPS_USE_WAYLAND) || defined(GLPS_USE_X11)
+  return glps_egl_get_proc_addr(name);
+#endif
+#ifdef GLPS_USE_WIN32
+  return glps_wgl_get_proc_addr(name);
+#endif
+
+return NULL;
+}
 
-  ssize_t window_id;
+static size_t __window_create(glps_WindowManager *wm, const char *title,
+                              int width, int height, bool software)
+{
+  ssize_t window_id = -1;
 #ifdef GLPS_USE_WAYLAND
-  window_id = glps_wl_window_create(wm, title, width, height);
+  window_id = glps_wl_window_create(wm, title, width, height, software);
 #endif
 
 #ifdef GLPS_USE_WIN32
-  window_id = glps_win32_window_create(wm, title, width, height);
+  if (software)
+  {
+    LOG_WARNING("Software windows are not implemented on Win32.");
+  }
+  else
+  {
+    window_id = glps_win32_window_create(wm, title, width, height);
+  }
 #endif
 
 #ifdef GLPS_USE_X11
-  window_id = glps_x11_window_create(wm, title, width, height);
+  window_id = glps_x11_window_create(wm, title, width, height, software);
 #endif
 
   if (window_id < 0)
@@ -443,75 +1272,436 @@ size_t glps_wm_window_create(glps_WindowManager *wm, const char *title,
   return window_id;
 }
 
+size_t glps_wm_window_create(glps_WindowManager *wm, const char *title,
+                             int width, int height)
+{
+
+  PERF_SCOPE("glps_wm_window_create");
+  return __window_create(wm, title, width, height, false);
+}
+
+size_t glps_wm_window_create_software(glps_WindowManager *wm,
+                                      const char *title, int width,
+                                      int height)
+{
+  PERF_SCOPE("glps_wm_window_create_software");
+  return __window_create(wm, title, width, height, true);
+}
+
+#ifdef GLPS_USE_WAYLAND
+// Posted tasks name their window by handle, its ID can shift before they run.
+static uint32_t __window_handle(glps_WindowManager *wm, size_t window_id)
+{
+  unsigned epoch;
+  glps_WaylandWindow *window = glps_sync_read_begin(wm, window_id, &epoch);
+  uint32_t handle = window != NULL ? window->handle : 0;
+  glps_sync_read_end(wm, epoch);
+  return handle;
+}
+
+static void __window_destroy_task(glps_WindowManager *wm, void *data)
+{
+  size_t window_id;
+  if (glps_wl_window_find(wm, (uint32_t)(uintptr_t)data, &window_id))
+  {
+    glps_wm_window_destroy(wm, window_id);
+  }
+}
+#endif
+
 void glps_wm_window_destroy(glps_WindowManager *wm, size_t window_id)
 {
+#ifdef GLPS_USE_WAYLAND
+  // Render threads can close their window, the owner does the work.
+  if (wm != NULL && !glps_sync_is_owner(wm))
+  {
+    uint32_t handle = __window_handle(wm, window_id);
+    if (handle == 0)
+    {
+      LOG_ERROR("Invalid window ID.");
+      return;
+    }
+    glps_sync_post(wm, __window_destroy_task, (void *)(uintptr_t)handle);
+    return;
+  }
+#endif
+
   if (wm == NULL || window_id >= wm->window_count ||
       wm->windows[window_id] == NULL)
   {
     LOG_ERROR("Invalid window ID or window manager is NULL.");
     return;
   }
+
+#ifdef GLPS_USE_WAYLAND
+  // A render thread releases the window's timer queries on its own context.
+  glps_wl_window_stop_render_thread(wm, window_id);
+#endif
+  glps_gpu_timer_destroy(wm, &wm->windows[window_id]->gpu_timer);
+#if defined(GLPS_USE_WIN32) || defined(GLPS_USE_X11)
+  glps_scaled_framebuffer_destroy(&wm->windows[window_id]->scaled_fb);
+#endif
+
 #ifdef GLPS_USE_WAYLAND
   glps_wl_window_destroy(wm, window_id);
 #endif
 
+#ifdef GLPS_USE_X11
+  glps_x11_window_destroy(wm, window_id);
+#endif
+
 #ifdef GLPS_USE_WIN32
 
 #endif
 }
 
-double glps_wm_get_fps(glps_WindowManager *wm, size_t window_id)
+static glps_FrameStatsTracker *__get_frame_stats(glps_WindowManager *wm,
+                                                 size_t window_id)
 {
-  if (!wm->windows[window_id]->fps_is_init)
+  if (!__has_window(wm, window_id))
   {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return NULL;
+  }
+
+  return &__WINDOW(wm, window_id)->frame_stats;
+}
+
+glps_FrameStats glps_wm_window_get_frame_stats(glps_WindowManager *wm,
+                                               size_t window_id)
+{
+  glps_FrameStats stats = {0};
+
 #ifdef GLPS_USE_WAYLAND
-    clock_gettime(CLOCK_MONOTONIC, &wm->windows[window_id]->fps_start_time);
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return stats;
+  }
+
+  unsigned epoch;
+  glps_WaylandWindow *window = glps_sync_read_begin(wm, window_id, &epoch);
+  if (window != NULL)
+  {
+    glps_FrameStatsTracker tracker;
+    GLPS_SEQLOCK_SNAPSHOT(&window->frame_stats_cell, &tracker);
+    glps_sync_read_end(wm, epoch);
+    glps_frame_stats_get(&tracker, &stats);
+    return stats;
+  }
+  glps_sync_read_end(wm, epoch);
+  LOG_ERROR("Invalid window ID.");
+#else
+  glps_FrameStatsTracker *tracker = __get_frame_stats(wm, window_id);
+  if (tracker != NULL)
+  {
+    glps_frame_stats_get(tracker, &stats);
+  }
 #endif
+  return stats;
+}
 
-#ifdef GLPS_USE_WIN32
-    QueryPerformanceCounter(&wm->windows[window_id]->fps_start_time);
-    QueryPerformanceFrequency(&wm->windows[window_id]->fps_freq);
+void glps_wm_window_set_frame_budget(glps_WindowManager *wm, size_t window_id,
+                                     double budget_ms)
+{
+  glps_FrameStatsTracker *tracker = __get_frame_stats(wm, window_id);
+  if (tracker != NULL)
+  {
+    glps_frame_stats_set_budget(tracker, budget_ms);
+    __publish_frame_stats(wm, window_id);
+  }
+}
+
+void glps_wm_window_set_frame_stats_window(glps_WindowManager *wm,
+                                           size_t window_id, size_t frames)
+{
+  glps_FrameStatsTracker *tracker = __get_frame_stats(wm, window_id);
+  if (tracker != NULL)
+  {
+    glps_frame_stats_set_window(tracker, frames);
+    __publish_frame_stats(wm, window_id);
+  }
+}
+
+void glps_wm_window_set_gpu_timing(glps_WindowManager *wm, size_t window_id,
+                                   bool enabled)
+{
+  if (!__has_window(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+
+  glps_gpu_timer_set_enabled(&__WINDOW(wm, window_id)->gpu_timer, enabled);
+}
+
+static glps_LatencyTracker *__get_latency_tracker(glps_WindowManager *wm,
+                                                  size_t window_id)
+{
+  if (!__has_window(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return NULL;
+  }
+
+  return &__WINDOW(wm, window_id)->latency;
+}
+
+glps_LatencyStats glps_wm_window_get_latency_stats(glps_WindowManager *wm,
+                                                   size_t window_id)
+{
+  glps_LatencyStats stats = {0};
+  glps_LatencyTracker *tracker = __get_latency_tracker(wm, window_id);
+  if (tracker != NULL)
+  {
+    __lock_latency(wm, window_id);
+    glps_latency_get(tracker, &stats);
+    __unlock_latency(wm, window_id);
+  }
+  return stats;
+}
+
+void glps_wm_window_reset_latency_stats(glps_WindowManager *wm,
+                                        size_t window_id)
+{
+  glps_LatencyTracker *tracker = __get_latency_tracker(wm, window_id);
+  if (tracker != NULL)
+  {
+    __lock_latency(wm, window_id);
+    glps_latency_reset(tracker);
+    __unlock_latency(wm, window_id);
+  }
+}
+
+void glps_wm_window_mark_input(glps_WindowManager *wm, size_t window_id)
+{
+  glps_LatencyTracker *tracker = __get_latency_tracker(wm, window_id);
+  if (tracker == NULL)
+  {
+    return;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  uint64_t now_ns = glps_wl_clock_now_ns(wm);
+#else
+  uint64_t now_ns = perf_now_ns();
+#endif
+  __lock_latency(wm, window_id);
+  glps_latency_input(tracker, now_ns, now_ns);
+  __unlock_latency(wm, window_id);
+}
+
+glps_InputTimestamp glps_wm_get_input_timestamp(glps_WindowManager *wm)
+{
+  glps_InputTimestamp timestamp = {0};
+#ifdef GLPS_USE_WAYLAND
+  timestamp = glps_window_event_input_timestamp();
+#else
+  if (wm != NULL)
+  {
+    timestamp = wm->input_timestamp;
+  }
 #endif
+  return timestamp;
+}
 
-    wm->windows[window_id]->fps_is_init = true;
-    return 0.0;
+glps_InputDevice glps_wm_get_input_device(glps_WindowManager *wm)
+{
+  glps_InputDevice device = {0};
+#ifdef GLPS_USE_X11
+  if (wm != NULL)
+  {
+    device = wm->input_device;
   }
-  else
+#endif
+  return device;
+}
+
+double glps_wm_get_fps(glps_WindowManager *wm, size_t window_id)
+{
+  return glps_wm_window_get_frame_stats(wm, window_id).mean_fps;
+}
+
+static glps_WindowProperties __get_properties(glps_WindowManager *wm,
+                                              size_t window_id)
+{
+  glps_WindowProperties properties = {0};
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return properties;
+  }
+#ifdef GLPS_USE_WAYLAND
+  unsigned epoch;
+  glps_WaylandWindow *window = glps_sync_read_begin(wm, window_id, &epoch);
+  if (window != NULL)
+  {
+    GLPS_SEQLOCK_SNAPSHOT(&window->properties_cell, &properties);
+  }
+  glps_sync_read_end(wm, epoch);
+#else
+  if (window_id < wm->window_count && wm->windows[window_id] != NULL)
   {
+    properties = wm->windows[window_id]->properties;
+  }
+#endif
+  return properties;
+}
+
+double glps_wm_window_get_refresh_rate(glps_WindowManager *wm,
+                                       size_t window_id)
+{
+  return __get_properties(wm, window_id).refresh_mhz / 1000.0;
+}
+
+int glps_wm_window_get_scale(glps_WindowManager *wm, size_t window_id)
+{
+  int scale = __get_properties(wm, window_id).scale;
+  return scale > 0 ? scale : 1;
+}
+
 #ifdef GLPS_USE_WAYLAND
-    struct timespec end_time;
-    clock_gettime(CLOCK_MONOTONIC, &end_time);
+typedef struct
+{
+  uint32_t window_handle;
+  double render_scale;
+} glps_RenderScaleTask;
 
-    double seconds = (double)(end_time.tv_sec - wm->windows[window_id]->fps_start_time.tv_sec);
-    double nanoseconds = (double)(end_time.tv_nsec - wm->windows[window_id]->fps_start_time.tv_nsec);
+static void __render_scale_task(glps_WindowManager *wm, void *data)
+{
+  glps_RenderScaleTask task = *(glps_RenderScaleTask *)data;
+  free(data);
+  size_t window_id;
+  if (glps_wl_window_find(wm, task.window_handle, &window_id))
+  {
+    glps_wm_window_set_render_scale(wm, window_id, task.render_scale);
+  }
+}
+#endif
 
-    if (nanoseconds < 0)
+void glps_wm_window_set_render_scale(glps_WindowManager *wm, size_t window_id,
+                                     double render_scale)
+{
+#ifdef GLPS_USE_WAYLAND
+  // Render threads adapt their own resolution, the owner resizes.
+  if (wm != NULL && !glps_sync_is_owner(wm))
+  {
+    uint32_t handle = __window_handle(wm, window_id);
+    if (handle == 0)
     {
-      seconds -= 1.0;
-      nanoseconds += 1e9;
+      LOG_ERROR("Invalid window ID or window manager is NULL.");
+      return;
     }
-
-    wm->windows[window_id]->fps_start_time = end_time;
-    return 1.0 / (seconds + nanoseconds / 1e9);
+    glps_RenderScaleTask *task = malloc(sizeof(glps_RenderScaleTask));
+    if (task == NULL)
+    {
+      LOG_ERROR("Failed to allocate render scale task.");
+      return;
+    }
+    *task = (glps_RenderScaleTask){handle, render_scale};
+    if (!glps_sync_post(wm, __render_scale_task, task))
+    {
+      free(task);
+    }
+    return;
+  }
 #endif
 
-#ifdef GLPS_USE_WIN32
-    LARGE_INTEGER end_time;
-    QueryPerformanceCounter(&end_time);
+  if (wm == NULL || window_id >= wm->window_count ||
+      wm->windows[window_id] == NULL)
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+  if (!(render_scale > 0.0))
+  {
+    LOG_ERROR("Render scale %f is not positive.", render_scale);
+    return;
+  }
 
-    double time_taken = (double)(end_time.QuadPart - wm->windows[window_id]->fps_start_time.QuadPart) /
-                        (double)wm->windows[window_id]->fps_freq.QuadPart;
+  if (render_scale < GLPS_RESOLUTION_MIN_SCALE)
+    render_scale = GLPS_RESOLUTION_MIN_SCALE;
+  else if (render_scale > 1.0)
+    render_scale = 1.0;
 
-    wm->windows[window_id]->fps_start_time = end_time;
-    return 1.0 / time_taken;
+#ifdef GLPS_USE_WAYLAND
+  glps_wl_window_set_render_scale(wm, window_id, render_scale);
+#else
+  if (__is_software(wm, window_id))
+  {
+    LOG_WARNING("Software window %zu renders at full size.", window_id);
+    return;
+  }
+  glps_WindowProperties *properties = &wm->windows[window_id]->properties;
+  if (properties->render_scale == render_scale)
+  {
+    return;
+  }
+  // Frames after the next swap draw into the scaled framebuffer.
+  properties->render_scale = render_scale;
+  if (wm->callbacks.window_resize_callback)
+  {
+    int width = 0, height = 0;
+    glps_wm_window_get_framebuffer_size(wm, window_id, &width, &height);
+    wm->callbacks.window_resize_callback(window_id, width, height,
+                                         wm->callbacks.window_resize_data);
+  }
 #endif
+}
+
+double glps_wm_window_get_render_scale(glps_WindowManager *wm,
+                                       size_t window_id)
+{
+  double render_scale = __get_properties(wm, window_id).render_scale;
+  return render_scale > 0.0 ? render_scale : 1.0;
+}
+
+void glps_wm_window_set_dynamic_resolution(glps_WindowManager *wm,
+                                           size_t window_id, bool enabled,
+                                           double min_scale, double max_scale)
+{
+  if (!__has_window(wm, window_id))
+  {
+    LOG_ERROR("Invalid window ID or window manager is NULL.");
+    return;
+  }
+  if (min_scale < GLPS_RESOLUTION_MIN_SCALE)
+    min_scale = GLPS_RESOLUTION_MIN_SCALE;
+  if (max_scale > 1.0)
+    max_scale = 1.0;
+  if (!(min_scale <= max_scale))
+  {
+    LOG_ERROR("Render scale bounds [%f, %f] are empty.", min_scale,
+              max_scale);
+    return;
   }
 
-  return -1.0f;
+  glps_ResolutionController *controller =
+      &__WINDOW(wm, window_id)->resolution;
+  glps_resolution_configure(controller, enabled, min_scale, max_scale,
+                            glps_wm_window_get_render_scale(wm, window_id));
+  // Windows leave the controller at full resolution.
+  glps_wm_window_set_render_scale(wm, window_id,
+                                  enabled ? controller->scale : 1.0);
+}
+
+unsigned int glps_wm_window_get_framebuffer(glps_WindowManager *wm,
+                                            size_t window_id)
+{
+#if defined(GLPS_USE_WIN32) || defined(GLPS_USE_X11)
+  if (__has_window(wm, window_id) &&
+      __WINDOW(wm, window_id)->scaled_fb.bound)
+  {
+    return __WINDOW(wm, window_id)->scaled_fb.framebuffer;
+  }
+#endif
+  return 0;
 }
 
 bool glps_wm_should_close(glps_WindowManager *wm)
 {
+  pico_trace_poll();
+
 #ifdef GLPS_USE_WAYLAND
   return glps_wl_should_close(wm);
 #endif
@@ -531,6 +1721,37 @@ bool glps_wm_should_close(glps_WindowManager *wm)
 #endif
 }
 
+bool glps_wm_dispatch_events(glps_WindowManager *wm, int timeout_ms)
+{
+#ifdef GLPS_USE_WAYLAND
+  pico_trace_poll();
+  return glps_wl_dispatch(wm, timeout_ms) >= 0;
+#elif defined(GLPS_USE_X11)
+  pico_trace_poll();
+  return glps_x11_dispatch(wm, timeout_ms) >= 0;
+#else
+  (void)timeout_ms;
+  return !glps_wm_should_close(wm);
+#endif
+}
+
+int glps_wm_get_event_fd(glps_WindowManager *wm)
+{
+  if (wm == NULL)
+  {
+    LOG_ERROR("Window Manager is NULL.");
+    return -1;
+  }
+
+#ifdef GLPS_USE_WAYLAND
+  return wl_display_get_fd(wm->wayland_ctx->wl_display);
+#elif defined(GLPS_USE_X11)
+  return glps_x11_get_fd(wm);
+#else
+  return -1;
+#endif
+}
+
 void glps_wm_destroy(glps_WindowManager *wm)
 {
 #ifdef GLPS_USE_WAYLAND
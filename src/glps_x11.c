@@ -15,6 +15,896 @@
  */
 
 #include "glps_x11.h"
+#include "glps_window_manager.h"
+#include "glps_egl_context.h"
+#include "glps_frame_stats.h"
+#include "glps_input_latency.h"
+#include "glps_resolution.h"
+#include <math.h>
+#include <poll.h>
+#ifdef GLPS_HAVE_XCB_SHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
+
+#define X11_WHEEL_STEP 15.0 /**< Scroll distance of a wheel click, as the
+                                 Wayland backend reports it. */
+
+static ssize_t __x11_get_window_id(glps_WindowManager *wm, xcb_window_t window)
+{
+    for (size_t i = 0; i < wm->window_count; ++i)
+    {
+        if (wm->windows[i]->window == window)
+        {
+            return (ssize_t)i;
+        }
+    }
+    return -1;
+}
+
+static xcb_get_keyboard_mapping_cookie_t
+__x11_request_keymap(glps_X11Context *ctx)
+{
+    const xcb_setup_t *setup = xcb_get_setup(ctx->connection);
+    ctx->min_keycode = setup->min_keycode;
+    ctx->max_keycode = setup->max_keycode;
+    return xcb_get_keyboard_mapping(ctx->connection, ctx->min_keycode,
+                                    ctx->max_keycode - ctx->min_keycode + 1);
+}
+
+static void __x11_load_keymap(glps_X11Context *ctx,
+                              xcb_get_keyboard_mapping_cookie_t cookie)
+{
+    xcb_get_keyboard_mapping_reply_t *reply =
+        xcb_get_keyboard_mapping_reply(ctx->connection, cookie, NULL);
+    if (reply == NULL)
+    {
+        LOG_ERROR("Failed to get the keyboard mapping.");
+        return;
+    }
+
+    int length = xcb_get_keyboard_mapping_keysyms_length(reply);
+    xcb_keysym_t *keysyms = malloc(sizeof(xcb_keysym_t) * length);
+    if (keysyms == NULL)
+    {
+        LOG_ERROR("Failed to allocate the keyboard mapping.");
+        free(reply);
+        return;
+    }
+    memcpy(keysyms, xcb_get_keyboard_mapping_keysyms(reply),
+           sizeof(xcb_keysym_t) * length);
+
+    free(ctx->keysyms);
+    ctx->keysyms = keysyms;
+    ctx->keysyms_per_keycode = reply->keysyms_per_keycode;
+    free(reply);
+}
+
+static xcb_keysym_t __x11_get_keysym(glps_X11Context *ctx,
+                                     xcb_keycode_t keycode, uint16_t state)
+{
+    if (ctx->keysyms == NULL || ctx->keysyms_per_keycode == 0 ||
+        keycode < ctx->min_keycode || keycode > ctx->max_keycode)
+    {
+        return NoSymbol;
+    }
+
+    const xcb_keysym_t *syms =
+        &ctx->keysyms[(keycode - ctx->min_keycode) * ctx->keysyms_per_keycode];
+    xcb_keysym_t lower = syms[0];
+    xcb_keysym_t upper = ctx->keysyms_per_keycode > 1 && syms[1] != NoSymbol
+                             ? syms[1]
+                             : lower;
+    bool letter = lower >= 'a' && lower <= 'z';
+    if (letter && upper == lower)
+    {
+        upper = lower - 'a' + 'A';
+    }
+
+    // Caps Lock only inverts Shift for letters.
+    bool shift = (state & XCB_MOD_MASK_SHIFT) != 0;
+    if (letter && (state & XCB_MOD_MASK_LOCK))
+    {
+        shift = !shift;
+    }
+    return shift ? upper : lower;
+}
+
+// Printable keysyms become their UTF-8 text, the others their name.
+static void __x11_get_key_value(xcb_keysym_t sym, char *value, size_t size)
+{
+    uint32_t code = 0;
+    if ((sym >= 0x20 && sym <= 0x7e) || (sym >= 0xa0 && sym <= 0xff))
+    {
+        code = sym;
+    }
+    else if ((sym & 0xff000000) == 0x01000000)
+    {
+        code = sym & 0x00ffffff;
+    }
+
+    if (code == 0)
+    {
+        const char *name = XKeysymToString(sym);
+        strncpy(value, name != NULL ? name : "", size - 1);
+        value[size - 1] = '\0';
+        return;
+    }
+
+    size_t n = 0;
+    if (code < 0x80)
+    {
+        value[n++] = (char)code;
+    }
+    else if (code < 0x800)
+    {
+        value[n++] = (char)(0xc0 | (code >> 6));
+        value[n++] = (char)(0x80 | (code & 0x3f));
+    }
+    else if (code < 0x10000)
+    {
+        value[n++] = (char)(0xe0 | (code >> 12));
+        value[n++] = (char)(0x80 | ((code >> 6) & 0x3f));
+        value[n++] = (char)(0x80 | (code & 0x3f));
+    }
+    else
+    {
+        value[n++] = (char)(0xf0 | (code >> 18));
+        value[n++] = (char)(0x80 | ((code >> 12) & 0x3f));
+        value[n++] = (char)(0x80 | ((code >> 6) & 0x3f));
+        value[n++] = (char)(0x80 | (code & 0x3f));
+    }
+    value[n] = '\0';
+}
+
+// Input counts towards the latency of the window it was sent to. Core
+// events don't tell their device, XInput2 handlers set it after this.
+static void __x11_stamp_input(glps_WindowManager *wm, size_t window_id,
+                              xcb_timestamp_t time)
+{
+    uint64_t now_ns = perf_now_ns();
+    wm->input_timestamp =
+        (glps_InputTimestamp){.time_ms = time, .receive_ns = now_ns};
+    wm->input_device = (glps_InputDevice){0};
+    glps_latency_input(&wm->windows[window_id]->latency,
+                       glps_latency_event_time_ns(time, now_ns), now_ns);
+}
+
+// Auto-repeat sends a release and a press with the same time, both dropped
+// so a held key reads as one press, as on Win32.
+static bool __x11_is_key_repeat(const xcb_generic_event_t *event,
+                                const xcb_generic_event_t *next)
+{
+    if (next == NULL || (event->response_type & ~0x80) != XCB_KEY_RELEASE ||
+        (next->response_type & ~0x80) != XCB_KEY_PRESS)
+    {
+        return false;
+    }
+
+    const xcb_key_release_event_t *release =
+        (const xcb_key_release_event_t *)event;
+    const xcb_key_press_event_t *press = (const xcb_key_press_event_t *)next;
+    return release->detail == press->detail && release->time == press->time;
+}
+
+#ifdef GLPS_HAVE_XINPUT2
+
+// XInput2 event type of an event, 0 for any other event.
+static uint16_t __x11_xi_event_type(const glps_X11Context *ctx,
+                                    const xcb_generic_event_t *event)
+{
+    const xcb_ge_generic_event_t *generic =
+        (const xcb_ge_generic_event_t *)event;
+    if (ctx->xi_opcode == 0 ||
+        (event->response_type & ~0x80) != XCB_GE_GENERIC ||
+        generic->extension != ctx->xi_opcode)
+    {
+        return 0;
+    }
+    return generic->event_type;
+}
+
+#endif
+
+// Window, time and device of a pointer motion event, false for other events.
+// Core motion has no device and reports 0.
+static bool __x11_get_motion(const glps_X11Context *ctx,
+                             const xcb_generic_event_t *event,
+                             xcb_window_t *window, xcb_timestamp_t *time,
+                             uint16_t *device)
+{
+    if ((event->response_type & ~0x80) == XCB_MOTION_NOTIFY)
+    {
+        const xcb_motion_notify_event_t *motion =
+            (const xcb_motion_notify_event_t *)event;
+        *window = motion->event;
+        *time = motion->time;
+        *device = 0;
+        return true;
+    }
+#ifdef GLPS_HAVE_XINPUT2
+    if (__x11_xi_event_type(ctx, event) == XCB_INPUT_MOTION)
+    {
+        const xcb_input_motion_event_t *motion =
+            (const xcb_input_motion_event_t *)event;
+        *window = motion->event;
+        *time = motion->time;
+        *device = motion->deviceid;
+        return true;
+    }
+#endif
+    return false;
+}
+
+// Motion followed by more motion of the same device over the same window is
+// never seen by the callback, only the latest position is.
+static bool __x11_is_superseded_motion(const glps_X11Context *ctx,
+                                       const xcb_generic_event_t *event,
+                                       const xcb_generic_event_t *next)
+{
+    xcb_window_t window, next_window;
+    xcb_timestamp_t time, next_time;
+    uint16_t device, next_device;
+    if (next == NULL ||
+        !__x11_get_motion(ctx, event, &window, &time, &device) ||
+        !__x11_get_motion(ctx, next, &next_window, &next_time, &next_device))
+    {
+        return false;
+    }
+
+    return window == next_window && device == next_device;
+}
+
+static void __x11_handle_key(glps_WindowManager *wm, size_t window_id,
+                             xcb_key_press_event_t *event)
+{
+    bool pressed = (event->response_type & ~0x80) == XCB_KEY_PRESS;
+
+    __x11_stamp_input(wm, window_id, event->time);
+    if (!wm->callbacks.keyboard_callback)
+    {
+        return;
+    }
+
+    xcb_keysym_t sym = __x11_get_keysym(wm->x11_ctx, event->detail, event->state);
+    if (sym == NoSymbol)
+    {
+        return;
+    }
+
+    char value[32];
+    __x11_get_key_value(sym, value, sizeof(value));
+    wm->callbacks.keyboard_callback(window_id, pressed, value,
+                                    wm->callbacks.keyboard_data);
+}
+
+static void __x11_handle_button(glps_WindowManager *wm, size_t window_id,
+                                uint32_t button, bool pressed)
+{
+    // Buttons 4 to 7 are wheel clicks, sent as a press and release pair.
+    if (button >= 4 && button <= 7)
+    {
+        if (!pressed || !wm->callbacks.mouse_scroll_callback)
+        {
+            return;
+        }
+        GLPS_SCROLL_AXES axis =
+            button <= 5 ? GLPS_SCROLL_V_AXIS : GLPS_SCROLL_H_AXIS;
+        int discrete = button == 4 || button == 6 ? -1 : 1;
+        wm->callbacks.mouse_scroll_callback(
+            window_id, axis, GLPS_SCROLL_SOURCE_WHEEL, discrete * X11_WHEEL_STEP,
+            discrete, false, wm->callbacks.mouse_scroll_data);
+        return;
+    }
+
+    if (wm->callbacks.mouse_click_callback)
+    {
+        wm->callbacks.mouse_click_callback(window_id, pressed,
+                                           wm->callbacks.mouse_click_data);
+    }
+}
+
+#ifdef GLPS_HAVE_XINPUT2
+
+static double __x11_fp3232(xcb_input_fp3232_t value)
+{
+    return value.integral + value.frac / 4294967296.0;
+}
+
+// Names and scroll valuators of every device, queried again whenever
+// devices are plugged or a master device switches to another physical one.
+static void __x11_xi_query_devices(glps_X11Context *ctx)
+{
+    xcb_input_xi_query_device_reply_t *reply = xcb_input_xi_query_device_reply(
+        ctx->connection,
+        xcb_input_xi_query_device(ctx->connection, XCB_INPUT_DEVICE_ALL),
+        NULL);
+    if (reply == NULL)
+    {
+        LOG_ERROR("Failed to query XInput2 devices.");
+        return;
+    }
+
+    ctx->device_count = 0;
+    ctx->scroll_axis_count = 0;
+    xcb_input_xi_device_info_iterator_t infos =
+        xcb_input_xi_query_device_infos_iterator(reply);
+    for (; infos.rem > 0; xcb_input_xi_device_info_next(&infos))
+    {
+        xcb_input_xi_device_info_t *info = infos.data;
+        glps_X11Device *device = NULL;
+        if (ctx->device_count < GLPS_X11_MAX_DEVICES)
+        {
+            device = &ctx->devices[ctx->device_count++];
+            int length = xcb_input_xi_device_info_name_length(info);
+            if (length >= (int)sizeof(device->name))
+            {
+                length = sizeof(device->name) - 1;
+            }
+            device->id = info->deviceid;
+            memcpy(device->name, xcb_input_xi_device_info_name(info), length);
+            device->name[length] = '\0';
+            device->absolute = false;
+        }
+
+        size_t first_axis = ctx->scroll_axis_count;
+        xcb_input_device_class_iterator_t classes =
+            xcb_input_xi_device_info_classes_iterator(info);
+        for (; classes.rem > 0; xcb_input_device_class_next(&classes))
+        {
+            if (classes.data->type != XCB_INPUT_DEVICE_CLASS_TYPE_SCROLL ||
+                ctx->scroll_axis_count >= GLPS_X11_MAX_SCROLL_AXES)
+            {
+                continue;
+            }
+            xcb_input_scroll_class_t *scroll =
+                (xcb_input_scroll_class_t *)classes.data;
+            ctx->scroll_axes[ctx->scroll_axis_count++] = (glps_X11ScrollAxis){
+                .device_id = info->deviceid,
+                .number = scroll->number,
+                .axis = scroll->scroll_type == XCB_INPUT_SCROLL_TYPE_HORIZONTAL
+                            ? GLPS_SCROLL_H_AXIS
+                            : GLPS_SCROLL_V_AXIS,
+                .increment = __x11_fp3232(scroll->increment),
+            };
+        }
+
+        // Scroll classes only name their valuator, its current value and
+        // mode are in the valuator class.
+        classes = xcb_input_xi_device_info_classes_iterator(info);
+        for (; classes.rem > 0; xcb_input_device_class_next(&classes))
+        {
+            if (classes.data->type != XCB_INPUT_DEVICE_CLASS_TYPE_VALUATOR)
+            {
+                continue;
+            }
+            xcb_input_valuator_class_t *valuator =
+                (xcb_input_valuator_class_t *)classes.data;
+            if (device != NULL && valuator->number == 0)
+            {
+                device->absolute =
+                    valuator->mode == XCB_INPUT_VALUATOR_MODE_ABSOLUTE;
+            }
+            for (size_t i = first_axis; i < ctx->scroll_axis_count; ++i)
+            {
+                if (ctx->scroll_axes[i].number == valuator->number)
+                {
+                    ctx->scroll_axes[i].last = __x11_fp3232(valuator->value);
+                    ctx->scroll_axes[i].known = true;
+                }
+            }
+        }
+    }
+    free(reply);
+}
+
+static glps_X11Device *__x11_xi_get_device(glps_X11Context *ctx,
+                                           uint16_t device_id)
+{
+    for (size_t i = 0; i < ctx->device_count; ++i)
+    {
+        if (ctx->devices[i].id == device_id)
+        {
+            return &ctx->devices[i];
+        }
+    }
+    return NULL;
+}
+
+static void __x11_xi_set_input_device(glps_WindowManager *wm,
+                                      uint16_t device_id)
+{
+    wm->input_device = (glps_InputDevice){.id = device_id};
+    glps_X11Device *device = __x11_xi_get_device(wm->x11_ctx, device_id);
+    if (device != NULL)
+    {
+        memcpy(wm->input_device.name, device->name, sizeof(device->name));
+    }
+}
+
+// Events only carry the valuators whose bit is set in their mask, packed in
+// the order of the bits.
+static bool __x11_xi_get_valuator(const uint32_t *mask, uint16_t mask_len,
+                                  const xcb_input_fp3232_t *values,
+                                  uint16_t number, double *value)
+{
+    if (number >= mask_len * 32 || !(mask[number / 32] & (1u << number % 32)))
+    {
+        return false;
+    }
+
+    size_t index = 0;
+    for (uint16_t i = 0; i < number; ++i)
+    {
+        if (mask[i / 32] & (1u << i % 32))
+        {
+            index++;
+        }
+    }
+    *value = __x11_fp3232(values[index]);
+    return true;
+}
+
+static void __x11_xi_scroll(glps_WindowManager *wm, size_t window_id,
+                            xcb_input_motion_event_t *motion)
+{
+    glps_X11Context *ctx = wm->x11_ctx;
+    const uint32_t *mask = xcb_input_button_press_valuator_mask(motion);
+    const xcb_input_fp3232_t *values =
+        xcb_input_button_press_axisvalues(motion);
+
+    for (size_t i = 0; i < ctx->scroll_axis_count; ++i)
+    {
+        glps_X11ScrollAxis *axis = &ctx->scroll_axes[i];
+        double value;
+        if (axis->device_id != motion->deviceid ||
+            !__x11_xi_get_valuator(mask, motion->valuators_len, values,
+                                   axis->number, &value))
+        {
+            continue;
+        }
+
+        double delta = value - axis->last;
+        bool known = axis->known;
+        axis->last = value;
+        axis->known = true;
+        if (!known || delta == 0.0 || axis->increment == 0.0 ||
+            !wm->callbacks.mouse_scroll_callback)
+        {
+            continue;
+        }
+
+        // Whole increments are wheel clicks, anything finer comes from a
+        // touchpad or a high-resolution wheel.
+        double clicks = delta / axis->increment;
+        bool wheel = clicks == round(clicks);
+        wm->callbacks.mouse_scroll_callback(
+            window_id, axis->axis,
+            wheel ? GLPS_SCROLL_SOURCE_WHEEL : GLPS_SCROLL_SOURCE_CONTINUOUS,
+            clicks * X11_WHEEL_STEP, wheel ? (int)clicks : 0, false,
+            wm->callbacks.mouse_scroll_data);
+    }
+}
+
+// Raw motion is summed up and reported once per dispatch.
+static void __x11_xi_raw_motion(glps_X11Context *ctx,
+                                xcb_input_raw_motion_event_t *event)
+{
+    glps_X11Device *device = __x11_xi_get_device(ctx, event->sourceid);
+    if (device != NULL && device->absolute)
+    {
+        return;
+    }
+
+    const uint32_t *mask = xcb_input_raw_button_press_valuator_mask(event);
+    const xcb_input_fp3232_t *values =
+        xcb_input_raw_button_press_axisvalues_raw(event);
+    double delta;
+    if (__x11_xi_get_valuator(mask, event->valuators_len, values, 0, &delta))
+    {
+        ctx->raw_dx += delta;
+        ctx->raw_pending = true;
+    }
+    if (__x11_xi_get_valuator(mask, event->valuators_len, values, 1, &delta))
+    {
+        ctx->raw_dy += delta;
+        ctx->raw_pending = true;
+    }
+}
+
+// Goes to the window under the pointer, or the focused one when the pointer
+// is elsewhere.
+static void __x11_xi_flush_raw_motion(glps_WindowManager *wm)
+{
+    glps_X11Context *ctx = wm->x11_ctx;
+    if (!ctx->raw_pending)
+    {
+        return;
+    }
+
+    double dx = ctx->raw_dx, dy = ctx->raw_dy;
+    ctx->raw_dx = ctx->raw_dy = 0.0;
+    ctx->raw_pending = false;
+
+    ssize_t window_id = __x11_get_window_id(wm, ctx->pointer_window);
+    if (window_id < 0)
+    {
+        window_id = __x11_get_window_id(wm, ctx->focus_window);
+    }
+    if (window_id >= 0 && wm->callbacks.raw_motion_callback)
+    {
+        wm->callbacks.raw_motion_callback(window_id, dx, dy,
+                                          wm->callbacks.raw_motion_data);
+    }
+}
+
+static void __x11_xi_handle_event(glps_WindowManager *wm,
+                                  xcb_generic_event_t *event,
+                                  uint16_t event_type)
+{
+    glps_X11Context *ctx = wm->x11_ctx;
+
+    switch (event_type)
+    {
+    case XCB_INPUT_HIERARCHY:
+    case XCB_INPUT_DEVICE_CHANGED:
+        __x11_xi_query_devices(ctx);
+        return;
+    case XCB_INPUT_RAW_MOTION:
+        __x11_xi_raw_motion(ctx, (xcb_input_raw_motion_event_t *)event);
+        return;
+    }
+
+    // The rest are device events, which share one layout.
+    xcb_input_button_press_event_t *device_event =
+        (xcb_input_button_press_event_t *)event;
+    ssize_t window_id = __x11_get_window_id(wm, device_event->event);
+    if (window_id < 0)
+    {
+        return;
+    }
+    __x11_stamp_input(wm, window_id, device_event->time);
+    __x11_xi_set_input_device(wm, device_event->sourceid);
+    double x = device_event->event_x / 65536.0;
+    double y = device_event->event_y / 65536.0;
+
+    switch (event_type)
+    {
+    case XCB_INPUT_MOTION:
+        __x11_xi_scroll(wm, window_id, device_event);
+        if (wm->callbacks.mouse_move_callback)
+        {
+            wm->callbacks.mouse_move_callback(window_id, x, y,
+                                              wm->callbacks.mouse_move_data);
+        }
+        break;
+
+    case XCB_INPUT_BUTTON_PRESS:
+    case XCB_INPUT_BUTTON_RELEASE:
+        // Wheel buttons emulated from scroll valuators were already
+        // reported by the motion that carried them.
+        if (device_event->flags & XCB_INPUT_POINTER_EVENT_FLAGS_POINTER_EMULATED)
+        {
+            break;
+        }
+        __x11_handle_button(wm, window_id, device_event->detail,
+                            event_type == XCB_INPUT_BUTTON_PRESS);
+        break;
+
+    case XCB_INPUT_TOUCH_BEGIN:
+    case XCB_INPUT_TOUCH_UPDATE:
+    case XCB_INPUT_TOUCH_END:
+        // As on Wayland, the state is set for touches going down or up.
+        if (wm->callbacks.touch_callback)
+        {
+            wm->callbacks.touch_callback(
+                window_id, (int)device_event->detail, x, y,
+                event_type != XCB_INPUT_TOUCH_UPDATE, 0.0, 0.0, 0.0,
+                wm->callbacks.touch_data);
+        }
+        break;
+    }
+}
+
+// Without XInput 2.2 the core events are all there is.
+static void __x11_xi_init(glps_X11Context *ctx)
+{
+    const xcb_query_extension_reply_t *extension =
+        xcb_get_extension_data(ctx->connection, &xcb_input_id);
+    if (extension == NULL || !extension->present)
+    {
+        LOG_INFO("XInput2 not available, using core input events.");
+        return;
+    }
+
+    xcb_input_xi_query_version_reply_t *version =
+        xcb_input_xi_query_version_reply(
+            ctx->connection,
+            xcb_input_xi_query_version(ctx->connection, 2, 2), NULL);
+    bool supported = version != NULL &&
+                     (version->major_version > 2 ||
+                      (version->major_version == 2 &&
+                       version->minor_version >= 2));
+    free(version);
+    if (!supported)
+    {
+        LOG_INFO("XInput 2.2 not supported, using core input events.");
+        return;
+    }
+
+    ctx->xi_opcode = extension->major_opcode;
+    __x11_xi_query_devices(ctx);
+
+    // Raw motion and device changes are selected on the root window, they
+    // arrive wherever the pointer is.
+    struct
+    {
+        xcb_input_event_mask_t head;
+        uint32_t mask;
+    } masks[] = {
+        {{XCB_INPUT_DEVICE_ALL_MASTER, 1}, XCB_INPUT_XI_EVENT_MASK_RAW_MOTION},
+        {{XCB_INPUT_DEVICE_ALL, 1},
+         XCB_INPUT_XI_EVENT_MASK_HIERARCHY |
+             XCB_INPUT_XI_EVENT_MASK_DEVICE_CHANGED},
+    };
+    xcb_input_xi_select_events(ctx->connection, ctx->screen->root, 2,
+                               &masks[0].head);
+}
+
+// Pointer and touch events of the window come through XInput2, which the
+// server sends instead of the core ones.
+static void __x11_xi_select_window(glps_X11Context *ctx, xcb_window_t window)
+{
+    if (ctx->xi_opcode == 0)
+    {
+        return;
+    }
+
+    struct
+    {
+        xcb_input_event_mask_t head;
+        uint32_t mask;
+    } mask = {
+        {XCB_INPUT_DEVICE_ALL_MASTER, 1},
+        XCB_INPUT_XI_EVENT_MASK_MOTION | XCB_INPUT_XI_EVENT_MASK_BUTTON_PRESS |
+            XCB_INPUT_XI_EVENT_MASK_BUTTON_RELEASE |
+            XCB_INPUT_XI_EVENT_MASK_TOUCH_BEGIN |
+            XCB_INPUT_XI_EVENT_MASK_TOUCH_UPDATE |
+            XCB_INPUT_XI_EVENT_MASK_TOUCH_END,
+    };
+    xcb_input_xi_select_events(ctx->connection, window, 1, &mask.head);
+}
+
+#endif
+
+// The window an event is about, 0 for events not tied to one.
+static xcb_window_t __x11_event_window(const xcb_generic_event_t *event)
+{
+    switch (event->response_type & ~0x80)
+    {
+    case XCB_EXPOSE:
+        return ((const xcb_expose_event_t *)event)->window;
+    case XCB_CONFIGURE_NOTIFY:
+        return ((const xcb_configure_notify_event_t *)event)->window;
+    case XCB_CLIENT_MESSAGE:
+        return ((const xcb_client_message_event_t *)event)->window;
+    case XCB_KEY_PRESS:
+    case XCB_KEY_RELEASE:
+        return ((const xcb_key_press_event_t *)event)->event;
+    case XCB_BUTTON_PRESS:
+    case XCB_BUTTON_RELEASE:
+        return ((const xcb_button_press_event_t *)event)->event;
+    case XCB_MOTION_NOTIFY:
+        return ((const xcb_motion_notify_event_t *)event)->event;
+    case XCB_ENTER_NOTIFY:
+    case XCB_LEAVE_NOTIFY:
+        return ((const xcb_enter_notify_event_t *)event)->event;
+    case XCB_FOCUS_IN:
+    case XCB_FOCUS_OUT:
+        return ((const xcb_focus_in_event_t *)event)->event;
+    }
+    return 0;
+}
+
+#ifdef GLPS_HAVE_XCB_SHM
+// The server read a segment, its buffer can be drawn into again.
+static void __x11_shm_completion(glps_WindowManager *wm,
+                                 const xcb_shm_completion_event_t *completion)
+{
+    ssize_t window_id = __x11_get_window_id(wm, completion->drawable);
+    if (window_id < 0)
+    {
+        return;
+    }
+    glps_X11Window *window = wm->windows[window_id];
+    for (size_t i = 0; i < GLPS_SHM_BUFFERS; ++i)
+    {
+        if (window->shm_buffers[i].segment == completion->shmseg)
+        {
+            window->shm_buffers[i].busy = false;
+        }
+    }
+    // Paced like the Wayland frame callback, by the server's pace.
+    window->frame_pending = true;
+}
+#endif
+
+static void __x11_handle_event(glps_WindowManager *wm,
+                               xcb_generic_event_t *event)
+{
+    glps_X11Context *ctx = wm->x11_ctx;
+    uint8_t type = event->response_type & ~0x80;
+
+#ifdef GLPS_HAVE_XINPUT2
+    uint16_t xi_type = __x11_xi_event_type(ctx, event);
+    if (xi_type != 0)
+    {
+        __x11_xi_handle_event(wm, event, xi_type);
+        return;
+    }
+#endif
+
+    if (type == XCB_MAPPING_NOTIFY)
+    {
+        if (((xcb_mapping_notify_event_t *)event)->request ==
+            XCB_MAPPING_KEYBOARD)
+        {
+            __x11_load_keymap(ctx, __x11_request_keymap(ctx));
+        }
+        return;
+    }
+
+#ifdef GLPS_HAVE_XCB_SHM
+    if (ctx->shm_completion != 0 && type == ctx->shm_completion)
+    {
+        __x11_shm_completion(wm, (xcb_shm_completion_event_t *)event);
+        return;
+    }
+#endif
+
+    ssize_t window_id = __x11_get_window_id(wm, __x11_event_window(event));
+    if (window_id < 0)
+    {
+        return;
+    }
+    glps_X11Window *window = wm->windows[window_id];
+
+    switch (type)
+    {
+    case XCB_EXPOSE:
+        // However many regions were exposed, the next frame redraws once.
+        if (((xcb_expose_event_t *)event)->count == 0)
+        {
+            window->frame_pending = true;
+            window->exposed = true;
+        }
+        break;
+
+    case XCB_CONFIGURE_NOTIFY:
+    {
+        xcb_configure_notify_event_t *configure =
+            (xcb_configure_notify_event_t *)event;
+        if (configure->width == window->properties.width &&
+            configure->height == window->properties.height)
+        {
+            break;
+        }
+        // EGL follows the window size on its own, no resize call needed.
+        // A drag sends dozens of these, the callback runs once per dispatch.
+        window->properties.width = configure->width;
+        window->properties.height = configure->height;
+        window->resize_pending = true;
+        break;
+    }
+
+    case XCB_CLIENT_MESSAGE:
+    {
+        xcb_client_message_event_t *message =
+            (xcb_client_message_event_t *)event;
+        if (message->type != ctx->wm_protocols ||
+            message->data.data32[0] != ctx->wm_delete_window)
+        {
+            break;
+        }
+        // Without a close callback the window just goes away.
+        if (wm->callbacks.window_close_callback)
+        {
+            wm->callbacks.window_close_callback(
+                window_id, wm->callbacks.window_close_data);
+        }
+        else
+        {
+            glps_wm_window_destroy(wm, window_id);
+        }
+        break;
+    }
+
+    case XCB_KEY_PRESS:
+    case XCB_KEY_RELEASE:
+        __x11_handle_key(wm, window_id, (xcb_key_press_event_t *)event);
+        break;
+
+    case XCB_BUTTON_PRESS:
+    case XCB_BUTTON_RELEASE:
+    {
+        xcb_button_press_event_t *button = (xcb_button_press_event_t *)event;
+        __x11_stamp_input(wm, window_id, button->time);
+        __x11_handle_button(wm, window_id, button->detail,
+                            type == XCB_BUTTON_PRESS);
+        break;
+    }
+
+    case XCB_MOTION_NOTIFY:
+    {
+        xcb_motion_notify_event_t *motion = (xcb_motion_notify_event_t *)event;
+        __x11_stamp_input(wm, window_id, motion->time);
+        if (wm->callbacks.mouse_move_callback)
+        {
+            wm->callbacks.mouse_move_callback(window_id, motion->event_x,
+                                              motion->event_y,
+                                              wm->callbacks.mouse_move_data);
+        }
+        break;
+    }
+
+    case XCB_ENTER_NOTIFY:
+#ifdef GLPS_HAVE_XINPUT2
+        // Other clients may have been scrolled since the pointer left.
+        ctx->pointer_window = window->window;
+        for (size_t i = 0; i < ctx->scroll_axis_count; ++i)
+        {
+            ctx->scroll_axes[i].known = false;
+        }
+#endif
+        if (wm->callbacks.mouse_enter_callback)
+        {
+            xcb_enter_notify_event_t *enter = (xcb_enter_notify_event_t *)event;
+            wm->callbacks.mouse_enter_callback(window_id, enter->event_x,
+                                               enter->event_y,
+                                               wm->callbacks.mouse_enter_data);
+        }
+        break;
+
+    case XCB_LEAVE_NOTIFY:
+#ifdef GLPS_HAVE_XINPUT2
+        if (ctx->pointer_window == window->window)
+        {
+            ctx->pointer_window = 0;
+        }
+#endif
+        if (wm->callbacks.mouse_leave_callback)
+        {
+            wm->callbacks.mouse_leave_callback(window_id,
+                                               wm->callbacks.mouse_leave_data);
+        }
+        break;
+
+    case XCB_FOCUS_IN:
+#ifdef GLPS_HAVE_XINPUT2
+        ctx->focus_window = window->window;
+#endif
+        if (wm->callbacks.keyboard_enter_callback)
+        {
+            wm->callbacks.keyboard_enter_callback(
+                window_id, wm->callbacks.keyboard_enter_data);
+        }
+        break;
+
+    case XCB_FOCUS_OUT:
+#ifdef GLPS_HAVE_XINPUT2
+        if (ctx->focus_window == window->window)
+        {
+            ctx->focus_window = 0;
+        }
+#endif
+        if (wm->callbacks.keyboard_leave_callback)
+        {
+            wm->callbacks.keyboard_leave_callback(
+                window_id, wm->callbacks.keyboard_leave_data);
+        }
+        break;
+    }
+}
 
 void glps_x11_init(glps_WindowManager *wm)
 {
@@ -24,59 +914,535 @@ void glps_x11_init(glps_WindowManager *wm)
         exit(EXIT_FAILURE);
     }
 
-    wm->x11_ctx = (glps_X11Context *)malloc(sizeof(glps_X11Context));
+    wm->x11_ctx = (glps_X11Context *)calloc(1, sizeof(glps_X11Context));
 
     wm->windows = (glps_X11Window **)malloc(sizeof(glps_X11Window *) * MAX_WINDOWS);
 
-    wm->x11_ctx->display = XOpenDisplay(NULL);
-    if (!wm->x11_ctx->display)
+    glps_X11Context *ctx = wm->x11_ctx;
+    ctx->connection = xcb_connect(NULL, &ctx->screen_number);
+    if (xcb_connection_has_error(ctx->connection))
     {
         LOG_CRITICAL("Failed to open X display\n");
         exit(EXIT_FAILURE);
     }
 
-    wm->x11_ctx->font = XLoadQueryFont(wm->x11_ctx->display, "fixed");
-    if (!wm->x11_ctx->font)
+    xcb_screen_iterator_t screens =
+        xcb_setup_roots_iterator(xcb_get_setup(ctx->connection));
+    for (int i = 0; i < ctx->screen_number; ++i)
     {
-        LOG_CRITICAL("Failed to load system font\n");
-        XCloseDisplay(wm->x11_ctx->display);
-        exit(EXIT_FAILURE);
+        xcb_screen_next(&screens);
+    }
+    ctx->screen = screens.data;
+
+    // Every request goes out before the first reply is awaited, so startup
+    // costs a single round trip.
+    const char *atom_names[] = {"WM_PROTOCOLS", "WM_DELETE_WINDOW",
+                                "_NET_WM_NAME", "UTF8_STRING"};
+    xcb_atom_t *atoms[] = {&ctx->wm_protocols, &ctx->wm_delete_window,
+                           &ctx->net_wm_name, &ctx->utf8_string};
+    xcb_intern_atom_cookie_t cookies[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        cookies[i] = xcb_intern_atom(ctx->connection, 0, strlen(atom_names[i]),
+                                     atom_names[i]);
+    }
+    xcb_get_keyboard_mapping_cookie_t keymap = __x11_request_keymap(ctx);
+#ifdef GLPS_HAVE_XINPUT2
+    xcb_prefetch_extension_data(ctx->connection, &xcb_input_id);
+#endif
+#ifdef GLPS_HAVE_XCB_SHM
+    xcb_prefetch_extension_data(ctx->connection, &xcb_shm_id);
+#endif
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        xcb_intern_atom_reply_t *reply =
+            xcb_intern_atom_reply(ctx->connection, cookies[i], NULL);
+        *atoms[i] = reply != NULL ? reply->atom : XCB_ATOM_NONE;
+        free(reply);
+    }
+    __x11_load_keymap(ctx, keymap);
+#ifdef GLPS_HAVE_XINPUT2
+    __x11_xi_init(ctx);
+#endif
+#ifdef GLPS_HAVE_XCB_SHM
+    const xcb_query_extension_reply_t *shm =
+        xcb_get_extension_data(ctx->connection, &xcb_shm_id);
+    if (shm != NULL && shm->present)
+    {
+        ctx->has_shm = true;
+        ctx->shm_completion = shm->first_event + XCB_SHM_COMPLETION;
+    }
+    else
+    {
+        LOG_INFO("No MIT-SHM, software windows are copied into requests.");
+    }
+#endif
+}
+
+// Visual of the screen with that ID and its depth, NULL if it has none.
+static xcb_visualtype_t *__x11_visual_type(xcb_screen_t *screen,
+                                           xcb_visualid_t visual,
+                                           uint8_t *depth)
+{
+    xcb_depth_iterator_t depths = xcb_screen_allowed_depths_iterator(screen);
+    for (; depths.rem > 0; xcb_depth_next(&depths))
+    {
+        xcb_visualtype_iterator_t visuals =
+            xcb_depth_visuals_iterator(depths.data);
+        for (; visuals.rem > 0; xcb_visualtype_next(&visuals))
+        {
+            if (visuals.data->visual_id == visual)
+            {
+                *depth = depths.data->depth;
+                return visuals.data;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Depth of a visual of the screen, 0 if it has none with that ID.
+static uint8_t __x11_visual_depth(xcb_screen_t *screen, xcb_visualid_t visual)
+{
+    uint8_t depth = 0;
+    __x11_visual_type(screen, visual, &depth);
+    return depth;
+}
+
+// Software windows hand their pixels over as they are, so the root visual
+// must store 0xXXRRGGBB words in the client's byte order.
+static bool __x11_software_visual(glps_X11Context *ctx, uint8_t *depth)
+{
+    xcb_visualtype_t *visual =
+        __x11_visual_type(ctx->screen, ctx->screen->root_visual, depth);
+    if (visual == NULL || visual->_class != XCB_VISUAL_CLASS_TRUE_COLOR ||
+        visual->red_mask != 0xff0000 || visual->green_mask != 0xff00 ||
+        visual->blue_mask != 0xff)
+    {
+        return false;
+    }
+
+    const xcb_setup_t *setup = xcb_get_setup(ctx->connection);
+    uint8_t byte_order = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                             ? XCB_IMAGE_ORDER_LSB_FIRST
+                             : XCB_IMAGE_ORDER_MSB_FIRST;
+    if (setup->image_byte_order != byte_order)
+    {
+        return false;
+    }
+
+    xcb_format_iterator_t formats = xcb_setup_pixmap_formats_iterator(setup);
+    for (; formats.rem > 0; xcb_format_next(&formats))
+    {
+        if (formats.data->depth == *depth)
+        {
+            return formats.data->bits_per_pixel == 32;
+        }
+    }
+    return false;
+}
+
+static void __x11_shm_buffer_destroy(glps_X11Context *ctx,
+                                     glps_X11ShmBuffer *buffer)
+{
+#ifdef GLPS_HAVE_XCB_SHM
+    if (buffer->segment != 0)
+    {
+        // Ordered after any put still reading it.
+        xcb_shm_detach(ctx->connection, buffer->segment);
+        shmdt(buffer->pixels);
+        *buffer = (glps_X11ShmBuffer){0};
+        return;
+    }
+#endif
+    free(buffer->pixels);
+    *buffer = (glps_X11ShmBuffer){0};
+}
+
+#ifdef GLPS_HAVE_XCB_SHM
+// Shares the pixels with the server, false if it can't attach them.
+static bool __x11_shm_attach(glps_X11Context *ctx, glps_X11ShmBuffer *buffer,
+                             size_t size)
+{
+    int id = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (id < 0)
+    {
+        LOG_WARNING("Failed to create shared memory: %s", strerror(errno));
+        return false;
+    }
+    void *pixels = shmat(id, NULL, 0);
+    if (pixels == (void *)-1)
+    {
+        LOG_WARNING("Failed to attach shared memory: %s", strerror(errno));
+        shmctl(id, IPC_RMID, NULL);
+        return false;
+    }
+
+    xcb_shm_seg_t segment = xcb_generate_id(ctx->connection);
+    xcb_generic_error_t *error = xcb_request_check(
+        ctx->connection,
+        xcb_shm_attach_checked(ctx->connection, segment, id, 0));
+    // Both sides are attached, the segment goes away with the last detach.
+    shmctl(id, IPC_RMID, NULL);
+    if (error != NULL)
+    {
+        free(error);
+        shmdt(pixels);
+        return false;
+    }
+
+    buffer->pixels = pixels;
+    buffer->segment = segment;
+    return true;
+}
+#endif
+
+// Only happens for the first frame and after resizes, never per frame.
+static bool __x11_shm_buffer_create(glps_X11Context *ctx,
+                                    glps_X11ShmBuffer *buffer, int width,
+                                    int height)
+{
+    __x11_shm_buffer_destroy(ctx, buffer);
+
+    size_t size = (size_t)width * height * sizeof(uint32_t);
+#ifdef GLPS_HAVE_XCB_SHM
+    if (ctx->has_shm && !__x11_shm_attach(ctx, buffer, size))
+    {
+        LOG_WARNING("MIT-SHM unusable, copying software frames instead.");
+        ctx->has_shm = false;
+    }
+#endif
+    if (buffer->pixels == NULL)
+    {
+        buffer->pixels = malloc(size);
+        if (buffer->pixels == NULL)
+        {
+            LOG_ERROR("Failed to allocate software framebuffer.");
+            return false;
+        }
     }
+
+    buffer->width = width;
+    buffer->height = height;
+    return true;
 }
 
 ssize_t glps_x11_window_create(glps_WindowManager *wm, const char *title,
-                               int width, int height)
+                               int width, int height, bool software)
 {
 
-    if (wm == NULL || wm->x11_ctx->display == NULL)
+    if (wm == NULL || wm->x11_ctx->connection == NULL)
     {
         LOG_CRITICAL("Failed to create X11 window. Window manager and/or Display NULL.");
         exit(EXIT_FAILURE);
     }
 
-    int screen = DefaultScreen(wm->x11_ctx->display);
-    wm->windows[wm->window_count] = (glps_X11Window *)malloc(sizeof(glps_X11Window));
-    wm->windows[wm->window_count]->window = XCreateSimpleWindow(
-        wm->x11_ctx->display,
-        RootWindow(wm->x11_ctx->display, screen),
-        10, 10, width, height, 1,
-        BlackPixel(wm->x11_ctx->display, screen),
-        WhitePixel(wm->x11_ctx->display, screen));
-    XSetWindowBackground(wm->x11_ctx->display, wm->windows[wm->window_count]->window, 0xFFFFFF);
-    XStoreName(wm->x11_ctx->display, wm->windows[wm->window_count]->window, title);
+    if (wm->window_count >= MAX_WINDOWS)
+    {
+        LOG_ERROR("Maximum number of windows reached.");
+        return -1;
+    }
+
+    glps_X11Context *ctx = wm->x11_ctx;
+    xcb_connection_t *connection = ctx->connection;
+
+    EGLint visual_id = 0;
+    uint8_t depth = 0;
+    if (software)
+    {
+        if (!__x11_software_visual(ctx, &depth))
+        {
+            LOG_ERROR("The root visual can't show 32-bit RGB pixels.");
+            return -1;
+        }
+        visual_id = ctx->screen->root_visual;
+    }
+    else
+    {
+        // The window must use the visual of the EGL config it is rendered
+        // with.
+        EGLConfig config;
+        if (!glps_egl_surface_config(wm, &config) ||
+            !eglGetConfigAttrib(wm->egl_ctx->dpy, config, EGL_NATIVE_VISUAL_ID,
+                                &visual_id))
+        {
+            LOG_ERROR("Failed to get the visual of the EGL config.");
+            return -1;
+        }
+
+        depth = __x11_visual_depth(ctx->screen, (xcb_visualid_t)visual_id);
+        if (depth == 0)
+        {
+            LOG_ERROR("No X visual matches the EGL config.");
+            return -1;
+        }
+    }
+
+    glps_X11Window *window = (glps_X11Window *)calloc(1, sizeof(glps_X11Window));
+    if (window == NULL)
+    {
+        LOG_ERROR("Failed to allocate X11 window.");
+        return -1;
+    }
+    window->properties.width = width;
+    window->properties.height = height;
+    window->properties.render_scale = 1.0;
+    strncpy(window->properties.title, title,
+            sizeof(window->properties.title) - 1);
+    glps_frame_stats_init(&window->frame_stats);
+    glps_resolution_init(&window->resolution);
+    glps_latency_init(&window->latency);
+    memset(&window->gpu_timer, 0, sizeof(window->gpu_timer));
+    window->software = software;
+
+    window->colormap = xcb_generate_id(connection);
+    xcb_create_colormap(connection, XCB_COLORMAP_ALLOC_NONE, window->colormap,
+                        ctx->screen->root, (xcb_visualid_t)visual_id);
+
+    // Values are listed in the order of their mask bits.
+    uint32_t values[] = {
+        0,
+        XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_STRUCTURE_NOTIFY |
+            XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+            XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+            XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_ENTER_WINDOW |
+            XCB_EVENT_MASK_LEAVE_WINDOW | XCB_EVENT_MASK_FOCUS_CHANGE,
+        window->colormap,
+    };
+    window->window = xcb_generate_id(connection);
+    xcb_create_window(connection, depth, window->window, ctx->screen->root, 10,
+                      10, width, height, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      (xcb_visualid_t)visual_id,
+                      XCB_CW_BORDER_PIXEL | XCB_CW_EVENT_MASK | XCB_CW_COLORMAP,
+                      values);
+#ifdef GLPS_HAVE_XINPUT2
+    __x11_xi_select_window(ctx, window->window);
+#endif
+
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window->window,
+                        XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, strlen(title),
+                        title);
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window->window,
+                        ctx->net_wm_name, ctx->utf8_string, 8, strlen(title),
+                        title);
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window->window,
+                        ctx->wm_protocols, XCB_ATOM_ATOM, 32, 1,
+                        &ctx->wm_delete_window);
+    xcb_map_window(connection, window->window);
+
+    if (software)
+    {
+        // Software windows need neither an EGL surface nor the context.
+        window->gc = xcb_generate_id(connection);
+        xcb_create_gc(connection, window->gc, window->window, 0, NULL);
+        wm->windows[wm->window_count] = window;
+        return wm->window_count++;
+    }
 
-    wm->x11_ctx->gc = XCreateGC(wm->x11_ctx->display, wm->windows[wm->window_count]->window, 0, NULL);
+    // The fallback Xlib display of EGL must see the window.
+    xcb_flush(connection);
 
-    wm->x11_ctx->wm_delete_window = XInternAtom(wm->x11_ctx->display, "WM_DELETE_WINDOW", False);
-    XSetWMProtocols(wm->x11_ctx->display, wm->windows[wm->window_count]->window, &wm->x11_ctx->wm_delete_window, 1);
+    window->egl_surface = glps_egl_create_surface(
+        wm, (EGLNativeWindowType)window->window, &window->window);
+    if (window->egl_surface == EGL_NO_SURFACE)
+    {
+        LOG_ERROR("Failed to create EGL surface: 0x%x", eglGetError());
+        xcb_destroy_window(connection, window->window);
+        xcb_free_colormap(connection, window->colormap);
+        free(window);
+        return -1;
+    }
 
-    XSelectInput(wm->x11_ctx->display, wm->windows[wm->window_count]->window,
-                 ExposureMask | ButtonPressMask | KeyPressMask | StructureNotifyMask);
+    wm->windows[wm->window_count] = window;
+    if (wm->egl_ctx->ctx == EGL_NO_CONTEXT)
+    {
+        glps_egl_create_ctx(wm);
+        glps_egl_make_ctx_current(wm, wm->window_count);
+    }
 
-    XMapWindow(wm->x11_ctx->display, wm->windows[wm->window_count]->window);
     return wm->window_count++;
 }
 
+void glps_x11_window_destroy(glps_WindowManager *wm, size_t window_id)
+{
+    glps_X11Window *window = wm->windows[window_id];
+    xcb_connection_t *connection = wm->x11_ctx->connection;
+
+    if (window->software)
+    {
+        for (size_t i = 0; i < GLPS_SHM_BUFFERS; ++i)
+        {
+            __x11_shm_buffer_destroy(wm->x11_ctx, &window->shm_buffers[i]);
+        }
+        xcb_free_gc(connection, window->gc);
+    }
+    else
+    {
+        if (eglGetCurrentSurface(EGL_DRAW) == window->egl_surface)
+        {
+            eglMakeCurrent(wm->egl_ctx->dpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                           EGL_NO_CONTEXT);
+        }
+        eglDestroySurface(wm->egl_ctx->dpy, window->egl_surface);
+    }
+    xcb_destroy_window(connection, window->window);
+    xcb_free_colormap(connection, window->colormap);
+    free(window);
+
+    for (size_t i = window_id; i < wm->window_count - 1; ++i)
+    {
+        wm->windows[i] = wm->windows[i + 1];
+    }
+    wm->window_count--;
+
+    if (wm->window_count == 0)
+    {
+        LOG_INFO("All windows destroyed. Exiting program.");
+    }
+}
+
+int glps_x11_get_fd(glps_WindowManager *wm)
+{
+    return xcb_get_file_descriptor(wm->x11_ctx->connection);
+}
+
+int glps_x11_dispatch(glps_WindowManager *wm, int timeout_ms)
+{
+    xcb_connection_t *connection = wm->x11_ctx->connection;
+
+    // Windows waiting for their frame callback don't let the wait block.
+    for (size_t i = 0; i < wm->window_count; ++i)
+    {
+        if (wm->windows[i]->frame_pending)
+        {
+            timeout_ms = 0;
+            break;
+        }
+    }
+
+    xcb_flush(connection);
+
+    // Replies awaited since the last dispatch may have queued events that
+    // the socket no longer signals.
+    xcb_generic_event_t *event = xcb_poll_for_queued_event(connection);
+    if (event == NULL && timeout_ms != 0)
+    {
+        struct pollfd fd = {.fd = xcb_get_file_descriptor(connection),
+                            .events = POLLIN};
+        int ret;
+        while ((ret = poll(&fd, 1, timeout_ms)) < 0 && errno == EINTR)
+        {
+        }
+        if (ret < 0)
+        {
+            LOG_ERROR("Failed to wait for X events: %s", strerror(errno));
+            return -1;
+        }
+    }
+    if (event == NULL)
+    {
+        // Reads the socket once, the rest is drained from the queue.
+        event = xcb_poll_for_event(connection);
+    }
+
+    // Everything queued is handled before any frame is drawn.
+    glps_X11Context *ctx = wm->x11_ctx;
+    int count = 0;
+    while (event != NULL)
+    {
+        xcb_generic_event_t *next = xcb_poll_for_queued_event(connection);
+        if (__x11_is_key_repeat(event, next))
+        {
+            free(event);
+            free(next);
+            event = xcb_poll_for_queued_event(connection);
+            continue;
+        }
+
+        if (__x11_is_superseded_motion(ctx, event, next))
+        {
+            // The oldest motion still starts the latency sample.
+            xcb_window_t window;
+            xcb_timestamp_t time;
+            uint16_t device;
+            __x11_get_motion(ctx, event, &window, &time, &device);
+            ssize_t window_id = __x11_get_window_id(wm, window);
+            if (window_id >= 0)
+            {
+                __x11_stamp_input(wm, window_id, time);
+#ifdef GLPS_HAVE_XINPUT2
+                // Scrolling rides on XInput2 motion and isn't dropped with it.
+                if (device != 0)
+                {
+                    __x11_xi_set_input_device(
+                        wm, ((xcb_input_motion_event_t *)event)->sourceid);
+                    __x11_xi_scroll(wm, window_id,
+                                    (xcb_input_motion_event_t *)event);
+                }
+#endif
+            }
+            free(event);
+            event = next;
+            continue;
+        }
+
+        __x11_handle_event(wm, event);
+        free(event);
+        count++;
+        event = next;
+    }
+
+    if (xcb_connection_has_error(connection))
+    {
+        LOG_ERROR("Connection to the X server failed.");
+        return -1;
+    }
+
+#ifdef GLPS_HAVE_XINPUT2
+    __x11_xi_flush_raw_motion(wm);
+#endif
+
+    // Layout follows the latest size once, before the frame that shows it.
+    for (size_t i = 0; i < wm->window_count; ++i)
+    {
+        glps_X11Window *window = wm->windows[i];
+        if (!window->resize_pending)
+        {
+            continue;
+        }
+        window->resize_pending = false;
+        window->frame_pending = true;
+        if (wm->callbacks.window_resize_callback)
+        {
+            int width = 0, height = 0;
+            glps_resolution_scaled_size(window->properties.render_scale,
+                                        window->properties.width,
+                                        window->properties.height, &width,
+                                        &height);
+            wm->callbacks.window_resize_callback(
+                i, width, height, wm->callbacks.window_resize_data);
+        }
+    }
+
+    for (size_t i = 0; i < wm->window_count; ++i)
+    {
+        if (!wm->windows[i]->frame_pending)
+        {
+            continue;
+        }
+        wm->windows[i]->frame_pending = false;
+        if (wm->callbacks.window_frame_update_callback)
+        {
+            PERF_SCOPE("frame_update_callback");
+            wm->callbacks.window_frame_update_callback(
+                i, wm->callbacks.window_frame_update_data);
+        }
+    }
+
+    return count;
+}
+
 bool glps_x11_should_close(glps_WindowManager *wm)
 {
     if (wm == NULL)
@@ -85,26 +1451,202 @@ bool glps_x11_should_close(glps_WindowManager *wm)
         exit(EXIT_FAILURE);
     }
 
-    XEvent event;
+    int result;
+    {
+        PERF_SCOPE("x11_dispatch");
+        result = glps_x11_dispatch(wm, -1);
+    }
+
+    return result < 0 || wm->window_count == 0;
+}
+
+void glps_x11_swap_buffers(glps_WindowManager *wm, size_t window_id)
+{
+    glps_egl_swap_buffers(wm, window_id);
+    // Stands in for the Wayland frame callback, the swap interval paces it.
+    wm->windows[window_id]->frame_pending = true;
+}
+
+glps_PixelBuffer glps_x11_window_map_pixels(glps_WindowManager *wm,
+                                            size_t window_id)
+{
+    glps_X11Window *window = wm->windows[window_id];
+    glps_PixelBuffer pixels = {0};
 
-    if (XPending(wm->x11_ctx->display) > 0)
+    if (window->shm_mapped == NULL)
     {
-        XNextEvent(wm->x11_ctx->display, &event);
+        // The free buffer presented last needs the least redrawing.
+        glps_X11ShmBuffer *buffer = NULL;
+        for (size_t i = 0; i < GLPS_SHM_BUFFERS; ++i)
+        {
+            glps_X11ShmBuffer *candidate = &window->shm_buffers[i];
+            if (!candidate->busy &&
+                (buffer == NULL || candidate->frame > buffer->frame))
+            {
+                buffer = candidate;
+            }
+        }
+        if (buffer == NULL)
+        {
+            LOG_WARNING("Every buffer of window %zu is still read by the "
+                        "server.",
+                        window_id);
+            return pixels;
+        }
 
-        if (event.type == ClientMessage && event.xclient.data.l[0] == wm->x11_ctx->wm_delete_window)
+        if (buffer->pixels == NULL ||
+            buffer->width != window->properties.width ||
+            buffer->height != window->properties.height)
         {
-            return true;
+            if (!__x11_shm_buffer_create(wm->x11_ctx, buffer,
+                                         window->properties.width,
+                                         window->properties.height))
+            {
+                return pixels;
+            }
         }
+        window->shm_mapped = buffer;
+    }
+
+    glps_X11ShmBuffer *buffer = window->shm_mapped;
+    pixels.pixels = buffer->pixels;
+    pixels.width = buffer->width;
+    pixels.height = buffer->height;
+    pixels.stride = buffer->width;
+    pixels.age = buffer->frame != 0
+                     ? (int)(window->shm_frame - buffer->frame + 1)
+                     : 0;
+    return pixels;
+}
+
+// Clips a damage rectangle to the buffer, false if nothing is left.
+static bool __x11_clip_rect(const glps_X11ShmBuffer *buffer,
+                            const glps_Rect *rect, glps_Rect *clipped)
+{
+    int x0 = rect->x > 0 ? rect->x : 0;
+    int y0 = rect->y > 0 ? rect->y : 0;
+    int x1 = rect->x + rect->width;
+    int y1 = rect->y + rect->height;
+    x1 = x1 < buffer->width ? x1 : buffer->width;
+    y1 = y1 < buffer->height ? y1 : buffer->height;
+    *clipped = (glps_Rect){x0, y0, x1 - x0, y1 - y0};
+    return x1 > x0 && y1 > y0;
+}
+
+// Without MIT-SHM whole rows go out in as few requests as the server takes.
+static void __x11_put_rows(glps_X11Context *ctx, glps_X11Window *window,
+                           const glps_X11ShmBuffer *buffer, int y, int height)
+{
+    uint8_t depth = __x11_visual_depth(ctx->screen, ctx->screen->root_visual);
+    size_t row_size = (size_t)buffer->width * sizeof(uint32_t);
+    // Maximum length is in 4-byte units and includes the 24-byte header.
+    size_t max_size =
+        (size_t)xcb_get_maximum_request_length(ctx->connection) * 4 - 24;
+    int rows = (int)(max_size / row_size);
+    if (rows < 1)
+    {
+        LOG_ERROR("Software window too wide for a put-image request.");
+        return;
+    }
+
+    for (int row = y; row < y + height; row += rows)
+    {
+        int count = row + rows < y + height ? rows : y + height - row;
+        xcb_put_image(ctx->connection, XCB_IMAGE_FORMAT_Z_PIXMAP,
+                      window->window, window->gc, buffer->width, count, 0,
+                      row, 0, depth, row_size * count,
+                      (const uint8_t *)(buffer->pixels +
+                                        (size_t)row * buffer->width));
+    }
+}
 
+bool glps_x11_window_present_pixels(glps_WindowManager *wm, size_t window_id,
+                                    const glps_Rect *damage,
+                                    size_t damage_count)
+{
+    glps_X11Context *ctx = wm->x11_ctx;
+    glps_X11Window *window = wm->windows[window_id];
+    glps_X11ShmBuffer *buffer = window->shm_mapped;
+    if (buffer == NULL)
+    {
+        LOG_ERROR("No pixels of window %zu are mapped.", window_id);
         return false;
     }
+
+    // The server keeps no copy of what was exposed.
+    glps_Rect whole = {0, 0, buffer->width, buffer->height};
+    if (damage == NULL || damage_count == 0 || buffer->frame == 0 ||
+        window->exposed)
+    {
+        damage = &whole;
+        damage_count = 1;
+    }
+    window->exposed = false;
+
+#ifdef GLPS_HAVE_XCB_SHM
+    if (buffer->segment != 0)
+    {
+        // Only the last put reports completion, the server works in order.
+        size_t last = damage_count;
+        glps_Rect rect;
+        for (size_t i = 0; i < damage_count; ++i)
+        {
+            if (__x11_clip_rect(buffer, &damage[i], &rect))
+            {
+                last = i;
+            }
+        }
+        for (size_t i = 0; i < damage_count; ++i)
+        {
+            if (!__x11_clip_rect(buffer, &damage[i], &rect))
+            {
+                continue;
+            }
+            xcb_shm_put_image(
+                ctx->connection, window->window, window->gc, buffer->width,
+                buffer->height, rect.x, rect.y, rect.width, rect.height,
+                rect.x, rect.y,
+                __x11_visual_depth(ctx->screen, ctx->screen->root_visual),
+                XCB_IMAGE_FORMAT_Z_PIXMAP, i == last, buffer->segment, 0);
+        }
+        // The completion event asks for the next frame.
+        buffer->busy = last != damage_count;
+        if (!buffer->busy)
+        {
+            window->frame_pending = true;
+        }
+    }
+    else
+#endif
+    {
+        glps_Rect rect;
+        for (size_t i = 0; i < damage_count; ++i)
+        {
+            if (__x11_clip_rect(buffer, &damage[i], &rect))
+            {
+                __x11_put_rows(ctx, window, buffer, rect.y, rect.height);
+            }
+        }
+        // The pixels were copied into the requests, the buffer is free.
+        window->frame_pending = true;
+    }
+
+    buffer->frame = ++window->shm_frame;
+    window->shm_mapped = NULL;
+    xcb_flush(ctx->connection);
+    return true;
 }
 
 void glps_x11_window_update(glps_WindowManager *wm, size_t window_id)
 {
-    XFlush(wm->x11_ctx->display);
+    wm->windows[window_id]->frame_pending = true;
+}
 
-    XClearWindow(wm->x11_ctx->display, wm->windows[window_id]->window);
+void glps_x11_get_window_dimensions(glps_WindowManager *wm, size_t window_id,
+                                    int *width, int *height)
+{
+    *width = wm->windows[window_id]->properties.width;
+    *height = wm->windows[window_id]->properties.height;
 }
 
 void glps_x11_destroy(glps_WindowManager *wm)
@@ -112,43 +1654,32 @@ void glps_x11_destroy(glps_WindowManager *wm)
 
     if (wm->windows)
     {
-        for (size_t i = 0; i < wm->window_count; ++i)
+        while (wm->window_count > 0)
         {
-            if (wm->windows[i]->window)
-            {
-                XDestroyWindow(wm->x11_ctx->display, wm->windows[i]->window);
-            }
-            free(wm->windows[i]);
-            wm->windows[i] = NULL;
+            glps_x11_window_destroy(wm, wm->window_count - 1);
         }
         free(wm->windows);
         wm->windows = NULL;
     }
 
+    if (wm->egl_ctx)
+    {
+        glps_egl_destroy(wm);
+    }
+
     if (wm->x11_ctx)
     {
-        if (wm->x11_ctx->font)
-        {
-            XFreeFont(wm->x11_ctx->display, wm->x11_ctx->font);
-        }
-        if (wm->x11_ctx->display)
+        if (wm->x11_ctx->egl_display)
         {
-            XCloseDisplay(wm->x11_ctx->display);
+            XCloseDisplay(wm->x11_ctx->egl_display);
         }
-        if(wm->x11_ctx->gc)
+        if (wm->x11_ctx->connection)
         {
-            XFreeGC(wm->x11_ctx->display, wm->x11_ctx->gc);
+            xcb_disconnect(wm->x11_ctx->connection);
         }
 
+        free(wm->x11_ctx->keysyms);
         free(wm->x11_ctx);
         wm->x11_ctx=NULL;
     }
 }
-void glps_x11_get_window_dimensions(glps_WindowManager *wm, size_t window_id,
-                                    int *width, int *height);
-
-void glps_x11_attach_to_clipboard(glps_WindowManager *wm, char *mime,
-                                  char *data);
-
-void glps_x11_get_from_clipboard(glps_WindowManager *wm, char *data,
-                                 size_t data_size);
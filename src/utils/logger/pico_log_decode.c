@@ -0,0 +1,383 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Offline decoder for binary logs written by save_binary_log_file().
+ *
+ * Usage: pico_log_decode <binary log> [output file]
+ *
+ * Prints one line per record in the same layout as save_log_file().
+ */
+
+#include "utils/logger/pico_log_format.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct
+{
+    uint64_t address;
+    char *value;
+} LogString;
+
+typedef struct
+{
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+} Reader;
+
+static LogString *strings = NULL;
+static uint32_t string_count = 0;
+
+static const char *level_names[] = {"INFO", "WARNING", "ERROR", "CRITICAL"};
+
+static int read_bytes(Reader *reader, void *out, size_t size)
+{
+    if (reader->size - reader->offset < size)
+    {
+        return 0;
+    }
+    memcpy(out, reader->data + reader->offset, size);
+    reader->offset += size;
+    return 1;
+}
+
+static const char *lookup_string(uint64_t address)
+{
+    size_t low = 0, high = string_count;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (strings[mid].address == address)
+        {
+            return strings[mid].value;
+        }
+        if (strings[mid].address < address)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return "?";
+}
+
+static int read_arg(Reader *payload, uint8_t expected, void *value, char **string)
+{
+    uint8_t tag;
+    if (!read_bytes(payload, &tag, sizeof(tag)))
+    {
+        return 0;
+    }
+
+    if (tag == PICO_LOG_ARG_STRING)
+    {
+        uint32_t length;
+        if (!read_bytes(payload, &length, sizeof(length)) || payload->size - payload->offset < length)
+        {
+            return 0;
+        }
+        if (string)
+        {
+            *string = malloc((size_t)length + 1);
+            if (!*string)
+            {
+                return 0;
+            }
+            memcpy(*string, payload->data + payload->offset, length);
+            (*string)[length] = '\0';
+        }
+        payload->offset += length;
+        return expected == PICO_LOG_ARG_STRING;
+    }
+
+    uint64_t raw;
+    if (!read_bytes(payload, &raw, sizeof(raw)))
+    {
+        return 0;
+    }
+    memcpy(value, &raw, sizeof(raw));
+    return expected == 0 || tag == expected ||
+           ((tag == PICO_LOG_ARG_INT || tag == PICO_LOG_ARG_UINT) &&
+            (expected == PICO_LOG_ARG_INT || expected == PICO_LOG_ARG_UINT));
+}
+
+static void append(char *out, size_t out_size, size_t *used, const char *text, size_t length)
+{
+    if (*used + 1 >= out_size)
+    {
+        return;
+    }
+    size_t room = out_size - *used - 1;
+    if (length > room)
+    {
+        length = room;
+    }
+    memcpy(out + *used, text, length);
+    *used += length;
+    out[*used] = '\0';
+}
+
+static void format_message(const char *fmt, Reader *payload, char *out, size_t out_size)
+{
+    size_t used = 0;
+    out[0] = '\0';
+
+    for (const char *p = fmt; *p != '\0'; ++p)
+    {
+        if (*p != '%')
+        {
+            append(out, out_size, &used, p, 1);
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            append(out, out_size, &used, "%", 1);
+            ++p;
+            continue;
+        }
+
+        /* Rebuild the conversion with '*' resolved and the length forced to ll. */
+        char spec[64] = "%";
+        size_t spec_length = 1;
+        ++p;
+        while (*p != '\0' && strchr("-+ #0'.*0123456789", *p) && spec_length < 40)
+        {
+            if (*p == '*')
+            {
+                int64_t star = 0;
+                read_arg(payload, PICO_LOG_ARG_INT, &star, NULL);
+                spec_length += (size_t)snprintf(spec + spec_length, sizeof(spec) - spec_length, "%d", (int)star);
+            }
+            else
+            {
+                spec[spec_length++] = *p;
+            }
+            ++p;
+        }
+        while (*p != '\0' && strchr("hlqjztL", *p))
+        {
+            ++p;
+        }
+        if (*p == '\0')
+        {
+            break;
+        }
+
+        char text[1024];
+        char conversion = *p;
+        text[0] = '\0';
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        {
+            int64_t value = 0;
+            read_arg(payload, PICO_LOG_ARG_INT, &value, NULL);
+            snprintf(spec + spec_length, sizeof(spec) - spec_length, "ll%c", conversion);
+            if (conversion == 'd' || conversion == 'i')
+            {
+                snprintf(text, sizeof(text), spec, (long long)value);
+            }
+            else
+            {
+                snprintf(text, sizeof(text), spec, (unsigned long long)value);
+            }
+            break;
+        }
+        case 'c':
+        {
+            int64_t value = 0;
+            read_arg(payload, PICO_LOG_ARG_INT, &value, NULL);
+            snprintf(spec + spec_length, sizeof(spec) - spec_length, "c");
+            snprintf(text, sizeof(text), spec, (int)value);
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            double value = 0.0;
+            read_arg(payload, PICO_LOG_ARG_DOUBLE, &value, NULL);
+            snprintf(spec + spec_length, sizeof(spec) - spec_length, "%c", conversion);
+            snprintf(text, sizeof(text), spec, value);
+            break;
+        }
+        case 's':
+        {
+            char *value = NULL;
+            read_arg(payload, PICO_LOG_ARG_STRING, NULL, &value);
+            snprintf(spec + spec_length, sizeof(spec) - spec_length, "s");
+            snprintf(text, sizeof(text), spec, value ? value : "?");
+            free(value);
+            break;
+        }
+        case 'p':
+        {
+            uint64_t value = 0;
+            read_arg(payload, PICO_LOG_ARG_POINTER, &value, NULL);
+            snprintf(text, sizeof(text), "0x%llx", (unsigned long long)value);
+            break;
+        }
+        default:
+            break;
+        }
+        append(out, out_size, &used, text, strlen(text));
+    }
+}
+
+static int compare_strings(const void *a, const void *b)
+{
+    uint64_t lhs = ((const LogString *)a)->address;
+    uint64_t rhs = ((const LogString *)b)->address;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <binary log> [output file]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in)
+    {
+        perror("Failed to open binary log");
+        return EXIT_FAILURE;
+    }
+    fseek(in, 0, SEEK_END);
+    long file_size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    if (file_size < 0)
+    {
+        perror("Failed to get binary log size");
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    unsigned char *data = malloc((size_t)file_size + 1);
+    if (!data || fread(data, 1, (size_t)file_size, in) != (size_t)file_size)
+    {
+        perror("Failed to read binary log");
+        free(data);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+    fclose(in);
+
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out)
+    {
+        perror("Failed to open output file");
+        free(data);
+        return EXIT_FAILURE;
+    }
+
+    Reader reader = {data, (size_t)file_size, 0};
+    char magic[PICO_LOG_BINARY_MAGIC_SIZE];
+    if (!read_bytes(&reader, magic, sizeof(magic)) ||
+        memcmp(magic, PICO_LOG_BINARY_MAGIC, PICO_LOG_BINARY_MAGIC_SIZE) != 0 ||
+        !read_bytes(&reader, &string_count, sizeof(string_count)))
+    {
+        fprintf(stderr, "%s is not a binary log file.\n", argv[1]);
+        free(data);
+        return EXIT_FAILURE;
+    }
+
+    strings = calloc(string_count ? string_count : 1, sizeof(LogString));
+    for (uint32_t i = 0; strings && i < string_count; i++)
+    {
+        uint32_t length;
+        if (!read_bytes(&reader, &strings[i].address, sizeof(uint64_t)) ||
+            !read_bytes(&reader, &length, sizeof(length)) ||
+            reader.size - reader.offset < length)
+        {
+            fprintf(stderr, "Truncated string table.\n");
+            return EXIT_FAILURE;
+        }
+        strings[i].value = malloc((size_t)length + 1);
+        memcpy(strings[i].value, reader.data + reader.offset, length);
+        strings[i].value[length] = '\0';
+        reader.offset += length;
+    }
+    qsort(strings, string_count, sizeof(LogString), compare_strings);
+
+    uint64_t records_size = 0;
+    read_bytes(&reader, &records_size, sizeof(records_size));
+    if (records_size > reader.size - reader.offset)
+    {
+        records_size = reader.size - reader.offset;
+    }
+    size_t records_end = reader.offset + (size_t)records_size;
+
+    while (reader.offset + sizeof(PicoLogRecord) <= records_end)
+    {
+        PicoLogRecord record;
+        read_bytes(&reader, &record, sizeof(record));
+        if (record.payload_size > records_end - reader.offset)
+        {
+            fprintf(stderr, "Truncated record.\n");
+            break;
+        }
+
+        Reader payload = {reader.data + reader.offset, record.payload_size, 0};
+        reader.offset += record.payload_size;
+
+        char message[4096];
+        format_message(lookup_string(record.fmt), &payload, message, sizeof(message));
+
+        time_t seconds = (time_t)(record.timestamp_ns / 1000000000ull);
+        char time_buffer[20];
+        strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+
+        fprintf(out, "[%s] %s [%s:%u] %s: %s\n", time_buffer,
+                record.level < 4 ? level_names[record.level] : "UNKNOWN",
+                lookup_string(record.file), record.line, lookup_string(record.func), message);
+    }
+
+    for (uint32_t i = 0; strings && i < string_count; i++)
+    {
+        free(strings[i].value);
+    }
+    free(strings);
+    free(data);
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return EXIT_SUCCESS;
+}
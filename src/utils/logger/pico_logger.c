@@ -21,15 +21,18 @@
  */
 
 #include "utils/logger/pico_logger.h"
+#include "utils/logger/pico_log_format.h"
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include "utils/profiler/pico_profiler.h"
 #ifdef GLPS_USE_WAYLAND
 
 #include <execinfo.h>
-static struct timespec start_time = {0};
 
 #endif
 #include <unistd.h>
@@ -46,8 +49,30 @@ static LogEntry *log_entries = NULL;
 static size_t log_capacity = 0;
 static size_t log_count = 0;
 
+static unsigned char *binary_log = NULL;
+static size_t binary_log_capacity = 0;
+static size_t binary_log_size = 0;
+
+/* Render and input threads log too. Sections are short, file I/O happens
+   outside, so a spinlock keeps the logger free of a threading library on
+   every platform. */
+static atomic_flag log_lock = ATOMIC_FLAG_INIT;
+
+static void lock_log(void)
+{
+    while (atomic_flag_test_and_set_explicit(&log_lock, memory_order_acquire))
+    {
+    }
+}
+
+static void unlock_log(void)
+{
+    atomic_flag_clear_explicit(&log_lock, memory_order_release);
+}
+
 void add_log_entry(const char *log_message)
 {
+    lock_log();
     if (log_count == log_capacity)
     {
 
@@ -69,10 +94,12 @@ void add_log_entry(const char *log_message)
         exit(EXIT_FAILURE);
     }
     log_count++;
+    unlock_log();
 }
 
 void free_log_entries()
 {
+    lock_log();
     for (size_t i = 0; i < log_count; i++)
     {
         free(log_entries[i].message);
@@ -80,6 +107,63 @@ void free_log_entries()
     free(log_entries);
     log_entries = NULL;
     log_capacity = log_count = 0;
+
+    free(binary_log);
+    binary_log = NULL;
+    binary_log_capacity = binary_log_size = 0;
+    unlock_log();
+}
+
+static void binary_log_append(const void *data, size_t size)
+{
+    if (binary_log_size + size > binary_log_capacity)
+    {
+        size_t new_capacity = binary_log_capacity == 0 ? 4096 : binary_log_capacity;
+        while (new_capacity < binary_log_size + size)
+        {
+            new_capacity *= 2;
+        }
+        unsigned char *new_log = realloc(binary_log, new_capacity);
+        if (!new_log)
+        {
+            perror("Failed to allocate memory for binary log");
+            exit(EXIT_FAILURE);
+        }
+        binary_log = new_log;
+        binary_log_capacity = new_capacity;
+    }
+
+    memcpy(binary_log + binary_log_size, data, size);
+    binary_log_size += size;
+}
+
+static void binary_log_append_arg(PicoLogArgTag tag, const void *value, size_t size)
+{
+    uint8_t tag_byte = (uint8_t)tag;
+    binary_log_append(&tag_byte, sizeof(tag_byte));
+    binary_log_append(value, size);
+}
+
+static void binary_log_append_int(int64_t value)
+{
+    binary_log_append_arg(PICO_LOG_ARG_INT, &value, sizeof(value));
+}
+
+static void binary_log_append_uint(uint64_t value)
+{
+    binary_log_append_arg(PICO_LOG_ARG_UINT, &value, sizeof(value));
+}
+
+static void binary_log_append_string(const char *value)
+{
+    if (!value)
+    {
+        value = "(null)";
+    }
+    size_t length = strlen(value);
+    uint32_t size = length > UINT32_MAX ? UINT32_MAX : (uint32_t)length;
+    binary_log_append_arg(PICO_LOG_ARG_STRING, &size, sizeof(size));
+    binary_log_append(value, size);
 }
 
 void log_message(DebugLevel level, const char *file, int line, const char *func, const char *fmt, ...)
@@ -136,6 +220,237 @@ void log_message(DebugLevel level, const char *file, int line, const char *func,
     add_log_entry(full_log);
 }
 
+typedef enum
+{
+    LENGTH_NONE,
+    LENGTH_HH,
+    LENGTH_H,
+    LENGTH_L,
+    LENGTH_LL,
+    LENGTH_J,
+    LENGTH_Z,
+    LENGTH_T,
+    LENGTH_LONG_DOUBLE
+} ArgLength;
+
+static const char *parse_length(const char *p, ArgLength *length)
+{
+    switch (*p)
+    {
+    case 'h':
+        if (p[1] == 'h')
+        {
+            *length = LENGTH_HH;
+            return p + 2;
+        }
+        *length = LENGTH_H;
+        return p + 1;
+    case 'l':
+        if (p[1] == 'l')
+        {
+            *length = LENGTH_LL;
+            return p + 2;
+        }
+        *length = LENGTH_L;
+        return p + 1;
+    case 'q':
+        *length = LENGTH_LL;
+        return p + 1;
+    case 'j':
+        *length = LENGTH_J;
+        return p + 1;
+    case 'z':
+        *length = LENGTH_Z;
+        return p + 1;
+    case 't':
+        *length = LENGTH_T;
+        return p + 1;
+    case 'L':
+        *length = LENGTH_LONG_DOUBLE;
+        return p + 1;
+    default:
+        *length = LENGTH_NONE;
+        return p;
+    }
+}
+
+void log_binary(DebugLevel level, const char *file, int line, const char *func, const char *fmt, ...)
+{
+    if (!logging_enabled || level < min_log_level || fmt == NULL)
+    {
+        return;
+    }
+
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+
+    PicoLogRecord record = {0};
+    record.timestamp_ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+    record.fmt = (uint64_t)(uintptr_t)fmt;
+    record.file = (uint64_t)(uintptr_t)file;
+    record.func = (uint64_t)(uintptr_t)func;
+    record.line = (uint32_t)line;
+    record.level = (uint8_t)level;
+
+    lock_log();
+    size_t record_offset = binary_log_size;
+    binary_log_append(&record, sizeof(record));
+
+    va_list args;
+    va_start(args, fmt);
+    for (const char *p = fmt; *p != '\0'; ++p)
+    {
+        if (*p != '%')
+        {
+            continue;
+        }
+        ++p;
+        if (*p == '%')
+        {
+            continue;
+        }
+
+        while (*p != '\0' && strchr("-+ #0'", *p))
+        {
+            ++p;
+        }
+        if (*p == '*')
+        {
+            binary_log_append_int(va_arg(args, int));
+            record.arg_count++;
+            ++p;
+        }
+        while (*p >= '0' && *p <= '9')
+        {
+            ++p;
+        }
+        if (*p == '.')
+        {
+            ++p;
+            if (*p == '*')
+            {
+                binary_log_append_int(va_arg(args, int));
+                record.arg_count++;
+                ++p;
+            }
+            while (*p >= '0' && *p <= '9')
+            {
+                ++p;
+            }
+        }
+
+        ArgLength length;
+        p = parse_length(p, &length);
+        if (*p == '\0')
+        {
+            break;
+        }
+
+        switch (*p)
+        {
+        case 'd':
+        case 'i':
+            switch (length)
+            {
+            case LENGTH_HH:
+                binary_log_append_int((signed char)va_arg(args, int));
+                break;
+            case LENGTH_H:
+                binary_log_append_int((short)va_arg(args, int));
+                break;
+            case LENGTH_L:
+                binary_log_append_int(va_arg(args, long));
+                break;
+            case LENGTH_LL:
+                binary_log_append_int(va_arg(args, long long));
+                break;
+            case LENGTH_J:
+                binary_log_append_int(va_arg(args, intmax_t));
+                break;
+            case LENGTH_Z:
+                binary_log_append_int((int64_t)va_arg(args, size_t));
+                break;
+            case LENGTH_T:
+                binary_log_append_int(va_arg(args, ptrdiff_t));
+                break;
+            default:
+                binary_log_append_int(va_arg(args, int));
+                break;
+            }
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            switch (length)
+            {
+            case LENGTH_HH:
+                binary_log_append_uint((unsigned char)va_arg(args, unsigned int));
+                break;
+            case LENGTH_H:
+                binary_log_append_uint((unsigned short)va_arg(args, unsigned int));
+                break;
+            case LENGTH_L:
+                binary_log_append_uint(va_arg(args, unsigned long));
+                break;
+            case LENGTH_LL:
+                binary_log_append_uint(va_arg(args, unsigned long long));
+                break;
+            case LENGTH_J:
+                binary_log_append_uint(va_arg(args, uintmax_t));
+                break;
+            case LENGTH_Z:
+                binary_log_append_uint(va_arg(args, size_t));
+                break;
+            case LENGTH_T:
+                binary_log_append_uint((uint64_t)va_arg(args, ptrdiff_t));
+                break;
+            default:
+                binary_log_append_uint(va_arg(args, unsigned int));
+                break;
+            }
+            break;
+        case 'c':
+            binary_log_append_int(va_arg(args, int));
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            double value = length == LENGTH_LONG_DOUBLE ? (double)va_arg(args, long double)
+                                                        : va_arg(args, double);
+            binary_log_append_arg(PICO_LOG_ARG_DOUBLE, &value, sizeof(value));
+            break;
+        }
+        case 's':
+            binary_log_append_string(va_arg(args, const char *));
+            break;
+        case 'p':
+        {
+            uint64_t value = (uint64_t)(uintptr_t)va_arg(args, void *);
+            binary_log_append_arg(PICO_LOG_ARG_POINTER, &value, sizeof(value));
+            break;
+        }
+        case 'n':
+            (void)va_arg(args, void *);
+            continue;
+        default:
+            continue;
+        }
+        record.arg_count++;
+    }
+    va_end(args);
+
+    record.payload_size = (uint32_t)(binary_log_size - record_offset - sizeof(record));
+    memcpy(binary_log + record_offset, &record, sizeof(record));
+    unlock_log();
+}
+
 void set_logging_enabled(bool enabled)
 {
     logging_enabled = enabled;
@@ -146,6 +461,58 @@ void set_minimum_log_level(DebugLevel level)
     min_log_level = level;
 }
 
+/* Saving takes the log out of the lock for the file I/O, entries logged
+   meanwhile are appended to it when it is put back. */
+static void restore_log_entries(LogEntry *entries, size_t count, size_t capacity)
+{
+    lock_log();
+    if (count + log_count > capacity)
+    {
+        capacity = count + log_count;
+        LogEntry *new_entries = realloc(entries, capacity * sizeof(LogEntry));
+        if (!new_entries)
+        {
+            perror("Failed to allocate memory for log entries");
+            exit(EXIT_FAILURE);
+        }
+        entries = new_entries;
+    }
+    if (log_count > 0)
+    {
+        memcpy(entries + count, log_entries, log_count * sizeof(LogEntry));
+    }
+    free(log_entries);
+    log_entries = entries;
+    log_count += count;
+    log_capacity = capacity;
+    unlock_log();
+}
+
+static void restore_binary_log(unsigned char *records, size_t size, size_t capacity)
+{
+    lock_log();
+    if (size + binary_log_size > capacity)
+    {
+        capacity = size + binary_log_size;
+        unsigned char *new_log = realloc(records, capacity);
+        if (!new_log)
+        {
+            perror("Failed to allocate memory for binary log");
+            exit(EXIT_FAILURE);
+        }
+        records = new_log;
+    }
+    if (binary_log_size > 0)
+    {
+        memcpy(records + size, binary_log, binary_log_size);
+    }
+    free(binary_log);
+    binary_log = records;
+    binary_log_size += size;
+    binary_log_capacity = capacity;
+    unlock_log();
+}
+
 void save_log_file(const char *path)
 {
     FILE *fp = fopen(path, "w");
@@ -155,12 +522,113 @@ void save_log_file(const char *path)
         return;
     }
 
-    for (size_t i = 0; i < log_count; i++)
+    lock_log();
+    LogEntry *entries = log_entries;
+    size_t count = log_count;
+    size_t capacity = log_capacity;
+    log_entries = NULL;
+    log_count = log_capacity = 0;
+    unlock_log();
+
+    for (size_t i = 0; i < count; i++)
     {
-        fprintf(fp, "%s\n", log_entries[i].message);
+        fprintf(fp, "%s\n", entries[i].message);
     }
+    fclose(fp);
 
+    restore_log_entries(entries, count, capacity);
+}
+
+static int compare_addresses(const void *a, const void *b)
+{
+    uint64_t lhs = *(const uint64_t *)a;
+    uint64_t rhs = *(const uint64_t *)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+void save_binary_log_file(const char *path)
+{
+    size_t address_count = 0;
+    size_t address_capacity = 64;
+    uint64_t *addresses = malloc(address_capacity * sizeof(uint64_t));
+    if (!addresses)
+    {
+        perror("Failed to allocate memory for binary log strings");
+        return;
+    }
+
+    lock_log();
+    unsigned char *records = binary_log;
+    size_t size = binary_log_size;
+    size_t capacity = binary_log_capacity;
+    binary_log = NULL;
+    binary_log_size = binary_log_capacity = 0;
+    unlock_log();
+
+    for (size_t offset = 0; offset < size;)
+    {
+        PicoLogRecord record;
+        memcpy(&record, records + offset, sizeof(record));
+        if (address_count + 3 > address_capacity)
+        {
+            address_capacity *= 2;
+            uint64_t *new_addresses = realloc(addresses, address_capacity * sizeof(uint64_t));
+            if (!new_addresses)
+            {
+                perror("Failed to allocate memory for binary log strings");
+                restore_binary_log(records, size, capacity);
+                free(addresses);
+                return;
+            }
+            addresses = new_addresses;
+        }
+        addresses[address_count++] = record.fmt;
+        addresses[address_count++] = record.file;
+        addresses[address_count++] = record.func;
+        offset += sizeof(record) + record.payload_size;
+    }
+
+    qsort(addresses, address_count, sizeof(uint64_t), compare_addresses);
+    size_t unique_count = 0;
+    for (size_t i = 0; i < address_count; i++)
+    {
+        if (addresses[i] != 0 && (unique_count == 0 || addresses[unique_count - 1] != addresses[i]))
+        {
+            addresses[unique_count++] = addresses[i];
+        }
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp)
+    {
+        perror("Failed to open binary log file");
+        restore_binary_log(records, size, capacity);
+        free(addresses);
+        return;
+    }
+
+    uint32_t string_count = (uint32_t)unique_count;
+    fwrite(PICO_LOG_BINARY_MAGIC, 1, PICO_LOG_BINARY_MAGIC_SIZE, fp);
+    fwrite(&string_count, sizeof(string_count), 1, fp);
+    for (size_t i = 0; i < unique_count; i++)
+    {
+        const char *string = (const char *)(uintptr_t)addresses[i];
+        uint32_t length = (uint32_t)strlen(string);
+        fwrite(&addresses[i], sizeof(addresses[i]), 1, fp);
+        fwrite(&length, sizeof(length), 1, fp);
+        fwrite(string, 1, length, fp);
+    }
+
+    uint64_t records_size = size;
+    fwrite(&records_size, sizeof(records_size), 1, fp);
+    if (size > 0)
+    {
+        fwrite(records, 1, size, fp);
+    }
     fclose(fp);
+    free(addresses);
+
+    restore_binary_log(records, size, capacity);
 }
 
 void print_stack_trace(void)
@@ -199,64 +667,22 @@ void dump_memory(const char *label, const void *buffer, size_t size)
 
 
 
-#ifdef GLPS_USE_WIN32
-#include <windows.h>
-#else
-#include <sys/time.h>
-#endif
-
-#ifdef GLPS_USE_WIN32
-static LARGE_INTEGER start_time;
-static LARGE_INTEGER frequency;
-#else
-static struct timespec start_time;
-#endif
-
 void log_performance(char *message)
 {
+    int legacy_zone = PERF_ZONE_ID("log_performance");
+
     if (message)
     {
-        #ifdef GLPS_USE_WIN32
-        if (start_time.QuadPart)
-        #else
-        if (start_time.tv_nsec || start_time.tv_sec)
-        #endif
+        uint64_t duration_ns = perf_zone_end(legacy_zone);
+        if (duration_ns == 0)
         {
-            char time_buffer[20];
-            time_t raw_time;
-            struct tm *time_info;
-            time(&raw_time);
-            time_info = localtime(&raw_time);
-            strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", time_info);
-
-            double time_taken;
-
-            #ifdef GLPS_USE_WIN32
-            LARGE_INTEGER end;
-            QueryPerformanceCounter(&end);
-            time_taken = (double)(end.QuadPart - start_time.QuadPart) / frequency.QuadPart;
-            #else
-            struct timespec end;
-            clock_gettime(CLOCK_MONOTONIC, &end);
-            time_taken = (end.tv_sec - start_time.tv_sec) +
-                         (end.tv_nsec - start_time.tv_nsec) / 1e9;
-            #endif
-
-            char full_log[1024];
-            printf("[%s] METRICS Function %s took %.9f seconds to execute.\n", time_buffer, message, time_taken);
-            snprintf(full_log, sizeof(full_log), "[%s] METRICS Function %s took %.9f seconds to execute.\n", time_buffer, message, time_taken);
-            add_log_entry(full_log);
+            LOG_ERROR("Start time not defined.");
             return;
         }
-        LOG_ERROR("Start time not defined.");
+        perf_zone_record(perf_zone_register(message), duration_ns);
     }
     else
     {
-        #ifdef GLPS_USE_WIN32
-        QueryPerformanceCounter(&start_time);
-        QueryPerformanceFrequency(&frequency);
-        #else
-        clock_gettime(CLOCK_MONOTONIC, &start_time);
-        #endif
+        perf_zone_begin(legacy_zone);
     }
 }
@@ -0,0 +1,299 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "utils/profiler/pico_profiler.h"
+#include "utils/logger/pico_logger.h"
+#include "utils/profiler/pico_trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef GLPS_USE_WIN32
+#include <windows.h>
+#endif
+
+typedef struct
+{
+    char *name;
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t total_ns;
+    atomic_uint_fast64_t min_ns;
+    atomic_uint_fast64_t max_ns;
+    atomic_uint_fast64_t histogram[PICO_PROFILER_HISTOGRAM_BUCKETS];
+} ZoneSlot;
+
+typedef struct
+{
+    int zone_id;
+    uint64_t start_ns;
+} OpenZone;
+
+static ZoneSlot zones[PICO_PROFILER_MAX_ZONES];
+static atomic_size_t zone_count = 0;
+static atomic_flag registry_lock = ATOMIC_FLAG_INIT;
+static atomic_bool profiler_enabled = true;
+
+static _Thread_local OpenZone zone_stack[PICO_PROFILER_MAX_DEPTH];
+static _Thread_local int zone_depth = 0;
+
+uint64_t perf_now_ns(void)
+{
+#ifdef GLPS_USE_WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000ull +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000ull / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static void reset_slot(ZoneSlot *slot)
+{
+    atomic_store_explicit(&slot->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->total_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->min_ns, UINT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&slot->max_ns, 0, memory_order_relaxed);
+    for (size_t i = 0; i < PICO_PROFILER_HISTOGRAM_BUCKETS; i++)
+    {
+        atomic_store_explicit(&slot->histogram[i], 0, memory_order_relaxed);
+    }
+}
+
+int perf_zone_register(const char *name)
+{
+    if (name == NULL)
+    {
+        return -1;
+    }
+
+    while (atomic_flag_test_and_set_explicit(&registry_lock, memory_order_acquire))
+    {
+    }
+
+    size_t count = atomic_load_explicit(&zone_count, memory_order_relaxed);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (strcmp(zones[i].name, name) == 0)
+        {
+            atomic_flag_clear_explicit(&registry_lock, memory_order_release);
+            return (int)i;
+        }
+    }
+
+    if (count == PICO_PROFILER_MAX_ZONES)
+    {
+        atomic_flag_clear_explicit(&registry_lock, memory_order_release);
+        LOG_WARNING("Profiler zone table is full, dropping zone %s.", name);
+        return -1;
+    }
+
+    zones[count].name = strdup(name);
+    if (zones[count].name == NULL)
+    {
+        atomic_flag_clear_explicit(&registry_lock, memory_order_release);
+        LOG_ERROR("Failed to allocate profiler zone %s.", name);
+        return -1;
+    }
+    reset_slot(&zones[count]);
+    atomic_store_explicit(&zone_count, count + 1, memory_order_release);
+    atomic_flag_clear_explicit(&registry_lock, memory_order_release);
+
+    return (int)count;
+}
+
+static bool is_valid_zone(int zone_id)
+{
+    return zone_id >= 0 && (size_t)zone_id < atomic_load_explicit(&zone_count, memory_order_acquire);
+}
+
+static size_t histogram_bucket(uint64_t duration_ns)
+{
+    if (duration_ns == 0)
+    {
+        return 0;
+    }
+    size_t bucket = 63 - (size_t)__builtin_clzll(duration_ns);
+    return bucket < PICO_PROFILER_HISTOGRAM_BUCKETS ? bucket : PICO_PROFILER_HISTOGRAM_BUCKETS - 1;
+}
+
+void perf_zone_record(int zone_id, uint64_t duration_ns)
+{
+    if (!is_valid_zone(zone_id))
+    {
+        return;
+    }
+
+    ZoneSlot *slot = &zones[zone_id];
+    atomic_fetch_add_explicit(&slot->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&slot->total_ns, duration_ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&slot->histogram[histogram_bucket(duration_ns)], 1, memory_order_relaxed);
+
+    uint_fast64_t current = atomic_load_explicit(&slot->min_ns, memory_order_relaxed);
+    while (duration_ns < current &&
+           !atomic_compare_exchange_weak_explicit(&slot->min_ns, &current, duration_ns,
+                                                  memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+
+    current = atomic_load_explicit(&slot->max_ns, memory_order_relaxed);
+    while (duration_ns > current &&
+           !atomic_compare_exchange_weak_explicit(&slot->max_ns, &current, duration_ns,
+                                                  memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+void perf_zone_begin(int zone_id)
+{
+    if (!atomic_load_explicit(&profiler_enabled, memory_order_relaxed) || zone_id < 0)
+    {
+        return;
+    }
+
+    if (zone_depth == PICO_PROFILER_MAX_DEPTH)
+    {
+        LOG_WARNING("Profiler zone stack overflow, zone %d ignored.", zone_id);
+        return;
+    }
+
+    zone_stack[zone_depth].zone_id = zone_id;
+    zone_stack[zone_depth].start_ns = perf_now_ns();
+    zone_depth++;
+}
+
+uint64_t perf_zone_end(int zone_id)
+{
+    if (zone_id < 0 || zone_depth == 0)
+    {
+        return 0;
+    }
+
+    uint64_t end_ns = perf_now_ns();
+    for (int i = zone_depth - 1; i >= 0; i--)
+    {
+        if (zone_stack[i].zone_id != zone_id)
+        {
+            continue;
+        }
+
+        uint64_t duration_ns = end_ns - zone_stack[i].start_ns;
+        zone_depth = i;
+        perf_zone_record(zone_id, duration_ns);
+        pico_trace_complete(zone_id, zone_stack[i].start_ns, duration_ns);
+        return duration_ns;
+    }
+
+    return 0;
+}
+
+bool perf_zone_get_stats(int zone_id, PerfZoneStats *stats)
+{
+    if (stats == NULL || !is_valid_zone(zone_id))
+    {
+        return false;
+    }
+
+    ZoneSlot *slot = &zones[zone_id];
+    stats->name = slot->name;
+    stats->count = atomic_load_explicit(&slot->count, memory_order_relaxed);
+    stats->total_ns = atomic_load_explicit(&slot->total_ns, memory_order_relaxed);
+    stats->min_ns = stats->count ? atomic_load_explicit(&slot->min_ns, memory_order_relaxed) : 0;
+    stats->max_ns = atomic_load_explicit(&slot->max_ns, memory_order_relaxed);
+    for (size_t i = 0; i < PICO_PROFILER_HISTOGRAM_BUCKETS; i++)
+    {
+        stats->histogram[i] = atomic_load_explicit(&slot->histogram[i], memory_order_relaxed);
+    }
+
+    return true;
+}
+
+size_t perf_zone_count(void)
+{
+    return atomic_load_explicit(&zone_count, memory_order_acquire);
+}
+
+void perf_zone_reset(void)
+{
+    size_t count = perf_zone_count();
+    for (size_t i = 0; i < count; i++)
+    {
+        reset_slot(&zones[i]);
+    }
+}
+
+void perf_set_enabled(bool enabled)
+{
+    atomic_store_explicit(&profiler_enabled, enabled, memory_order_relaxed);
+}
+
+void perf_report(FILE *fp)
+{
+    if (fp == NULL)
+    {
+        return;
+    }
+
+    fprintf(fp, "%-40s %10s %14s %12s %12s %12s\n", "zone", "count", "total (ms)", "mean (us)",
+            "min (us)", "max (us)");
+
+    size_t count = perf_zone_count();
+    for (size_t i = 0; i < count; i++)
+    {
+        PerfZoneStats stats;
+        if (!perf_zone_get_stats((int)i, &stats) || stats.count == 0)
+        {
+            continue;
+        }
+
+        fprintf(fp, "%-40s %10llu %14.3f %12.3f %12.3f %12.3f\n", stats.name,
+                (unsigned long long)stats.count, stats.total_ns / 1e6,
+                (double)stats.total_ns / (double)stats.count / 1e3, stats.min_ns / 1e3,
+                stats.max_ns / 1e3);
+    }
+}
+
+PerfScope perf_scope_begin(int zone_id)
+{
+    PerfScope scope = {-1};
+    if (zone_id >= 0 && atomic_load_explicit(&profiler_enabled, memory_order_relaxed))
+    {
+        perf_zone_begin(zone_id);
+        scope.zone_id = zone_id;
+    }
+    return scope;
+}
+
+void perf_scope_end(PerfScope *scope)
+{
+    if (scope->zone_id >= 0)
+    {
+        perf_zone_end(scope->zone_id);
+        scope->zone_id = -1;
+    }
+}
@@ -0,0 +1,248 @@
+/*
+ Copyright (c) 2025 Yassine Ahmed Ali
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy of
+ this software and associated documentation files (the "Software"), to deal in
+ the Software without restriction, including without limitation the rights to
+ use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ the Software, and to permit persons to whom the Software is furnished to do so,
+ subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "utils/profiler/pico_trace.h"
+#include "utils/logger/pico_logger.h"
+#include "utils/profiler/pico_profiler.h"
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef GLPS_USE_WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+typedef struct
+{
+    atomic_uint_fast64_t sequence; /* index + 1 once the slot is fully written */
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint32_t thread_id;
+    int32_t zone_id;
+} TraceEvent;
+
+/* Writers may still hold a ring after tracing restarts, so rings are never
+   freed: a restart with the same capacity reuses the ring, any other keeps the
+   old one on the retired list. */
+typedef struct TraceRing
+{
+    size_t capacity;
+    struct TraceRing *retired;
+    TraceEvent events[];
+} TraceRing;
+
+static _Atomic(TraceRing *) trace_ring = NULL;
+static atomic_uint_fast64_t trace_next = 0;
+static atomic_bool trace_enabled = false;
+static atomic_uint_fast32_t trace_thread_count = 0;
+static _Thread_local uint32_t trace_thread_id = 0;
+
+static volatile sig_atomic_t dump_requested = 0;
+static char dump_path[256];
+
+bool pico_trace_start(size_t capacity)
+{
+    if (capacity == 0)
+    {
+        LOG_ERROR("Trace buffer capacity must not be zero.");
+        return false;
+    }
+
+    atomic_store(&trace_enabled, false);
+
+    TraceRing *ring = atomic_load(&trace_ring);
+    if (ring != NULL && ring->capacity == capacity)
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            atomic_store_explicit(&ring->events[i].sequence, 0, memory_order_relaxed);
+        }
+    }
+    else
+    {
+        TraceRing *new_ring = calloc(1, sizeof(TraceRing) + capacity * sizeof(TraceEvent));
+        if (!new_ring)
+        {
+            LOG_ERROR("Failed to allocate memory for %zu trace events.", capacity);
+            return false;
+        }
+        new_ring->capacity = capacity;
+        new_ring->retired = ring;
+        atomic_store_explicit(&trace_ring, new_ring, memory_order_release);
+    }
+    atomic_store(&trace_next, 0);
+    atomic_store(&trace_enabled, true);
+
+    return true;
+}
+
+void pico_trace_stop(void)
+{
+    atomic_store(&trace_enabled, false);
+}
+
+bool pico_trace_is_enabled(void)
+{
+    return atomic_load_explicit(&trace_enabled, memory_order_relaxed);
+}
+
+void pico_trace_complete(int zone_id, uint64_t start_ns, uint64_t duration_ns)
+{
+    /* Acquire pairs with the start that published the ring. */
+    if (!atomic_load_explicit(&trace_enabled, memory_order_acquire))
+    {
+        return;
+    }
+
+    if (trace_thread_id == 0)
+    {
+        trace_thread_id = (uint32_t)atomic_fetch_add(&trace_thread_count, 1) + 1;
+    }
+
+    TraceRing *ring = atomic_load_explicit(&trace_ring, memory_order_acquire);
+    uint64_t index = atomic_fetch_add_explicit(&trace_next, 1, memory_order_relaxed);
+    TraceEvent *event = &ring->events[index % ring->capacity];
+
+    atomic_store_explicit(&event->sequence, 0, memory_order_relaxed);
+    event->start_ns = start_ns;
+    event->duration_ns = duration_ns;
+    event->thread_id = trace_thread_id;
+    event->zone_id = zone_id;
+    atomic_store_explicit(&event->sequence, index + 1, memory_order_release);
+}
+
+static void write_json_string(FILE *fp, const char *value)
+{
+    fputc('"', fp);
+    for (const char *c = value; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', fp);
+            fputc(*c, fp);
+        }
+        else if ((unsigned char)*c < 0x20)
+        {
+            fprintf(fp, "\\u%04x", (unsigned char)*c);
+        }
+        else
+        {
+            fputc(*c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+bool pico_trace_dump(const char *path)
+{
+    TraceRing *ring = atomic_load_explicit(&trace_ring, memory_order_acquire);
+    if (ring == NULL)
+    {
+        LOG_ERROR("Trace buffer was never started.");
+        return false;
+    }
+
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+    {
+        LOG_ERROR("Failed to open trace file %s.", path);
+        return false;
+    }
+
+#ifdef GLPS_USE_WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+
+    uint64_t end = atomic_load_explicit(&trace_next, memory_order_acquire);
+    uint64_t begin = end > ring->capacity ? end - ring->capacity : 0;
+    bool first = true;
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (uint64_t index = begin; index < end; index++)
+    {
+        TraceEvent *event = &ring->events[index % ring->capacity];
+        if (atomic_load_explicit(&event->sequence, memory_order_acquire) != index + 1)
+        {
+            continue;
+        }
+
+        TraceEvent copy;
+        copy.start_ns = event->start_ns;
+        copy.duration_ns = event->duration_ns;
+        copy.thread_id = event->thread_id;
+        copy.zone_id = event->zone_id;
+        if (atomic_load_explicit(&event->sequence, memory_order_acquire) != index + 1)
+        {
+            continue;
+        }
+
+        PerfZoneStats stats;
+        const char *name = perf_zone_get_stats(copy.zone_id, &stats) ? stats.name : "unknown";
+
+        fprintf(fp, "%s\n{\"name\":", first ? "" : ",");
+        write_json_string(fp, name);
+        fprintf(fp, ",\"cat\":\"glps\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%u}",
+                copy.start_ns / 1e3, copy.duration_ns / 1e3, pid, copy.thread_id);
+        first = false;
+    }
+    fprintf(fp, "\n]}\n");
+
+    fclose(fp);
+    return true;
+}
+
+static void handle_dump_signal(int signo)
+{
+    dump_requested = 1;
+    signal(signo, handle_dump_signal);
+}
+
+void pico_trace_dump_on_signal(int signo, const char *path)
+{
+    if (path == NULL)
+    {
+        return;
+    }
+
+    strncpy(dump_path, path, sizeof(dump_path) - 1);
+    dump_path[sizeof(dump_path) - 1] = '\0';
+    signal(signo, handle_dump_signal);
+}
+
+void pico_trace_poll(void)
+{
+    if (!dump_requested)
+    {
+        return;
+    }
+
+    dump_requested = 0;
+    if (pico_trace_dump(dump_path))
+    {
+        LOG_INFO("Trace written to %s.", dump_path);
+    }
+}